@@ -4,19 +4,79 @@
 
 #include "media/base/audio_renderer_mixer.h"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/feature_list.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
 #include "base/trace_event/trace_event.h"
+#include "media/base/audio_bus.h"
+#include "media/base/media_switches.h"
+#include "media/base/vector_math.h"
 
 namespace media {
 
 enum { kPauseDelaySeconds = 10 };
 
+// Upper bound on the number of threads used for ahead of time resampling.
+const int kMaxResamplerThreads = 4;
+
+// Real-time priority threads used for ahead of time resampling, shared by all
+// mixers in the process; see set_parallel_resampling().
+class ResamplerThreadPool {
+ public:
+  ResamplerThreadPool() : next_thread_(0) {
+    const int thread_count =
+        std::max(1, std::min(base::SysInfo::NumberOfProcessors() - 1,
+                             kMaxResamplerThreads));
+    for (int i = 0; i < thread_count; ++i) {
+      threads_.push_back(base::MakeUnique<base::Thread>(
+          base::StringPrintf("AudioMixerResampler%d", i)));
+      base::Thread::Options options;
+      options.priority = base::ThreadPriority::REALTIME_AUDIO;
+      CHECK(threads_.back()->StartWithOptions(options));
+    }
+  }
+
+  // Hands out the threads round robin.
+  scoped_refptr<base::SingleThreadTaskRunner> GetTaskRunner() {
+    base::AutoLock auto_lock(lock_);
+    scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+        threads_[next_thread_]->task_runner();
+    next_thread_ = (next_thread_ + 1) % threads_.size();
+    return task_runner;
+  }
+
+ private:
+  std::vector<std::unique_ptr<base::Thread>> threads_;
+
+  base::Lock lock_;
+  size_t next_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResamplerThreadPool);
+};
+
+base::LazyInstance<ResamplerThreadPool>::Leaky g_resampler_thread_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+static void RemoveFromInputs(
+    AudioConverter::InputCallback* input,
+    std::vector<AudioConverter::InputCallback*>* inputs) {
+  auto it = std::find(inputs->begin(), inputs->end(), input);
+  DCHECK(it != inputs->end());
+  inputs->erase(it);
+}
+
 // Tracks the maximum value of a counter and logs it into a UMA histogram upon
 // each increase of the maximum. NOT thread-safe, make sure it is used under
 // lock.
@@ -49,16 +109,245 @@ class AudioRendererMixer::UMAMaxValueTracker {
   DISALLOW_COPY_AND_ASSIGN(UMAMaxValueTracker);
 };
 
+// Mixes a list of inputs into a single stream.  The list belongs to the
+// snapshot the current Render() call is using and is set by Render() before
+// any audio is pulled; only touched on the rendering thread.
+class AudioRendererMixer::InputList : public AudioConverter::InputCallback {
+ public:
+  InputList() : inputs_(nullptr) {}
+  ~InputList() override {}
+
+  void set_inputs(const std::vector<AudioConverter::InputCallback*>* inputs) {
+    inputs_ = inputs;
+  }
+
+  // AudioConverter::InputCallback implementation.
+  double ProvideInput(AudioBus* audio_bus, uint32_t frames_delayed) override {
+    DCHECK(inputs_);
+    if (inputs_->empty()) {
+      audio_bus->Zero();
+      return 1.0;
+    }
+
+    // Have the first input render directly into |audio_bus|, then render and
+    // mix the others in via |mix_audio_bus_|.
+    for (size_t i = 0; i < inputs_->size(); ++i) {
+      AudioConverter::InputCallback* input = (*inputs_)[i];
+      if (!i) {
+        const float volume = input->ProvideInput(audio_bus, frames_delayed);
+        // Optimize the most common single input, full volume case.
+        if (volume == 1.0f)
+          continue;
+        if (volume > 0) {
+          for (int ch = 0; ch < audio_bus->channels(); ++ch) {
+            vector_math::FMUL(audio_bus->channel(ch), volume,
+                              audio_bus->frames(), audio_bus->channel(ch));
+          }
+        } else {
+          audio_bus->Zero();
+        }
+        continue;
+      }
+
+      if (!mix_audio_bus_ ||
+          mix_audio_bus_->channels() != audio_bus->channels() ||
+          mix_audio_bus_->frames() != audio_bus->frames()) {
+        mix_audio_bus_ =
+            AudioBus::Create(audio_bus->channels(), audio_bus->frames());
+      }
+
+      const float volume =
+          input->ProvideInput(mix_audio_bus_.get(), frames_delayed);
+      if (volume > 0) {
+        for (int ch = 0; ch < audio_bus->channels(); ++ch) {
+          vector_math::FMAC(mix_audio_bus_->channel(ch), volume,
+                            audio_bus->frames(), audio_bus->channel(ch));
+        }
+      }
+    }
+    return 1.0;
+  }
+
+ private:
+  const std::vector<AudioConverter::InputCallback*>* inputs_;
+  std::unique_ptr<AudioBus> mix_audio_bus_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputList);
+};
+
+// Immutable view of the mixing graph used by Render().
+struct AudioRendererMixer::InputSnapshot {
+  InputSnapshot() : resample_jobs(0) {}
+
+  // Inputs at the output sample rate along with the resampling groups, in the
+  // order they were added.
+  std::vector<AudioConverter::InputCallback*> master_inputs;
+
+  // Each resampling group referenced by |master_inputs| and its inputs.
+  std::vector<std::pair<ResamplingGroup*,
+                        std::vector<AudioConverter::InputCallback*>>>
+      converters;
+
+  // The number of buffers being resampled ahead of time on helper threads with
+  // inputs from |converters|.  The snapshot may not be freed until it's zero.
+  mutable base::subtle::Atomic32 resample_jobs;
+};
+
+// Mixes all inputs of one sample rate and resamples the result to the output
+// sample rate.  If given a |resampler_task_runner|, each buffer is resampled
+// one buffer ahead of time on it; see set_parallel_resampling().
+class AudioRendererMixer::ResamplingGroup
+    : public AudioConverter::InputCallback {
+ public:
+  // We expect all InputCallbacks to be capable of handling arbitrary buffer
+  // size requests, disabling FIFO.
+  ResamplingGroup(
+      const AudioParameters& input_params,
+      const AudioParameters& output_params,
+      scoped_refptr<base::SingleThreadTaskRunner> resampler_task_runner)
+      : converter_(input_params, output_params, true),
+        output_channels_(output_params.channels()),
+        resampler_task_runner_(std::move(resampler_task_runner)),
+        render_snapshot_(nullptr),
+        render_inputs_(nullptr),
+        resample_snapshot_(nullptr),
+        has_resampled_audio_(false),
+        resample_sequence_(0) {
+    converter_.AddInput(&input_list_);
+  }
+  ~ResamplingGroup() override { converter_.RemoveInput(&input_list_); }
+
+  // Inputs of this group; maintained by the writer side of the mixer under
+  // |lock_| and copied into each snapshot.
+  std::vector<AudioConverter::InputCallback*>* inputs() { return &inputs_; }
+
+  // Sets the snapshot the current Render() call is using, and this group's
+  // inputs in it.  Rendering thread only.
+  void set_render_inputs(
+      const InputSnapshot* snapshot,
+      const std::vector<AudioConverter::InputCallback*>* inputs) {
+    render_snapshot_ = snapshot;
+    render_inputs_ = inputs;
+  }
+
+  // Returns true while a buffer is being resampled on the helper thread.
+  bool is_resampling() const {
+    return !!(base::subtle::Acquire_Load(&resample_sequence_) & 1);
+  }
+
+  // Waits for the buffer being resampled on the helper thread, if any.
+  void WaitForResampling() const {
+    const base::subtle::Atomic32 sequence =
+        base::subtle::Acquire_Load(&resample_sequence_);
+    if (!(sequence & 1))
+      return;
+    while (base::subtle::Acquire_Load(&resample_sequence_) == sequence)
+      base::PlatformThread::YieldCurrentThread();
+  }
+
+  // AudioConverter::InputCallback implementation.
+  double ProvideInput(AudioBus* audio_bus, uint32_t frames_delayed) override {
+    DCHECK(render_inputs_);
+    if (!resampler_task_runner_) {
+      input_list_.set_inputs(render_inputs_);
+      converter_.ConvertWithDelay(frames_delayed, audio_bus);
+      return 1.0;
+    }
+
+    // The helper thread owns |converter_| until it's done; rather than wait on
+    // it, this group is silent for the buffer.
+    if (is_resampling()) {
+      TRACE_EVENT_INSTANT0("audio", "AudioRendererMixer::ResamplingUnderrun",
+                           TRACE_EVENT_SCOPE_THREAD);
+      return 0.0;
+    }
+
+    if (has_resampled_audio_ &&
+        resampled_audio_->frames() == audio_bus->frames()) {
+      resampled_audio_->CopyTo(audio_bus);
+    } else {
+      // Nothing was resampled ahead of time for a buffer of this size, which
+      // happens on the first call; do it now.
+      input_list_.set_inputs(render_inputs_);
+      converter_.ConvertWithDelay(frames_delayed, audio_bus);
+    }
+
+    // Resample the next buffer, which will be played out one buffer after this
+    // one.  The job keeps the snapshot, and so its inputs, from being freed
+    // until the helper thread is done with them.
+    input_list_.set_inputs(render_inputs_);
+    resample_snapshot_ = render_snapshot_;
+    base::subtle::Barrier_AtomicIncrement(&resample_snapshot_->resample_jobs,
+                                          1);
+    base::subtle::Barrier_AtomicIncrement(&resample_sequence_, 1);
+    resampler_task_runner_->PostTask(
+        FROM_HERE, base::Bind(&ResamplingGroup::ResampleAhead,
+                              base::Unretained(this),
+                              frames_delayed + audio_bus->frames(),
+                              audio_bus->frames()));
+    return 1.0;
+  }
+
+ private:
+  // Runs on |resampler_task_runner_|.
+  void ResampleAhead(uint32_t frames_delayed, int frames) {
+    TRACE_EVENT0("audio", "AudioRendererMixer::ResampleAhead");
+    if (!resampled_audio_ || resampled_audio_->frames() != frames)
+      resampled_audio_ = AudioBus::Create(output_channels_, frames);
+    converter_.ConvertWithDelay(frames_delayed, resampled_audio_.get());
+    has_resampled_audio_ = true;
+
+    // Either update may let the mixer free what it guards, so nothing is
+    // touched after it: first the snapshot, then this group, whose sequence is
+    // the last thing written.
+    base::subtle::Barrier_AtomicIncrement(&resample_snapshot_->resample_jobs,
+                                          -1);
+    base::subtle::Barrier_AtomicIncrement(&resample_sequence_, 1);
+  }
+
+  InputList input_list_;
+  AudioConverter converter_;
+  const int output_channels_;
+  std::vector<AudioConverter::InputCallback*> inputs_;
+  const scoped_refptr<base::SingleThreadTaskRunner> resampler_task_runner_;
+  const InputSnapshot* render_snapshot_;
+  const std::vector<AudioConverter::InputCallback*>* render_inputs_;
+
+  // Ahead of time resampling state.  |converter_|, |input_list_|,
+  // |resample_snapshot_| and |resampled_audio_| belong to the helper thread
+  // while |resample_sequence_| is odd; it's incremented when a job is handed
+  // to the helper thread and again when the job is done.
+  const InputSnapshot* resample_snapshot_;
+  std::unique_ptr<AudioBus> resampled_audio_;
+  bool has_resampled_audio_;
+  base::subtle::Atomic32 resample_sequence_;
+
+  DISALLOW_COPY_AND_ASSIGN(ResamplingGroup);
+};
+
+struct AudioRendererMixer::RetiredSnapshot {
+  std::unique_ptr<InputSnapshot> snapshot;
+  std::unique_ptr<ResamplingGroup> converter;
+
+  // Value of |render_epoch_| right after |snapshot| was replaced.
+  base::subtle::Atomic32 render_epoch;
+};
+
 AudioRendererMixer::AudioRendererMixer(const AudioParameters& output_params,
                                        scoped_refptr<AudioRendererSink> sink,
                                        const UmaLogCallback& log_callback)
     : output_params_(output_params),
       audio_sink_(std::move(sink)),
-      master_converter_(output_params, output_params, true),
+      master_input_list_(new InputList()),
+      current_snapshot_(
+          reinterpret_cast<base::subtle::AtomicWord>(new InputSnapshot())),
+      render_epoch_(0),
       pause_delay_(base::TimeDelta::FromSeconds(kPauseDelaySeconds)),
       last_play_time_(base::TimeTicks::Now()),
       // Initialize |playing_| to true since Start() results in an auto-play.
       playing_(true),
+      parallel_resampling_(
+          base::FeatureList::IsEnabled(kParallelAudioMixerResampling)),
       input_count_tracker_(new UMAMaxValueTracker(log_callback)) {
   DCHECK(audio_sink_);
   audio_sink_->Initialize(output_params, this);
@@ -70,9 +359,13 @@ AudioRendererMixer::~AudioRendererMixer() {
   audio_sink_->Stop();
 
   // Ensure that all mixer inputs have removed themselves prior to destruction.
-  DCHECK(master_converter_.empty());
+  DCHECK(master_inputs_.empty());
   DCHECK(converters_.empty());
   DCHECK_EQ(error_callbacks_.size(), 0U);
+
+  // No more Render() calls can happen, so every snapshot can be freed.
+  delete reinterpret_cast<InputSnapshot*>(
+      base::subtle::NoBarrier_Load(&current_snapshot_));
 }
 
 void AudioRendererMixer::AddMixerInput(const AudioParameters& input_params,
@@ -86,28 +379,31 @@ void AudioRendererMixer::AddMixerInput(const AudioParameters& input_params,
 
   int input_sample_rate = input_params.sample_rate();
   if (is_master_sample_rate(input_sample_rate)) {
-    master_converter_.AddInput(input);
+    master_inputs_.push_back(input);
   } else {
     AudioConvertersMap::iterator converter =
         converters_.find(input_sample_rate);
     if (converter == converters_.end()) {
       std::pair<AudioConvertersMap::iterator, bool> result =
           converters_.insert(std::make_pair(
-              input_sample_rate, base::WrapUnique(
-                                     // We expect all InputCallbacks to be
-                                     // capable of handling arbitrary buffer
-                                     // size requests, disabling FIFO.
-                                     new LoopbackAudioConverter(
-                                         input_params, output_params_, true))));
+              input_sample_rate,
+              base::MakeUnique<ResamplingGroup>(
+                  input_params, output_params_,
+                  parallel_resampling_
+                      ? g_resampler_thread_pool.Get().GetTaskRunner()
+                      : nullptr)));
       converter = result.first;
 
       // Add newly-created resampler as an input to the master mixer.
-      master_converter_.AddInput(converter->second.get());
+      master_inputs_.push_back(converter->second.get());
     }
-    converter->second->AddInput(input);
+    converter->second->inputs()->push_back(input);
   }
 
   input_count_tracker_->Increment();
+
+  PublishSnapshot_Locked(nullptr);
+  ReclaimSnapshots_Locked(false);
 }
 
 void AudioRendererMixer::RemoveMixerInput(
@@ -115,22 +411,31 @@ void AudioRendererMixer::RemoveMixerInput(
     AudioConverter::InputCallback* input) {
   base::AutoLock auto_lock(lock_);
 
+  std::unique_ptr<ResamplingGroup> removed_converter;
   int input_sample_rate = input_params.sample_rate();
   if (is_master_sample_rate(input_sample_rate)) {
-    master_converter_.RemoveInput(input);
+    RemoveFromInputs(input, &master_inputs_);
   } else {
     AudioConvertersMap::iterator converter =
         converters_.find(input_sample_rate);
     DCHECK(converter != converters_.end());
-    converter->second->RemoveInput(input);
-    if (converter->second->empty()) {
-      // Remove converter when it's empty.
-      master_converter_.RemoveInput(converter->second.get());
+    RemoveFromInputs(input, converter->second->inputs());
+    if (converter->second->inputs()->empty()) {
+      // Remove converter when it's empty; it's freed along with the last
+      // snapshot referencing it.
+      RemoveFromInputs(converter->second.get(), &master_inputs_);
+      removed_converter = std::move(converter->second);
       converters_.erase(converter);
     }
   }
 
   input_count_tracker_->Decrement();
+
+  PublishSnapshot_Locked(std::move(removed_converter));
+
+  // |input| may be destroyed as soon as this returns, so wait until Render() is
+  // no longer using a snapshot which refers to it.
+  ReclaimSnapshots_Locked(true);
 }
 
 void AudioRendererMixer::AddErrorCallback(const base::Closure& error_cb) {
@@ -166,23 +471,115 @@ int AudioRendererMixer::Render(AudioBus* audio_bus,
                                uint32_t frames_delayed,
                                uint32_t frames_skipped) {
   TRACE_EVENT0("audio", "AudioRendererMixer::Render");
-  base::AutoLock auto_lock(lock_);
 
   // If there are no mixer inputs and we haven't seen one for a while, pause the
   // sink to avoid wasting resources when media elements are present but remain
-  // in the pause state.
-  const base::TimeTicks now = base::TimeTicks::Now();
-  if (!master_converter_.empty()) {
-    last_play_time_ = now;
-  } else if (now - last_play_time_ >= pause_delay_ && playing_) {
-    audio_sink_->Pause();
-    playing_ = false;
+  // in the pause state.  If inputs are being added or removed right now, skip
+  // the check rather than wait; it'll be made again on the next call.
+  if (lock_.Try()) {
+    const base::TimeTicks now = base::TimeTicks::Now();
+    if (!master_inputs_.empty()) {
+      last_play_time_ = now;
+    } else if (now - last_play_time_ >= pause_delay_ && playing_) {
+      audio_sink_->Pause();
+      playing_ = false;
+    }
+    lock_.Release();
   }
 
-  master_converter_.ConvertWithDelay(frames_delayed, audio_bus);
+  // The full barrier orders the epoch update before the snapshot load; see
+  // PublishSnapshot_Locked().
+  base::subtle::Barrier_AtomicIncrement(&render_epoch_, 1);
+  const InputSnapshot* snapshot = reinterpret_cast<const InputSnapshot*>(
+      base::subtle::Acquire_Load(&current_snapshot_));
+
+  for (const auto& converter : snapshot->converters)
+    converter.first->set_render_inputs(snapshot, &converter.second);
+  master_input_list_->set_inputs(&snapshot->master_inputs);
+  master_input_list_->ProvideInput(audio_bus, frames_delayed);
+
+  base::subtle::Barrier_AtomicIncrement(&render_epoch_, 1);
   return audio_bus->frames();
 }
 
+void AudioRendererMixer::PublishSnapshot_Locked(
+    std::unique_ptr<ResamplingGroup> removed_converter) {
+  lock_.AssertAcquired();
+
+  std::unique_ptr<InputSnapshot> snapshot(new InputSnapshot());
+  snapshot->master_inputs = master_inputs_;
+  for (const auto& converter : converters_) {
+    snapshot->converters.push_back(
+        std::make_pair(converter.second.get(), *converter.second->inputs()));
+  }
+
+  std::unique_ptr<RetiredSnapshot> retired(new RetiredSnapshot());
+  retired->snapshot.reset(reinterpret_cast<InputSnapshot*>(
+      base::subtle::NoBarrier_Load(&current_snapshot_)));
+  retired->converter = std::move(removed_converter);
+  base::subtle::Release_Store(
+      &current_snapshot_,
+      reinterpret_cast<base::subtle::AtomicWord>(snapshot.release()));
+
+  // Read the epoch with a full barrier: any Render() call which hasn't entered
+  // by now is guaranteed to load the new snapshot.
+  retired->render_epoch =
+      base::subtle::Barrier_AtomicIncrement(&render_epoch_, 0);
+  retired_snapshots_.push_back(std::move(retired));
+}
+
+void AudioRendererMixer::ReclaimSnapshots_Locked(bool wait_for_render) {
+  lock_.AssertAcquired();
+
+  while (!retired_snapshots_.empty()) {
+    const base::subtle::Atomic32 render_epoch =
+        base::subtle::Barrier_AtomicIncrement(&render_epoch_, 0);
+
+    // A retired snapshot is unused if Render() wasn't running when it was
+    // replaced, or if the Render() call which was has since returned, and no
+    // buffer Render() handed to a helper thread is still being resampled with
+    // its inputs.  A retired converter must also be done with any resampling;
+    // no more is handed out once the snapshot is unused.
+    for (auto it = retired_snapshots_.begin();
+         it != retired_snapshots_.end();) {
+      const RetiredSnapshot& retired = **it;
+      if ((!(retired.render_epoch & 1) ||
+           retired.render_epoch != render_epoch) &&
+          !base::subtle::Acquire_Load(&retired.snapshot->resample_jobs) &&
+          (!retired.converter || !retired.converter->is_resampling())) {
+        it = retired_snapshots_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (!wait_for_render)
+      return;
+    if (retired_snapshots_.empty())
+      break;
+
+    // Render() never blocks, so this wait is bounded by a single callback.
+    base::PlatformThread::YieldCurrentThread();
+  }
+}
+
+void AudioRendererMixer::WaitForParallelResampling_Locked() {
+  lock_.AssertAcquired();
+  for (const auto& converter : converters_)
+    converter.second->WaitForResampling();
+}
+
+void AudioRendererMixer::set_parallel_resampling(bool parallel_resampling) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK(converters_.empty());
+  parallel_resampling_ = parallel_resampling;
+}
+
+void AudioRendererMixer::FlushParallelResamplingForTesting() {
+  base::AutoLock auto_lock(lock_);
+  WaitForParallelResampling_Locked();
+}
+
 void AudioRendererMixer::OnRenderError() {
   // Call each mixer input and signal an error.
   base::AutoLock auto_lock(lock_);
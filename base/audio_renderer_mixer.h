@@ -7,22 +7,32 @@
 
 #include <stdint.h>
 
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "base/atomicops.h"
 #include "base/macros.h"
 #include "base/synchronization/lock.h"
 #include "base/time/time.h"
 #include "media/base/audio_converter.h"
 #include "media/base/audio_renderer_sink.h"
-#include "media/base/loopback_audio_converter.h"
 
 namespace media {
 
 // Mixes a set of AudioConverter::InputCallbacks into a single output stream
 // which is funneled into a single shared AudioRendererSink; saving a bundle
 // on renderer side resources.
+//
+// Render() never waits on AddMixerInput() or RemoveMixerInput().  Those build
+// a new immutable InputSnapshot of the mixing graph and publish it atomically;
+// the rendering thread picks up whichever snapshot is current when Render()
+// starts.  Old snapshots (and converters no longer referenced by the current
+// one) are reclaimed once the rendering thread is known to be done with them;
+// RemoveMixerInput() waits for that so the removed input is never called again
+// after it returns.  It therefore must not be called from within Render().
 class MEDIA_EXPORT AudioRendererMixer
     : NON_EXPORTED_BASE(public AudioRendererSink::RenderCallback) {
  public:
@@ -49,6 +59,18 @@ class MEDIA_EXPORT AudioRendererMixer
     pause_delay_ = delay;
   }
 
+  // When enabled, inputs requiring resampling are mixed and resampled one
+  // buffer ahead of time on real-time helper threads, so Render() only has to
+  // sum the results; at the cost of one buffer of extra latency for those
+  // inputs.  If a helper falls behind, its inputs are silent for that buffer
+  // rather than stalling the device thread.  Defaults to the
+  // kParallelAudioMixerResampling feature; must be set before any inputs are
+  // added.
+  void set_parallel_resampling(bool parallel_resampling);
+
+  // Waits for all outstanding ahead of time resampling to finish.
+  void FlushParallelResamplingForTesting();
+
   OutputDeviceInfo GetOutputDeviceInfo();
 
   // Returns true if called on rendering thread, otherwise false.
@@ -57,11 +79,17 @@ class MEDIA_EXPORT AudioRendererMixer
   const AudioParameters& GetOutputParamsForTesting() { return output_params_; };
 
  private:
+  class InputList;
+  class ResamplingGroup;
   class UMAMaxValueTracker;
+  struct InputSnapshot;
 
   // Maps input sample rate to the dedicated converter.
-  using AudioConvertersMap =
-      std::map<int, std::unique_ptr<LoopbackAudioConverter>>;
+  using AudioConvertersMap = std::map<int, std::unique_ptr<ResamplingGroup>>;
+
+  // A snapshot which has been replaced, along with the converters only it
+  // referenced, waiting for the rendering thread to stop using it.
+  struct RetiredSnapshot;
 
   // AudioRendererSink::RenderCallback implementation.
   int Render(AudioBus* audio_bus,
@@ -73,13 +101,43 @@ class MEDIA_EXPORT AudioRendererMixer
     return sample_rate == output_params_.sample_rate();
   }
 
+  // Builds a snapshot from |master_inputs_| and |converters_|, publishes it for
+  // Render() and retires the previous one along with |removed_converter|, if
+  // any.  |lock_| must be held.
+  void PublishSnapshot_Locked(
+      std::unique_ptr<ResamplingGroup> removed_converter);
+
+  // Frees retired snapshots which Render() can no longer be using.  If
+  // |wait_for_render| is true, waits for an in progress Render() call, and any
+  // resampling it handed to helper threads, to finish so that every retired
+  // snapshot can be freed.  |lock_| must be held.
+  void ReclaimSnapshots_Locked(bool wait_for_render);
+
+  // Waits for ahead of time resampling running on helper threads to finish.
+  // |lock_| must be held.
+  void WaitForParallelResampling_Locked();
+
   // Output parameters for this mixer.
   const AudioParameters output_params_;
 
   // Output sink for this mixer.
   const scoped_refptr<AudioRendererSink> audio_sink_;
 
+  // Mixes the inputs of the current snapshot; only used by Render().
+  std::unique_ptr<InputList> master_input_list_;
+
+  // The snapshot Render() should use; an InputSnapshot* written under |lock_|
+  // and read without it.
+  base::subtle::AtomicWord current_snapshot_;
+
+  // Incremented on entry to and exit from Render(), so it's odd while a
+  // Render() call may be using a snapshot.  Used to decide when retired
+  // snapshots may be freed.
+  base::subtle::Atomic32 render_epoch_;
+
   // ---------------[ All variables below protected by |lock_| ]---------------
+  // Render() only ever tries to acquire |lock_|, so holding it never blocks the
+  // rendering thread.
   base::Lock lock_;
 
   // List of error callbacks used by this mixer.
@@ -88,12 +146,16 @@ class MEDIA_EXPORT AudioRendererMixer
 
   // Each of these converters mixes inputs with a given sample rate and
   // resamples them to the output sample rate. Inputs not reqiuring resampling
-  // go directly to |master_converter_|.
+  // go directly to |master_inputs_|.
   AudioConvertersMap converters_;
 
-  // Master converter which mixes all the outputs from |converters_| as well as
-  // mixer inputs that are in the output sample rate.
-  AudioConverter master_converter_;
+  // All the outputs from |converters_| as well as mixer inputs that are in the
+  // output sample rate, in the order they were added.
+  std::vector<AudioConverter::InputCallback*> master_inputs_;
+
+  // Snapshots replaced since the rendering thread was last seen outside of
+  // Render(), oldest first.
+  std::list<std::unique_ptr<RetiredSnapshot>> retired_snapshots_;
 
   // Handles physical stream pause when no inputs are playing.  For latency
   // reasons we don't want to immediately pause the physical stream.
@@ -101,6 +163,9 @@ class MEDIA_EXPORT AudioRendererMixer
   base::TimeTicks last_play_time_;
   bool playing_;
 
+  // See set_parallel_resampling().
+  bool parallel_resampling_;
+
   // Tracks the maximum number of simultaneous mixer inputs and logs it into
   // UMA histogram upon the destruction.
   std::unique_ptr<UMAMaxValueTracker> input_count_tracker_;
@@ -0,0 +1,132 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/audio_renderer_mixer.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "media/base/audio_bus.h"
+#include "media/base/mock_audio_renderer_sink.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkRenderCalls = 20000;
+static const int kMixerInputs = 8;
+
+// InputCallback that zero's out the provided AudioBus.
+class NullInputProvider : public AudioConverter::InputCallback {
+ public:
+  NullInputProvider() {}
+  ~NullInputProvider() override {}
+
+  double ProvideInput(AudioBus* audio_bus, uint32_t frames_delayed) override {
+    audio_bus->Zero();
+    return 1;
+  }
+};
+
+static void LogUma(int value) {}
+
+// Calls Render() |render_calls| times, recording how long each call took, then
+// sets |done|.
+static void RenderRepeatedly(AudioRendererSink::RenderCallback* callback,
+                             AudioBus* audio_bus,
+                             int render_calls,
+                             std::vector<base::TimeDelta>* render_times,
+                             base::subtle::Atomic32* done) {
+  for (int i = 0; i < render_calls; ++i) {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    callback->Render(audio_bus, 0, 0);
+    render_times->push_back(base::TimeTicks::Now() - start);
+  }
+  base::subtle::Release_Store(done, 1);
+}
+
+// Measures how long Render() takes while inputs, both at the output sample rate
+// and requiring resampling, are added and removed as fast as possible on
+// another thread.  Render() never waits on input registration, so the worst
+// case should stay well within the device period.
+static void RunAddRemoveWhileRenderingBenchmark(bool parallel_resampling,
+                                                const std::string& trace) {
+  const AudioParameters output_params(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                                      CHANNEL_LAYOUT_STEREO, 44100, 16, 256);
+  const AudioParameters input_params[] = {
+      AudioParameters(AudioParameters::AUDIO_PCM_LINEAR, CHANNEL_LAYOUT_STEREO,
+                      44100, 32, 8192),
+      AudioParameters(AudioParameters::AUDIO_PCM_LINEAR, CHANNEL_LAYOUT_STEREO,
+                      48000, 32, 8192)};
+
+  scoped_refptr<testing::NiceMock<MockAudioRendererSink>> sink =
+      new testing::NiceMock<MockAudioRendererSink>();
+  AudioRendererMixer mixer(output_params, sink, base::Bind(&LogUma));
+  mixer.set_parallel_resampling(parallel_resampling);
+  std::unique_ptr<AudioBus> audio_bus = AudioBus::Create(output_params);
+
+  std::vector<std::unique_ptr<NullInputProvider>> inputs;
+  for (int i = 0; i < kMixerInputs; ++i)
+    inputs.push_back(base::MakeUnique<NullInputProvider>());
+
+  base::Thread render_thread("AudioRendererMixerRenderThread");
+  ASSERT_TRUE(render_thread.Start());
+
+  std::vector<base::TimeDelta> render_times;
+  render_times.reserve(kBenchmarkRenderCalls);
+  base::subtle::Atomic32 done = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  render_thread.task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(&RenderRepeatedly, sink->callback(), audio_bus.get(),
+                 kBenchmarkRenderCalls, &render_times, &done));
+
+  int cycles = 0;
+  while (!base::subtle::Acquire_Load(&done)) {
+    for (size_t i = 0; i < inputs.size(); ++i)
+      mixer.AddMixerInput(input_params[i % 2], inputs[i].get());
+    for (size_t i = 0; i < inputs.size(); ++i)
+      mixer.RemoveMixerInput(input_params[i % 2], inputs[i].get());
+    ++cycles;
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  render_thread.Stop();
+
+  std::sort(render_times.begin(), render_times.end());
+  const base::TimeDelta device_period = output_params.GetBufferDuration();
+  const size_t missed_periods =
+      render_times.end() - std::upper_bound(render_times.begin(),
+                                            render_times.end(), device_period);
+
+  perf_test::PrintResult(
+      "audio_renderer_mixer_render", "_p99", trace,
+      render_times[render_times.size() * 99 / 100].InMicrosecondsF(), "us",
+      true);
+  perf_test::PrintResult("audio_renderer_mixer_render", "_max", trace,
+                         render_times.back().InMicrosecondsF(), "us", true);
+  perf_test::PrintResult("audio_renderer_mixer_render", "_missed_periods",
+                         trace, missed_periods, "calls", true);
+  perf_test::PrintResult("audio_renderer_mixer_add_remove", "", trace,
+                         cycles / elapsed.InSecondsF(), "cycles/s", true);
+}
+
+TEST(AudioRendererMixerPerfTest, AddRemoveWhileRendering) {
+  RunAddRemoveWhileRenderingBenchmark(false, "serial");
+}
+
+TEST(AudioRendererMixerPerfTest, AddRemoveWhileRenderingParallel) {
+  RunAddRemoveWhileRenderingBenchmark(true, "parallel");
+}
+
+}  // namespace media
@@ -12,12 +12,15 @@
 #include <cmath>
 #include <memory>
 
+#include "base/atomicops.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/macros.h"
+#include "base/memory/ptr_util.h"
 #include "base/memory/scoped_vector.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
 #include "media/base/audio_renderer_mixer_input.h"
 #include "media/base/audio_renderer_mixer_pool.h"
 #include "media/base/fake_audio_render_callback.h"
@@ -50,6 +53,47 @@ const int kTestInputLower = 44100;
 const int kTestInputHigher = 48000;
 const int kTestInput3Rates[] = {22050, 44100, 48000};
 
+// Number of Render() calls made while inputs are added and removed.
+const int kStressRenderCalls = 2000;
+
+// Calls Render() |render_calls| times, then sets |done|.
+static void RenderRepeatedly(AudioRendererSink::RenderCallback* callback,
+                             AudioBus* audio_bus,
+                             int render_calls,
+                             base::subtle::Atomic32* done) {
+  for (int i = 0; i < render_calls; ++i)
+    EXPECT_EQ(audio_bus->frames(), callback->Render(audio_bus, 0, 0));
+  base::subtle::Release_Store(done, 1);
+}
+
+// Provides silence, and fails the test if it is asked for input while it isn't
+// added to the mixer.
+class RegistrationCheckingCallback : public AudioConverter::InputCallback {
+ public:
+  RegistrationCheckingCallback() : added_(0), calls_(0) {}
+  ~RegistrationCheckingCallback() override {}
+
+  // Must be called before the callback is added to the mixer, and after it has
+  // been removed.
+  void set_added(bool added) { base::subtle::Release_Store(&added_, added); }
+
+  int calls() const { return base::subtle::Acquire_Load(&calls_); }
+
+  double ProvideInput(AudioBus* audio_bus, uint32_t frames_delayed) override {
+    EXPECT_TRUE(base::subtle::Acquire_Load(&added_))
+        << "Called after RemoveMixerInput() returned.";
+    base::subtle::NoBarrier_AtomicIncrement(&calls_, 1);
+    audio_bus->Zero();
+    return 1;
+  }
+
+ private:
+  base::subtle::Atomic32 added_;
+  base::subtle::Atomic32 calls_;
+
+  DISALLOW_COPY_AND_ASSIGN(RegistrationCheckingCallback);
+};
+
 // Tuple of <input sampling rates, number of input sample rates,
 // output sampling rate, epsilon>.
 using AudioRendererMixerTestData =
@@ -512,6 +556,110 @@ TEST_P(AudioRendererMixerBehavioralTest, MixerPausesStream) {
   mixer_inputs_[0]->Stop();
 }
 
+// Adds and removes inputs, both at the output sample rate and requiring
+// resampling, as fast as possible while another thread renders.  Every Render()
+// call must fill the bus, and an input must never be called once
+// RemoveMixerInput() has returned.  How long Render() takes meanwhile is
+// measured by audio_renderer_mixer_perftest.cc.
+TEST_P(AudioRendererMixerBehavioralTest, AddRemoveInputsWhileRendering) {
+  const AudioParameters resampled_params(
+      AudioParameters::AUDIO_PCM_LINEAR, kChannelLayout, kTestInputHigher,
+      kBitsPerChannel, kHighLatencyBufferSize);
+  const AudioParameters* const params[] = {&input_parameters_[0],
+                                           &resampled_params};
+
+  std::vector<std::unique_ptr<RegistrationCheckingCallback>> callbacks;
+  for (int i = 0; i < kMixerInputs; ++i)
+    callbacks.push_back(base::MakeUnique<RegistrationCheckingCallback>());
+
+  base::Thread render_thread("AudioRendererMixerRenderThread");
+  ASSERT_TRUE(render_thread.Start());
+
+  base::subtle::Atomic32 done = 0;
+  render_thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&RenderRepeatedly, mixer_callback_,
+                            audio_bus_.get(), kStressRenderCalls, &done));
+
+  int cycles = 0;
+  while (!base::subtle::Acquire_Load(&done)) {
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      callbacks[i]->set_added(true);
+      mixer_->AddMixerInput(*params[i % 2], callbacks[i].get());
+    }
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+      mixer_->RemoveMixerInput(*params[i % 2], callbacks[i].get());
+      callbacks[i]->set_added(false);
+    }
+    ++cycles;
+  }
+  render_thread.Stop();
+  EXPECT_GT(cycles, 0);
+
+  // With every input removed, rendering produces silence without calling any
+  // of them.
+  int calls = 0;
+  for (const auto& callback : callbacks)
+    calls += callback->calls();
+  EXPECT_EQ(audio_bus_->frames(),
+            mixer_callback_->Render(audio_bus_.get(), 0, 0));
+  for (const auto& callback : callbacks)
+    calls -= callback->calls();
+  EXPECT_EQ(0, calls);
+  for (int ch = 0; ch < audio_bus_->channels(); ++ch) {
+    for (int i = 0; i < audio_bus_->frames(); ++i)
+      ASSERT_EQ(0.0f, audio_bus_->channel(ch)[i]);
+  }
+}
+
+// Resampling ahead of time on helper threads must produce the same audio as
+// resampling on the rendering thread, as long as the helpers keep up.
+TEST_P(AudioRendererMixerBehavioralTest, ParallelResampling) {
+  scoped_refptr<MockAudioRendererSink> parallel_sink =
+      new MockAudioRendererSink();
+  EXPECT_CALL(*parallel_sink.get(), Start());
+  EXPECT_CALL(*parallel_sink.get(), Stop());
+  AudioRendererMixer parallel_mixer(output_parameters_, parallel_sink,
+                                    base::Bind(&LogUma));
+  parallel_mixer.set_parallel_resampling(true);
+  mixer_->set_parallel_resampling(false);
+
+  // Two sample rates which need resampling, plus one which doesn't.
+  const int kInputRates[] = {kTestInputHigher, 22050, kTestInputLower};
+  std::vector<AudioParameters> params;
+  ScopedVector<FakeAudioRenderCallback> callbacks;
+  ScopedVector<FakeAudioRenderCallback> parallel_callbacks;
+  for (int rate : kInputRates) {
+    params.push_back(AudioParameters(AudioParameters::AUDIO_PCM_LINEAR,
+                                     kChannelLayout, rate, kBitsPerChannel,
+                                     kHighLatencyBufferSize));
+    callbacks.push_back(new FakeAudioRenderCallback(0.01));
+    parallel_callbacks.push_back(new FakeAudioRenderCallback(0.01));
+    mixer_->AddMixerInput(params.back(), callbacks.back());
+    parallel_mixer.AddMixerInput(params.back(), parallel_callbacks.back());
+  }
+
+  std::unique_ptr<AudioBus> parallel_audio_bus =
+      AudioBus::Create(output_parameters_);
+  for (int i = 0; i < kMixerCycles * 4; ++i) {
+    mixer_callback_->Render(audio_bus_.get(), 0, 0);
+    parallel_sink->callback()->Render(parallel_audio_bus.get(), 0, 0);
+    parallel_mixer.FlushParallelResamplingForTesting();
+
+    for (int ch = 0; ch < audio_bus_->channels(); ++ch) {
+      for (int j = 0; j < audio_bus_->frames(); ++j) {
+        ASSERT_FLOAT_EQ(audio_bus_->channel(ch)[j],
+                        parallel_audio_bus->channel(ch)[j])
+            << "buffer=" << i << " ch=" << ch << " frame=" << j;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < params.size(); ++i) {
+    mixer_->RemoveMixerInput(params[i], callbacks[i]);
+    parallel_mixer.RemoveMixerInput(params[i], parallel_callbacks[i]);
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
     AudioRendererMixerTest,
     AudioRendererMixerTest,
@@ -16,6 +16,10 @@ namespace media {
 // unique IDs.
 static base::StaticAtomicSequenceNumber g_media_log_count;
 
+// Number of records buffered before the oldest ones are dropped; must be a
+// power of two.  At 56 bytes a slot this costs ~14KB per MediaLog.
+static const size_t kMaxBufferedRecords = 256;
+
 const char MediaLog::kWatchTimeAudioVideoAll[] =
     "Media.WatchTime.AudioVideo.All";
 const char MediaLog::kWatchTimeAudioVideoMse[] =
@@ -163,7 +167,8 @@ std::string MediaLog::MediaEventToLogString(const MediaLogEvent& event) {
   return EventTypeToString(event.type) + " " + params_json;
 }
 
-MediaLog::MediaLog() : id_(g_media_log_count.GetNext()) {}
+MediaLog::MediaLog()
+    : id_(g_media_log_count.GetNext()), records_(kMaxBufferedRecords) {}
 
 MediaLog::~MediaLog() {}
 
@@ -173,6 +178,10 @@ std::string MediaLog::GetLastErrorMessage() {
   return "";
 }
 
+bool MediaLog::IsObserved() {
+  return false;
+}
+
 void MediaLog::RecordRapporWithSecurityOrigin(const std::string& metric) {
   DVLOG(1) << "Default MediaLog doesn't support rappor reporting.";
 }
@@ -300,6 +309,43 @@ void MediaLog::SetBooleanProperty(
   AddEvent(std::move(event));
 }
 
+void MediaLog::RecordDoubleProperty(const char* key, double value) {
+  MediaLogRecord record;
+  record.key = key;
+  record.time = base::TimeTicks::Now();
+  record.value = value;
+  records_.Push(record);
+}
+
+size_t MediaLog::DrainRecords() {
+  // Converting records costs the allocations they exist to avoid; there's no
+  // point while nobody looks at the events.
+  if (!IsObserved())
+    return 0;
+
+  base::AutoLock auto_lock(drain_lock_);
+  size_t events = 0;
+  MediaLogRecord record;
+  while (records_.Pop(&record)) {
+    AddEvent(CreateEventFromRecord(record));
+    ++events;
+  }
+  return events;
+}
+
+int64_t MediaLog::GetDroppedRecordCount() const {
+  return records_.dropped_records();
+}
+
+std::unique_ptr<MediaLogEvent> MediaLog::CreateEventFromRecord(
+    const MediaLogRecord& record) {
+  std::unique_ptr<MediaLogEvent> event(
+      CreateEvent(MediaLogEvent::PROPERTY_CHANGE));
+  event->params.SetDouble(record.key, record.value);
+  event->time = record.time;
+  return event;
+}
+
 LogHelper::LogHelper(MediaLog::MediaLogLevel level,
                      const scoped_refptr<MediaLog>& media_log)
     : level_(level), media_log_(media_log) {
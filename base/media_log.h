@@ -15,8 +15,10 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
 #include "media/base/media_export.h"
 #include "media/base/media_log_event.h"
+#include "media/base/media_log_ring_buffer.h"
 #include "media/base/pipeline_impl.h"
 #include "media/base/pipeline_status.h"
 
@@ -47,6 +49,12 @@ class MEDIA_EXPORT MediaLog : public base::RefCountedThreadSafe<MediaLog> {
   // Retrieve an error message, if any.
   virtual std::string GetLastErrorMessage();
 
+  // Returns true if something, e.g. chrome://media-internals, is watching the
+  // events passed to AddEvent().  Records are only turned into events while it
+  // is; see DrainRecords().  The default implementation discards all events
+  // and returns false.
+  virtual bool IsObserved();
+
   // Records the domain and registry of the current frame security origin to a
   // Rappor privacy-preserving metric. See:
   //   https://www.chromium.org/developers/design-documents/rappor
@@ -83,6 +91,29 @@ class MEDIA_EXPORT MediaLog : public base::RefCountedThreadSafe<MediaLog> {
   void SetDoubleProperty(const std::string& key, double value);
   void SetBooleanProperty(const std::string& key, bool value);
 
+  // Allocation free counterpart of SetDoubleProperty() for values reported
+  // often, e.g. on every frame statistics update.  |key| must be a string
+  // literal or otherwise outlive the MediaLog.  Records are kept in a fixed size
+  // lock-free ring buffer and are only turned into MediaLogEvents by
+  // DrainRecords(); when it isn't called often enough, or nobody is observing
+  // the log, the oldest records are overwritten.  May be called on any thread.
+  void RecordDoubleProperty(const char* key, double value);
+
+  // If IsObserved(), converts the buffered records, oldest first, into
+  // MediaLogEvents stamped with the time they were recorded and passes them to
+  // AddEvent(); otherwise leaves them in the ring buffer, where they are
+  // eventually overwritten.  Called periodically by the owner of this log, e.g.
+  // WebMediaPlayerImpl.  Returns the number of events added.
+  size_t DrainRecords();
+
+  // Number of records dropped because the ring buffer was full.
+  int64_t GetDroppedRecordCount() const;
+
+  // Converts |record| into the MediaLogEvent AddEvent() would have received
+  // from the equivalent SetDoubleProperty() call.
+  std::unique_ptr<MediaLogEvent> CreateEventFromRecord(
+      const MediaLogRecord& record);
+
   // Histogram names used for reporting; also double as MediaLog key names.
   static const char kWatchTimeAudioVideoAll[];
   static const char kWatchTimeAudioVideoMse[];
@@ -103,6 +134,10 @@ class MEDIA_EXPORT MediaLog : public base::RefCountedThreadSafe<MediaLog> {
   // A unique (to this process) id for this MediaLog.
   int32_t id_;
 
+  // Keeps the events added by concurrent DrainRecords() calls in order.
+  base::Lock drain_lock_;
+  MediaLogRingBuffer records_;
+
   DISALLOW_COPY_AND_ASSIGN(MediaLog);
 };
 
@@ -0,0 +1,74 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/media_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkIterations = 1000000;
+
+// How often the observed benchmark drains records, roughly matching a 60Hz
+// statistics update producing a handful of records per drain.
+static const int kRecordsPerDrain = 8;
+
+static void PrintEventRate(const std::string& trace,
+                           base::TimeTicks start) {
+  perf_test::PrintResult(
+      "media_log", "", trace,
+      kBenchmarkIterations / (base::TimeTicks::Now() - start).InMillisecondsF(),
+      "events/ms", true);
+}
+
+// Stands in for a MediaLog with an observer, which discards the events.
+class ObservedMediaLog : public MediaLog {
+ public:
+  ObservedMediaLog() {}
+
+  void AddEvent(std::unique_ptr<MediaLogEvent> event) override {}
+  bool IsObserved() override { return true; }
+
+ private:
+  ~ObservedMediaLog() override {}
+
+  DISALLOW_COPY_AND_ASSIGN(ObservedMediaLog);
+};
+
+TEST(MediaLogPerfTest, DoubleProperty) {
+  scoped_refptr<MediaLog> media_log(new ObservedMediaLog());
+
+  // Every event allocates a MediaLogEvent and its DictionaryValue.
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkIterations; ++i)
+    media_log->SetDoubleProperty("video_ready_frames_target", i);
+  PrintEventRate("dictionary", start);
+
+  // Records are converted to events in batches, as an observer would.
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    media_log->RecordDoubleProperty("video_ready_frames_target", i);
+    if (i % kRecordsPerDrain == kRecordsPerDrain - 1)
+      media_log->DrainRecords();
+  }
+  PrintEventRate("record_observed", start);
+  EXPECT_EQ(0, media_log->GetDroppedRecordCount());
+
+  // Without draining the ring buffer fills up and records are dropped.
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkIterations; ++i)
+    media_log->RecordDoubleProperty("video_ready_frames_target", i);
+  PrintEventRate("record_unobserved", start);
+  EXPECT_GT(media_log->GetDroppedRecordCount(), 0);
+
+  // Recording never allocates; each record occupies a fixed size slot.
+  perf_test::PrintResult("media_log", "", "record_size",
+                         sizeof(MediaLogRecord), "bytes", true);
+}
+
+}  // namespace media
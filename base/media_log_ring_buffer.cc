@@ -0,0 +1,103 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/media_log_ring_buffer.h"
+
+#include "base/logging.h"
+
+namespace media {
+
+using base::subtle::AtomicWord;
+
+MediaLogRingBuffer::MediaLogRingBuffer(size_t capacity)
+    : mask_(capacity - 1),
+      slots_(new Slot[capacity]),
+      write_position_(0),
+      read_position_(0),
+      dropped_records_(0) {
+  DCHECK_GT(capacity, 0u);
+  DCHECK_EQ(capacity & mask_, 0u) << "capacity must be a power of two";
+  for (size_t i = 0; i < capacity; ++i)
+    base::subtle::NoBarrier_Store(&slots_[i].sequence, i);
+}
+
+MediaLogRingBuffer::~MediaLogRingBuffer() {}
+
+bool MediaLogRingBuffer::Push(const MediaLogRecord& record) {
+  AtomicWord position = base::subtle::NoBarrier_Load(&write_position_);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & mask_];
+    const AtomicWord sequence = base::subtle::Acquire_Load(&slot->sequence);
+    const AtomicWord difference = sequence - position;
+    if (difference == 0) {
+      // The slot is free; try to claim it.
+      const AtomicWord previous = base::subtle::NoBarrier_CompareAndSwap(
+          &write_position_, position, position + 1);
+      if (previous == position)
+        break;
+      position = previous;
+    } else if (difference < 0) {
+      // The slot still holds the oldest record, from the previous lap; we're
+      // full.  Claim that record as a consumer would, which leaves the slot to
+      // us alone: no other producer can claim |position| until its sequence
+      // changes.  If a consumer or another producer has claimed it already,
+      // drop |record| rather than wait for them.
+      const AtomicWord oldest = position - static_cast<AtomicWord>(capacity());
+      if (base::subtle::NoBarrier_CompareAndSwap(&read_position_, oldest,
+                                                 oldest + 1) != oldest) {
+        base::subtle::NoBarrier_AtomicIncrement(&dropped_records_, 1);
+        return false;
+      }
+      base::subtle::NoBarrier_AtomicIncrement(&dropped_records_, 1);
+      const AtomicWord previous = base::subtle::NoBarrier_CompareAndSwap(
+          &write_position_, position, position + 1);
+      DCHECK_EQ(previous, position);
+      break;
+    } else {
+      // Another producer claimed the slot first.
+      position = base::subtle::NoBarrier_Load(&write_position_);
+    }
+  }
+
+  slot->record = record;
+  base::subtle::Release_Store(&slot->sequence, position + 1);
+  return true;
+}
+
+bool MediaLogRingBuffer::Pop(MediaLogRecord* record) {
+  AtomicWord position = base::subtle::NoBarrier_Load(&read_position_);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & mask_];
+    const AtomicWord sequence = base::subtle::Acquire_Load(&slot->sequence);
+    const AtomicWord difference = sequence - (position + 1);
+    if (difference == 0) {
+      // The slot holds a published record; try to claim it.
+      const AtomicWord previous = base::subtle::NoBarrier_CompareAndSwap(
+          &read_position_, position, position + 1);
+      if (previous == position)
+        break;
+      position = previous;
+    } else if (difference < 0) {
+      // Nothing has been published at this position yet.
+      return false;
+    } else {
+      // Another consumer popped the slot first.
+      position = base::subtle::NoBarrier_Load(&read_position_);
+    }
+  }
+
+  *record = slot->record;
+
+  // Hand the slot to the producer of the next lap.
+  base::subtle::Release_Store(&slot->sequence, position + mask_ + 1);
+  return true;
+}
+
+int64_t MediaLogRingBuffer::dropped_records() const {
+  return base::subtle::NoBarrier_Load(&dropped_records_);
+}
+
+}  // namespace media
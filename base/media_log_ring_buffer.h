@@ -0,0 +1,85 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_MEDIA_LOG_RING_BUFFER_H_
+#define MEDIA_BASE_MEDIA_LOG_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/atomicops.h"
+#include "base/gtest_prod_util.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+// A fixed size, allocation free form of a MediaLogEvent::PROPERTY_CHANGE
+// carrying a single numeric property.  Converted into a MediaLogEvent only when
+// the log is drained.
+struct MediaLogRecord {
+  // Name of the property; must have static storage duration.
+  const char* key;
+
+  base::TimeTicks time;
+
+  double value;
+};
+
+// A bounded, lock-free queue of MediaLogRecords.  Any number of threads may
+// Push() and Pop() concurrently without locks or allocations, and neither ever
+// waits for another thread.  When the buffer is full, Push() overwrites the
+// oldest record, so a consumer which falls behind sees the most recent values.
+class MEDIA_EXPORT MediaLogRingBuffer {
+ public:
+  // |capacity| must be a power of two.
+  explicit MediaLogRingBuffer(size_t capacity);
+  ~MediaLogRingBuffer();
+
+  // Appends a copy of |record|.  If the buffer is full the oldest record is
+  // overwritten, unless a consumer is still copying it out; then |record| is
+  // dropped instead and false is returned.  Either way, exactly one record is
+  // lost and counted in dropped_records().
+  bool Push(const MediaLogRecord& record);
+
+  // Removes the oldest record into |record|.  Returns false if there was none.
+  bool Pop(MediaLogRecord* record);
+
+  // Number of records lost to a full buffer so far.
+  int64_t dropped_records() const;
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  FRIEND_TEST_ALL_PREFIXES(MediaLogRingBufferTest,
+                           DropsOneRecordWhileConsumerHoldsOldest);
+
+  // Each slot carries a sequence number telling producers and the consumer
+  // whose turn it is: it equals the write position while the slot is free and
+  // the write position + 1 once the record is published.
+  struct Slot {
+    base::subtle::AtomicWord sequence;
+    MediaLogRecord record;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Next position to be claimed by a producer.
+  base::subtle::AtomicWord write_position_;
+
+  // Next position to be claimed by a consumer.
+  base::subtle::AtomicWord read_position_;
+
+  base::subtle::AtomicWord dropped_records_;
+
+  DISALLOW_COPY_AND_ASSIGN(MediaLogRingBuffer);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_MEDIA_LOG_RING_BUFFER_H_
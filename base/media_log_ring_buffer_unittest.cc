@@ -0,0 +1,226 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/media_log_ring_buffer.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/threading/thread.h"
+#include "media/base/media_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static MediaLogRecord MakeRecord(double value) {
+  MediaLogRecord record;
+  record.key = "value";
+  record.value = value;
+  return record;
+}
+
+TEST(MediaLogRingBufferTest, PopsInOrder) {
+  MediaLogRingBuffer buffer(4);
+  MediaLogRecord record;
+  EXPECT_FALSE(buffer.Pop(&record));
+
+  // Go around the buffer several times.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 3; ++i)
+      EXPECT_TRUE(buffer.Push(MakeRecord(lap * 10 + i)));
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(buffer.Pop(&record));
+      EXPECT_EQ(lap * 10 + i, record.value);
+    }
+    EXPECT_FALSE(buffer.Pop(&record));
+  }
+  EXPECT_EQ(0, buffer.dropped_records());
+}
+
+TEST(MediaLogRingBufferTest, DropsOldestWhenFull) {
+  MediaLogRingBuffer buffer(4);
+  for (int i = 0; i < 6; ++i)
+    EXPECT_TRUE(buffer.Push(MakeRecord(i)));
+  EXPECT_EQ(2, buffer.dropped_records());
+
+  // The newest records are kept, in order.
+  MediaLogRecord record;
+  for (int i = 2; i < 6; ++i) {
+    ASSERT_TRUE(buffer.Pop(&record));
+    EXPECT_EQ(i, record.value);
+  }
+  EXPECT_FALSE(buffer.Pop(&record));
+}
+
+TEST(MediaLogRingBufferTest, DropsOneRecordWhileConsumerHoldsOldest) {
+  const int kCapacity = 4;
+  MediaLogRingBuffer buffer(kCapacity);
+  for (int i = 0; i < kCapacity; ++i)
+    EXPECT_TRUE(buffer.Push(MakeRecord(i)));
+
+  // Stall a consumer right after it claimed the oldest record, before it has
+  // copied it out and released the slot.
+  base::subtle::NoBarrier_Store(&buffer.read_position_, 1);
+
+  // The oldest record can't be overwritten, so the new one is dropped; none of
+  // the records after the one being read are touched.
+  EXPECT_FALSE(buffer.Push(MakeRecord(kCapacity)));
+  EXPECT_EQ(1, buffer.dropped_records());
+
+  // The consumer finishes.
+  base::subtle::Release_Store(&buffer.slots_[0].sequence, kCapacity);
+
+  MediaLogRecord record;
+  for (int i = 1; i < kCapacity; ++i) {
+    ASSERT_TRUE(buffer.Pop(&record));
+    EXPECT_EQ(i, record.value);
+  }
+  EXPECT_FALSE(buffer.Pop(&record));
+  EXPECT_EQ(1, buffer.dropped_records());
+
+  // And the slot is reused.
+  EXPECT_TRUE(buffer.Push(MakeRecord(kCapacity + 1)));
+  ASSERT_TRUE(buffer.Pop(&record));
+  EXPECT_EQ(kCapacity + 1, record.value);
+}
+
+static void PushRecords(MediaLogRingBuffer* buffer, int producer, int count) {
+  for (int i = 0; i < count; ++i)
+    buffer->Push(MakeRecord(producer * count + i));
+}
+
+TEST(MediaLogRingBufferTest, ConcurrentProducers) {
+  const int kProducers = 4;
+  const int kRecordsPerProducer = 1000;
+  const int kCapacity = 8192;
+  static_assert(kCapacity >= kProducers * kRecordsPerProducer, "too small");
+  MediaLogRingBuffer buffer(kCapacity);
+
+  std::vector<std::unique_ptr<base::Thread>> threads;
+  for (int i = 0; i < kProducers; ++i) {
+    threads.emplace_back(new base::Thread("MediaLogProducer"));
+    ASSERT_TRUE(threads.back()->Start());
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&PushRecords, &buffer, i, kRecordsPerProducer));
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+
+  // Every record arrives exactly once, and each producer's records in order.
+  std::vector<int> next_value(kProducers);
+  for (int i = 0; i < kProducers; ++i)
+    next_value[i] = i * kRecordsPerProducer;
+  MediaLogRecord record;
+  int records = 0;
+  while (buffer.Pop(&record)) {
+    const int value = static_cast<int>(record.value);
+    const int producer = value / kRecordsPerProducer;
+    ASSERT_LT(producer, kProducers);
+    EXPECT_EQ(next_value[producer]++, value);
+    ++records;
+  }
+  EXPECT_EQ(kProducers * kRecordsPerProducer, records);
+  EXPECT_EQ(0, buffer.dropped_records());
+}
+
+TEST(MediaLogRingBufferTest, ConcurrentProducersOverflowing) {
+  const int kProducers = 4;
+  const int kRecordsPerProducer = 1000;
+  MediaLogRingBuffer buffer(16);
+
+  std::vector<std::unique_ptr<base::Thread>> threads;
+  for (int i = 0; i < kProducers; ++i) {
+    threads.emplace_back(new base::Thread("MediaLogProducer"));
+    ASSERT_TRUE(threads.back()->Start());
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&PushRecords, &buffer, i, kRecordsPerProducer));
+  }
+  for (auto& thread : threads)
+    thread->Stop();
+
+  // Records are dropped, but never duplicated or reordered.
+  std::vector<int> last_value(kProducers, -1);
+  MediaLogRecord record;
+  int records = 0;
+  while (buffer.Pop(&record)) {
+    const int value = static_cast<int>(record.value);
+    const int producer = value / kRecordsPerProducer;
+    ASSERT_LT(producer, kProducers);
+    EXPECT_LT(last_value[producer], value);
+    last_value[producer] = value;
+    ++records;
+  }
+  EXPECT_LE(records, 16);
+  EXPECT_EQ(kProducers * kRecordsPerProducer,
+            records + buffer.dropped_records());
+}
+
+class RecordingMediaLog : public MediaLog {
+ public:
+  RecordingMediaLog() : observed(true) {}
+
+  void AddEvent(std::unique_ptr<MediaLogEvent> event) override {
+    events.push_back(std::move(event));
+  }
+
+  bool IsObserved() override { return observed; }
+
+  bool observed;
+  std::vector<std::unique_ptr<MediaLogEvent>> events;
+
+ protected:
+  ~RecordingMediaLog() override {}
+};
+
+TEST(MediaLogRingBufferTest, MediaLogConvertsRecordsWhenDrained) {
+  scoped_refptr<RecordingMediaLog> media_log(new RecordingMediaLog());
+  media_log->RecordDoubleProperty("first", 1.5);
+  media_log->RecordDoubleProperty("second", 2.5);
+  EXPECT_TRUE(media_log->events.empty());
+
+  EXPECT_EQ(2u, media_log->DrainRecords());
+  ASSERT_EQ(2u, media_log->events.size());
+
+  double number = 0;
+  EXPECT_EQ(MediaLogEvent::PROPERTY_CHANGE, media_log->events[0]->type);
+  EXPECT_TRUE(media_log->events[0]->params.GetDouble("first", &number));
+  EXPECT_EQ(1.5, number);
+
+  EXPECT_EQ(MediaLogEvent::PROPERTY_CHANGE, media_log->events[1]->type);
+  EXPECT_TRUE(media_log->events[1]->params.GetDouble("second", &number));
+  EXPECT_EQ(2.5, number);
+  EXPECT_LE(media_log->events[0]->time, media_log->events[1]->time);
+
+  EXPECT_EQ(0u, media_log->DrainRecords());
+}
+
+TEST(MediaLogRingBufferTest, MediaLogKeepsRecordsUntilObserved) {
+  scoped_refptr<RecordingMediaLog> media_log(new RecordingMediaLog());
+  media_log->observed = false;
+
+  // Without an observer nothing is converted, and old records make way for
+  // new ones.
+  const int kRecords = 1000;
+  for (int i = 0; i < kRecords; ++i)
+    media_log->RecordDoubleProperty("double", i);
+  EXPECT_EQ(0u, media_log->DrainRecords());
+  EXPECT_TRUE(media_log->events.empty());
+  EXPECT_LT(0, media_log->GetDroppedRecordCount());
+
+  // Once observed, the newest records are drained.
+  media_log->observed = true;
+  const size_t events = media_log->DrainRecords();
+  ASSERT_EQ(events, media_log->events.size());
+  EXPECT_EQ(kRecords, static_cast<int64_t>(events) +
+                          media_log->GetDroppedRecordCount());
+  double number = 0;
+  EXPECT_TRUE(media_log->events.back()->params.GetDouble("double", &number));
+  EXPECT_EQ(kRecords - 1, number);
+}
+
+}  // namespace media
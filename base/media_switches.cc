@@ -10,6 +10,11 @@ namespace switches {
 // Allow users to specify a custom buffer size for debugging purpose.
 const char kAudioBufferSize[] = "audio-buffer-size";
 
+// Default time stretching algorithm used at playback rates other than 1.0; one
+// of "low", "normal" (the default) or "high".  Renderer factories configured
+// with a quality of their own ignore it.
+const char kAudioTimeStretchQuality[] = "audio-time-stretch-quality";
+
 // Set number of threads to use for video decoding.
 const char kVideoThreads[] = "video-threads";
 
@@ -129,12 +134,22 @@ const char kMSEVideoBufferSizeLimit[] = "mse-video-buffer-size-limit";
 
 namespace media {
 
+// Starts playback sooner by initializing the audio and video renderers
+// concurrently and having the demuxer read ahead the first GOP while decoders
+// are being initialized.
+const base::Feature kFastStartPipeline{"FastStartPipeline",
+                                       base::FEATURE_DISABLED_BY_DEFAULT};
+
 #if defined(OS_WIN)
 // Enables H264 HW encode acceleration using Media Foundation for Windows.
 const base::Feature kMediaFoundationH264Encoding{
     "MediaFoundationH264Encoding", base::FEATURE_DISABLED_BY_DEFAULT};
 #endif  // defined(OS_WIN)
 
+// Seeks the demuxer while the renderers flush rather than after they are done.
+const base::Feature kOverlapSeekWithFlush{"OverlapSeekWithFlush",
+                                          base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Use new audio rendering mixer.
 const base::Feature kNewAudioRenderingMixingStrategy{
     "NewAudioRenderingMixingStrategy", base::FEATURE_DISABLED_BY_DEFAULT};
@@ -143,6 +158,11 @@ const base::Feature kNewAudioRenderingMixingStrategy{
 const base::Feature kOverlayFullscreenVideo{"overlay-fullscreen-video",
                                             base::FEATURE_ENABLED_BY_DEFAULT};
 
+// Resample each AudioRendererMixer input sample rate one buffer ahead on
+// real-time helper threads instead of on the audio device thread.
+const base::Feature kParallelAudioMixerResampling{
+    "ParallelAudioMixerResampling", base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Let videos be resumed via remote controls (for example, the notification)
 // when in background.
 const base::Feature kResumeBackgroundVideo {
@@ -162,6 +182,11 @@ const base::Feature kUseNewMediaCache{"use-new-media-cache",
 const base::Feature kVideoColorManagement{"video-color-management",
                                           base::FEATURE_DISABLED_BY_DEFAULT};
 
+// Run all VpxVideoDecoder decodes on TaskScheduler sequences instead of the
+// media thread and per-decoder libvpx threads.
+const base::Feature kVpxSharedDecodePool{"VpxSharedDecodePool",
+                                         base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Enables support for External Clear Key (ECK) key system for testing on
 // supported platforms. On platforms that do not support ECK, this feature has
 // no effect.
@@ -5,19 +5,25 @@
 #include "media/base/pipeline_impl.h"
 
 #include <algorithm>
+#include <map>
+#include <memory>
 
+#include "base/barrier_closure.h"
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
 #include "base/command_line.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/single_thread_task_runner.h"
 #include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "media/base/audio_decoder_config.h"
 #include "media/base/bind_to_current_loop.h"
+#include "media/base/decoder_buffer.h"
 #include "media/base/demuxer.h"
 #include "media/base/media_log.h"
 #include "media/base/media_switches.h"
@@ -34,6 +40,131 @@ static const float kDefaultVolume = 1.0f;
 
 namespace media {
 
+namespace {
+
+// Stands between the renderer and the demuxer streams when seeks overlap the
+// renderer flush.  While closed, new reads are answered with kAborted instead
+// of reaching the demuxer, so the demuxer can be seeked as soon as the reads it
+// was already handed have returned; demuxers don't allow seeking with a read
+// outstanding.
+class SeekReadGate : public DemuxerStreamProvider {
+ public:
+  explicit SeekReadGate(DemuxerStreamProvider* provider)
+      : provider_(provider), closed_(false), pending_reads_(0) {}
+  ~SeekReadGate() override {}
+
+  // DemuxerStreamProvider implementation.
+  DemuxerStream* GetStream(DemuxerStream::Type type) override {
+    DemuxerStream* stream = provider_->GetStream(type);
+    if (!stream)
+      return nullptr;
+
+    std::unique_ptr<GatedStream>& gated_stream = streams_[type];
+    if (!gated_stream)
+      gated_stream.reset(new GatedStream(this, stream));
+    DCHECK_EQ(gated_stream->stream(), stream);
+    return gated_stream.get();
+  }
+  MediaUrlParams GetMediaUrlParams() const override {
+    return provider_->GetMediaUrlParams();
+  }
+  DemuxerStreamProvider::Type GetType() const override {
+    return provider_->GetType();
+  }
+
+  void Close() { closed_ = true; }
+  void Open() {
+    DCHECK(idle_cb_.is_null());
+    closed_ = false;
+  }
+
+  // Runs |idle_cb| once none of the demuxer streams has a read outstanding.
+  // The gate must be closed.
+  void WaitForIdle(const base::Closure& idle_cb) {
+    DCHECK(closed_);
+    DCHECK(idle_cb_.is_null());
+    if (!pending_reads_) {
+      idle_cb.Run();
+      return;
+    }
+    idle_cb_ = idle_cb;
+  }
+
+ private:
+  class GatedStream : public DemuxerStream {
+   public:
+    GatedStream(SeekReadGate* gate, DemuxerStream* stream)
+        : gate_(gate), stream_(stream), weak_factory_(this) {}
+    ~GatedStream() override {}
+
+    DemuxerStream* stream() const { return stream_; }
+
+    // DemuxerStream implementation.
+    void Read(const ReadCB& read_cb) override {
+      if (gate_->closed_) {
+        BindToCurrentLoop(read_cb).Run(kAborted, nullptr);
+        return;
+      }
+      ++gate_->pending_reads_;
+      stream_->Read(base::Bind(&GatedStream::OnReadDone,
+                               weak_factory_.GetWeakPtr(), read_cb));
+    }
+    AudioDecoderConfig audio_decoder_config() override {
+      return stream_->audio_decoder_config();
+    }
+    VideoDecoderConfig video_decoder_config() override {
+      return stream_->video_decoder_config();
+    }
+    Type type() const override { return stream_->type(); }
+    Liveness liveness() const override { return stream_->liveness(); }
+    void EnableBitstreamConverter() override {
+      stream_->EnableBitstreamConverter();
+    }
+    bool SupportsConfigChanges() override {
+      return stream_->SupportsConfigChanges();
+    }
+    VideoRotation video_rotation() override {
+      return stream_->video_rotation();
+    }
+    bool enabled() const override { return stream_->enabled(); }
+    void set_enabled(bool enabled, base::TimeDelta timestamp) override {
+      stream_->set_enabled(enabled, timestamp);
+    }
+    void SetStreamStatusChangeCB(const StreamStatusChangeCB& cb) override {
+      stream_->SetStreamStatusChangeCB(cb);
+    }
+
+   private:
+    void OnReadDone(const ReadCB& read_cb,
+                    Status status,
+                    const scoped_refptr<DecoderBuffer>& buffer) {
+      DCHECK_GT(gate_->pending_reads_, 0);
+      if (!--gate_->pending_reads_ && !gate_->idle_cb_.is_null())
+        base::ResetAndReturn(&gate_->idle_cb_).Run();
+      read_cb.Run(status, buffer);
+    }
+
+    SeekReadGate* const gate_;
+    DemuxerStream* const stream_;
+    base::WeakPtrFactory<GatedStream> weak_factory_;
+
+    DISALLOW_COPY_AND_ASSIGN(GatedStream);
+  };
+
+  DemuxerStreamProvider* const provider_;
+  std::map<DemuxerStream::Type, std::unique_ptr<GatedStream>> streams_;
+
+  bool closed_;
+
+  // Number of reads handed to the demuxer streams which haven't returned yet.
+  int pending_reads_;
+  base::Closure idle_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(SeekReadGate);
+};
+
+}  // namespace
+
 class PipelineImpl::RendererWrapper : public DemuxerHost,
                                       public RendererClient {
  public:
@@ -132,6 +263,11 @@ class PipelineImpl::RendererWrapper : public DemuxerHost,
   void SetState(State next_state);
   void CompleteSeek(base::TimeDelta seek_time, PipelineStatus status);
   void CompleteSuspend(PipelineStatus status);
+  void FlushAndSeekDemuxer(base::TimeDelta seek_time,
+                           const PipelineStatusCB& done_cb);
+  void SeekDemuxer(base::TimeDelta seek_time, const base::Closure& barrier);
+  void OnDemuxerSeekDone(const base::Closure& barrier, PipelineStatus status);
+  void OnFlushAndSeekDone(const PipelineStatusCB& done_cb);
   void InitializeDemuxer(const PipelineStatusCB& done_cb);
   void InitializeRenderer(const PipelineStatusCB& done_cb);
   void DestroyRenderer();
@@ -148,6 +284,10 @@ class PipelineImpl::RendererWrapper : public DemuxerHost,
   float volume_;
   CdmContext* cdm_context_;
 
+  // Handed to the renderer in place of |demuxer_| when seeks overlap the
+  // renderer flush; see FlushAndSeekDemuxer().  Outlives the renderer.
+  std::unique_ptr<SeekReadGate> read_gate_;
+
   // Lock used to serialize |shared_state_|.
   mutable base::Lock shared_state_lock_;
 
@@ -170,6 +310,9 @@ class PipelineImpl::RendererWrapper : public DemuxerHost,
   // Series of tasks to Start(), Seek(), and Resume().
   std::unique_ptr<SerialRunner> pending_callbacks_;
 
+  // Result of the demuxer seek issued by FlushAndSeekDemuxer().
+  PipelineStatus demuxer_seek_status_;
+
   base::WeakPtr<RendererWrapper> weak_this_;
   base::WeakPtrFactory<RendererWrapper> weak_factory_;
   DISALLOW_COPY_AND_ASSIGN(RendererWrapper);
@@ -189,6 +332,7 @@ PipelineImpl::RendererWrapper::RendererWrapper(
       status_(PIPELINE_OK),
       renderer_ended_(false),
       text_renderer_ended_(false),
+      demuxer_seek_status_(PIPELINE_OK),
       weak_factory_(this) {
   weak_this_ = weak_factory_.GetWeakPtr();
   media_log_->AddEvent(media_log_->CreatePipelineStateChangedEvent(kCreated));
@@ -320,20 +464,25 @@ void PipelineImpl::RendererWrapper::Seek(base::TimeDelta time) {
                               base::Unretained(text_renderer_.get())));
   }
 
-  // Flush.
   DCHECK(shared_state_.renderer);
-  bound_fns.Push(base::Bind(&Renderer::Flush,
-                            base::Unretained(shared_state_.renderer.get())));
-
-  if (text_renderer_) {
-    bound_fns.Push(base::Bind(&TextRenderer::Flush,
-                              base::Unretained(text_renderer_.get())));
+  if (read_gate_ && !text_renderer_) {
+    bound_fns.Push(base::Bind(&RendererWrapper::FlushAndSeekDemuxer,
+                              weak_this_, seek_timestamp));
+  } else {
+    // Flush.
+    bound_fns.Push(base::Bind(&Renderer::Flush,
+                              base::Unretained(shared_state_.renderer.get())));
+
+    if (text_renderer_) {
+      bound_fns.Push(base::Bind(&TextRenderer::Flush,
+                                base::Unretained(text_renderer_.get())));
+    }
+
+    // Seek demuxer.
+    bound_fns.Push(
+        base::Bind(&Demuxer::Seek, base::Unretained(demuxer_), seek_timestamp));
   }
 
-  // Seek demuxer.
-  bound_fns.Push(
-      base::Bind(&Demuxer::Seek, base::Unretained(demuxer_), seek_timestamp));
-
   // Run tasks.
   pending_callbacks_ = SerialRunner::Run(
       bound_fns,
@@ -617,6 +766,16 @@ void PipelineImpl::RendererWrapper::OnStatisticsUpdate(
   shared_state_.statistics.video_frames_dropped += stats.video_frames_dropped;
   shared_state_.statistics.audio_memory_usage += stats.audio_memory_usage;
   shared_state_.statistics.video_memory_usage += stats.video_memory_usage;
+  shared_state_.statistics.audio_time_stretch_us +=
+      stats.audio_time_stretch_us;
+  shared_state_.statistics.video_decode_ahead_depth +=
+      stats.video_decode_ahead_depth;
+  shared_state_.statistics.video_ready_frames_target +=
+      stats.video_ready_frames_target;
+  shared_state_.statistics.audio_latency_p50_us += stats.audio_latency_p50_us;
+  shared_state_.statistics.audio_latency_p99_us += stats.audio_latency_p99_us;
+  shared_state_.statistics.video_latency_p50_us += stats.video_latency_p50_us;
+  shared_state_.statistics.video_latency_p99_us += stats.video_latency_p99_us;
 }
 
 void PipelineImpl::RendererWrapper::OnBufferingStateChange(
@@ -748,6 +907,53 @@ void PipelineImpl::RendererWrapper::SetState(State next_state) {
   media_log_->AddEvent(media_log_->CreatePipelineStateChangedEvent(next_state));
 }
 
+void PipelineImpl::RendererWrapper::FlushAndSeekDemuxer(
+    base::TimeDelta seek_time,
+    const PipelineStatusCB& done_cb) {
+  DCHECK(media_task_runner_->BelongsToCurrentThread());
+  DCHECK_EQ(state_, kSeeking);
+
+  DCHECK(read_gate_);
+  DCHECK(!text_renderer_);
+
+  // The renderer may still issue reads while it flushes, and the demuxer can't
+  // seek while one is outstanding.  Answer new reads with kAborted, abort the
+  // ones the demuxer already has, and seek once they have all come back; the
+  // decoders drain in the meantime.
+  read_gate_->Close();
+  demuxer_->AbortPendingReads();
+
+  demuxer_seek_status_ = PIPELINE_OK;
+  const base::Closure barrier = base::BarrierClosure(
+      2, base::Bind(&RendererWrapper::OnFlushAndSeekDone, weak_this_, done_cb));
+
+  shared_state_.renderer->Flush(barrier);
+  read_gate_->WaitForIdle(base::Bind(&RendererWrapper::SeekDemuxer, weak_this_,
+                                     seek_time, barrier));
+}
+
+void PipelineImpl::RendererWrapper::SeekDemuxer(base::TimeDelta seek_time,
+                                                const base::Closure& barrier) {
+  DCHECK(media_task_runner_->BelongsToCurrentThread());
+  demuxer_->Seek(seek_time, base::Bind(&RendererWrapper::OnDemuxerSeekDone,
+                                       weak_this_, barrier));
+}
+
+void PipelineImpl::RendererWrapper::OnDemuxerSeekDone(
+    const base::Closure& barrier,
+    PipelineStatus status) {
+  DCHECK(media_task_runner_->BelongsToCurrentThread());
+  demuxer_seek_status_ = status;
+  barrier.Run();
+}
+
+void PipelineImpl::RendererWrapper::OnFlushAndSeekDone(
+    const PipelineStatusCB& done_cb) {
+  DCHECK(media_task_runner_->BelongsToCurrentThread());
+  read_gate_->Open();
+  done_cb.Run(demuxer_seek_status_);
+}
+
 void PipelineImpl::RendererWrapper::CompleteSeek(base::TimeDelta seek_time,
                                                  PipelineStatus status) {
   DCHECK(media_task_runner_->BelongsToCurrentThread());
@@ -802,6 +1008,12 @@ void PipelineImpl::RendererWrapper::CompleteSuspend(PipelineStatus status) {
     base::AutoLock auto_lock(shared_state_lock_);
     shared_state_.statistics.audio_memory_usage = 0;
     shared_state_.statistics.video_memory_usage = 0;
+    shared_state_.statistics.video_decode_ahead_depth = 0;
+    shared_state_.statistics.video_ready_frames_target = 0;
+    shared_state_.statistics.audio_latency_p50_us = 0;
+    shared_state_.statistics.audio_latency_p99_us = 0;
+    shared_state_.statistics.video_latency_p50_us = 0;
+    shared_state_.statistics.video_latency_p99_us = 0;
   }
 
   // Abort any reads the renderer may have kicked off.
@@ -847,7 +1059,14 @@ void PipelineImpl::RendererWrapper::InitializeRenderer(
     shared_state_.renderer->SetCdm(cdm_context_,
                                    base::Bind(&IgnoreCdmAttached));
 
-  shared_state_.renderer->Initialize(demuxer_, this, done_cb);
+  DemuxerStreamProvider* demuxer_stream_provider = demuxer_;
+  read_gate_.reset();
+  if (base::FeatureList::IsEnabled(kOverlapSeekWithFlush)) {
+    read_gate_.reset(new SeekReadGate(demuxer_));
+    demuxer_stream_provider = read_gate_.get();
+  }
+
+  shared_state_.renderer->Initialize(demuxer_stream_provider, this, done_cb);
 }
 
 void PipelineImpl::RendererWrapper::DestroyRenderer() {
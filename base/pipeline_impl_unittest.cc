@@ -16,6 +16,7 @@
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/stl_util.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "base/threading/simple_thread.h"
 #include "base/threading/thread_task_runner_handle.h"
@@ -23,6 +24,7 @@
 #include "media/base/fake_text_track_stream.h"
 #include "media/base/gmock_callback_support.h"
 #include "media/base/media_log.h"
+#include "media/base/media_switches.h"
 #include "media/base/mock_filters.h"
 #include "media/base/test_helpers.h"
 #include "media/base/text_renderer.h"
@@ -523,6 +525,79 @@ TEST_F(PipelineImplTest, Seek) {
   DoSeek(expected);
 }
 
+static void SaveReadStatus(std::vector<DemuxerStream::Status>* statuses,
+                           DemuxerStream::Status status,
+                           const scoped_refptr<DecoderBuffer>& buffer) {
+  statuses->push_back(status);
+}
+
+TEST_F(PipelineImplTest, OverlappedSeekWaitsForPendingReads) {
+  base::test::ScopedFeatureList scoped_feature_list;
+  scoped_feature_list.InitAndEnableFeature(kOverlapSeekWithFlush);
+
+  CreateAudioStream();
+  MockDemuxerStreamVector streams;
+  streams.push_back(audio_stream());
+  SetDemuxerExpectations(&streams);
+
+  DemuxerStreamProvider* demuxer_stream_provider = nullptr;
+  EXPECT_CALL(*renderer_, Initialize(_, _, _))
+      .WillOnce(DoAll(SaveArg<0>(&demuxer_stream_provider),
+                      SaveArg<1>(&renderer_client_),
+                      PostCallback<2>(PIPELINE_OK)));
+  EXPECT_CALL(*renderer_, HasAudio()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*renderer_, HasVideo()).WillRepeatedly(Return(false));
+  StartPipelineAndExpect(PIPELINE_OK);
+
+  // The renderer has a read outstanding on the demuxer when the seek starts.
+  DemuxerStream* stream =
+      demuxer_stream_provider->GetStream(DemuxerStream::AUDIO);
+  ASSERT_TRUE(stream);
+  std::vector<DemuxerStream::Status> statuses;
+  DemuxerStream::ReadCB pending_read_cb;
+  EXPECT_CALL(*audio_stream(), Read(_))
+      .WillOnce(SaveArg<0>(&pending_read_cb));
+  stream->Read(base::Bind(&SaveReadStatus, &statuses));
+
+  base::Closure flush_cb;
+  const base::TimeDelta seek_time = base::TimeDelta::FromSeconds(5);
+  EXPECT_CALL(*demuxer_, AbortPendingReads()).Times(2);
+  EXPECT_CALL(*renderer_, Flush(_))
+      .WillOnce(
+          DoAll(SetBufferingState(&renderer_client_, BUFFERING_HAVE_NOTHING),
+                SaveArg<0>(&flush_cb)));
+  EXPECT_CALL(callbacks_, OnBufferingStateChange(BUFFERING_HAVE_NOTHING));
+  DoSeek(seek_time);
+  ASSERT_FALSE(flush_cb.is_null());
+
+  // Reads issued while flushing are aborted without reaching the demuxer, and
+  // the demuxer isn't seeked while the earlier read is outstanding.
+  stream->Read(base::Bind(&SaveReadStatus, &statuses));
+  base::RunLoop().RunUntilIdle();
+  ASSERT_EQ(1u, statuses.size());
+  EXPECT_EQ(DemuxerStream::kAborted, statuses[0]);
+
+  // Once it returns the demuxer seeks, overlapping the renderer flush.
+  EXPECT_CALL(*demuxer_, Seek(seek_time, _))
+      .WillOnce(RunCallback<1>(PIPELINE_OK));
+  pending_read_cb.Run(DemuxerStream::kAborted, nullptr);
+  ASSERT_EQ(2u, statuses.size());
+  EXPECT_EQ(DemuxerStream::kAborted, statuses[1]);
+
+  EXPECT_CALL(*renderer_, SetPlaybackRate(_));
+  EXPECT_CALL(*renderer_, SetVolume(_));
+  EXPECT_CALL(*renderer_, StartPlayingFrom(seek_time))
+      .WillOnce(SetBufferingState(&renderer_client_, BUFFERING_HAVE_ENOUGH));
+  EXPECT_CALL(callbacks_, OnSeek(PIPELINE_OK));
+  EXPECT_CALL(callbacks_, OnBufferingStateChange(BUFFERING_HAVE_ENOUGH));
+  flush_cb.Run();
+  base::RunLoop().RunUntilIdle();
+
+  // Reads reach the demuxer again after the seek.
+  EXPECT_CALL(*audio_stream(), Read(_));
+  stream->Read(base::Bind(&SaveReadStatus, &statuses));
+}
+
 TEST_F(PipelineImplTest, SeekAfterError) {
   CreateAudioStream();
   MockDemuxerStreamVector streams;
@@ -0,0 +1,158 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/pipeline_latency_histograms.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/bits.h"
+#include "base/logging.h"
+
+namespace media {
+
+// Number of buckets each power of two is split into.
+static const int kSubBucketBits = 3;
+static const int kSubBuckets = 1 << kSubBucketBits;
+
+// Latencies are clamped to just below 2^kMaxLatencyBits microseconds.
+static const int kMaxLatencyBits = 28;
+
+// How often GetTotalPercentileChanges() reports.
+static const int kReportIntervalSeconds = 1;
+
+LatencyHistogram::LatencyHistogram() {
+  static_assert((kMaxLatencyBits - kSubBucketBits + 1) * kSubBuckets ==
+                    kBucketCount,
+                "kBucketCount doesn't cover kMaxLatencyBits");
+  for (int i = 0; i < kBucketCount; ++i)
+    base::subtle::NoBarrier_Store(&buckets_[i], 0);
+}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+void LatencyHistogram::AddSample(base::TimeDelta latency) {
+  const int64_t microseconds = std::min(
+      std::max<int64_t>(latency.InMicroseconds(), 0),
+      (INT64_C(1) << kMaxLatencyBits) - 1);
+  base::subtle::NoBarrier_AtomicIncrement(
+      &buckets_[BucketForMicroseconds(microseconds)], 1);
+}
+
+int64_t LatencyHistogram::GetCount() const {
+  int64_t count = 0;
+  for (int i = 0; i < kBucketCount; ++i)
+    count += base::subtle::NoBarrier_Load(&buckets_[i]);
+  return count;
+}
+
+base::TimeDelta LatencyHistogram::GetPercentile(double percentile) const {
+  DCHECK_GE(percentile, 0);
+  DCHECK_LE(percentile, 100);
+
+  // Take a snapshot, since samples may be added concurrently.
+  int64_t counts[kBucketCount];
+  int64_t total = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    counts[i] = base::subtle::NoBarrier_Load(&buckets_[i]);
+    total += counts[i];
+  }
+  if (!total)
+    return base::TimeDelta();
+
+  const int64_t rank = std::max<int64_t>(
+      static_cast<int64_t>(std::ceil(total * percentile / 100)), 1);
+  int64_t seen = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return base::TimeDelta::FromMicroseconds(
+          BucketMidpointInMicroseconds(i));
+    }
+  }
+
+  NOTREACHED();
+  return base::TimeDelta();
+}
+
+// static
+int LatencyHistogram::BucketForMicroseconds(int64_t microseconds) {
+  DCHECK_GE(microseconds, 0);
+  DCHECK_LT(microseconds, INT64_C(1) << kMaxLatencyBits);
+
+  // Small values get a bucket each.
+  if (microseconds < 2 * kSubBuckets)
+    return static_cast<int>(microseconds);
+
+  // Otherwise the top bit selects the power of two and the kSubBucketBits
+  // below it the bucket within.
+  const int top_bit =
+      base::bits::Log2Floor(static_cast<uint32_t>(microseconds));
+  const int sub_bucket =
+      (microseconds >> (top_bit - kSubBucketBits)) & (kSubBuckets - 1);
+  return (top_bit - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+// static
+int64_t LatencyHistogram::BucketMidpointInMicroseconds(int bucket) {
+  if (bucket < 2 * kSubBuckets)
+    return bucket;
+
+  const int shift = bucket / kSubBuckets - 1;
+  const int64_t lower = static_cast<int64_t>(kSubBuckets + bucket % kSubBuckets)
+                        << shift;
+  return lower + ((INT64_C(1) << shift) / 2);
+}
+
+// static
+const char* PipelineLatencyHistograms::GetStageName(Stage stage) {
+  switch (stage) {
+    case DEMUXER_READ:
+      return "demuxer_read";
+    case DECRYPT:
+      return "decrypt";
+    case DECODE:
+      return "decode";
+    case OUTPUT_QUEUE:
+      return "output_queue";
+    case READY_QUEUE:
+      return "ready_queue";
+  }
+  NOTREACHED();
+  return "";
+}
+
+PipelineLatencyHistograms::PipelineLatencyHistograms() {}
+
+PipelineLatencyHistograms::~PipelineLatencyHistograms() {}
+
+base::TimeDelta PipelineLatencyHistograms::GetTotalPercentile(
+    double percentile) const {
+  base::TimeDelta total;
+  for (const LatencyHistogram& histogram : histograms_)
+    total += histogram.GetPercentile(percentile);
+  return total;
+}
+
+bool PipelineLatencyHistograms::GetTotalPercentileChanges(
+    base::TimeTicks now,
+    int64_t* p50_change_us,
+    int64_t* p99_change_us) {
+  if (!last_report_time_.is_null() &&
+      now - last_report_time_ <
+          base::TimeDelta::FromSeconds(kReportIntervalSeconds)) {
+    return false;
+  }
+  last_report_time_ = now;
+
+  const base::TimeDelta p50 = GetTotalPercentile(50);
+  const base::TimeDelta p99 = GetTotalPercentile(99);
+  *p50_change_us = (p50 - last_reported_p50_).InMicroseconds();
+  *p99_change_us = (p99 - last_reported_p99_).InMicroseconds();
+  last_reported_p50_ = p50;
+  last_reported_p99_ = p99;
+  return true;
+}
+
+}  // namespace media
@@ -0,0 +1,109 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_PIPELINE_LATENCY_HISTOGRAMS_H_
+#define MEDIA_BASE_PIPELINE_LATENCY_HISTOGRAMS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+// A histogram of latencies which may be added to from any thread without locks.
+// Buckets are exact below 16us and then split each power of two into eight, so
+// percentiles are accurate to within ~6%.  Latencies above ~4 minutes are
+// clamped.
+class MEDIA_EXPORT LatencyHistogram {
+ public:
+  LatencyHistogram();
+  ~LatencyHistogram();
+
+  void AddSample(base::TimeDelta latency);
+
+  // Returns the number of samples added so far.
+  int64_t GetCount() const;
+
+  // Returns an estimate of the latency below which |percentile| percent of the
+  // samples fall, or zero if there are no samples.
+  base::TimeDelta GetPercentile(double percentile) const;
+
+ private:
+  enum { kBucketCount = 208 };
+
+  static int BucketForMicroseconds(int64_t microseconds);
+  static int64_t BucketMidpointInMicroseconds(int bucket);
+
+  base::subtle::Atomic32 buckets_[kBucketCount];
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyHistogram);
+};
+
+// Per-buffer latency of each stage a stream's buffers pass through, from being
+// read from the demuxer to being rendered.  Cheap enough to always be enabled:
+// each sample is a couple of atomic operations on the thread that measured it.
+class MEDIA_EXPORT PipelineLatencyHistograms
+    : public base::RefCountedThreadSafe<PipelineLatencyHistograms> {
+ public:
+  enum Stage {
+    // DemuxerStream::Read() until the buffer arrives at the DecoderStream;
+    // includes DECRYPT for encrypted streams.
+    DEMUXER_READ,
+    // Submitting an encrypted buffer to the Decryptor until it is decrypted.
+    DECRYPT,
+    // Submitting a buffer to the decoder until its decode completes.
+    DECODE,
+    // Decoder output until it is read by the renderer.
+    OUTPUT_QUEUE,
+    // The renderer's queue of decoded frames until the frame is rendered.
+    READY_QUEUE,
+    STAGE_MAX = READY_QUEUE,
+  };
+
+  static const char* GetStageName(Stage stage);
+
+  PipelineLatencyHistograms();
+
+  void AddSample(Stage stage, base::TimeDelta latency) {
+    histograms_[stage].AddSample(latency);
+  }
+
+  const LatencyHistogram& histogram(Stage stage) const {
+    return histograms_[stage];
+  }
+
+  // Returns an estimate of the |percentile| latency from demuxer read to
+  // render: the sum of that percentile over all stages.
+  base::TimeDelta GetTotalPercentile(double percentile) const;
+
+  // For filling in PipelineStatistics, which carries the change of the 50th
+  // and 99th percentile total latency since the previous update.  Returns false
+  // if less than a second has passed since the last update, leaving the out
+  // parameters untouched.  Must not be called by multiple threads at once.
+  bool GetTotalPercentileChanges(base::TimeTicks now,
+                                 int64_t* p50_change_us,
+                                 int64_t* p99_change_us);
+
+ private:
+  friend class base::RefCountedThreadSafe<PipelineLatencyHistograms>;
+  ~PipelineLatencyHistograms();
+
+  LatencyHistogram histograms_[STAGE_MAX + 1];
+
+  // State of GetTotalPercentileChanges().
+  base::TimeTicks last_report_time_;
+  base::TimeDelta last_reported_p50_;
+  base::TimeDelta last_reported_p99_;
+
+  DISALLOW_COPY_AND_ASSIGN(PipelineLatencyHistograms);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_PIPELINE_LATENCY_HISTOGRAMS_H_
@@ -0,0 +1,89 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/pipeline_latency_histograms.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+// Percentiles are accurate to within one bucket, 1/16th of the value.
+static void ExpectNear(base::TimeDelta expected, base::TimeDelta actual) {
+  EXPECT_NEAR(expected.InMicroseconds(), actual.InMicroseconds(),
+              expected.InMicroseconds() / 16)
+      << "expected " << expected << ", got " << actual;
+}
+
+TEST(LatencyHistogramTest, Empty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.GetCount());
+  EXPECT_EQ(base::TimeDelta(), histogram.GetPercentile(50));
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 16; ++i)
+    histogram.AddSample(base::TimeDelta::FromMicroseconds(i));
+  EXPECT_EQ(16, histogram.GetCount());
+  EXPECT_EQ(base::TimeDelta(), histogram.GetPercentile(0));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(7), histogram.GetPercentile(50));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(15),
+            histogram.GetPercentile(100));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+
+  // 1ms to 100ms in 1ms steps.
+  for (int i = 1; i <= 100; ++i)
+    histogram.AddSample(base::TimeDelta::FromMilliseconds(i));
+  EXPECT_EQ(100, histogram.GetCount());
+  ExpectNear(base::TimeDelta::FromMilliseconds(1), histogram.GetPercentile(0));
+  ExpectNear(base::TimeDelta::FromMilliseconds(50),
+             histogram.GetPercentile(50));
+  ExpectNear(base::TimeDelta::FromMilliseconds(99),
+             histogram.GetPercentile(99));
+}
+
+TEST(LatencyHistogramTest, OutOfRangeValuesAreClamped) {
+  LatencyHistogram histogram;
+  histogram.AddSample(-base::TimeDelta::FromSeconds(1));
+  EXPECT_EQ(base::TimeDelta(), histogram.GetPercentile(100));
+
+  histogram.AddSample(base::TimeDelta::FromHours(1));
+  EXPECT_EQ(2, histogram.GetCount());
+  ExpectNear(base::TimeDelta::FromMicroseconds(1 << 28),
+             histogram.GetPercentile(100));
+}
+
+TEST(PipelineLatencyHistogramsTest, TotalPercentileChanges) {
+  scoped_refptr<PipelineLatencyHistograms> histograms(
+      new PipelineLatencyHistograms());
+  histograms->AddSample(PipelineLatencyHistograms::DECODE,
+                        base::TimeDelta::FromMilliseconds(10));
+  histograms->AddSample(PipelineLatencyHistograms::READY_QUEUE,
+                        base::TimeDelta::FromMilliseconds(40));
+  ExpectNear(base::TimeDelta::FromMilliseconds(50),
+             histograms->GetTotalPercentile(50));
+
+  base::TimeTicks now = base::TimeTicks() + base::TimeDelta::FromSeconds(1);
+  int64_t p50 = 0;
+  int64_t p99 = 0;
+  ASSERT_TRUE(histograms->GetTotalPercentileChanges(now, &p50, &p99));
+  EXPECT_EQ(histograms->GetTotalPercentile(50).InMicroseconds(), p50);
+  EXPECT_EQ(histograms->GetTotalPercentile(99).InMicroseconds(), p99);
+
+  // Reports are rate limited.
+  histograms->AddSample(PipelineLatencyHistograms::DEMUXER_READ,
+                        base::TimeDelta::FromMilliseconds(20));
+  now += base::TimeDelta::FromMilliseconds(500);
+  EXPECT_FALSE(histograms->GetTotalPercentileChanges(now, &p50, &p99));
+
+  now += base::TimeDelta::FromMilliseconds(500);
+  ASSERT_TRUE(histograms->GetTotalPercentileChanges(now, &p50, &p99));
+  ExpectNear(base::TimeDelta::FromMilliseconds(20),
+             base::TimeDelta::FromMicroseconds(p50));
+}
+
+}  // namespace media
@@ -59,6 +59,18 @@ struct PipelineStatistics {
   uint32_t video_frames_dropped = 0;
   int64_t audio_memory_usage = 0;
   int64_t video_memory_usage = 0;
+  // Time spent time stretching audio at playback rates other than 1.0.
+  int64_t audio_time_stretch_us = 0;
+  // Current decode-ahead limits of the video renderer.  Like the memory usage
+  // these are levels, hence updates carry the change since the last update.
+  int32_t video_decode_ahead_depth = 0;
+  int32_t video_ready_frames_target = 0;
+  // Estimated 50th and 99th percentile time from demuxer read to render, see
+  // PipelineLatencyHistograms.  Also levels sent as changes.
+  int64_t audio_latency_p50_us = 0;
+  int64_t audio_latency_p99_us = 0;
+  int64_t video_latency_p50_us = 0;
+  int64_t video_latency_p99_us = 0;
 };
 
 // Used for updating pipeline statistics; the passed value should be a delta
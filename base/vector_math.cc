@@ -23,15 +23,20 @@
 #define FMUL_FUNC FMUL_C
 #endif
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
+// Reductions are not auto-vectorized without relaxed floating point semantics,
+// so the SSE version is used with clang as well.
+#define DotProduct_FUNC DotProduct_SSE
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
 #define FMAC_FUNC FMAC_NEON
 #define FMUL_FUNC FMUL_NEON
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_NEON
+#define DotProduct_FUNC DotProduct_NEON
 #else
 #define FMAC_FUNC FMAC_C
 #define FMUL_FUNC FMUL_C
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_C
+#define DotProduct_FUNC DotProduct_C
 #endif
 
 namespace media {
@@ -89,6 +94,17 @@ std::pair<float, float> EWMAAndMaxPower_C(
   return result;
 }
 
+float DotProduct(const float a[], const float b[], int len) {
+  return DotProduct_FUNC(a, b, len);
+}
+
+float DotProduct_C(const float a[], const float b[], int len) {
+  float sum = 0;
+  for (int i = 0; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
+
 #if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
 void FMUL_SSE(const float src[], float scale, int len, float dest[]) {
   const int rem = len % 4;
@@ -192,6 +208,26 @@ std::pair<float, float> EWMAAndMaxPower_SSE(
 
   return result;
 }
+
+float DotProduct_SSE(const float a[], const float b[], int len) {
+  const int rem = len % 4;
+  const int last_index = len - rem;
+  __m128 m_sum = _mm_setzero_ps();
+  for (int i = 0; i < last_index; i += 4) {
+    m_sum = _mm_add_ps(
+        m_sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+
+  // Fold the four partial sums together.
+  m_sum = _mm_add_ps(m_sum, _mm_movehl_ps(m_sum, m_sum));
+  m_sum = _mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1));
+  float sum = _mm_cvtss_f32(m_sum);
+
+  // Handle any remaining values that wouldn't fit in an SSE pass.
+  for (int i = last_index; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -285,6 +321,24 @@ std::pair<float, float> EWMAAndMaxPower_NEON(
 
   return result;
 }
+
+float DotProduct_NEON(const float a[], const float b[], int len) {
+  const int rem = len % 4;
+  const int last_index = len - rem;
+  float32x4_t m_sum = vdupq_n_f32(0.0f);
+  for (int i = 0; i < last_index; i += 4)
+    m_sum = vmlaq_f32(m_sum, vld1q_f32(a + i), vld1q_f32(b + i));
+
+  // Fold the four partial sums together.
+  float32x2_t sum_x2 = vadd_f32(vget_low_f32(m_sum), vget_high_f32(m_sum));
+  sum_x2 = vpadd_f32(sum_x2, sum_x2);
+  float sum = vget_lane_f32(sum_x2, 0);
+
+  // Handle any remaining values that wouldn't fit in an NEON pass.
+  for (int i = last_index; i < len; ++i)
+    sum += a[i] * b[i];
+  return sum;
+}
 #endif
 
 }  // namespace vector_math
@@ -33,6 +33,10 @@ MEDIA_EXPORT void FMUL(const float src[], float scale, int len, float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower(
     float initial_value, const float src[], int len, float smoothing_factor);
 
+// Returns the sum of the element-wise products of |a| and |b| (up to |len|).
+// Unlike the other functions, |a| and |b| need not be aligned.
+MEDIA_EXPORT float DotProduct(const float a[], const float b[], int len);
+
 MEDIA_EXPORT void Crossfade(const float src[], int len, float dest[]);
 
 }  // namespace vector_math
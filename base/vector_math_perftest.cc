@@ -75,6 +75,25 @@ class VectorMathPerfTest : public testing::Test {
                            true);
   }
 
+  void RunBenchmark(float (*fn)(const float[], const float[], int),
+                    bool aligned,
+                    const std::string& test_name,
+                    const std::string& trace_name) {
+    TimeTicks start = TimeTicks::Now();
+    for (int i = 0; i < kBenchmarkIterations; ++i) {
+      fn(input_vector_.get() + (aligned ? 0 : 1), output_vector_.get(),
+         kVectorSize - 1);
+    }
+    double total_time_milliseconds =
+        (TimeTicks::Now() - start).InMillisecondsF();
+    perf_test::PrintResult(test_name,
+                           "",
+                           trace_name,
+                           kBenchmarkIterations / total_time_milliseconds,
+                           "runs/ms",
+                           true);
+  }
+
  protected:
   std::unique_ptr<float, base::AlignedFreeDeleter> input_vector_;
   std::unique_ptr<float, base::AlignedFreeDeleter> output_vector_;
@@ -87,10 +106,12 @@ class VectorMathPerfTest : public testing::Test {
 #define FMAC_FUNC FMAC_SSE
 #define FMUL_FUNC FMUL_SSE
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
+#define DotProduct_FUNC DotProduct_SSE
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #define FMAC_FUNC FMAC_NEON
 #define FMUL_FUNC FMUL_NEON
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_NEON
+#define DotProduct_FUNC DotProduct_NEON
 #endif
 
 // Benchmark for each optimized vector_math::FMAC() method.
@@ -156,4 +177,19 @@ TEST_F(VectorMathPerfTest, EWMAAndMaxPower) {
 #endif
 }
 
+// Benchmark for each optimized vector_math::DotProduct() method.
+TEST_F(VectorMathPerfTest, DotProduct) {
+  // Benchmark DotProduct_C().
+  RunBenchmark(
+      vector_math::DotProduct_C, true, "vector_math_dot_product", "unoptimized");
+#if defined(DotProduct_FUNC)
+  // Benchmark DotProduct_FUNC() with an unaligned input, as used by WSOLA.
+  RunBenchmark(vector_math::DotProduct_FUNC, false, "vector_math_dot_product",
+               "optimized_unaligned");
+  // Benchmark DotProduct_FUNC() with aligned inputs.
+  RunBenchmark(vector_math::DotProduct_FUNC, true, "vector_math_dot_product",
+               "optimized_aligned");
+#endif
+}
+
 } // namespace media
@@ -138,6 +138,64 @@ TEST_F(VectorMathTest, FMUL) {
 #endif
 }
 
+// Ensure each optimized vector_math::DotProduct() method returns the same value
+// for aligned and unaligned inputs.
+TEST_F(VectorMathTest, DotProduct) {
+  FillTestVectors(kInputFillValue, kOutputFillValue);
+  static const float kResult =
+      kInputFillValue * kOutputFillValue * kVectorSize;
+  static const float kUnalignedResult =
+      kInputFillValue * kOutputFillValue * (kVectorSize - 1);
+
+  {
+    SCOPED_TRACE("DotProduct");
+    EXPECT_FLOAT_EQ(kResult,
+                    vector_math::DotProduct(input_vector_.get(),
+                                            output_vector_.get(), kVectorSize));
+    EXPECT_FLOAT_EQ(
+        kUnalignedResult,
+        vector_math::DotProduct(input_vector_.get() + 1, output_vector_.get(),
+                                kVectorSize - 1));
+  }
+
+  {
+    SCOPED_TRACE("DotProduct_C");
+    EXPECT_FLOAT_EQ(kResult, vector_math::DotProduct_C(input_vector_.get(),
+                                                       output_vector_.get(),
+                                                       kVectorSize));
+    EXPECT_FLOAT_EQ(
+        kUnalignedResult,
+        vector_math::DotProduct_C(input_vector_.get() + 1, output_vector_.get(),
+                                  kVectorSize - 1));
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  {
+    SCOPED_TRACE("DotProduct_SSE");
+    EXPECT_FLOAT_EQ(kResult, vector_math::DotProduct_SSE(input_vector_.get(),
+                                                         output_vector_.get(),
+                                                         kVectorSize));
+    EXPECT_FLOAT_EQ(kUnalignedResult,
+                    vector_math::DotProduct_SSE(input_vector_.get() + 1,
+                                                output_vector_.get(),
+                                                kVectorSize - 1));
+  }
+#endif
+
+#if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+  {
+    SCOPED_TRACE("DotProduct_NEON");
+    EXPECT_FLOAT_EQ(kResult, vector_math::DotProduct_NEON(input_vector_.get(),
+                                                          output_vector_.get(),
+                                                          kVectorSize));
+    EXPECT_FLOAT_EQ(kUnalignedResult,
+                    vector_math::DotProduct_NEON(input_vector_.get() + 1,
+                                                 output_vector_.get(),
+                                                 kVectorSize - 1));
+  }
+#endif
+}
+
 TEST_F(VectorMathTest, Crossfade) {
   FillTestVectors(0, 1);
   vector_math::Crossfade(
@@ -12,6 +12,12 @@ VideoDecoder::VideoDecoder() {}
 
 VideoDecoder::~VideoDecoder() {}
 
+void VideoDecoder::DecodeDiscardingOutput(
+    const scoped_refptr<DecoderBuffer>& buffer,
+    const DecodeCB& decode_cb) {
+  Decode(buffer, decode_cb);
+}
+
 bool VideoDecoder::NeedsBitstreamConversion() const {
   return false;
 }
@@ -96,6 +96,15 @@ class MEDIA_EXPORT VideoDecoder {
   virtual void Decode(const scoped_refptr<DecoderBuffer>& buffer,
                       const DecodeCB& decode_cb) = 0;
 
+  // Like Decode(), but hints that the output of |buffer| will not be shown,
+  // e.g. because it precedes the target of a seek.  |buffer| must still be
+  // decoded so that later frames can reference it, but the decoder may skip
+  // producing its output.  |buffer| must not be an EOS buffer.  The default
+  // implementation ignores the hint and calls Decode().
+  virtual void DecodeDiscardingOutput(
+      const scoped_refptr<DecoderBuffer>& buffer,
+      const DecodeCB& decode_cb);
+
   // Resets decoder state. All pending Decode() requests will be finished or
   // aborted before |closure| is called.
   // Note: No VideoDecoder calls should be made before |closure| is executed.
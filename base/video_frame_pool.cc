@@ -4,12 +4,14 @@
 
 #include "media/base/video_frame_pool.h"
 
-#include <list>
+#include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
 
 namespace media {
 
@@ -32,6 +34,8 @@ class VideoFramePool::PoolImpl
 
   size_t GetPoolSizeForTesting() const { return frames_.size(); }
 
+  size_t GetNumFramesInUse() const;
+
  private:
   friend class base::RefCountedThreadSafe<VideoFramePool::PoolImpl>;
   ~PoolImpl();
@@ -41,14 +45,25 @@ class VideoFramePool::PoolImpl
   // in |frames_| by this function so it can be reused.
   void FrameReleased(const scoped_refptr<VideoFrame>& frame);
 
-  base::Lock lock_;
+  // Emits the pool occupancy as a trace counter.  |lock_| must be held.
+  void TraceOccupancy();
+
+  mutable base::Lock lock_;
   bool is_shutdown_;
-  std::list<scoped_refptr<VideoFrame> > frames_;
+
+  // Free frames, most recently released last.  Frames are reused from the back
+  // so the hottest memory is handed out first, and a vector avoids allocating
+  // a list node every time a frame is returned once the pool is warm.
+  std::vector<scoped_refptr<VideoFrame>> frames_;
+
+  // Number of frames handed out by CreateFrame() and not yet released.
+  size_t frames_in_use_;
 
   DISALLOW_COPY_AND_ASSIGN(PoolImpl);
 };
 
-VideoFramePool::PoolImpl::PoolImpl() : is_shutdown_(false) {}
+VideoFramePool::PoolImpl::PoolImpl()
+    : is_shutdown_(false), frames_in_use_(0) {}
 
 VideoFramePool::PoolImpl::~PoolImpl() {
   DCHECK(is_shutdown_);
@@ -65,8 +80,8 @@ scoped_refptr<VideoFrame> VideoFramePool::PoolImpl::CreateFrame(
 
   scoped_refptr<VideoFrame> frame;
   while (!frame.get() && !frames_.empty()) {
-      scoped_refptr<VideoFrame> pool_frame = frames_.front();
-      frames_.pop_front();
+      scoped_refptr<VideoFrame> pool_frame = std::move(frames_.back());
+      frames_.pop_back();
 
       if (pool_frame->format() == format &&
           pool_frame->coded_size() == coded_size &&
@@ -93,9 +108,22 @@ scoped_refptr<VideoFrame> VideoFramePool::PoolImpl::CreateFrame(
       frame, frame->format(), frame->visible_rect(), frame->natural_size());
   wrapped_frame->AddDestructionObserver(
       base::Bind(&VideoFramePool::PoolImpl::FrameReleased, this, frame));
+  ++frames_in_use_;
+  TraceOccupancy();
   return wrapped_frame;
 }
 
+size_t VideoFramePool::PoolImpl::GetNumFramesInUse() const {
+  base::AutoLock auto_lock(lock_);
+  return frames_in_use_;
+}
+
+void VideoFramePool::PoolImpl::TraceOccupancy() {
+  lock_.AssertAcquired();
+  TRACE_COUNTER_ID2("media", "VideoFramePool", this, "in_use", frames_in_use_,
+                    "free", frames_.size());
+}
+
 void VideoFramePool::PoolImpl::Shutdown() {
   base::AutoLock auto_lock(lock_);
   is_shutdown_ = true;
@@ -105,10 +133,13 @@ void VideoFramePool::PoolImpl::Shutdown() {
 void VideoFramePool::PoolImpl::FrameReleased(
     const scoped_refptr<VideoFrame>& frame) {
   base::AutoLock auto_lock(lock_);
+  DCHECK_GT(frames_in_use_, 0u);
+  --frames_in_use_;
   if (is_shutdown_)
     return;
 
   frames_.push_back(frame);
+  TraceOccupancy();
 }
 
 VideoFramePool::VideoFramePool() : pool_(new PoolImpl()) {
@@ -128,6 +159,10 @@ scoped_refptr<VideoFrame> VideoFramePool::CreateFrame(
                             timestamp);
 }
 
+size_t VideoFramePool::GetNumFramesInUse() const {
+  return pool_->GetNumFramesInUse();
+}
+
 size_t VideoFramePool::GetPoolSizeForTesting() const {
   return pool_->GetPoolSizeForTesting();
 }
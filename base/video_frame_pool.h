@@ -37,6 +37,11 @@ class MEDIA_EXPORT VideoFramePool {
                                         const gfx::Size& natural_size,
                                         base::TimeDelta timestamp);
 
+  // Returns the number of frames created by the pool which are still alive.
+  // Together with the number of free frames this is also emitted as the
+  // "VideoFramePool" trace counter whenever the pool's occupancy changes.
+  size_t GetNumFramesInUse() const;
+
 protected:
   friend class VideoFramePoolTest;
 
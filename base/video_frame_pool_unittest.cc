@@ -80,6 +80,35 @@ TEST_F(VideoFramePoolTest, SimpleFormatChange) {
   CheckPoolSize(0u);
 }
 
+TEST_F(VideoFramePoolTest, MostRecentlyReleasedFrameIsReused) {
+  scoped_refptr<VideoFrame> frame_a = CreateFrame(PIXEL_FORMAT_YV12, 10);
+  scoped_refptr<VideoFrame> frame_b = CreateFrame(PIXEL_FORMAT_YV12, 10);
+  const uint8_t* b_y_data = frame_b->data(VideoFrame::kYPlane);
+
+  frame_a = NULL;
+  frame_b = NULL;
+
+  scoped_refptr<VideoFrame> new_frame = CreateFrame(PIXEL_FORMAT_YV12, 20);
+  EXPECT_EQ(b_y_data, new_frame->data(VideoFrame::kYPlane));
+  CheckPoolSize(1u);
+}
+
+TEST_F(VideoFramePoolTest, FramesInUse) {
+  EXPECT_EQ(0u, pool_->GetNumFramesInUse());
+  scoped_refptr<VideoFrame> frame_a = CreateFrame(PIXEL_FORMAT_YV12, 10);
+  scoped_refptr<VideoFrame> frame_b = CreateFrame(PIXEL_FORMAT_YV12, 10);
+  EXPECT_EQ(2u, pool_->GetNumFramesInUse());
+
+  frame_a = NULL;
+  EXPECT_EQ(1u, pool_->GetNumFramesInUse());
+  CheckPoolSize(1u);
+
+  // Reusing a frame from the pool moves it back into use.
+  frame_a = CreateFrame(PIXEL_FORMAT_YV12, 20);
+  EXPECT_EQ(2u, pool_->GetNumFramesInUse());
+  CheckPoolSize(0u);
+}
+
 TEST_F(VideoFramePoolTest, FrameValidAfterPoolDestruction) {
   scoped_refptr<VideoFrame> frame = CreateFrame(PIXEL_FORMAT_YV12, 10);
 
@@ -247,6 +247,9 @@ WebMediaPlayerImpl::WebMediaPlayerImpl(
 
   media_log_->AddEvent(
       media_log_->CreateEvent(MediaLogEvent::WEBMEDIAPLAYER_CREATED));
+  media_log_drain_timer_.Start(
+      FROM_HERE, base::TimeDelta::FromSeconds(1),
+      base::Bind(base::IgnoreResult(&MediaLog::DrainRecords), media_log_));
 
   if (params.initial_cdm())
     SetCdm(params.initial_cdm());
@@ -288,6 +291,10 @@ WebMediaPlayerImpl::~WebMediaPlayerImpl() {
     static_cast<cc::VideoLayer*>(video_weblayer_->layer())->StopUsingProvider();
   compositor_task_runner_->DeleteSoon(FROM_HERE, compositor_);
 
+  // The pipeline is stopped, so this picks up the last of its records.
+  media_log_drain_timer_.Stop();
+  media_log_->DrainRecords();
+
   media_log_->AddEvent(
       media_log_->CreateEvent(MediaLogEvent::WEBMEDIAPLAYER_DESTROYED));
 }
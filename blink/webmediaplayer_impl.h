@@ -386,6 +386,10 @@ class MEDIA_BLINK_EXPORT WebMediaPlayerImpl
   scoped_refptr<base::TaskRunner> worker_task_runner_;
   scoped_refptr<MediaLog> media_log_;
 
+  // Periodically turns the records the pipeline leaves in |media_log_| into
+  // events while the log is observed; see MediaLog::DrainRecords().
+  base::RepeatingTimer media_log_drain_timer_;
+
   // |pipeline_controller_| references |pipeline_| and therefore must be
   // constructed after and destructed before |pipeline_|.
   PipelineImpl pipeline_;
@@ -12,7 +12,8 @@ VideoCodecParams::VideoCodecParams()
       min_qp(kDefaultMinQp),
       max_cpu_saver_qp(kDefaultMaxCpuSaverQp),
       max_number_of_video_buffers_used(kDefaultNumberOfVideoBuffers),
-      number_of_encode_threads(1) {}
+      number_of_encode_threads(1),
+      is_screen_content(false) {}
 
 VideoCodecParams::VideoCodecParams(const VideoCodecParams& other) = default;
 
@@ -36,7 +37,10 @@ FrameSenderConfig::FrameSenderConfig()
       min_bitrate(0),
       start_bitrate(0),
       max_frame_rate(kDefaultMaxFrameRate),
-      codec(CODEC_UNKNOWN) {}
+      codec(CODEC_UNKNOWN),
+      enable_fec(false),
+      congestion_control(CONGESTION_CONTROL_ADAPTIVE),
+      enable_quality_scaling(false) {}
 
 FrameSenderConfig::FrameSenderConfig(const FrameSenderConfig& other) = default;
 
@@ -50,7 +54,8 @@ FrameReceiverConfig::FrameReceiverConfig()
       rtp_timebase(0),
       channels(0),
       target_frame_rate(0),
-      codec(CODEC_UNKNOWN) {}
+      codec(CODEC_UNKNOWN),
+      transport_feedback_interval_ms(0) {}
 
 FrameReceiverConfig::FrameReceiverConfig(const FrameReceiverConfig& other) =
     default;
@@ -63,6 +63,17 @@ enum SuggestedDefaults {
   kDefaultNumberOfVideoBuffers = 1,
 };
 
+// How a video sender chooses the bitrate to encode at.
+enum CongestionControlType {
+  // Keeps the estimated amount of data in flight well within what can be
+  // delivered before the playout deadline, based on frame acknowledgements.
+  CONGESTION_CONTROL_ADAPTIVE,
+
+  // Backs off as soon as the one-way delay of packets starts to grow, which
+  // keeps network queues short.  See NewDelayBasedCongestionControl().
+  CONGESTION_CONTROL_DELAY_BASED,
+};
+
 // These parameters are only for video encoders.
 struct VideoCodecParams {
   VideoCodecParams();
@@ -93,7 +104,14 @@ struct VideoCodecParams {
   // choose a suitable value for the platform and other encoding settings.
   int max_number_of_video_buffers_used;
 
+  // The most threads the encoder may use.  The software VP8 encoder starts
+  // with fewer for small frames, and adds threads while encoding at its
+  // fastest speed still takes too long.
   int number_of_encode_threads;
+
+  // If true, the content is mostly text and still images, such as a captured
+  // screen, rather than camera video.  Only used by the software VP8 codec.
+  bool is_screen_content;
 };
 
 struct FrameSenderConfig {
@@ -154,6 +172,20 @@ struct FrameSenderConfig {
 
   // These are codec specific parameters for video streams only.
   VideoCodecParams video_codec_params;
+
+  // If true, FEC packets are sent so that the receiver can restore some lost
+  // packets without waiting for a retransmission.  The receiver must support
+  // them, as they are counted as lost by receivers which don't.
+  bool enable_fec;
+
+  // Only used by video senders with the built-in software encoder, which use
+  // a fixed bitrate otherwise.
+  CongestionControlType congestion_control;
+
+  // If true, video senders lower the resolution and frame rate they encode at
+  // while the encoder or the network cannot keep up, and raise them again once
+  // they can.  Senders with an external encoder only change the frame rate.
+  bool enable_quality_scaling;
 };
 
 // TODO(miu): Naming and minor type changes are badly needed in a later CL.
@@ -202,6 +234,11 @@ struct FrameReceiverConfig {
   // strings, crypto is not being used.
   std::string aes_key;
   std::string aes_iv_mask;
+
+  // How often to report the arrival time of every RTP packet to the sender,
+  // which delay-based congestion control relies on.  Zero disables the
+  // reports.
+  int transport_feedback_interval_ms;
 };
 
 // TODO(miu): Remove the CreateVEA callbacks.  http://crbug.com/454029
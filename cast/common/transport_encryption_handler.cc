@@ -4,11 +4,9 @@
 
 #include "media/cast/common/transport_encryption_handler.h"
 
-#include <stddef.h>
+#include <string.h>
 
 #include "base/logging.h"
-#include "crypto/encryptor.h"
-#include "crypto/symmetric_key.h"
 #include "media/cast/net/cast_transport_defines.h"
 
 namespace media {
@@ -20,10 +18,12 @@ namespace {
 const size_t kAesBlockSize = 16;
 const size_t kAesKeySize = 16;
 
-std::string GetAesNonce(FrameId frame_id, const std::string& iv_mask) {
+void GetAesNonce(FrameId frame_id,
+                 const std::string& iv_mask,
+                 uint8_t aes_nonce[kAesBlockSize]) {
   DCHECK(!frame_id.is_null());
 
-  std::string aes_nonce(kAesBlockSize, 0);
+  memset(aes_nonce, 0, kAesBlockSize);
 
   // Serializing frame_id in big-endian order (aes_nonce[8] is the most
   // significant byte of frame_id).
@@ -36,24 +36,39 @@ std::string GetAesNonce(FrameId frame_id, const std::string& iv_mask) {
   for (size_t i = 0; i < kAesBlockSize; ++i) {
     aes_nonce[i] ^= iv_mask[i];
   }
-  return aes_nonce;
+}
+
+// Adds |blocks| to the 128-bit big-endian |counter|, as stepping through that
+// many blocks of the key stream would.
+void AdvanceCounter(uint64_t blocks, uint8_t counter[kAesBlockSize]) {
+  for (int i = kAesBlockSize - 1; i >= 0 && blocks; --i) {
+    blocks += counter[i];
+    counter[i] = static_cast<uint8_t>(blocks);
+    blocks >>= 8;
+  }
 }
 
 }  // namespace
 
 TransportEncryptionHandler::TransportEncryptionHandler()
-    : key_(), encryptor_(), iv_mask_(), is_activated_(false) {}
+    : iv_mask_(), is_activated_(false) {
+  memset(&key_, 0, sizeof(key_));
+}
 
-TransportEncryptionHandler::~TransportEncryptionHandler() {}
+TransportEncryptionHandler::~TransportEncryptionHandler() {
+  memset(&key_, 0, sizeof(key_));
+}
 
 bool TransportEncryptionHandler::Initialize(const std::string& aes_key,
                                             const std::string& aes_iv_mask) {
   is_activated_ = false;
   if (aes_iv_mask.size() == kAesKeySize && aes_key.size() == kAesKeySize) {
     iv_mask_ = aes_iv_mask;
-    key_ = crypto::SymmetricKey::Import(crypto::SymmetricKey::AES, aes_key);
-    encryptor_.reset(new crypto::Encryptor());
-    encryptor_->Init(key_.get(), crypto::Encryptor::CTR, std::string());
+    if (AES_set_encrypt_key(reinterpret_cast<const uint8_t*>(aes_key.data()),
+                            kAesKeySize * 8, &key_) != 0) {
+      NOTREACHED() << "Failed to expand key";
+      return false;
+    }
     is_activated_ = true;
   } else if (aes_iv_mask.size() != 0 || aes_key.size() != 0) {
     DCHECK_EQ(aes_iv_mask.size(), 0u)
@@ -70,15 +85,8 @@ bool TransportEncryptionHandler::Encrypt(FrameId frame_id,
                                          std::string* encrypted_data) {
   if (!is_activated_)
     return false;
-  if (!encryptor_->SetCounter(GetAesNonce(frame_id, iv_mask_))) {
-    NOTREACHED() << "Failed to set counter";
-    return false;
-  }
-  if (!encryptor_->Encrypt(data, encrypted_data)) {
-    NOTREACHED() << "Encrypt error";
-    return false;
-  }
-  return true;
+  data.CopyToString(encrypted_data);
+  return EncryptInPlace(frame_id, encrypted_data);
 }
 
 bool TransportEncryptionHandler::Decrypt(FrameId frame_id,
@@ -87,16 +95,48 @@ bool TransportEncryptionHandler::Decrypt(FrameId frame_id,
   if (!is_activated_) {
     return false;
   }
-  if (!encryptor_->SetCounter(GetAesNonce(frame_id, iv_mask_))) {
-    NOTREACHED() << "Failed to set counter";
-    return false;
-  }
-  if (!encryptor_->Decrypt(ciphertext, plaintext)) {
-    VLOG(1) << "Decryption error";
+  ciphertext.CopyToString(plaintext);
+  return DecryptInPlace(frame_id, plaintext);
+}
+
+bool TransportEncryptionHandler::EncryptInPlace(FrameId frame_id,
+                                                std::string* data) const {
+  if (!is_activated_)
     return false;
+  if (!data->empty()) {
+    uint8_t* const bytes = reinterpret_cast<uint8_t*>(&(*data)[0]);
+    EncryptRange(frame_id, 0, bytes, data->size(), bytes);
   }
   return true;
 }
 
+bool TransportEncryptionHandler::DecryptInPlace(FrameId frame_id,
+                                                std::string* data) const {
+  return EncryptInPlace(frame_id, data);
+}
+
+void TransportEncryptionHandler::EncryptRange(FrameId frame_id,
+                                              size_t offset,
+                                              const uint8_t* in,
+                                              size_t size,
+                                              uint8_t* out) const {
+  DCHECK(is_activated_);
+
+  uint8_t counter[kAesBlockSize];
+  GetAesNonce(frame_id, iv_mask_, counter);
+  AdvanceCounter(offset / kAesBlockSize, counter);
+
+  // When |offset| falls inside a block, start part way through that block's
+  // key stream, as though the bytes before it had just been encrypted.
+  uint8_t key_stream[kAesBlockSize];
+  unsigned int key_stream_offset = offset % kAesBlockSize;
+  if (key_stream_offset) {
+    AES_encrypt(counter, key_stream, &key_);
+    AdvanceCounter(1, counter);
+  }
+  AES_ctr128_encrypt(in, out, size, &key_, counter, key_stream,
+                     &key_stream_offset);
+}
+
 }  // namespace cast
 }  // namespace media
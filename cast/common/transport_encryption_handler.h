@@ -7,24 +7,23 @@
 
 // Helper class to handle encryption for the Cast Transport library.
 
+#include <stddef.h>
 #include <stdint.h>
 
-#include <memory>
 #include <string>
 
 #include "base/macros.h"
 #include "base/strings/string_piece.h"
 #include "base/threading/non_thread_safe.h"
 #include "media/cast/common/frame_id.h"
-
-namespace crypto {
-class Encryptor;
-class SymmetricKey;
-}
+#include "third_party/boringssl/src/include/openssl/aes.h"
 
 namespace media {
 namespace cast {
 
+// Encrypts and decrypts frames with AES-128 in CTR mode, with a counter which
+// starts at the frame ID XORed with the IV mask.  The key is expanded once, in
+// Initialize(), and BoringSSL uses the CPU's AES instructions where it can.
 class TransportEncryptionHandler : public base::NonThreadSafe {
  public:
   TransportEncryptionHandler();
@@ -40,11 +39,26 @@ class TransportEncryptionHandler : public base::NonThreadSafe {
                const base::StringPiece& ciphertext,
                std::string* plaintext);
 
+  // Like Encrypt() and Decrypt(), but replace the contents of |data|.
+  bool EncryptInPlace(FrameId frame_id, std::string* data) const;
+  bool DecryptInPlace(FrameId frame_id, std::string* data) const;
+
+  // Encrypts (or, CTR mode being symmetric, decrypts) the |size| bytes of the
+  // frame which start at |offset|, from |in| to |out|, which may be the same.
+  // This lets a frame be encrypted piece by piece, straight into the packets
+  // it is sent in.  It changes no state, and so may be called from several
+  // threads at once to work on different parts of a frame.  Must only be
+  // called once the handler is activated.
+  void EncryptRange(FrameId frame_id,
+                    size_t offset,
+                    const uint8_t* in,
+                    size_t size,
+                    uint8_t* out) const;
+
   bool is_activated() const { return is_activated_; }
 
  private:
-  std::unique_ptr<crypto::SymmetricKey> key_;
-  std::unique_ptr<crypto::Encryptor> encryptor_;
+  AES_KEY key_;
   std::string iv_mask_;
   bool is_activated_;
 
@@ -0,0 +1,141 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/common/transport_encryption_handler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "crypto/encryptor.h"
+#include "crypto/symmetric_key.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const char kAesKey[] = "0123456789abcdef";
+
+// The mask makes the counter carry out of its lowest 32 bits within the first
+// few blocks of every frame.
+const char kAesIvMask[] = "\x01\x02\x03\x04\x05\x06\x07\x08"
+                          "\x00\x00\x00\x00\xff\xff\xff\xfe";
+
+std::string MakeData(size_t size) {
+  std::string data(size, 0);
+  for (size_t i = 0; i < size; ++i)
+    data[i] = static_cast<char>(i * 13 + i / 256);
+  return data;
+}
+
+// Encrypts the way TransportEncryptionHandler did before it expanded the key
+// itself, with a crypto::Encryptor whose counter starts at the nonce.
+std::string EncryptWithEncryptor(FrameId frame_id, const std::string& data) {
+  std::string nonce(std::begin(kAesIvMask), std::end(kAesIvMask) - 1);
+  const uint32_t truncated_id = frame_id.lower_32_bits();
+  for (int i = 0; i < 4; ++i)
+    nonce[8 + i] ^= static_cast<char>(truncated_id >> (24 - 8 * i));
+
+  std::unique_ptr<crypto::SymmetricKey> key = crypto::SymmetricKey::Import(
+      crypto::SymmetricKey::AES, std::string(kAesKey));
+  crypto::Encryptor encryptor;
+  EXPECT_TRUE(encryptor.Init(key.get(), crypto::Encryptor::CTR, std::string()));
+  EXPECT_TRUE(encryptor.SetCounter(nonce));
+  std::string encrypted_data;
+  EXPECT_TRUE(encryptor.Encrypt(data, &encrypted_data));
+  return encrypted_data;
+}
+
+class TransportEncryptionHandlerTest : public ::testing::Test {
+ protected:
+  TransportEncryptionHandlerTest() {
+    const std::string iv_mask(std::begin(kAesIvMask), std::end(kAesIvMask) - 1);
+    EXPECT_TRUE(handler_.Initialize(kAesKey, iv_mask));
+  }
+
+  TransportEncryptionHandler handler_;
+};
+
+}  // namespace
+
+TEST(TransportEncryptionHandlerConfigTest, NoKeyLeavesEncryptionOff) {
+  TransportEncryptionHandler handler;
+  EXPECT_TRUE(handler.Initialize(std::string(), std::string()));
+  EXPECT_FALSE(handler.is_activated());
+  std::string data = MakeData(100);
+  EXPECT_FALSE(handler.EncryptInPlace(FrameId::first(), &data));
+  EXPECT_EQ(MakeData(100), data);
+}
+
+TEST_F(TransportEncryptionHandlerTest, MatchesEncryptor) {
+  for (size_t size : {1, 15, 16, 17, 1000, 100000}) {
+    const FrameId frame_id = FrameId::first() + static_cast<int>(size);
+    const std::string data = MakeData(size);
+    std::string encrypted_data;
+    ASSERT_TRUE(handler_.Encrypt(frame_id, data, &encrypted_data));
+    EXPECT_EQ(EncryptWithEncryptor(frame_id, data), encrypted_data) << size;
+
+    std::string decrypted_data;
+    ASSERT_TRUE(handler_.Decrypt(frame_id, encrypted_data, &decrypted_data));
+    EXPECT_EQ(data, decrypted_data);
+  }
+}
+
+TEST_F(TransportEncryptionHandlerTest, InPlace) {
+  const FrameId frame_id = FrameId::first() + 42;
+  const std::string data = MakeData(5000);
+  std::string buffer = data;
+  ASSERT_TRUE(handler_.EncryptInPlace(frame_id, &buffer));
+  EXPECT_EQ(EncryptWithEncryptor(frame_id, data), buffer);
+  ASSERT_TRUE(handler_.DecryptInPlace(frame_id, &buffer));
+  EXPECT_EQ(data, buffer);
+
+  std::string empty;
+  EXPECT_TRUE(handler_.EncryptInPlace(frame_id, &empty));
+  EXPECT_TRUE(empty.empty());
+}
+
+// Encrypting a frame a piece at a time, as the packetizer does, whatever the
+// size and alignment of the pieces, gives the same result as doing it whole.
+TEST_F(TransportEncryptionHandlerTest, EncryptRangeMatchesWholeFrame) {
+  const FrameId frame_id = FrameId::first() + 7;
+  const std::string data = MakeData(10000);
+  const std::string expected_data = EncryptWithEncryptor(frame_id, data);
+  const uint8_t* const in = reinterpret_cast<const uint8_t*>(data.data());
+
+  for (size_t piece_size : {1, 7, 16, 33, 1389, 4096}) {
+    std::string encrypted_data(data.size(), 0);
+    uint8_t* const out = reinterpret_cast<uint8_t*>(&encrypted_data[0]);
+    for (size_t offset = 0; offset < data.size(); offset += piece_size) {
+      const size_t size = std::min(piece_size, data.size() - offset);
+      handler_.EncryptRange(frame_id, offset, in + offset, size, out + offset);
+    }
+    EXPECT_EQ(expected_data, encrypted_data) << piece_size;
+  }
+
+  // The pieces may also be done out of order.
+  std::string encrypted_data(data.size(), 0);
+  uint8_t* const out = reinterpret_cast<uint8_t*>(&encrypted_data[0]);
+  handler_.EncryptRange(frame_id, 5000, in + 5000, 5000, out + 5000);
+  handler_.EncryptRange(frame_id, 9, in + 9, 4991, out + 9);
+  handler_.EncryptRange(frame_id, 0, in, 9, out);
+  EXPECT_EQ(expected_data, encrypted_data);
+}
+
+TEST_F(TransportEncryptionHandlerTest, FramesUseDifferentKeyStreams) {
+  const std::string data = MakeData(100);
+  std::string first;
+  std::string second;
+  ASSERT_TRUE(handler_.Encrypt(FrameId::first(), data, &first));
+  ASSERT_TRUE(handler_.Encrypt(FrameId::first() + 1, data, &second));
+  EXPECT_NE(first, second);
+}
+
+}  // namespace cast
+}  // namespace media
@@ -0,0 +1,269 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/batched_udp_transport_linux.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/callback_helpers.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "net/base/sockaddr_storage.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+// Maximum number of packets received or sent per system call.
+const size_t kMaxBatchSize = 32;
+
+bool IsEmpty(const net::IPEndPoint& addr) {
+  return (addr.address().empty() || addr.address().IsZero()) && !addr.port();
+}
+
+}  // namespace
+
+BatchedUdpTransport::BatchedUdpTransport(
+    const scoped_refptr<base::SingleThreadTaskRunner>& io_thread_proxy,
+    const net::IPEndPoint& local_end_point,
+    const net::IPEndPoint& remote_end_point,
+    const CastTransportStatusCallback& status_callback)
+    : io_thread_proxy_(io_thread_proxy),
+      local_addr_(local_end_point),
+      remote_addr_(remote_end_point),
+      status_callback_(status_callback),
+      send_buffer_size_(media::cast::kMaxBurstSize *
+                        media::cast::kMaxIpPacketSize),
+      bytes_sent_(0),
+      client_connected_(false),
+      recv_packets_(kMaxBatchSize),
+      read_watcher_(FROM_HERE),
+      write_watcher_(FROM_HERE) {
+  DCHECK(!IsEmpty(local_end_point) || !IsEmpty(remote_end_point));
+}
+
+BatchedUdpTransport::~BatchedUdpTransport() {}
+
+void BatchedUdpTransport::SetSendBufferSize(int32_t send_buffer_size) {
+  send_buffer_size_ = send_buffer_size;
+}
+
+void BatchedUdpTransport::StartReceiving(
+    const PacketReceiverCallbackWithStatus& packet_receiver) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  DCHECK(!socket_.is_valid());
+
+  // Like UdpTransport, bind if there is a local address and otherwise connect.
+  const bool bind_local = !IsEmpty(local_addr_);
+  const net::IPEndPoint& addr = bind_local ? local_addr_ : remote_addr_;
+  net::SockaddrStorage storage;
+  const int reuse_addr = 1;
+  base::ScopedFD fd(socket(addr.GetSockAddrFamily(),
+                           SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+  if (!fd.is_valid() ||
+      setsockopt(fd.get(), SOL_SOCKET, SO_REUSEADDR, &reuse_addr,
+                 sizeof(reuse_addr)) < 0 ||
+      !addr.ToSockAddr(storage.addr, &storage.addr_len) ||
+      (bind_local ? bind(fd.get(), storage.addr, storage.addr_len)
+                  : connect(fd.get(), storage.addr, storage.addr_len)) < 0) {
+    PLOG(ERROR) << "Failed to " << (bind_local ? "bind local" : "connect to")
+                << " address.";
+    status_callback_.Run(TRANSPORT_SOCKET_ERROR);
+    return;
+  }
+  client_connected_ = !bind_local;
+
+  if (setsockopt(fd.get(), SOL_SOCKET, SO_SNDBUF, &send_buffer_size_,
+                 sizeof(send_buffer_size_)) < 0) {
+    LOG(WARNING) << "Failed to set socket send buffer size.";
+  }
+
+  socket_ = std::move(fd);
+  packet_receiver_ = packet_receiver;
+  if (!base::MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_.get(), true, base::MessageLoopForIO::WATCH_READ,
+          &read_watcher_, this)) {
+    LOG(ERROR) << "Failed to watch socket.";
+    status_callback_.Run(TRANSPORT_SOCKET_ERROR);
+  }
+}
+
+void BatchedUdpTransport::StopReceiving() {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  packet_receiver_ = PacketReceiverCallbackWithStatus();
+  read_watcher_.StopWatchingFileDescriptor();
+}
+
+void BatchedUdpTransport::OnFileCanReadWithoutBlocking(int fd) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  DCHECK_EQ(fd, socket_.get());
+
+  // Keep reading while full batches are returned; a partial batch means the
+  // socket has been drained.
+  size_t received = kMaxBatchSize;
+  while (received == kMaxBatchSize && !packet_receiver_.is_null()) {
+    mmsghdr messages[kMaxBatchSize];
+    iovec iovecs[kMaxBatchSize];
+    net::SockaddrStorage addresses[kMaxBatchSize];
+    memset(messages, 0, sizeof(messages));
+    for (size_t i = 0; i < kMaxBatchSize; ++i) {
+      if (!recv_packets_[i])
+        recv_packets_[i].reset(new Packet(media::cast::kMaxIpPacketSize));
+      iovecs[i].iov_base = &recv_packets_[i]->front();
+      iovecs[i].iov_len = recv_packets_[i]->size();
+      messages[i].msg_hdr.msg_iov = &iovecs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_name = addresses[i].addr;
+      messages[i].msg_hdr.msg_namelen = addresses[i].addr_len;
+    }
+
+    const int result =
+        HANDLE_EINTR(recvmmsg(fd, messages, kMaxBatchSize, 0, nullptr));
+    if (result < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        VPLOG(1) << "Failed to receive packets";
+      return;
+    }
+
+    received = static_cast<size_t>(result);
+    for (size_t i = 0; i < received && !packet_receiver_.is_null(); ++i) {
+      net::IPEndPoint address;
+      if (!address.FromSockAddr(
+              static_cast<const sockaddr*>(messages[i].msg_hdr.msg_name),
+              messages[i].msg_hdr.msg_namelen)) {
+        continue;
+      }
+      recv_packets_[i]->resize(messages[i].msg_len);
+      OnPacketReceived(std::move(recv_packets_[i]), address);
+    }
+  }
+}
+
+void BatchedUdpTransport::OnPacketReceived(std::unique_ptr<Packet> packet,
+                                           const net::IPEndPoint& address) {
+  // Same as UdpTransport: the first packet sets the remote address if there is
+  // none, and packets from anywhere else are ignored.
+  if (IsEmpty(remote_addr_)) {
+    remote_addr_ = address;
+    VLOG(1) << "Setting remote address from first received packet: "
+            << remote_addr_.ToString();
+    if (!packet_receiver_.Run(std::move(packet))) {
+      VLOG(1) << "Packet was not valid, resetting remote address.";
+      remote_addr_ = net::IPEndPoint();
+    }
+  } else if (!(remote_addr_ == address)) {
+    VLOG(1) << "Ignoring packet received from an unrecognized address: "
+            << address.ToString() << ".";
+  } else {
+    packet_receiver_.Run(std::move(packet));
+  }
+}
+
+bool BatchedUdpTransport::SendPacket(PacketRef packet,
+                                     const base::Closure& cb) {
+  size_t num_sent;
+  return SendPackets(PacketList(1, packet), cb, &num_sent);
+}
+
+bool BatchedUdpTransport::SendPackets(const PacketList& packets,
+                                      const base::Closure& cb,
+                                      size_t* num_sent) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  DCHECK(!blocked_packet_);
+
+  size_t offset = 0;
+  if (!socket_.is_valid() || (!client_connected_ && IsEmpty(remote_addr_))) {
+    VLOG(1) << "Failed to send packets; socket is neither bound nor "
+            << "connected.";
+    offset = packets.size();
+  }
+
+  while (offset < packets.size()) {
+    const int result = SendBatch(packets, offset);
+    if (result > 0) {
+      offset += result;
+    } else if (result == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+      // The caller must wait for |cb| before sending more, and the packet which
+      // blocked is sent first when the socket becomes writable.  A result of
+      // zero means nothing was sent without an error being reported, so errno
+      // is stale; it is treated as blocked as well.
+      blocked_packet_ = packets[offset++];
+      blocked_cb_ = cb;
+      base::MessageLoopForIO::current()->WatchFileDescriptor(
+          socket_.get(), false, base::MessageLoopForIO::WATCH_WRITE,
+          &write_watcher_, this);
+      break;
+    } else {
+      VPLOG(1) << "Failed to send packet";
+      ++offset;
+    }
+  }
+
+  // As with UdpTransport, bytes are counted whether packets were sent or
+  // dropped.
+  *num_sent = offset;
+  for (size_t i = 0; i < offset; ++i)
+    bytes_sent_ += packets[i]->data.size();
+  return !blocked_packet_;
+}
+
+int BatchedUdpTransport::SendBatch(const PacketList& packets, size_t offset) {
+  net::SockaddrStorage remote;
+  if (!client_connected_ &&
+      !remote_addr_.ToSockAddr(remote.addr, &remote.addr_len)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  const size_t count = std::min(packets.size() - offset, kMaxBatchSize);
+  mmsghdr messages[kMaxBatchSize];
+  iovec iovecs[kMaxBatchSize];
+  memset(messages, 0, sizeof(messages));
+  for (size_t i = 0; i < count; ++i) {
+    Packet* const data = &packets[offset + i]->data;
+    iovecs[i].iov_base = &data->front();
+    iovecs[i].iov_len = data->size();
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    if (!client_connected_) {
+      messages[i].msg_hdr.msg_name = remote.addr;
+      messages[i].msg_hdr.msg_namelen = remote.addr_len;
+    }
+  }
+  return HANDLE_EINTR(sendmmsg(socket_.get(), messages, count, 0));
+}
+
+void BatchedUdpTransport::OnFileCanWriteWithoutBlocking(int fd) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  DCHECK_EQ(fd, socket_.get());
+  DCHECK(blocked_packet_);
+
+  const int result = SendBatch(PacketList(1, blocked_packet_), 0);
+  if (result == 0 ||
+      (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+    base::MessageLoopForIO::current()->WatchFileDescriptor(
+        socket_.get(), false, base::MessageLoopForIO::WATCH_WRITE,
+        &write_watcher_, this);
+    return;
+  }
+  if (result < 0)
+    VPLOG(1) << "Failed to send packet";
+
+  blocked_packet_ = nullptr;
+  base::ResetAndReturn(&blocked_cb_).Run();
+}
+
+int64_t BatchedUdpTransport::GetBytesSent() {
+  return bytes_sent_;
+}
+
+}  // namespace cast
+}  // namespace media
@@ -0,0 +1,96 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_NET_BATCHED_UDP_TRANSPORT_LINUX_H_
+#define MEDIA_CAST_NET_BATCHED_UDP_TRANSPORT_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "media/cast/net/cast_transport.h"
+#include "media/cast/net/cast_transport_config.h"
+#include "net/base/ip_endpoint.h"
+
+namespace media {
+namespace cast {
+
+// A drop-in alternative to UdpTransport which receives up to a batch of packets
+// per recvmmsg() call, and sends each burst handed to SendPackets() with
+// sendmmsg().  At the packet rates of high bitrate sessions this saves most of
+// the time UdpTransport spends in system calls.  DSCP is not supported.
+class BatchedUdpTransport : public PacketTransport,
+                            public base::MessageLoopForIO::Watcher {
+ public:
+  // See UdpTransport.  All methods must be called on |io_thread_proxy|, which
+  // must run a MessageLoopForIO.
+  BatchedUdpTransport(
+      const scoped_refptr<base::SingleThreadTaskRunner>& io_thread_proxy,
+      const net::IPEndPoint& local_end_point,
+      const net::IPEndPoint& remote_end_point,
+      const CastTransportStatusCallback& status_callback);
+  ~BatchedUdpTransport() final;
+
+  // Must be called before StartReceiving() to take effect.
+  void SetSendBufferSize(int32_t send_buffer_size);
+
+  // PacketTransport implementations.
+  bool SendPacket(PacketRef packet, const base::Closure& cb) final;
+  bool SendPackets(const PacketList& packets,
+                   const base::Closure& cb,
+                   size_t* num_sent) final;
+  int64_t GetBytesSent() final;
+  void StartReceiving(
+      const PacketReceiverCallbackWithStatus& packet_receiver) final;
+  void StopReceiving() final;
+
+  // base::MessageLoopForIO::Watcher implementations.
+  void OnFileCanReadWithoutBlocking(int fd) final;
+  void OnFileCanWriteWithoutBlocking(int fd) final;
+
+ private:
+  // Sends up to a batch of |packets| starting at |offset| with one sendmmsg()
+  // call.  Returns its result, leaving errno set on failure.
+  int SendBatch(const PacketList& packets, size_t offset);
+
+  // Passes |packet| to |packet_receiver_| if it came from the remote address.
+  void OnPacketReceived(std::unique_ptr<Packet> packet,
+                        const net::IPEndPoint& address);
+
+  const scoped_refptr<base::SingleThreadTaskRunner> io_thread_proxy_;
+  const net::IPEndPoint local_addr_;
+  net::IPEndPoint remote_addr_;
+  const CastTransportStatusCallback status_callback_;
+  int32_t send_buffer_size_;
+  int64_t bytes_sent_;
+  bool client_connected_;
+  PacketReceiverCallbackWithStatus packet_receiver_;
+
+  // Receive buffers, reused until they are handed to |packet_receiver_|.
+  std::vector<std::unique_ptr<Packet>> recv_packets_;
+
+  // The packet which blocked, and the callback to run once it has been sent.
+  PacketRef blocked_packet_;
+  base::Closure blocked_cb_;
+
+  base::ScopedFD socket_;
+
+  // Declared after |socket_| so that they stop watching before it is closed.
+  base::MessageLoopForIO::FileDescriptorWatcher read_watcher_;
+  base::MessageLoopForIO::FileDescriptorWatcher write_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchedUdpTransport);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_NET_BATCHED_UDP_TRANSPORT_LINUX_H_
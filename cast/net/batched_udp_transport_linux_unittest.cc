@@ -0,0 +1,139 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/batched_udp_transport_linux.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "media/cast/net/cast_transport_config.h"
+#include "media/cast/test/utility/net_utility.h"
+#include "net/base/ip_address.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+class PacketCollector {
+ public:
+  PacketCollector(size_t expected_packets, const base::Closure& done_cb)
+      : expected_packets_(expected_packets), done_cb_(done_cb) {}
+
+  bool ReceivedPacket(std::unique_ptr<Packet> packet) {
+    packets_.push_back(*packet);
+    if (packets_.size() == expected_packets_)
+      done_cb_.Run();
+    return true;
+  }
+
+  PacketReceiverCallbackWithStatus packet_receiver() {
+    return base::Bind(&PacketCollector::ReceivedPacket,
+                      base::Unretained(this));
+  }
+
+  const std::vector<Packet>& packets() const { return packets_; }
+
+ private:
+  const size_t expected_packets_;
+  const base::Closure done_cb_;
+  std::vector<Packet> packets_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacketCollector);
+};
+
+void UpdateCastTransportStatus(CastTransportStatus status) {
+  NOTREACHED();
+}
+
+PacketRef MakePacket(size_t size, uint8_t value) {
+  return new base::RefCountedData<Packet>(Packet(size, value));
+}
+
+}  // namespace
+
+TEST(BatchedUdpTransportTest, SendAndReceive) {
+  base::MessageLoopForIO message_loop;
+
+  net::IPEndPoint free_local_port1 = test::GetFreeLocalPort();
+  net::IPEndPoint free_local_port2 = test::GetFreeLocalPort();
+
+  BatchedUdpTransport send_transport(message_loop.task_runner(),
+                                     free_local_port1, free_local_port2,
+                                     base::Bind(&UpdateCastTransportStatus));
+  BatchedUdpTransport recv_transport(
+      message_loop.task_runner(), free_local_port2,
+      net::IPEndPoint(net::IPAddress::IPv4AllZeros(), 0),
+      base::Bind(&UpdateCastTransportStatus));
+
+  base::RunLoop send_run_loop;
+  base::RunLoop recv_run_loop;
+  PacketCollector sender_collector(1, send_run_loop.QuitClosure());
+  PacketCollector receiver_collector(1, recv_run_loop.QuitClosure());
+  send_transport.StartReceiving(sender_collector.packet_receiver());
+  recv_transport.StartReceiving(receiver_collector.packet_receiver());
+
+  const PacketRef packet = MakePacket(4, 't');
+  EXPECT_TRUE(send_transport.SendPacket(packet, base::Closure()));
+  EXPECT_EQ(4, send_transport.GetBytesSent());
+  recv_run_loop.Run();
+  ASSERT_EQ(1u, receiver_collector.packets().size());
+  EXPECT_EQ(packet->data, receiver_collector.packets()[0]);
+
+  // The receiver learned the sender's address from the first packet.
+  EXPECT_TRUE(recv_transport.SendPacket(packet, base::Closure()));
+  send_run_loop.Run();
+  ASSERT_EQ(1u, sender_collector.packets().size());
+  EXPECT_EQ(packet->data, sender_collector.packets()[0]);
+}
+
+TEST(BatchedUdpTransportTest, SendPacketsInBatches) {
+  base::MessageLoopForIO message_loop;
+
+  net::IPEndPoint free_local_port1 = test::GetFreeLocalPort();
+  net::IPEndPoint free_local_port2 = test::GetFreeLocalPort();
+
+  BatchedUdpTransport send_transport(message_loop.task_runner(),
+                                     free_local_port1, free_local_port2,
+                                     base::Bind(&UpdateCastTransportStatus));
+  send_transport.SetSendBufferSize(1 << 20);
+  BatchedUdpTransport recv_transport(
+      message_loop.task_runner(), free_local_port2,
+      net::IPEndPoint(net::IPAddress::IPv4AllZeros(), 0),
+      base::Bind(&UpdateCastTransportStatus));
+
+  // More than fit in one system call.
+  const size_t kNumPackets = 100;
+  base::RunLoop run_loop;
+  PacketCollector receiver_collector(kNumPackets, run_loop.QuitClosure());
+  send_transport.StartReceiving(PacketReceiverCallbackWithStatus());
+  recv_transport.StartReceiving(receiver_collector.packet_receiver());
+
+  PacketList packets;
+  int64_t bytes = 0;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    packets.push_back(MakePacket(100 + i, static_cast<uint8_t>(i)));
+    bytes += packets.back()->data.size();
+  }
+  size_t num_sent = 0;
+  EXPECT_TRUE(send_transport.SendPackets(packets, base::Closure(), &num_sent));
+  EXPECT_EQ(kNumPackets, num_sent);
+  EXPECT_EQ(bytes, send_transport.GetBytesSent());
+
+  run_loop.Run();
+  ASSERT_EQ(kNumPackets, receiver_collector.packets().size());
+  for (size_t i = 0; i < kNumPackets; ++i)
+    EXPECT_EQ(packets[i]->data, receiver_collector.packets()[i]);
+}
+
+}  // namespace cast
+}  // namespace media
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/single_thread_task_runner.h"
@@ -73,6 +74,19 @@ class RtcpObserver {
 
   // Called on receiving RTP receiver logs.
   virtual void OnReceivedReceiverLog(const RtcpReceiverLogMessage& log) {}
+
+  // Called on receiving the fraction of RTP packets lost since the previous
+  // report, in units of 1/256.
+  virtual void OnReceivedLossFraction(uint8_t fraction_lost) {}
+
+  // Called on receiving the arrival times of RTP packets from RTP receiver.
+  virtual void OnReceivedTransportFeedback(
+      const RtcpTransportFeedback& feedback) {}
+
+  // Called with the send and arrival times of RTP packets the receiver has
+  // reported, oldest first.  Retransmitted packets are left out.
+  virtual void OnReceivedPacketArrivals(
+      const std::vector<PacketArrival>& arrivals) {}
 };
 
 // The application should only trigger this class from the transport thread.
@@ -163,6 +177,7 @@ class CastTransport : public base::NonThreadSafe {
       const ReceiverRtcpEventSubscriber::RtcpEvents& rtcp_events) = 0;
   virtual void AddRtpReceiverReport(
       const RtcpReportBlock& rtp_report_block) = 0;
+  virtual void AddTransportFeedback(const RtcpTransportFeedback& feedback) = 0;
 
   // Finalize the building of the RTCP packet and send out the built packet.
   virtual void SendRtcpFromRtpReceiver() = 0;
@@ -11,7 +11,8 @@ CastTransportRtpConfig::CastTransportRtpConfig()
     : rtp_stream_id(0),
       ssrc(0),
       feedback_ssrc(0),
-      rtp_payload_type(RtpPayloadType::UNKNOWN) {}
+      rtp_payload_type(RtpPayloadType::UNKNOWN),
+      enable_fec(false) {}
 
 CastTransportRtpConfig::~CastTransportRtpConfig() {}
 
@@ -31,6 +32,18 @@ void EncodedFrame::CopyMetadataTo(EncodedFrame* dest) const {
   dest->new_playout_delay_ms = this->new_playout_delay_ms;
 }
 
+bool PacketTransport::SendPackets(const PacketList& packets,
+                                  const base::Closure& cb,
+                                  size_t* num_sent) {
+  *num_sent = 0;
+  for (const PacketRef& packet : packets) {
+    ++*num_sent;
+    if (!SendPacket(packet, cb))
+      return false;
+  }
+  return true;
+}
+
 RtcpSenderInfo::RtcpSenderInfo()
     : ntp_seconds(0),
       ntp_fraction(0),
@@ -82,6 +82,10 @@ struct CastTransportRtpConfig {
   // strings, crypto is not being used.
   std::string aes_key;
   std::string aes_iv_mask;
+
+  // If true, FEC packets are sent with each frame, at a redundancy that
+  // follows the packet loss reported by the receiver.
+  bool enable_fec;
 };
 
 // A combination of metadata and data for one encoded frame.  This can contain
@@ -171,6 +175,15 @@ class PacketTransport {
   // will return true indicating that the channel is not blocked.
   virtual bool SendPacket(PacketRef packet, const base::Closure& cb) = 0;
 
+  // Sends |packets| in order, as though SendPacket() were called for each until
+  // one returned false.  |*num_sent| is set to the number of packets taken,
+  // including the one which blocked, if any.  Transports which can send several
+  // packets with one system call override this; the default calls
+  // SendPacket().
+  virtual bool SendPackets(const PacketList& packets,
+                           const base::Closure& cb,
+                           size_t* num_sent);
+
   // Returns the number of bytes ever sent.
   virtual int64_t GetBytesSent() = 0;
 
@@ -0,0 +1,44 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/cast_transport_host.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "media/cast/net/cast_transport_impl.h"
+
+namespace media {
+namespace cast {
+
+CastTransportHost::CastTransportHost(
+    base::TickClock* clock,
+    const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+    int max_egress_bitrate)
+    : clock_(clock),
+      transport_task_runner_(transport_task_runner),
+      pacing_host_(clock, transport_task_runner, max_egress_bitrate) {
+  DCHECK(clock_);
+  DCHECK(transport_task_runner_);
+}
+
+CastTransportHost::~CastTransportHost() {}
+
+std::unique_ptr<CastTransport> CastTransportHost::CreateTransport(
+    base::TimeDelta logging_flush_interval,
+    std::unique_ptr<CastTransport::Client> client,
+    std::unique_ptr<PacketTransport> transport) {
+  DCHECK(CalledOnValidThread());
+  return std::unique_ptr<CastTransport>(new CastTransportImpl(
+      clock_, logging_flush_interval, std::move(client), std::move(transport),
+      transport_task_runner_, &pacing_host_));
+}
+
+void CastTransportHost::SetMaxEgressBitrate(int max_egress_bitrate) {
+  DCHECK(CalledOnValidThread());
+  pacing_host_.SetMaxEgressBitrate(max_egress_bitrate);
+}
+
+}  // namespace cast
+}  // namespace media
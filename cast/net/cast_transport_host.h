@@ -0,0 +1,60 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_NET_CAST_TRANSPORT_HOST_H_
+#define MEDIA_CAST_NET_CAST_TRANSPORT_HOST_H_
+
+#include <memory>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/non_thread_safe.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+#include "media/cast/net/cast_transport.h"
+#include "media/cast/net/pacing/pacing_host.h"
+
+namespace media {
+namespace cast {
+
+// Hosts the transports of many concurrent cast sessions, such as a server's
+// mirroring sessions, on one transport thread.  Each session still has its own
+// CastTransport, socket and PacedSender, but the pacers share one PacingHost:
+// their timers are kept in one timer wheel, so that the thread wakes once per
+// pacing interval however many sessions there are, and the rate at which all
+// of them send together may be bounded, with each session getting a fair share
+// of it.
+class CastTransportHost : public base::NonThreadSafe {
+ public:
+  // A |max_egress_bitrate| of zero leaves the total rate unbounded.
+  CastTransportHost(
+      base::TickClock* clock,  // Owned by the caller.
+      const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+      int max_egress_bitrate);
+  ~CastTransportHost();
+
+  // Like CastTransport::Create(), for a session hosted with the others.  The
+  // transports must be destroyed before the host.
+  std::unique_ptr<CastTransport> CreateTransport(
+      base::TimeDelta logging_flush_interval,
+      std::unique_ptr<CastTransport::Client> client,
+      std::unique_ptr<PacketTransport> transport);
+
+  void SetMaxEgressBitrate(int max_egress_bitrate);
+
+  PacingHost* pacing_host() { return &pacing_host_; }
+
+ private:
+  base::TickClock* const clock_;  // Not owned by this class.
+  const scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
+  PacingHost pacing_host_;
+
+  DISALLOW_COPY_AND_ASSIGN(CastTransportHost);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_NET_CAST_TRANSPORT_HOST_H_
@@ -0,0 +1,224 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/cast_transport_host.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "media/base/fake_single_thread_task_runner.h"
+#include "media/cast/net/cast_transport_config.h"
+#include "media/cast/net/pacing/paced_sender.h"
+#include "media/cast/net/rtcp/rtcp_defines.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const int64_t kStartMillisecond = INT64_C(12345678900000);
+const uint32_t kVideoSsrc = 1;
+const int kNumSessions = 100;
+// More packets than fit in a burst, so that each frame takes two to send.
+const size_t kFrameSize = 15000;
+const int64_t kFrameIntervalMicroseconds = 33333;
+
+class StubRtcpObserver : public RtcpObserver {
+ public:
+  StubRtcpObserver() {}
+
+  void OnReceivedCastMessage(const RtcpCastMessage& cast_message) final {}
+  void OnReceivedRtt(base::TimeDelta round_trip_time) final {}
+  void OnReceivedPli() final {}
+
+  DISALLOW_COPY_AND_ASSIGN(StubRtcpObserver);
+};
+
+class StubTransportClient : public CastTransport::Client {
+ public:
+  StubTransportClient() {}
+
+  void OnStatusChanged(CastTransportStatus status) final {}
+  void OnLoggingEventsReceived(
+      std::unique_ptr<std::vector<FrameEvent>> frame_events,
+      std::unique_ptr<std::vector<PacketEvent>> packet_events) final {}
+  void ProcessRtpPacket(std::unique_ptr<Packet> packet) final {}
+
+  DISALLOW_COPY_AND_ASSIGN(StubTransportClient);
+};
+
+// Counts what one session sends, standing in for its socket.
+class CountingPacketSender : public PacketTransport {
+ public:
+  CountingPacketSender() : packets_sent_(0), bytes_sent_(0) {}
+
+  bool SendPacket(PacketRef packet, const base::Closure& cb) final {
+    ++packets_sent_;
+    bytes_sent_ += packet->data.size();
+    return true;
+  }
+
+  int64_t GetBytesSent() final { return bytes_sent_; }
+
+  void StartReceiving(
+      const PacketReceiverCallbackWithStatus& packet_receiver) final {}
+
+  void StopReceiving() final {}
+
+  int packets_sent() const { return packets_sent_; }
+
+ private:
+  int packets_sent_;
+  int64_t bytes_sent_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingPacketSender);
+};
+
+}  // namespace
+
+class CastTransportHostTest : public ::testing::Test {
+ protected:
+  CastTransportHostTest() {
+    testing_clock_.Advance(
+        base::TimeDelta::FromMilliseconds(kStartMillisecond));
+    task_runner_ = new FakeSingleThreadTaskRunner(&testing_clock_);
+  }
+
+  // Creates |kNumSessions| video sessions, whose frames are spread out over
+  // the frame interval.
+  void CreateSessions(int max_egress_bitrate) {
+    host_.reset(new CastTransportHost(&testing_clock_, task_runner_,
+                                      max_egress_bitrate));
+    for (int i = 0; i < kNumSessions; ++i) {
+      CountingPacketSender* const packet_sender = new CountingPacketSender();
+      packet_senders_.push_back(packet_sender);
+      transports_.push_back(host_->CreateTransport(
+          base::TimeDelta::FromMilliseconds(50),
+          base::MakeUnique<StubTransportClient>(),
+          base::WrapUnique(packet_sender)));
+
+      CastTransportRtpConfig rtp_config;
+      rtp_config.ssrc = kVideoSsrc;
+      rtp_config.feedback_ssrc = 2;
+      rtp_config.rtp_payload_type = RtpPayloadType::VIDEO_VP8;
+      transports_.back()->InitializeStream(
+          rtp_config, base::MakeUnique<StubRtcpObserver>());
+
+      next_frame_times_.push_back(
+          testing_clock_.NowTicks() +
+          base::TimeDelta::FromMicroseconds(kFrameIntervalMicroseconds * i /
+                                            kNumSessions));
+      next_frame_ids_.push_back(FrameId::first());
+    }
+  }
+
+  // Sends the sessions' frames as they come due, for |duration|.
+  void SendFrames(base::TimeDelta duration) {
+    const base::TimeTicks end_time = testing_clock_.NowTicks() + duration;
+    while (testing_clock_.NowTicks() < end_time) {
+      for (int i = 0; i < kNumSessions; ++i) {
+        if (next_frame_times_[i] > testing_clock_.NowTicks())
+          continue;
+        EncodedFrame frame;
+        frame.frame_id = next_frame_ids_[i];
+        frame.referenced_frame_id =
+            frame.frame_id == FrameId::first() ? frame.frame_id
+                                               : frame.frame_id - 1;
+        frame.rtp_timestamp = RtpTimeTicks().Expand(
+            static_cast<uint32_t>((frame.frame_id - FrameId::first()) * 3000));
+        frame.dependency = frame.frame_id == FrameId::first()
+                               ? EncodedFrame::KEY
+                               : EncodedFrame::DEPENDENT;
+        frame.data.resize(kFrameSize, ' ');
+        transports_[i]->InsertFrame(kVideoSsrc, frame);
+        ++frames_inserted_;
+        next_frame_ids_[i] = frame.frame_id + 1;
+        next_frame_times_[i] +=
+            base::TimeDelta::FromMicroseconds(kFrameIntervalMicroseconds);
+      }
+      task_runner_->Sleep(base::TimeDelta::FromMilliseconds(1));
+    }
+  }
+
+  std::vector<int64_t> GetBytesSent() {
+    std::vector<int64_t> bytes_sent;
+    for (CountingPacketSender* packet_sender : packet_senders_)
+      bytes_sent.push_back(packet_sender->GetBytesSent());
+    return bytes_sent;
+  }
+
+  int GetPacketsSent() {
+    int packets_sent = 0;
+    for (CountingPacketSender* packet_sender : packet_senders_)
+      packets_sent += packet_sender->packets_sent();
+    return packets_sent;
+  }
+
+  base::SimpleTestTickClock testing_clock_;
+  scoped_refptr<FakeSingleThreadTaskRunner> task_runner_;
+  std::unique_ptr<CastTransportHost> host_;
+  std::vector<std::unique_ptr<CastTransport>> transports_;
+  std::vector<CountingPacketSender*> packet_senders_;  // Owned by transports_.
+  std::vector<base::TimeTicks> next_frame_times_;
+  std::vector<FrameId> next_frame_ids_;
+  int frames_inserted_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(CastTransportHostTest);
+};
+
+TEST_F(CastTransportHostTest, SendsEverythingWithOneTimer) {
+  CreateSessions(0);
+  SendFrames(base::TimeDelta::FromSeconds(1));
+  // Let the last bursts finish.
+  task_runner_->Sleep(base::TimeDelta::FromMilliseconds(20));
+
+  const int packets_per_frame = GetPacketsSent() / frames_inserted_;
+  EXPECT_LT(static_cast<int>(kTargetBurstSize), packets_per_frame);
+  EXPECT_EQ(packets_per_frame * frames_inserted_, GetPacketsSent());
+  // The second bursts of all of the sessions' frames, and their logging
+  // flushes, were run by at most one task per pacing interval.
+  EXPECT_LE(host_->pacing_host()->num_ticks_run(), 1020 / 10 + 1);
+}
+
+TEST_F(CastTransportHostTest, BoundsAndSharesEgress) {
+  // Well below the 360 Mbps the sessions would send together.
+  const int kMaxEgressBitrate = 80000000;
+  CreateSessions(kMaxEgressBitrate);
+  SendFrames(base::TimeDelta::FromMilliseconds(500));
+
+  const std::vector<int64_t> bytes_sent_before = GetBytesSent();
+  SendFrames(base::TimeDelta::FromMilliseconds(500));
+  const std::vector<int64_t> bytes_sent_after = GetBytesSent();
+
+  int64_t total_bytes_sent = 0;
+  int64_t min_bytes_sent = std::numeric_limits<int64_t>::max();
+  int64_t max_bytes_sent = 0;
+  for (int i = 0; i < kNumSessions; ++i) {
+    const int64_t bytes_sent = bytes_sent_after[i] - bytes_sent_before[i];
+    total_bytes_sent += bytes_sent;
+    min_bytes_sent = std::min(min_bytes_sent, bytes_sent);
+    max_bytes_sent = std::max(max_bytes_sent, bytes_sent);
+  }
+  const int64_t kBoundBytes = kMaxEgressBitrate / 8 / 2;
+  // Allow for one tick's budget, and each session's last packet overdrawing
+  // it.
+  EXPECT_LE(total_bytes_sent,
+            kBoundBytes + kBoundBytes / 50 +
+                kNumSessions * static_cast<int64_t>(kMaxIpPacketSize));
+  EXPECT_GE(total_bytes_sent, kBoundBytes * 9 / 10);
+  // No session is starved by the others.
+  EXPECT_GE(min_bytes_sent, max_bytes_sent * 8 / 10);
+}
+
+}  // namespace cast
+}  // namespace media
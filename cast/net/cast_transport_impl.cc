@@ -6,11 +6,13 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <deque>
 #include <string>
 #include <utility>
 
 #include "base/single_thread_task_runner.h"
 #include "build/build_config.h"
+#include "media/cast/constants.h"
 #include "media/cast/net/cast_transport_defines.h"
 #include "media/cast/net/rtcp/sender_rtcp_session.h"
 #include "net/base/net_errors.h"
@@ -65,7 +67,8 @@ class CastTransportImpl::RtcpClient : public RtcpObserver {
       : rtp_sender_ssrc_(rtp_sender_ssrc),
         rtcp_observer_(std::move(observer)),
         media_type_(media_type),
-        cast_transport_impl_(cast_transport_impl) {}
+        cast_transport_impl_(cast_transport_impl),
+        has_transport_feedback_(false) {}
 
   void OnReceivedCastMessage(const RtcpCastMessage& cast_message) override {
     rtcp_observer_->OnReceivedCastMessage(cast_message);
@@ -78,15 +81,41 @@ class CastTransportImpl::RtcpClient : public RtcpObserver {
 
   void OnReceivedReceiverLog(const RtcpReceiverLogMessage& log) override {
     cast_transport_impl_->OnReceivedLogMessage(media_type_, log);
+    // The receiver log samples only some of the packets, so it is used only
+    // until transport feedback arrives.
+    if (has_transport_feedback_)
+      return;
+    std::vector<PacketArrival> arrivals;
+    cast_transport_impl_->GetPacketArrivals(rtp_sender_ssrc_, log, &arrivals);
+    if (!arrivals.empty())
+      rtcp_observer_->OnReceivedPacketArrivals(arrivals);
+  }
+
+  void OnReceivedTransportFeedback(
+      const RtcpTransportFeedback& feedback) override {
+    rtcp_observer_->OnReceivedTransportFeedback(feedback);
+    has_transport_feedback_ = true;
+    std::vector<PacketArrival> arrivals;
+    cast_transport_impl_->GetPacketArrivals(rtp_sender_ssrc_, feedback,
+                                            &arrivals);
+    if (!arrivals.empty())
+      rtcp_observer_->OnReceivedPacketArrivals(arrivals);
   }
 
   void OnReceivedPli() override { rtcp_observer_->OnReceivedPli(); }
 
+  void OnReceivedLossFraction(uint8_t fraction_lost) override {
+    rtcp_observer_->OnReceivedLossFraction(fraction_lost);
+    cast_transport_impl_->OnReceivedLossFraction(rtp_sender_ssrc_,
+                                                 fraction_lost);
+  }
+
  private:
   const uint32_t rtp_sender_ssrc_;
   const std::unique_ptr<RtcpObserver> rtcp_observer_;
   const EventMediaType media_type_;
   CastTransportImpl* const cast_transport_impl_;
+  bool has_transport_feedback_;
 
   DISALLOW_COPY_AND_ASSIGN(RtcpClient);
 };
@@ -94,6 +123,14 @@ class CastTransportImpl::RtcpClient : public RtcpObserver {
 struct CastTransportImpl::RtpStreamSession {
   explicit RtpStreamSession(bool is_audio_stream) : is_audio(is_audio_stream) {}
 
+  // What is needed to find the send records of a frame's packets from the
+  // RTP timestamp in a receiver log.
+  struct SentFrame {
+    RtpTimeTicks rtp_timestamp;
+    FrameId frame_id;
+    base::TimeTicks reference_time;
+  };
+
   // Packetizer for audio and video frames.
   std::unique_ptr<RtpSender> rtp_sender;
 
@@ -109,6 +146,9 @@ struct CastTransportImpl::RtpStreamSession {
   // the damage that could be caused by a compromised renderer process.
   TransportEncryptionHandler encryptor;
 
+  // The last kMaxUnackedFrames frames sent, oldest first.
+  std::deque<SentFrame> recent_frames;
+
   const bool is_audio;
 };
 
@@ -118,11 +158,26 @@ CastTransportImpl::CastTransportImpl(
     std::unique_ptr<Client> client,
     std::unique_ptr<PacketTransport> transport,
     const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner)
+    : CastTransportImpl(clock,
+                        logging_flush_interval,
+                        std::move(client),
+                        std::move(transport),
+                        transport_task_runner,
+                        nullptr) {}
+
+CastTransportImpl::CastTransportImpl(
+    base::TickClock* clock,
+    base::TimeDelta logging_flush_interval,
+    std::unique_ptr<Client> client,
+    std::unique_ptr<PacketTransport> transport,
+    const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+    PacingHost* pacing_host)
     : clock_(clock),
       logging_flush_interval_(logging_flush_interval),
       transport_client_(std::move(client)),
       transport_(std::move(transport)),
       transport_task_runner_(transport_task_runner),
+      pacing_host_(pacing_host),
       pacer_(kTargetBurstSize,
              kMaxBurstSize,
              clock,
@@ -136,17 +191,17 @@ CastTransportImpl::CastTransportImpl(
   DCHECK(transport_client_);
   DCHECK(transport_);
   DCHECK(transport_task_runner_);
-  if (logging_flush_interval_ > base::TimeDelta()) {
-    transport_task_runner_->PostDelayedTask(
-        FROM_HERE, base::Bind(&CastTransportImpl::SendRawEvents,
-                              weak_factory_.GetWeakPtr()),
-        logging_flush_interval_);
-  }
+  if (pacing_host_)
+    pacer_.SetPacingHost(pacing_host_);
+  if (logging_flush_interval_ > base::TimeDelta())
+    ScheduleSendRawEvents();
   transport_->StartReceiving(
       base::Bind(&CastTransportImpl::OnReceivedPacket, base::Unretained(this)));
 }
 
 CastTransportImpl::~CastTransportImpl() {
+  if (pacing_host_)
+    pacing_host_->RemoveClient(this);
   transport_->StopReceiving();
 }
 
@@ -193,22 +248,14 @@ void CastTransportImpl::InitializeStream(
 
 namespace {
 void EncryptAndSendFrame(const EncodedFrame& frame,
-                         TransportEncryptionHandler* encryptor,
+                         const TransportEncryptionHandler* encryptor,
                          RtpSender* sender) {
   // TODO(miu): We probably shouldn't attempt to send an empty frame, but this
   // issue is still under investigation.  http://crbug.com/519022
-  if (encryptor->is_activated() && !frame.data.empty()) {
-    EncodedFrame encrypted_frame;
-    frame.CopyMetadataTo(&encrypted_frame);
-    if (encryptor->Encrypt(frame.frame_id, frame.data, &encrypted_frame.data)) {
-      sender->SendFrame(encrypted_frame);
-    } else {
-      LOG(ERROR) << "Encryption failed.  Not sending frame with ID "
-                 << frame.frame_id;
-    }
-  } else {
-    sender->SendFrame(frame);
-  }
+  // The packetizer encrypts the payloads as it builds the packets, so that
+  // the frame is not copied here.
+  const bool encrypt = encryptor->is_activated() && !frame.data.empty();
+  sender->SendFrame(frame, encrypt ? encryptor : nullptr);
 }
 }  // namespace
 
@@ -220,6 +267,14 @@ void CastTransportImpl::InsertFrame(uint32_t ssrc, const EncodedFrame& frame) {
   }
 
   it->second->rtcp_session->WillSendFrame(frame.frame_id);
+  std::deque<RtpStreamSession::SentFrame>& recent_frames =
+      it->second->recent_frames;
+  recent_frames.push_back(RtpStreamSession::SentFrame());
+  recent_frames.back().rtp_timestamp = frame.rtp_timestamp;
+  recent_frames.back().frame_id = frame.frame_id;
+  recent_frames.back().reference_time = frame.reference_time;
+  if (recent_frames.size() > static_cast<size_t>(kMaxUnackedFrames))
+    recent_frames.pop_front();
   EncryptAndSendFrame(frame, &it->second->encryptor,
                       it->second->rtp_sender.get());
 }
@@ -299,12 +354,25 @@ void CastTransportImpl::SendRawEvents() {
                                                std::move(packet_events));
   }
 
+  ScheduleSendRawEvents();
+}
+
+void CastTransportImpl::ScheduleSendRawEvents() {
+  if (pacing_host_) {
+    pacing_host_->ScheduleWakeup(this,
+                                 clock_->NowTicks() + logging_flush_interval_);
+    return;
+  }
   transport_task_runner_->PostDelayedTask(
       FROM_HERE,
       base::Bind(&CastTransportImpl::SendRawEvents, weak_factory_.GetWeakPtr()),
       logging_flush_interval_);
 }
 
+void CastTransportImpl::OnWakeup() {
+  SendRawEvents();
+}
+
 bool CastTransportImpl::OnReceivedPacket(std::unique_ptr<Packet> packet) {
   const uint8_t* const data = &packet->front();
   const size_t length = packet->size();
@@ -372,6 +440,92 @@ void CastTransportImpl::OnReceivedLogMessage(
   }
 }
 
+void CastTransportImpl::GetPacketArrivals(
+    uint32_t ssrc,
+    const RtcpReceiverLogMessage& log,
+    std::vector<PacketArrival>* arrivals) {
+  auto it = sessions_.find(ssrc);
+  if (it == sessions_.end())
+    return;
+  const std::deque<RtpStreamSession::SentFrame>& recent_frames =
+      it->second->recent_frames;
+
+  for (const RtcpReceiverFrameLogMessage& frame_log_message : log) {
+    // The log carries only the lower 32 bits of the RTP timestamp.
+    const uint32_t rtp_timestamp =
+        frame_log_message.rtp_timestamp_.lower_32_bits();
+    auto frame = std::find_if(
+        recent_frames.rbegin(), recent_frames.rend(),
+        [rtp_timestamp](const RtpStreamSession::SentFrame& sent_frame) {
+          return sent_frame.rtp_timestamp.lower_32_bits() == rtp_timestamp;
+        });
+    if (frame == recent_frames.rend())
+      continue;
+
+    for (const RtcpReceiverEventLogMessage& event_log_message :
+         frame_log_message.event_log_messages_) {
+      if (event_log_message.type != PACKET_RECEIVED)
+        continue;
+      PacketArrival arrival;
+      if (!pacer_.GetPacketSendTime(
+              PacketKey(frame->reference_time, ssrc, frame->frame_id,
+                        event_log_message.packet_id),
+              &arrival.send_time, &arrival.size)) {
+        continue;
+      }
+      arrival.arrival_time = event_log_message.event_timestamp;
+      arrivals->push_back(arrival);
+    }
+  }
+
+  std::sort(arrivals->begin(), arrivals->end(),
+            [](const PacketArrival& a, const PacketArrival& b) {
+              return a.send_time < b.send_time;
+            });
+}
+
+void CastTransportImpl::GetPacketArrivals(
+    uint32_t ssrc,
+    const RtcpTransportFeedback& feedback,
+    std::vector<PacketArrival>* arrivals) {
+  auto it = sessions_.find(ssrc);
+  if (it == sessions_.end())
+    return;
+  const std::deque<RtpStreamSession::SentFrame>& recent_frames =
+      it->second->recent_frames;
+
+  auto frame = recent_frames.rend();
+  for (const RtcpPacketArrival& packet_arrival : feedback) {
+    // Consecutive packets are usually of the same frame.
+    if (frame == recent_frames.rend() ||
+        frame->frame_id != packet_arrival.frame_id) {
+      const FrameId frame_id = packet_arrival.frame_id;
+      frame = std::find_if(
+          recent_frames.rbegin(), recent_frames.rend(),
+          [frame_id](const RtpStreamSession::SentFrame& sent_frame) {
+            return sent_frame.frame_id == frame_id;
+          });
+      if (frame == recent_frames.rend())
+        continue;
+    }
+
+    PacketArrival arrival;
+    if (!pacer_.GetPacketSendTime(
+            PacketKey(frame->reference_time, ssrc, frame->frame_id,
+                      packet_arrival.packet_id),
+            &arrival.send_time, &arrival.size)) {
+      continue;
+    }
+    arrival.arrival_time = packet_arrival.arrival_time;
+    arrivals->push_back(arrival);
+  }
+
+  std::sort(arrivals->begin(), arrivals->end(),
+            [](const PacketArrival& a, const PacketArrival& b) {
+              return a.send_time < b.send_time;
+            });
+}
+
 void CastTransportImpl::OnReceivedCastMessage(
     uint32_t ssrc,
     const RtcpCastMessage& cast_message) {
@@ -414,6 +568,14 @@ void CastTransportImpl::OnReceivedCastMessage(
   }
 }
 
+void CastTransportImpl::OnReceivedLossFraction(uint32_t ssrc,
+                                               uint8_t fraction_lost) {
+  auto it = sessions_.find(ssrc);
+  if (it == sessions_.end() || !it->second->rtp_sender)
+    return;
+  it->second->rtp_sender->OnReceivedLossFraction(fraction_lost);
+}
+
 void CastTransportImpl::AddValidRtpReceiver(uint32_t rtp_sender_ssrc,
                                             uint32_t rtp_receiver_ssrc) {
   valid_sender_ssrcs_.insert(rtp_sender_ssrc);
@@ -504,6 +666,16 @@ void CastTransportImpl::AddRtpReceiverReport(
   rtcp_builder_at_rtp_receiver_->AddRR(&rtp_receiver_report_block);
 }
 
+void CastTransportImpl::AddTransportFeedback(
+    const RtcpTransportFeedback& feedback) {
+  if (!rtcp_builder_at_rtp_receiver_) {
+    VLOG(1) << "rtcp_builder_at_rtp_receiver_ is not initialized before "
+               "calling CastTransportImpl::AddTransportFeedback.";
+    return;
+  }
+  rtcp_builder_at_rtp_receiver_->AddTransportFeedback(feedback);
+}
+
 void CastTransportImpl::SendRtcpFromRtpReceiver() {
   if (!rtcp_builder_at_rtp_receiver_) {
     VLOG(1) << "rtcp_builder_at_rtp_receiver_ is not initialized before "
@@ -19,7 +19,8 @@
 // There are objects of TransportEncryptionHandler, RtpSender and Rtcp
 // for each audio and video stream.
 // PacedSender and UdpTransport are shared between all RTP and RTCP
-// streams.
+// streams.  The PacedSenders of many sessions may in turn share a PacingHost;
+// see CastTransportHost.
 
 #ifndef MEDIA_CAST_NET_CAST_TRANSPORT_IMPL_H_
 #define MEDIA_CAST_NET_CAST_TRANSPORT_IMPL_H_
@@ -42,6 +43,7 @@
 #include "media/cast/net/cast_transport.h"
 #include "media/cast/net/cast_transport_config.h"
 #include "media/cast/net/pacing/paced_sender.h"
+#include "media/cast/net/pacing/pacing_host.h"
 #include "media/cast/net/rtcp/rtcp_builder.h"
 #include "media/cast/net/rtcp/sender_rtcp_session.h"
 #include "media/cast/net/rtp/rtp_parser.h"
@@ -53,7 +55,8 @@ namespace cast {
 
 class UdpTransport;
 
-class CastTransportImpl final : public CastTransport {
+class CastTransportImpl final : public CastTransport,
+                                public PacingHost::Client {
  public:
   CastTransportImpl(
       base::TickClock* clock,  // Owned by the caller.
@@ -62,6 +65,17 @@ class CastTransportImpl final : public CastTransport {
       std::unique_ptr<PacketTransport> transport,
       const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner);
 
+  // Like above, but with the pacer's bursts and the flushing of logging events
+  // scheduled by |pacing_host|, which must outlive this object, unless it is
+  // null.
+  CastTransportImpl(
+      base::TickClock* clock,  // Owned by the caller.
+      base::TimeDelta logging_flush_interval,
+      std::unique_ptr<Client> client,
+      std::unique_ptr<PacketTransport> transport,
+      const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+      PacingHost* pacing_host);
+
   ~CastTransportImpl() final;
 
   // CastTransport implementation for sending.
@@ -108,8 +122,12 @@ class CastTransportImpl final : public CastTransport {
       const ReceiverRtcpEventSubscriber::RtcpEvents& rtcp_events) final;
   void AddRtpReceiverReport(
       const RtcpReportBlock& rtp_receiver_report_block) final;
+  void AddTransportFeedback(const RtcpTransportFeedback& feedback) final;
   void SendRtcpFromRtpReceiver() final;
 
+  // PacingHost::Client implementation, which flushes the logging events.
+  void OnWakeup() final;
+
  private:
   // Handle received RTCP messages on RTP sender.
   class RtcpClient;
@@ -120,6 +138,9 @@ class CastTransportImpl final : public CastTransport {
   FRIEND_TEST_ALL_PREFIXES(CastTransportImplTest, CancelRetransmits);
   FRIEND_TEST_ALL_PREFIXES(CastTransportImplTest, Kickstart);
   FRIEND_TEST_ALL_PREFIXES(CastTransportImplTest, DedupRetransmissionWithAudio);
+  FRIEND_TEST_ALL_PREFIXES(CastTransportImplTest, ReportsPacketArrivals);
+  FRIEND_TEST_ALL_PREFIXES(CastTransportImplTest,
+                           ReportsPacketArrivalsFromTransportFeedback);
 
   // Resend packets for the stream identified by |ssrc|.
   // If |cancel_rtx_if_not_in_list| is true then transmission of packets for the
@@ -134,6 +155,9 @@ class CastTransportImpl final : public CastTransport {
   // intervals.
   void SendRawEvents();
 
+  // Calls SendRawEvents() in |logging_flush_interval_|.
+  void ScheduleSendRawEvents();
+
   // Called when a packet is received.
   bool OnReceivedPacket(std::unique_ptr<Packet> packet);
 
@@ -141,15 +165,30 @@ class CastTransportImpl final : public CastTransport {
   void OnReceivedLogMessage(EventMediaType media_type,
                             const RtcpReceiverLogMessage& log);
 
+  // Appends to |arrivals| the packets of stream |ssrc| which |log| reports
+  // as received and which were sent only once, ordered by send time.
+  void GetPacketArrivals(uint32_t ssrc,
+                         const RtcpReceiverLogMessage& log,
+                         std::vector<PacketArrival>* arrivals);
+
+  // Like above, for the packets reported in transport |feedback|.
+  void GetPacketArrivals(uint32_t ssrc,
+                         const RtcpTransportFeedback& feedback,
+                         std::vector<PacketArrival>* arrivals);
+
   // Called when a RTCP Cast message is received.
   void OnReceivedCastMessage(uint32_t ssrc,
                              const RtcpCastMessage& cast_message);
 
+  // Called when a receiver report gives the fraction of packets lost.
+  void OnReceivedLossFraction(uint32_t ssrc, uint8_t fraction_lost);
+
   base::TickClock* const clock_;  // Not owned by this class.
   const base::TimeDelta logging_flush_interval_;
   const std::unique_ptr<Client> transport_client_;
   const std::unique_ptr<PacketTransport> transport_;
   const scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
+  PacingHost* const pacing_host_;  // Not owned by this class.
 
   // FrameEvents and PacketEvents pending delivery via raw events callback.
   // Do not add elements to these when |logging_flush_interval| is
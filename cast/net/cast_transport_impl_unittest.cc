@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
@@ -406,5 +407,105 @@ TEST_F(CastTransportImplTest, DedupRetransmissionWithAudio) {
   EXPECT_EQ(2, num_times_logging_callback_called_);
 }
 
+TEST_F(CastTransportImplTest, ReportsPacketArrivals) {
+  InitWithoutLogging();
+  InitializeVideo();
+
+  // A fake frame that will be decomposed into 4 packets.
+  EncodedFrame fake_frame;
+  fake_frame.frame_id = FrameId::first() + 1;
+  fake_frame.referenced_frame_id = FrameId::first() + 1;
+  fake_frame.rtp_timestamp = RtpTimeTicks().Expand(UINT32_C(1));
+  fake_frame.dependency = EncodedFrame::KEY;
+  fake_frame.data.resize(5000, ' ');
+
+  const base::TimeTicks send_time = testing_clock_.NowTicks();
+  transport_sender_->InsertFrame(kVideoSsrc, fake_frame);
+  task_runner_->Sleep(base::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(4, transport_->packets_sent());
+
+  // The receiver got packets 0 and 2 of the frame, and acked a frame which was
+  // never sent.
+  const base::TimeTicks arrival_time =
+      send_time + base::TimeDelta::FromSeconds(100);
+  RtcpReceiverLogMessage log;
+  log.push_back(RtcpReceiverFrameLogMessage(fake_frame.rtp_timestamp));
+  for (uint16_t packet_id : {2, 0}) {
+    RtcpReceiverEventLogMessage event;
+    event.type = PACKET_RECEIVED;
+    event.event_timestamp = arrival_time;
+    event.packet_id = packet_id;
+    log.back().event_log_messages_.push_back(event);
+  }
+  log.push_back(RtcpReceiverFrameLogMessage(
+      fake_frame.rtp_timestamp + RtpTimeDelta::FromTicks(3000)));
+  RtcpReceiverEventLogMessage ack_event;
+  ack_event.type = FRAME_ACK_SENT;
+  log.back().event_log_messages_.push_back(ack_event);
+
+  std::vector<PacketArrival> arrivals;
+  transport_sender_->GetPacketArrivals(kVideoSsrc, log, &arrivals);
+  ASSERT_EQ(2u, arrivals.size());
+  for (const PacketArrival& arrival : arrivals) {
+    EXPECT_EQ(send_time, arrival.send_time);
+    EXPECT_EQ(arrival_time, arrival.arrival_time);
+    EXPECT_LT(0u, arrival.size);
+  }
+
+  // Once packet 0 is retransmitted, its arrival can't be matched to a send.
+  MissingFramesAndPacketsMap missing_packets;
+  missing_packets[fake_frame.frame_id].insert(0);
+  transport_sender_->ResendPackets(kVideoSsrc, missing_packets, true,
+                                   DedupInfo());
+  task_runner_->Sleep(base::TimeDelta::FromMilliseconds(10));
+  arrivals.clear();
+  transport_sender_->GetPacketArrivals(kVideoSsrc, log, &arrivals);
+  EXPECT_EQ(1u, arrivals.size());
+}
+
+TEST_F(CastTransportImplTest, ReportsPacketArrivalsFromTransportFeedback) {
+  InitWithoutLogging();
+  InitializeVideo();
+
+  // A fake frame that will be decomposed into 4 packets.
+  EncodedFrame fake_frame;
+  fake_frame.frame_id = FrameId::first() + 1;
+  fake_frame.referenced_frame_id = FrameId::first() + 1;
+  fake_frame.rtp_timestamp = RtpTimeTicks().Expand(UINT32_C(1));
+  fake_frame.dependency = EncodedFrame::KEY;
+  fake_frame.data.resize(5000, ' ');
+
+  const base::TimeTicks send_time = testing_clock_.NowTicks();
+  transport_sender_->InsertFrame(kVideoSsrc, fake_frame);
+  task_runner_->Sleep(base::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(4, transport_->packets_sent());
+
+  // The receiver got packets 3 and 1 of the frame, and a packet of a frame
+  // which was never sent.
+  const base::TimeTicks arrival_time =
+      send_time + base::TimeDelta::FromSeconds(100);
+  RtcpTransportFeedback feedback;
+  for (uint16_t packet_id : {3, 1}) {
+    RtcpPacketArrival packet_arrival;
+    packet_arrival.frame_id = fake_frame.frame_id;
+    packet_arrival.packet_id = packet_id;
+    packet_arrival.arrival_time = arrival_time;
+    feedback.push_back(packet_arrival);
+  }
+  RtcpPacketArrival unknown_packet_arrival;
+  unknown_packet_arrival.frame_id = fake_frame.frame_id + 1;
+  unknown_packet_arrival.arrival_time = arrival_time;
+  feedback.push_back(unknown_packet_arrival);
+
+  std::vector<PacketArrival> arrivals;
+  transport_sender_->GetPacketArrivals(kVideoSsrc, feedback, &arrivals);
+  ASSERT_EQ(2u, arrivals.size());
+  for (const PacketArrival& arrival : arrivals) {
+    EXPECT_EQ(send_time, arrival.send_time);
+    EXPECT_EQ(arrival_time, arrival.arrival_time);
+    EXPECT_LT(0u, arrival.size);
+  }
+}
+
 }  // namespace cast
 }  // namespace media
@@ -40,6 +40,8 @@ class MockCastTransport : public CastTransport {
       void(const ReceiverRtcpEventSubscriber::RtcpEvents& rtcp_events));
   MOCK_METHOD1(AddRtpReceiverReport,
                void(const RtcpReportBlock& rtp_report_block));
+  MOCK_METHOD1(AddTransportFeedback,
+               void(const RtcpTransportFeedback& feedback));
   MOCK_METHOD0(SendRtcpFromRtpReceiver, void());
   MOCK_METHOD1(SetOptions, void(const base::DictionaryValue& options));
 };
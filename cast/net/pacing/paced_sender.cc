@@ -4,11 +4,14 @@
 
 #include "media/cast/net/pacing/paced_sender.h"
 
+#include <limits>
+
 #include "base/big_endian.h"
 #include "base/bind.h"
 #include "base/debug/dump_without_crashing.h"
 #include "base/message_loop/message_loop.h"
 #include "base/numerics/safe_conversions.h"
+#include "media/cast/constants.h"
 
 namespace media {
 namespace cast {
@@ -19,7 +22,25 @@ static const int64_t kPacingIntervalMs = 10;
 // Each frame will be split into no more than kPacingMaxBurstsPerFrame
 // bursts of packets.
 static const size_t kPacingMaxBurstsPerFrame = 3;
-static const size_t kMaxDedupeWindowMs = 500;
+
+// Number of recent frames of each RTP stream whose send records are kept, in a
+// ring indexed by FrameId.  A power of two, and enough to cover every
+// unacknowledged frame.
+static const size_t kSendHistoryFrames = 128;
+static_assert(kSendHistoryFrames >= static_cast<size_t>(kMaxUnackedFrames),
+              "Send history must cover every unacknowledged frame.");
+static_assert((kSendHistoryFrames & (kSendHistoryFrames - 1)) == 0,
+              "kSendHistoryFrames must be a power of two.");
+
+static size_t SendHistoryIndex(FrameId frame_id) {
+  return static_cast<size_t>(frame_id - FrameId::first()) &
+         (kSendHistoryFrames - 1);
+}
+
+static bool IsSameFrame(const PacketKey& a, const PacketKey& b) {
+  return a.capture_time == b.capture_time && a.ssrc == b.ssrc &&
+         a.frame_id == b.frame_id;
+}
 
 // "Impossible" upper-bound on the maximum number of packets that should ever be
 // enqueued in the pacer.  This is used to detect bugs, reported as crash dumps.
@@ -48,26 +69,53 @@ PacketKey::~PacketKey() {}
 
 struct PacedSender::PacketSendRecord {
   PacketSendRecord()
-      : last_byte_sent(0), last_byte_sent_for_audio(0), cancel_count(0) {}
-
+      : is_valid(false),
+        last_byte_sent(0),
+        last_byte_sent_for_audio(0),
+        size(0),
+        was_resent(false),
+        cancel_count(0) {}
+
+  bool is_valid;           // Whether the packet has been sent.
   base::TimeTicks time;    // Time when the packet was sent.
   int64_t last_byte_sent;  // Number of bytes sent to network just after this
                            // packet was sent.
   int64_t last_byte_sent_for_audio;  // Number of bytes sent to network from
                                      // audio stream just before this packet.
+  size_t size;       // Size of the packet in bytes.
+  bool was_resent;   // Whether the packet has been sent more than once.
   int cancel_count;  // Number of times the packet was canceled (debugging).
 };
 
+struct PacedSender::BurstPacket {
+  PacketType type;
+  PacketKey key;
+  PacketRef packet;
+  bool from_priority_list;  // Which list to return the packet to if unsent.
+};
+
+// The send records of the packets of one frame, indexed by packet ID.
+struct PacedSender::FrameSendRecords {
+  base::TimeTicks capture_time;
+  FrameId frame_id;
+  std::vector<PacketSendRecord> packets;
+};
+
 struct PacedSender::RtpSession {
-  explicit RtpSession(bool is_audio_stream)
-      : last_byte_sent(0), is_audio(is_audio_stream) {}
-  RtpSession() {}
+  RtpSession(uint32_t ssrc, bool is_audio_stream)
+      : ssrc(ssrc),
+        last_byte_sent(0),
+        is_audio(is_audio_stream),
+        send_history(kSendHistoryFrames) {}
 
+  uint32_t ssrc;
   // Tracks recently-logged RTP timestamps so that it can expand the truncated
   // values found in packets.
   RtpTimeTicks last_logged_rtp_timestamp_;
   int64_t last_byte_sent;
   bool is_audio;
+  // Ring of the send records of recent frames, indexed by SendHistoryIndex().
+  std::vector<FrameSendRecords> send_history;
 };
 
 PacedSender::PacedSender(
@@ -81,6 +129,7 @@ PacedSender::PacedSender(
       recent_packet_events_(recent_packet_events),
       transport_(transport),
       transport_task_runner_(transport_task_runner),
+      pacing_host_(nullptr),
       last_byte_sent_for_audio_(0),
       target_burst_size_(target_burst_size),
       max_burst_size_(max_burst_size),
@@ -92,13 +141,29 @@ PacedSender::PacedSender(
       has_reached_upper_bound_once_(false),
       weak_factory_(this) {}
 
-PacedSender::~PacedSender() {}
+PacedSender::~PacedSender() {
+  if (pacing_host_)
+    pacing_host_->RemoveClient(this);
+}
+
+void PacedSender::SetPacingHost(PacingHost* pacing_host) {
+  DCHECK(empty());
+  DCHECK(!pacing_host_);
+  pacing_host_ = pacing_host;
+}
+
+void PacedSender::OnWakeup() {
+  SendStoredPackets();
+}
 
 void PacedSender::RegisterSsrc(uint32_t ssrc, bool is_audio) {
-  if (sessions_.find(ssrc) != sessions_.end())
+  RtpSession* const session = FindSession(ssrc);
+  if (session) {
     DVLOG(1) << "Re-register ssrc: " << ssrc;
-
-  sessions_[ssrc] = RtpSession(is_audio);
+    *session = RtpSession(ssrc, is_audio);
+  } else {
+    sessions_.push_back(RtpSession(ssrc, is_audio));
+  }
 }
 
 void PacedSender::RegisterPrioritySsrc(uint32_t ssrc) {
@@ -106,18 +171,29 @@ void PacedSender::RegisterPrioritySsrc(uint32_t ssrc) {
 }
 
 int64_t PacedSender::GetLastByteSentForPacket(const PacketKey& packet_key) {
-  PacketSendHistory::const_iterator it = send_history_.find(packet_key);
-  if (it == send_history_.end())
+  const PacketSendRecord* const send_record = FindSendRecord(packet_key);
+  if (!send_record)
     return 0;
-  return it->second.last_byte_sent;
+  return send_record->last_byte_sent;
+}
+
+bool PacedSender::GetPacketSendTime(const PacketKey& packet_key,
+                                    base::TimeTicks* send_time,
+                                    size_t* size) {
+  const PacketSendRecord* const send_record = FindSendRecord(packet_key);
+  if (!send_record || send_record->was_resent)
+    return false;
+  *send_time = send_record->time;
+  *size = send_record->size;
+  return true;
 }
 
 int64_t PacedSender::GetLastByteSentForSsrc(uint32_t ssrc) {
-  auto it = sessions_.find(ssrc);
+  const RtpSession* const session = FindSession(ssrc);
   // Return 0 for unknown session.
-  if (it == sessions_.end())
+  if (!session)
     return 0;
-  return it->second.last_byte_sent;
+  return session->last_byte_sent;
 }
 
 bool PacedSender::SendPackets(const SendPacketVector& packets) {
@@ -127,12 +203,11 @@ bool PacedSender::SendPackets(const SendPacketVector& packets) {
   const bool high_priority = IsHighPriority(packets.begin()->first);
   for (size_t i = 0; i < packets.size(); i++) {
     if (VLOG_IS_ON(2)) {
-      PacketSendHistory::const_iterator history_it =
-          send_history_.find(packets[i].first);
-      if (history_it != send_history_.end() &&
-          history_it->second.cancel_count > 0) {
+      const PacketSendRecord* const send_record =
+          FindSendRecord(packets[i].first);
+      if (send_record && send_record->cancel_count > 0) {
         VLOG(2) << "PacedSender::SendPackets() called for packet CANCELED "
-                << history_it->second.cancel_count << " times: "
+                << send_record->cancel_count << " times: "
                 << "ssrc=" << packets[i].first.ssrc
                 << ", frame_id=" << packets[i].first.frame_id
                 << ", packet_id=" << packets[i].first.packet_id;
@@ -157,10 +232,10 @@ bool PacedSender::SendPackets(const SendPacketVector& packets) {
 bool PacedSender::ShouldResend(const PacketKey& packet_key,
                                const DedupInfo& dedup_info,
                                const base::TimeTicks& now) {
-  PacketSendHistory::const_iterator it = send_history_.find(packet_key);
+  const PacketSendRecord* const send_record = FindSendRecord(packet_key);
 
   // No history of previous transmission. It might be sent too long ago.
-  if (it == send_history_.end())
+  if (!send_record)
     return true;
 
   // Suppose there is request to retransmit X and there is an audio
@@ -170,19 +245,19 @@ bool PacedSender::ShouldResend(const PacketKey& packet_key,
   //
   // TODO(miu): This sounds wrong.  Audio packets are always transmitted first
   // (because they are put in |priority_packet_list_|, see PopNextPacket()).
-  auto session_it = sessions_.find(packet_key.ssrc);
-  // The session should always have been registered in |sessions_|.
-  DCHECK(session_it != sessions_.end());
-  if (!session_it->second.is_audio) {
+  // The session should always have been registered in |sessions_|, since
+  // there is a send record.
+  const RtpSession* const session = FindSession(packet_key.ssrc);
+  if (!session->is_audio) {
     if (dedup_info.last_byte_acked_for_audio &&
-        it->second.last_byte_sent_for_audio &&
+        send_record->last_byte_sent_for_audio &&
         dedup_info.last_byte_acked_for_audio <
-        it->second.last_byte_sent_for_audio) {
+        send_record->last_byte_sent_for_audio) {
       return false;
     }
   }
   // Retransmission interval has to be greater than |resend_interval|.
-  if (now - it->second.time < dedup_info.resend_interval)
+  if (now - send_record->time < dedup_info.resend_interval)
     return false;
   return true;
 }
@@ -196,12 +271,11 @@ bool PacedSender::ResendPackets(const SendPacketVector& packets,
   const base::TimeTicks now = clock_->NowTicks();
   for (size_t i = 0; i < packets.size(); i++) {
     if (VLOG_IS_ON(2)) {
-      PacketSendHistory::const_iterator history_it =
-          send_history_.find(packets[i].first);
-      if (history_it != send_history_.end() &&
-          history_it->second.cancel_count > 0) {
+      const PacketSendRecord* const send_record =
+          FindSendRecord(packets[i].first);
+      if (send_record && send_record->cancel_count > 0) {
         VLOG(2) << "PacedSender::ReendPackets() called for packet CANCELED "
-                << history_it->second.cancel_count << " times: "
+                << send_record->cancel_count << " times: "
                 << "ssrc=" << packets[i].first.ssrc
                 << ", frame_id=" << packets[i].first.frame_id
                 << ", packet_id=" << packets[i].first.packet_id;
@@ -234,6 +308,8 @@ bool PacedSender::SendRtcpPacket(uint32_t ssrc, PacketRef packet) {
     priority_packet_list_[key] = make_pair(PacketType_RTCP, packet);
   } else {
     // We pass the RTCP packets straight through.
+    if (pacing_host_)
+      pacing_host_->OnBytesSent(packet->data.size());
     if (!transport_->SendPacket(
             packet,
             base::Bind(&PacedSender::SendStoredPackets,
@@ -249,9 +325,9 @@ void PacedSender::CancelSendingPacket(const PacketKey& packet_key) {
   priority_packet_list_.erase(packet_key);
 
   if (VLOG_IS_ON(2)) {
-    PacketSendHistory::iterator history_it = send_history_.find(packet_key);
-    if (history_it != send_history_.end())
-      ++history_it->second.cancel_count;
+    PacketSendRecord* const send_record = FindSendRecord(packet_key);
+    if (send_record)
+      ++send_record->cancel_count;
   }
 }
 
@@ -263,45 +339,27 @@ PacketRef PacedSender::PopNextPacket(PacketType* packet_type,
   DCHECK(!list->empty());
 
   // Determine which packet in the frame should be popped by examining the
-  // |send_history_| for prior transmission attempts.  Packets that have never
+  // send records for prior transmission attempts.  Packets that have never
   // been transmitted will be popped first.  If all packets have transmitted
   // before, pop the one that has not been re-attempted for the longest time.
-  PacketList::iterator it = list->begin();
-  PacketKey last_key = it->first;
-  last_key.packet_id = UINT16_C(0xffff);
-  PacketSendHistory::const_iterator history_it =
-      send_history_.lower_bound(it->first);
+  const PacketKey& first_key = list->begin()->first;
   base::TimeTicks earliest_send_time =
       base::TimeTicks() + base::TimeDelta::Max();
-  PacketList::iterator found_it = it;
-  while (true) {
-    if (history_it == send_history_.end() || it->first < history_it->first) {
-      // There is no send history for this packet, which means it has not been
+  PacketList::iterator found_it = list->begin();
+  for (PacketList::iterator it = list->begin();
+       it != list->end() && IsSameFrame(it->first, first_key); ++it) {
+    const PacketSendRecord* const send_record = FindSendRecord(it->first);
+    if (!send_record) {
+      // There is no send record for this packet, which means it has not been
       // transmitted yet.
       found_it = it;
       break;
     }
 
-    DCHECK(it->first == history_it->first);
-    if (history_it->second.time < earliest_send_time) {
-      earliest_send_time = history_it->second.time;
+    if (send_record->time < earliest_send_time) {
+      earliest_send_time = send_record->time;
       found_it = it;
     }
-
-    // Advance to next packet for the current frame, or break if there are no
-    // more.
-    ++it;
-    if (it == list->end() || last_key < it->first)
-      break;
-
-    // Advance to next history entry.  Since there may be "holes" in the packet
-    // list (e.g., due to packets canceled for retransmission), it's possible
-    // |history_it| will have to be advanced more than once even though |it| was
-    // only advanced once.
-    do {
-      ++history_it;
-    } while (history_it != send_history_.end() &&
-             history_it->first < it->first);
   }
 
   *packet_type = found_it->second.first;
@@ -316,6 +374,50 @@ bool PacedSender::IsHighPriority(const PacketKey& packet_key) const {
                    packet_key.ssrc) != priority_ssrcs_.end();
 }
 
+PacedSender::RtpSession* PacedSender::FindSession(uint32_t ssrc) {
+  for (RtpSession& session : sessions_) {
+    if (session.ssrc == ssrc)
+      return &session;
+  }
+  return nullptr;
+}
+
+PacedSender::PacketSendRecord* PacedSender::FindSendRecord(
+    const PacketKey& packet_key) {
+  RtpSession* const session = FindSession(packet_key.ssrc);
+  if (!session)
+    return nullptr;
+  FrameSendRecords& frame =
+      session->send_history[SendHistoryIndex(packet_key.frame_id)];
+  if (frame.frame_id != packet_key.frame_id ||
+      frame.capture_time != packet_key.capture_time ||
+      packet_key.packet_id >= frame.packets.size() ||
+      !frame.packets[packet_key.packet_id].is_valid) {
+    return nullptr;
+  }
+  return &frame.packets[packet_key.packet_id];
+}
+
+PacedSender::PacketSendRecord* PacedSender::AddSendRecord(
+    const PacketKey& packet_key) {
+  RtpSession* const session = FindSession(packet_key.ssrc);
+  DCHECK(session);
+  FrameSendRecords& frame =
+      session->send_history[SendHistoryIndex(packet_key.frame_id)];
+  if (frame.frame_id != packet_key.frame_id ||
+      frame.capture_time != packet_key.capture_time) {
+    // Reuse the slot of a frame old enough to have been forgotten.
+    frame.frame_id = packet_key.frame_id;
+    frame.capture_time = packet_key.capture_time;
+    frame.packets.clear();
+  }
+  if (packet_key.packet_id >= frame.packets.size())
+    frame.packets.resize(packet_key.packet_id + 1);
+  PacketSendRecord* const send_record = &frame.packets[packet_key.packet_id];
+  send_record->is_valid = true;
+  return send_record;
+}
+
 bool PacedSender::empty() const {
   return packet_list_.empty() && priority_packet_list_.empty();
 }
@@ -324,12 +426,15 @@ size_t PacedSender::size() const {
   return packet_list_.size() + priority_packet_list_.size();
 }
 
-// This function can be called from three places:
+// This function can be called from four places:
 // 1. User called one of the Send* functions and we were in an unblocked state.
 // 2. state_ == State_TransportBlocked and the transport is calling us to
 //    let us know that it's ok to send again.
 // 3. state_ == State_BurstFull and there are still packets to send. In this
-//    case we called PostDelayedTask on this function to start a new burst.
+//    case we called PostDelayedTask on this function, or asked |pacing_host_|
+//    to wake us, to start a new burst.
+// 4. state_ == State_EgressLimited and |pacing_host_| has some of its egress
+//    budget for us.
 void PacedSender::SendStoredPackets() {
   State previous_state = state_;
   state_ = State_Unblocked;
@@ -353,7 +458,13 @@ void PacedSender::SendStoredPackets() {
   if (now >= burst_end_ || previous_state == State_BurstFull) {
     // Start a new burst.
     current_burst_size_ = 0;
-    burst_end_ = now + base::TimeDelta::FromMilliseconds(kPacingIntervalMs);
+    // A hosted burst starts on the tick it was woken for, even if the host's
+    // task ran late, so that its wakeup falls on the next tick rather than the
+    // one after.
+    const base::TimeTicks burst_start =
+        pacing_host_ ? pacing_host_->GetTickAtOrBefore(now) : now;
+    burst_end_ =
+        burst_start + base::TimeDelta::FromMilliseconds(kPacingIntervalMs);
 
     // The goal here is to try to send out the queued packets over the next
     // three bursts, while trying to keep the burst size below 10 if possible.
@@ -373,73 +484,122 @@ void PacedSender::SendStoredPackets() {
     next_next_max_burst_size_ = max_burst_size;
   }
 
+  // The share of the egress budget of |pacing_host_| which may be used now.
+  // The last packet may overdraw it.
+  int64_t egress_allowance = pacing_host_
+                                 ? pacing_host_->GetEgressAllowance()
+                                 : std::numeric_limits<int64_t>::max();
+
   base::Closure cb = base::Bind(&PacedSender::SendStoredPackets,
                                 weak_factory_.GetWeakPtr());
+  std::vector<BurstPacket> burst;
+  std::vector<PacketRef> burst_packets;
   while (!empty()) {
     if (current_burst_size_ >= current_max_burst_size_) {
-      transport_task_runner_->PostDelayedTask(FROM_HERE,
-                                              cb,
-                                              burst_end_ - now);
+      if (pacing_host_) {
+        pacing_host_->ScheduleWakeup(this, burst_end_);
+      } else {
+        transport_task_runner_->PostDelayedTask(FROM_HERE,
+                                                cb,
+                                                burst_end_ - now);
+      }
       state_ = State_BurstFull;
       return;
     }
-    PacketType packet_type;
-    PacketKey packet_key;
-    PacketRef packet = PopNextPacket(&packet_type, &packet_key);
-    PacketSendRecord* const send_record = &(send_history_[packet_key]);
-    send_record->time = now;
-
-    if (send_record->cancel_count > 0 && packet_type != PacketType_RTCP) {
-      VLOG(2) << "PacedSender is sending a packet known to have been CANCELED "
-              << send_record->cancel_count << " times: "
-              << "ssrc=" << packet_key.ssrc
-              << ", frame_id=" << packet_key.frame_id
-              << ", packet_id=" << packet_key.packet_id;
+    if (egress_allowance <= 0) {
+      pacing_host_->WaitForEgress(this);
+      state_ = State_EgressLimited;
+      return;
     }
 
-    switch (packet_type) {
-      case PacketType_Resend:
-        LogPacketEvent(packet->data, PACKET_RETRANSMITTED);
-        break;
-      case PacketType_Normal:
-        LogPacketEvent(packet->data, PACKET_SENT_TO_NETWORK);
-        break;
-      case PacketType_RTCP:
-        break;
+    // Hand the rest of the burst to the transport at once, so that it can
+    // send them with a single system call.
+    burst.clear();
+    burst_packets.clear();
+    while (!empty() &&
+           burst.size() < current_max_burst_size_ - current_burst_size_ &&
+           egress_allowance > 0) {
+      BurstPacket burst_packet;
+      burst_packet.from_priority_list = !priority_packet_list_.empty();
+      burst_packet.packet =
+          PopNextPacket(&burst_packet.type, &burst_packet.key);
+      egress_allowance -= burst_packet.packet->data.size();
+      burst.push_back(burst_packet);
+      burst_packets.push_back(burst_packet.packet);
     }
 
-    const bool socket_blocked = !transport_->SendPacket(packet, cb);
+    const int64_t bytes_sent_before = transport_->GetBytesSent();
+    size_t num_sent = 0;
+    const bool socket_blocked =
+        !transport_->SendPackets(burst_packets, cb, &num_sent);
+    DCHECK_LE(num_sent, burst.size());
+    DCHECK(socket_blocked ? num_sent > 0 : num_sent == burst.size());
+    const int64_t bytes_sent_after = transport_->GetBytesSent();
+
+    int64_t bytes_sent = bytes_sent_before;
+    for (size_t i = 0; i < num_sent; ++i) {
+      const BurstPacket& burst_packet = burst[i];
+      RtpSession* const session = FindSession(burst_packet.key.ssrc);
+      // The session should always have been registered in |sessions_|.
+      DCHECK(session);
+
+      // Transports may not count a packet which blocked until it is actually
+      // sent, hence the clamp.
+      bytes_sent += burst_packet.packet->data.size();
+      const int64_t last_byte_sent = std::min(bytes_sent, bytes_sent_after);
+
+      // Save the send record.  RTCP packets are never retransmitted, so they
+      // don't need one.
+      if (burst_packet.type != PacketType_RTCP) {
+        PacketSendRecord* const send_record = AddSendRecord(burst_packet.key);
+        if (send_record->cancel_count > 0) {
+          VLOG(2) << "PacedSender is sending a packet known to have been "
+                  << "CANCELED " << send_record->cancel_count << " times: "
+                  << "ssrc=" << burst_packet.key.ssrc
+                  << ", frame_id=" << burst_packet.key.frame_id
+                  << ", packet_id=" << burst_packet.key.packet_id;
+        }
+        send_record->time = now;
+        send_record->last_byte_sent = last_byte_sent;
+        send_record->last_byte_sent_for_audio = last_byte_sent_for_audio_;
+        send_record->size = burst_packet.packet->data.size();
+        if (burst_packet.type == PacketType_Resend)
+          send_record->was_resent = true;
+      }
 
-    // Save the send record.
-    send_record->last_byte_sent = transport_->GetBytesSent();
-    send_record->last_byte_sent_for_audio = last_byte_sent_for_audio_;
-    send_history_buffer_[packet_key] = *send_record;
+      switch (burst_packet.type) {
+        case PacketType_Resend:
+          LogPacketEvent(burst_packet.packet->data, PACKET_RETRANSMITTED);
+          break;
+        case PacketType_Normal:
+          LogPacketEvent(burst_packet.packet->data, PACKET_SENT_TO_NETWORK);
+          break;
+        case PacketType_RTCP:
+          break;
+      }
 
-    auto it = sessions_.find(packet_key.ssrc);
-    // The session should always have been registered in |sessions_|.
-    DCHECK(it != sessions_.end());
-    it->second.last_byte_sent = send_record->last_byte_sent;
-    if (it->second.is_audio)
-      last_byte_sent_for_audio_ = send_record->last_byte_sent;
+      session->last_byte_sent = last_byte_sent;
+      if (session->is_audio)
+        last_byte_sent_for_audio_ = last_byte_sent;
+    }
+    if (pacing_host_)
+      pacing_host_->OnBytesSent(bytes_sent - bytes_sent_before);
 
     if (socket_blocked) {
+      // Packets the transport didn't take are sent once it unblocks.
+      for (size_t i = num_sent; i < burst.size(); ++i) {
+        PacketList* list = burst[i].from_priority_list ? &priority_packet_list_
+                                                       : &packet_list_;
+        (*list)[burst[i].key] = std::make_pair(burst[i].type, burst[i].packet);
+      }
+      // The packet which blocked doesn't count towards the burst.
+      current_burst_size_ += num_sent - 1;
       state_ = State_TransportBlocked;
       return;
     }
-    current_burst_size_++;
+    current_burst_size_ += num_sent;
   }
 
-  // Keep ~0.5 seconds of data (1000 packets).
-  //
-  // TODO(miu): This has no relation to the actual size of the frames, and so
-  // there's no way to reason whether 1000 is enough or too much, or whatever.
-  if (send_history_buffer_.size() >=
-      max_burst_size_ * kMaxDedupeWindowMs / kPacingIntervalMs) {
-    send_history_.swap(send_history_buffer_);
-    send_history_buffer_.clear();
-  }
-  DCHECK_LE(send_history_buffer_.size(),
-            max_burst_size_ * kMaxDedupeWindowMs / kPacingIntervalMs);
   state_ = State_Unblocked;
 }
 
@@ -463,12 +623,12 @@ void PacedSender::LogPacketEvent(const Packet& packet, CastLoggingEvent type) {
   uint32_t ssrc;
   success &= reader.ReadU32(&ssrc);
 
-  auto it = sessions_.find(ssrc);
+  RtpSession* const session = FindSession(ssrc);
   // The session should always have been registered in |sessions_|.
-  DCHECK(it != sessions_.end());
-  event.rtp_timestamp = it->second.last_logged_rtp_timestamp_ =
-      it->second.last_logged_rtp_timestamp_.Expand(truncated_rtp_timestamp);
-  event.media_type = it->second.is_audio ? AUDIO_EVENT : VIDEO_EVENT;
+  DCHECK(session);
+  event.rtp_timestamp = session->last_logged_rtp_timestamp_ =
+      session->last_logged_rtp_timestamp_.Expand(truncated_rtp_timestamp);
+  event.media_type = session->is_audio ? AUDIO_EVENT : VIDEO_EVENT;
   success &= reader.Skip(2);
   success &= reader.ReadU16(&event.packet_id);
   success &= reader.ReadU16(&event.max_packet_id);
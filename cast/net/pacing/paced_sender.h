@@ -22,6 +22,7 @@
 #include "base/time/time.h"
 #include "media/cast/logging/logging_defines.h"
 #include "media/cast/net/cast_transport_config.h"
+#include "media/cast/net/pacing/pacing_host.h"
 
 namespace media {
 namespace cast {
@@ -97,6 +98,7 @@ class PacedPacketSender {
 };
 
 class PacedSender : public PacedPacketSender,
+                    public PacingHost::Client,
                     public base::NonThreadSafe,
                     public base::SupportsWeakPtr<PacedSender> {
  public:
@@ -134,6 +136,13 @@ class PacedSender : public PacedPacketSender,
   // This function is currently only used by unittests.
   int64_t GetLastByteSentForSsrc(uint32_t ssrc);
 
+  // Sets |send_time| and |size| to when the specified packet was sent and how
+  // big it was.  Returns false if the packet cannot be found, or has been
+  // retransmitted so that it is unknown which copy a receiver saw.
+  bool GetPacketSendTime(const PacketKey& packet_key,
+                         base::TimeTicks* send_time,
+                         size_t* size);
+
   // PacedPacketSender implementation.
   bool SendPackets(const SendPacketVector& packets) final;
   bool ResendPackets(const SendPacketVector& packets,
@@ -148,6 +157,15 @@ class PacedSender : public PacedPacketSender,
 
   void SetMaxBurstSize(int burst_size) { max_burst_size_ = burst_size; }
 
+  // Hands the timing of bursts to |pacing_host|, to be paced together with
+  // the senders of other sessions and within their shared egress bound.  Must
+  // be called before any packets are sent, and |pacing_host| must outlive
+  // this object.
+  void SetPacingHost(PacingHost* pacing_host);
+
+  // PacingHost::Client implementation.
+  void OnWakeup() final;
+
  private:
   // Actually sends the packets to the transport.
   void SendStoredPackets();
@@ -182,7 +200,11 @@ class PacedSender : public PacedPacketSender,
     // Once we've written enough packets for a time slice, we go into this
     // state and PostDelayTask a call to ourselves to wake up when we can
     // send more data.
-    State_BurstFull
+    State_BurstFull,
+    // The egress bound of |pacing_host_| has been reached, and we wait for it
+    // to wake us when it is our turn to send again.  The burst carries on
+    // where it left off.
+    State_EgressLimited
   };
 
   bool empty() const;
@@ -200,6 +222,20 @@ class PacedSender : public PacedPacketSender,
   // Returns true if the packet should have a higher priority.
   bool IsHighPriority(const PacketKey& packet_key) const;
 
+  struct RtpSession;
+  struct PacketSendRecord;
+
+  // Returns the session registered for |ssrc|, or nullptr if there is none.
+  RtpSession* FindSession(uint32_t ssrc);
+
+  // Returns the record of when the packet indexed by |packet_key| was last
+  // sent, or nullptr if it hasn't been sent recently.
+  PacketSendRecord* FindSendRecord(const PacketKey& packet_key);
+
+  // Returns the send record for |packet_key|, creating it if needed.  The
+  // SSRC must have been registered.
+  PacketSendRecord* AddSendRecord(const PacketKey& packet_key);
+
   // These are externally-owned objects injected via the constructor.
   base::TickClock* const clock_;
   std::vector<PacketEvent>* const recent_packet_events_;
@@ -207,6 +243,9 @@ class PacedSender : public PacedPacketSender,
 
   scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
 
+  // Schedules the bursts instead of |transport_task_runner_|, if set.
+  PacingHost* pacing_host_;  // Not owned by this class.
+
   // Set of SSRCs that have higher priority. This is a vector instead of a
   // set because there's only very few in it (most likely 1).
   std::vector<uint32_t> priority_ssrcs_;
@@ -214,16 +253,13 @@ class PacedSender : public PacedPacketSender,
   PacketList packet_list_;
   PacketList priority_packet_list_;
 
-  struct PacketSendRecord;
-  using PacketSendHistory = std::map<PacketKey, PacketSendRecord>;
-  PacketSendHistory send_history_;
-  PacketSendHistory send_history_buffer_;
+  struct BurstPacket;
+  struct FrameSendRecords;
 
-  struct RtpSession;
-  using SessionMap = std::map<uint32_t, RtpSession>;
-  // Records all the cast sessions with the sender SSRC as the key. These
-  // sessions are in sync with those in CastTransportImpl.
-  SessionMap sessions_;
+  // Records all the cast sessions, each with the send history of its recent
+  // frames.  These sessions are in sync with those in CastTransportImpl.  There
+  // are only a few, so they are searched linearly.
+  std::vector<RtpSession> sessions_;
 
   // Records the last byte sent for audio payload.
   int64_t last_byte_sent_for_audio_;
@@ -4,11 +4,14 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include <algorithm>
 #include <deque>
+#include <vector>
 
 #include "base/big_endian.h"
+#include "base/callback_helpers.h"
 #include "base/macros.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/base/fake_single_thread_task_runner.h"
@@ -40,9 +43,11 @@ const uint16_t kRtcpPacketIdMagic = UINT16_C(31611);
 
 class TestPacketSender : public PacketTransport {
  public:
-  TestPacketSender() : bytes_sent_(0) {}
+  TestPacketSender()
+      : bytes_sent_(0), send_packets_calls_(0), packets_until_blocked_(0) {}
 
   bool SendPacket(PacketRef packet, const base::Closure& cb) final {
+    EXPECT_TRUE(blocked_cb_.is_null());
     EXPECT_FALSE(expected_packet_sizes_.empty());
     size_t expected_packet_size = expected_packet_sizes_.front();
     expected_packet_sizes_.pop_front();
@@ -61,9 +66,20 @@ class TestPacketSender : public PacketTransport {
     expected_packet_ids_.pop_front();
     EXPECT_EQ(expected_packet_id, packet_id);
 
+    if (packets_until_blocked_ > 0 && --packets_until_blocked_ == 0) {
+      blocked_cb_ = cb;
+      return false;
+    }
     return true;
   }
 
+  bool SendPackets(const PacketList& packets,
+                   const base::Closure& cb,
+                   size_t* num_sent) final {
+    ++send_packets_calls_;
+    return PacketTransport::SendPackets(packets, cb, num_sent);
+  }
+
   int64_t GetBytesSent() final { return bytes_sent_; }
 
   void StartReceiving(
@@ -71,6 +87,14 @@ class TestPacketSender : public PacketTransport {
 
   void StopReceiving() final {}
 
+  int send_packets_calls() const { return send_packets_calls_; }
+
+  // Blocks on the |count|th packet sent from now on.  Like a socket, the
+  // transport still takes that packet, but no more until Unblock().
+  void BlockOnPacket(int count) { packets_until_blocked_ = count; }
+  bool is_blocked() const { return !blocked_cb_.is_null(); }
+  void Unblock() { base::ResetAndReturn(&blocked_cb_).Run(); }
+
   void AddExpectedSizesAndPacketIds(int packet_size,
                                     uint16_t first_packet_id,
                                     int sequence_length) {
@@ -86,10 +110,40 @@ class TestPacketSender : public PacketTransport {
   std::deque<int> expected_packet_sizes_;
   std::deque<uint16_t> expected_packet_ids_;
   int64_t bytes_sent_;
+  int send_packets_calls_;
+  int packets_until_blocked_;
+  base::Closure blocked_cb_;
 
   DISALLOW_COPY_AND_ASSIGN(TestPacketSender);
 };
 
+// Counts packets without checking them, for benchmarking.
+class CountingPacketSender : public PacketTransport {
+ public:
+  CountingPacketSender() : bytes_sent_(0), packets_sent_(0) {}
+
+  bool SendPacket(PacketRef packet, const base::Closure& cb) final {
+    bytes_sent_ += packet->data.size();
+    ++packets_sent_;
+    return true;
+  }
+
+  int64_t GetBytesSent() final { return bytes_sent_; }
+
+  void StartReceiving(
+      const PacketReceiverCallbackWithStatus& packet_receiver) final {}
+
+  void StopReceiving() final {}
+
+  int packets_sent() const { return packets_sent_; }
+
+ private:
+  int64_t bytes_sent_;
+  int packets_sent_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingPacketSender);
+};
+
 class PacedSenderTest : public ::testing::Test {
  protected:
   PacedSenderTest() {
@@ -236,6 +290,88 @@ TEST_F(PacedSenderTest, BasicPace) {
   }
 }
 
+TEST_F(PacedSenderTest, SendsEachBurstWithOneCall) {
+  SendPacketVector packets = CreateSendPacketVector(kSize1, 20, false);
+
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 10);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+  EXPECT_EQ(1, mock_transport_.send_packets_calls());
+
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(10), 10);
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(10));
+  task_runner_->RunTasks();
+  EXPECT_EQ(2, mock_transport_.send_packets_calls());
+  EXPECT_TRUE(mock_transport_.expecting_nothing_else());
+}
+
+TEST_F(PacedSenderTest, RequeuesPacketsWhenTheTransportBlocks) {
+  SendPacketVector packets = CreateSendPacketVector(kSize1, 20, false);
+
+  // The transport takes the first four packets of the burst and blocks on the
+  // last of them.
+  mock_transport_.BlockOnPacket(4);
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 4);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+  EXPECT_EQ(1, mock_transport_.send_packets_calls());
+  EXPECT_TRUE(mock_transport_.is_blocked());
+  EXPECT_TRUE(mock_transport_.expecting_nothing_else());
+
+  // Nothing is sent while the transport is blocked.
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(5));
+  task_runner_->RunTasks();
+  EXPECT_EQ(1, mock_transport_.send_packets_calls());
+
+  // Once unblocked, the rest of the burst goes out.  The packet which blocked
+  // isn't sent again and doesn't count towards the burst.
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(4), 7);
+  mock_transport_.Unblock();
+  EXPECT_EQ(2, mock_transport_.send_packets_calls());
+  EXPECT_TRUE(mock_transport_.expecting_nothing_else());
+
+  // The remaining packets go out with the next burst.
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(11), 9);
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(5));
+  task_runner_->RunTasks();
+  EXPECT_EQ(3, mock_transport_.send_packets_calls());
+  EXPECT_TRUE(mock_transport_.expecting_nothing_else());
+
+  // Every packet is logged exactly once, in order.
+  ASSERT_EQ(20u, packet_events_.size());
+  for (size_t i = 0; i < packet_events_.size(); ++i)
+    EXPECT_EQ(i, packet_events_[i].packet_id);
+}
+
+TEST_F(PacedSenderTest, HostedBurstsKeepPaceWhenTasksRunLate) {
+  PacingHost pacing_host(&testing_clock_, task_runner_, 0);
+  paced_sender_->SetPacingHost(&pacing_host);
+
+  const int kNumPackets = 100;
+  SendPacketVector packets = CreateSendPacketVector(kSize1, kNumPackets, false);
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0),
+                                               kNumPackets);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+
+  // Run the host's tasks up to 2 ms after they are due.  Each burst should
+  // still go out on the tick after the previous one, not the one after that.
+  std::vector<base::TimeTicks> burst_times(1, testing_clock_.NowTicks());
+  for (int i = 0; i < 1000 && !mock_transport_.expecting_nothing_else(); ++i) {
+    const int send_packets_calls = mock_transport_.send_packets_calls();
+    testing_clock_.Advance(base::TimeDelta::FromMilliseconds(3));
+    task_runner_->RunTasks();
+    if (mock_transport_.send_packets_calls() != send_packets_calls)
+      burst_times.push_back(testing_clock_.NowTicks());
+  }
+  EXPECT_TRUE(mock_transport_.expecting_nothing_else());
+  ASSERT_LT(2u, burst_times.size());
+  for (size_t i = 1; i < burst_times.size(); ++i) {
+    EXPECT_GE(base::TimeDelta::FromMilliseconds(13),
+              burst_times[i] - burst_times[i - 1]);
+  }
+
+  // The sender must be removed from the host before the host goes away.
+  paced_sender_.reset();
+}
+
 TEST_F(PacedSenderTest, PaceWithNack) {
   // Testing what happen when we get multiple NACK requests for a fully lost
   // frames just as we sent the first packets in a frame.
@@ -487,6 +623,33 @@ TEST_F(PacedSenderTest, GetLastByteSent) {
             paced_sender_->GetLastByteSentForSsrc(kVideoSsrc));
 }
 
+TEST_F(PacedSenderTest, GetPacketSendTime) {
+  SendPacketVector packets = CreateSendPacketVector(kSize1, 2, false);
+  base::TimeTicks send_time;
+  size_t size = 0;
+  EXPECT_FALSE(
+      paced_sender_->GetPacketSendTime(packets[0].first, &send_time, &size));
+
+  const base::TimeTicks first_send_time = testing_clock_.NowTicks();
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 2);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+  ASSERT_TRUE(
+      paced_sender_->GetPacketSendTime(packets[0].first, &send_time, &size));
+  EXPECT_EQ(first_send_time, send_time);
+  EXPECT_EQ(kSize1, size);
+
+  // Once a packet is retransmitted, it's unknown which copy arrived.
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(100));
+  SendPacketVector resend_packets(1, packets[0]);
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 1);
+  EXPECT_TRUE(paced_sender_->ResendPackets(resend_packets, DedupInfo()));
+  EXPECT_FALSE(
+      paced_sender_->GetPacketSendTime(packets[0].first, &send_time, &size));
+  ASSERT_TRUE(
+      paced_sender_->GetPacketSendTime(packets[1].first, &send_time, &size));
+  EXPECT_EQ(first_send_time, send_time);
+}
+
 TEST_F(PacedSenderTest, DedupWithResendInterval) {
   SendPacketVector packets = CreateSendPacketVector(kSize1, 1, true);
   mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 1);
@@ -538,5 +701,61 @@ TEST_F(PacedSenderTest, AllPacketsInSameFrameAreResentFairly) {
   ASSERT_TRUE(mock_transport_.expecting_nothing_else());
 }
 
+// Measures how many packets per second go through PacedSender when a fifth of
+// every frame is retransmitted a few frames later.  Run with
+// --gtest_also_run_disabled_tests.
+TEST_F(PacedSenderTest, DISABLED_PacketRateBenchmark) {
+  const int kNumFrames = 20000;
+  const int kPacketsPerFrame = 50;
+  const int kResendDelayFrames = 3;
+
+  CountingPacketSender transport;
+  PacedSender paced_sender(2 * kPacketsPerFrame, 2 * kPacketsPerFrame,
+                           &testing_clock_, nullptr, &transport, task_runner_);
+  paced_sender.RegisterSsrc(kVideoSsrc, false);
+
+  // The packet contents don't matter, so every packet shares them.
+  const PacketRef packet(
+      new base::RefCountedData<Packet>(Packet(kSize1, kValue)));
+  std::vector<base::TimeTicks> capture_times;
+  SendPacketVector frame;
+  SendPacketVector resend;
+  int expected_packets = 0;
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumFrames; ++i) {
+    capture_times.push_back(testing_clock_.NowTicks());
+    frame.clear();
+    for (int j = 0; j < kPacketsPerFrame; ++j) {
+      frame.push_back(std::make_pair(
+          PacketKey(capture_times.back(), kVideoSsrc, FrameId::first() + i, j),
+          packet));
+    }
+    paced_sender.SendPackets(frame);
+    expected_packets += kPacketsPerFrame;
+
+    if (i >= kResendDelayFrames) {
+      const int resend_frame = i - kResendDelayFrames;
+      resend.clear();
+      for (int j = 0; j < kPacketsPerFrame; j += 5) {
+        resend.push_back(std::make_pair(
+            PacketKey(capture_times[resend_frame], kVideoSsrc,
+                      FrameId::first() + resend_frame, j),
+            packet));
+      }
+      paced_sender.ResendPackets(resend, DedupInfo());
+      expected_packets += resend.size();
+    }
+
+    testing_clock_.Advance(base::TimeDelta::FromMilliseconds(10));
+    task_runner_->RunTasks();
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  EXPECT_EQ(expected_packets, transport.packets_sent());
+  printf("PacedSender: %.0f packets/s\n",
+         transport.packets_sent() / elapsed.InSecondsF());
+}
+
 }  // namespace cast
 }  // namespace media
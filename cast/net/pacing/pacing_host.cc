@@ -0,0 +1,245 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/pacing/pacing_host.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "base/bind.h"
+#include "base/logging.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+// The same as PacedSender's burst interval, so that each burst is started by
+// one tick.
+const int64_t kTickMicroseconds = 10000;
+
+// The number of slots in the wheel.  Pacing wakeups are never more than a tick
+// away, so only longer timers ever wait for more than one turn.
+const size_t kNumSlots = 64;
+
+int64_t TicksSinceOrigin(base::TimeTicks time) {
+  return (time - base::TimeTicks()).InMicroseconds() / kTickMicroseconds;
+}
+
+// The budget a rate of |bitrate| earns in one tick, which is also as much as
+// is ever kept.
+int64_t MaxEgressBudget(int bitrate) {
+  return static_cast<int64_t>(bitrate) * kTickMicroseconds /
+         (8 * base::Time::kMicrosecondsPerSecond);
+}
+
+}  // namespace
+
+PacingHost::PacingHost(
+    base::TickClock* clock,
+    const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+    int max_egress_bitrate)
+    : clock_(clock),
+      transport_task_runner_(transport_task_runner),
+      slots_(kNumSlots),
+      num_due_clients_left_(0),
+      max_egress_bitrate_(max_egress_bitrate),
+      egress_budget_(MaxEgressBudget(max_egress_bitrate)),
+      egress_budget_time_(clock->NowTicks()),
+      num_ticks_run_(0),
+      weak_factory_(this) {
+  DCHECK_GE(max_egress_bitrate, 0);
+  next_tick_ = GetTickAtOrAfter(clock_->NowTicks());
+}
+
+PacingHost::~PacingHost() {
+  DCHECK(wakeups_.empty()) << "Clients must be removed before the host.";
+}
+
+void PacingHost::SetMaxEgressBitrate(int max_egress_bitrate) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_GE(max_egress_bitrate, 0);
+  const base::TimeTicks now = clock_->NowTicks();
+  RefillEgressBudget(now);
+  if (!max_egress_bitrate_) {
+    egress_budget_ = MaxEgressBudget(max_egress_bitrate);
+    egress_budget_time_ = now;
+  }
+  max_egress_bitrate_ = max_egress_bitrate;
+  egress_budget_ =
+      std::min(egress_budget_, MaxEgressBudget(max_egress_bitrate_));
+}
+
+void PacingHost::ScheduleWakeup(Client* client, base::TimeTicks time) {
+  DCHECK(CalledOnValidThread());
+  DCHECK(client);
+
+  // After a time with nothing to do, the slots in between need not be run.
+  if (wakeups_.empty() && scheduled_tick_.is_null())
+    next_tick_ = std::max(next_tick_, GetTickAtOrAfter(clock_->NowTicks()));
+
+  const base::TimeTicks tick = std::max(GetTickAtOrAfter(time), next_tick_);
+  wakeups_[client] = tick;
+  slots_[GetSlot(tick)].push_back(client);
+  ScheduleNextTick();
+}
+
+void PacingHost::RemoveClient(Client* client) {
+  DCHECK(CalledOnValidThread());
+  wakeups_.erase(client);
+  egress_waiters_.erase(client);
+  std::replace(due_clients_.begin(), due_clients_.end(), client,
+               static_cast<Client*>(nullptr));
+}
+
+int64_t PacingHost::GetEgressAllowance() {
+  DCHECK(CalledOnValidThread());
+  if (!max_egress_bitrate_)
+    return std::numeric_limits<int64_t>::max();
+  RefillEgressBudget(clock_->NowTicks());
+  const int64_t budget = std::max<int64_t>(egress_budget_, 0);
+  if (num_due_clients_left_)
+    return budget / num_due_clients_left_;
+  return egress_waiters_.empty() ? budget : 0;
+}
+
+void PacingHost::OnBytesSent(int64_t bytes) {
+  DCHECK(CalledOnValidThread());
+  if (!max_egress_bitrate_)
+    return;
+  RefillEgressBudget(clock_->NowTicks());
+  // The budget may be overdrawn by the last packet sent, and the debt is paid
+  // before anything more is sent.
+  egress_budget_ -= bytes;
+}
+
+void PacingHost::WaitForEgress(Client* client) {
+  DCHECK(CalledOnValidThread());
+  egress_waiters_.insert(client);
+  ScheduleWakeup(client, clock_->NowTicks() +
+                             base::TimeDelta::FromMicroseconds(1));
+}
+
+base::TimeTicks PacingHost::GetTickAtOrAfter(base::TimeTicks time) const {
+  const int64_t microseconds = (time - base::TimeTicks()).InMicroseconds();
+  const int64_t ticks =
+      (microseconds + kTickMicroseconds - 1) / kTickMicroseconds;
+  return base::TimeTicks() +
+         base::TimeDelta::FromMicroseconds(ticks * kTickMicroseconds);
+}
+
+base::TimeTicks PacingHost::GetTickAtOrBefore(base::TimeTicks time) const {
+  return base::TimeTicks() + base::TimeDelta::FromMicroseconds(
+                                 TicksSinceOrigin(time) * kTickMicroseconds);
+}
+
+size_t PacingHost::GetSlot(base::TimeTicks tick_time) const {
+  return static_cast<size_t>(TicksSinceOrigin(tick_time)) % kNumSlots;
+}
+
+void PacingHost::ScheduleNextTick() {
+  if (wakeups_.empty())
+    return;
+
+  // The first slot with entries is the earliest tick with a wakeup.  If those
+  // entries are stale, or for a later turn of the wheel, the task will simply
+  // find nothing to do.
+  const base::TimeDelta tick_duration =
+      base::TimeDelta::FromMicroseconds(kTickMicroseconds);
+  base::TimeTicks tick = next_tick_;
+  for (size_t i = 0; i < kNumSlots && slots_[GetSlot(tick)].empty(); ++i)
+    tick += tick_duration;
+
+  if (!scheduled_tick_.is_null() && scheduled_tick_ <= tick)
+    return;
+  // A task already posted for a later tick finds that it is no longer
+  // |scheduled_tick_|, and does nothing.
+  scheduled_tick_ = tick;
+  transport_task_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&PacingHost::RunTick, weak_factory_.GetWeakPtr(), tick),
+      std::max(tick - clock_->NowTicks(), base::TimeDelta()));
+}
+
+void PacingHost::RunTick(base::TimeTicks tick) {
+  DCHECK(CalledOnValidThread());
+  if (tick != scheduled_tick_)
+    return;
+  scheduled_tick_ = base::TimeTicks();
+  ++num_ticks_run_;
+
+  // Run the slots of every tick which has passed, but each slot only once, for
+  // its latest tick, should the task have been very late.
+  const base::TimeTicks now = clock_->NowTicks();
+  const base::TimeDelta tick_duration =
+      base::TimeDelta::FromMicroseconds(kTickMicroseconds);
+  const base::TimeDelta turn_duration = tick_duration * kNumSlots;
+  if (now - next_tick_ >= turn_duration)
+    next_tick_ += turn_duration * ((now - next_tick_) / turn_duration);
+
+  DCHECK(due_clients_.empty());
+  while (next_tick_ <= now) {
+    const size_t slot_index = GetSlot(next_tick_);
+    std::vector<Client*>& slot = slots_[slot_index];
+    size_t num_kept = 0;
+    for (Client* client : slot) {
+      const auto it = wakeups_.find(client);
+      if (it == wakeups_.end())
+        continue;
+      if (it->second <= next_tick_) {
+        due_clients_.push_back(client);
+        wakeups_.erase(it);
+      } else if (GetSlot(it->second) == slot_index) {
+        slot[num_kept++] = client;  // Due in a later turn of the wheel.
+      }
+    }
+    slot.resize(num_kept);
+    next_tick_ += tick_duration;
+  }
+
+  // Clients waiting for egress come back in the order they were woken, so
+  // moving the first to the back lets them take turns at being first, and the
+  // same ones don't always go without when the budget runs out early.
+  if (due_clients_.size() > 1)
+    std::rotate(due_clients_.begin(), due_clients_.begin() + 1,
+                due_clients_.end());
+
+  // Clients may schedule wakeups, or be removed, as they are woken.
+  for (size_t i = 0; i < due_clients_.size(); ++i) {
+    Client* const client = due_clients_[i];
+    if (!client)
+      continue;
+    num_due_clients_left_ = due_clients_.size() - i;
+    egress_waiters_.erase(client);
+    client->OnWakeup();
+  }
+  num_due_clients_left_ = 0;
+  due_clients_.clear();
+
+  ScheduleNextTick();
+}
+
+void PacingHost::RefillEgressBudget(base::TimeTicks now) {
+  if (!max_egress_bitrate_)
+    return;
+  const int64_t max_budget = MaxEgressBudget(max_egress_bitrate_);
+  // Any debt is long paid after a second, which keeps this from overflowing.
+  const int64_t microseconds =
+      std::min(now - egress_budget_time_, base::TimeDelta::FromSeconds(1))
+          .InMicroseconds();
+  const int64_t bytes = microseconds * max_egress_bitrate_ /
+                        (8 * base::Time::kMicrosecondsPerSecond);
+  if (egress_budget_ + bytes >= max_budget) {
+    egress_budget_ = max_budget;
+    egress_budget_time_ = now;
+  } else if (bytes > 0) {
+    // Keep the remainder of a byte for next time.
+    egress_budget_ += bytes;
+    egress_budget_time_ += base::TimeDelta::FromMicroseconds(
+        bytes * 8 * base::Time::kMicrosecondsPerSecond / max_egress_bitrate_);
+  }
+}
+
+}  // namespace cast
+}  // namespace media
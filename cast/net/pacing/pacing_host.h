@@ -0,0 +1,141 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_NET_PACING_PACING_HOST_H_
+#define MEDIA_CAST_NET_PACING_PACING_HOST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/non_thread_safe.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+
+namespace media {
+namespace cast {
+
+// Schedules the PacedSenders, and other timers, of many cast sessions which
+// run on one transport thread.
+//
+// Timers are kept in a single timer wheel of 10 ms ticks, the pacing interval,
+// so that however many sessions there are, at most one task is pending for
+// all of them, and each tick wakes every client due in it at once.
+//
+// The host can also bound the total rate at which its clients send.  The
+// budget is refilled continuously, up to one tick's worth.  A client which
+// finds it spent waits for the next tick with WaitForEgress(), and the
+// clients woken together in a tick share the budget equally, so that no
+// session is starved by the others.
+class PacingHost : public base::NonThreadSafe {
+ public:
+  class Client {
+   public:
+    // Called on the tick of a wakeup scheduled with ScheduleWakeup() or
+    // WaitForEgress().
+    virtual void OnWakeup() = 0;
+
+   protected:
+    virtual ~Client() {}
+  };
+
+  // A |max_egress_bitrate| of zero leaves the rate unbounded.
+  PacingHost(
+      base::TickClock* clock,
+      const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
+      int max_egress_bitrate);
+  ~PacingHost();
+
+  void SetMaxEgressBitrate(int max_egress_bitrate);
+  int max_egress_bitrate() const { return max_egress_bitrate_; }
+
+  // Calls |client|->OnWakeup() on the first tick at or after |time|.  This
+  // replaces any wakeup already scheduled for |client|.
+  void ScheduleWakeup(Client* client, base::TimeTicks time);
+
+  // Cancels the wakeups of |client|, which must be called before it is
+  // destroyed.
+  void RemoveClient(Client* client);
+
+  // Returns how many bytes a client may send now.  While the clients of a
+  // tick are being woken, each is offered an equal share of what remains.
+  // At other times, nothing is offered while clients wait for egress, so
+  // that they are served first.
+  int64_t GetEgressAllowance();
+
+  // Charges |bytes| sent by a client to the budget.
+  void OnBytesSent(int64_t bytes);
+
+  // Wakes |client| on the next tick to share the budget then.
+  void WaitForEgress(Client* client);
+
+  // Returns the time of the last tick at or before |time|.
+  base::TimeTicks GetTickAtOrBefore(base::TimeTicks time) const;
+
+  // Returns the number of timer tasks the host has run.
+  int64_t num_ticks_run() const { return num_ticks_run_; }
+
+ private:
+  // Returns the time of the first tick at or after |time|.
+  base::TimeTicks GetTickAtOrAfter(base::TimeTicks time) const;
+
+  // Returns the slot of the wheel for the tick at |tick_time|.
+  size_t GetSlot(base::TimeTicks tick_time) const;
+
+  // Makes sure a task will run at the earliest tick with wakeups.
+  void ScheduleNextTick();
+
+  // Wakes the clients which are due, if |tick| is still the tick a task is
+  // expected to run at.
+  void RunTick(base::TimeTicks tick);
+
+  // Adds the budget earned since it was last refilled.
+  void RefillEgressBudget(base::TimeTicks now);
+
+  base::TickClock* const clock_;  // Not owned by this class.
+  const scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
+
+  // The wheel.  Each slot lists the clients with a wakeup on the ticks it
+  // stands for, which may be in a later turn of the wheel.  Entries are not
+  // removed when a wakeup is replaced or canceled, but only woken if
+  // |wakeups_| still holds a wakeup for them, by tick, which is due.
+  std::vector<std::vector<Client*>> slots_;
+  std::map<Client*, base::TimeTicks> wakeups_;
+
+  // The first tick whose slot has not been run.
+  base::TimeTicks next_tick_;
+
+  // The tick at which a RunTick() task is pending, if any.
+  base::TimeTicks scheduled_tick_;
+
+  // The clients being woken by RunTick(), and how many of them are left.
+  std::vector<Client*> due_clients_;
+  size_t num_due_clients_left_;
+
+  // The clients waiting in WaitForEgress().
+  std::set<Client*> egress_waiters_;
+
+  int max_egress_bitrate_;
+  int64_t egress_budget_;
+  base::TimeTicks egress_budget_time_;
+
+  int64_t num_ticks_run_;
+
+  // NOTE: Weak pointers must be invalidated before all other member variables.
+  base::WeakPtrFactory<PacingHost> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacingHost);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_NET_PACING_PACING_HOST_H_
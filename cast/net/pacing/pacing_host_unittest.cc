@@ -0,0 +1,236 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/pacing/pacing_host.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "media/base/fake_single_thread_task_runner.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const int64_t kStartMillisecond = INT64_C(12345678900000);
+const int64_t kPacketSize = 1000;
+
+// Records when it is woken, and optionally schedules its next wakeup then.
+class FakeClient : public PacingHost::Client {
+ public:
+  FakeClient(base::TickClock* clock, PacingHost* host)
+      : clock_(clock), host_(host) {}
+  ~FakeClient() final { host_->RemoveClient(this); }
+
+  void set_period(base::TimeDelta period) { period_ = period; }
+
+  void OnWakeup() final {
+    wakeup_times_.push_back(clock_->NowTicks());
+    if (!period_.is_zero())
+      host_->ScheduleWakeup(this, clock_->NowTicks() + period_);
+  }
+
+  const std::vector<base::TimeTicks>& wakeup_times() const {
+    return wakeup_times_;
+  }
+
+ private:
+  base::TickClock* const clock_;
+  PacingHost* const host_;
+  base::TimeDelta period_;
+  std::vector<base::TimeTicks> wakeup_times_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeClient);
+};
+
+// Always has more to send than the host allows, in packets of kPacketSize.
+class BackloggedClient : public PacingHost::Client {
+ public:
+  explicit BackloggedClient(PacingHost* host) : host_(host), bytes_sent_(0) {}
+  ~BackloggedClient() final { host_->RemoveClient(this); }
+
+  void OnWakeup() final {
+    int64_t allowance = host_->GetEgressAllowance();
+    while (allowance > 0) {
+      host_->OnBytesSent(kPacketSize);
+      bytes_sent_ += kPacketSize;
+      allowance -= kPacketSize;
+    }
+    host_->WaitForEgress(this);
+  }
+
+  int64_t bytes_sent() const { return bytes_sent_; }
+  void reset_bytes_sent() { bytes_sent_ = 0; }
+
+ private:
+  PacingHost* const host_;
+  int64_t bytes_sent_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackloggedClient);
+};
+
+}  // namespace
+
+class PacingHostTest : public ::testing::Test {
+ protected:
+  PacingHostTest() {
+    testing_clock_.Advance(
+        base::TimeDelta::FromMilliseconds(kStartMillisecond));
+    task_runner_ = new FakeSingleThreadTaskRunner(&testing_clock_);
+  }
+
+  void CreateHost(int max_egress_bitrate) {
+    host_.reset(
+        new PacingHost(&testing_clock_, task_runner_, max_egress_bitrate));
+  }
+
+  base::TimeTicks Ms(int64_t milliseconds) {
+    return base::TimeTicks() +
+           base::TimeDelta::FromMilliseconds(kStartMillisecond + milliseconds);
+  }
+
+  base::SimpleTestTickClock testing_clock_;
+  scoped_refptr<FakeSingleThreadTaskRunner> task_runner_;
+  std::unique_ptr<PacingHost> host_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacingHostTest);
+};
+
+TEST_F(PacingHostTest, WakesClientsOnTheirTicks) {
+  CreateHost(0);
+  FakeClient early(&testing_clock_, host_.get());
+  FakeClient on_tick(&testing_clock_, host_.get());
+  FakeClient later(&testing_clock_, host_.get());
+  FakeClient next_turn(&testing_clock_, host_.get());
+  host_->ScheduleWakeup(&early, Ms(3));
+  host_->ScheduleWakeup(&on_tick, Ms(10));
+  host_->ScheduleWakeup(&later, Ms(25));
+  // More than a turn of the wheel away.
+  host_->ScheduleWakeup(&next_turn, Ms(1005));
+
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(2));
+  ASSERT_EQ(1u, early.wakeup_times().size());
+  EXPECT_EQ(Ms(10), early.wakeup_times()[0]);
+  ASSERT_EQ(1u, on_tick.wakeup_times().size());
+  EXPECT_EQ(Ms(10), on_tick.wakeup_times()[0]);
+  ASSERT_EQ(1u, later.wakeup_times().size());
+  EXPECT_EQ(Ms(30), later.wakeup_times()[0]);
+  ASSERT_EQ(1u, next_turn.wakeup_times().size());
+  EXPECT_EQ(Ms(1010), next_turn.wakeup_times()[0]);
+
+  // Only the ticks with wakeups ran, and the turn of the wheel in between.
+  EXPECT_LE(host_->num_ticks_run(), 4);
+}
+
+TEST_F(PacingHostTest, ReplacesAndRemovesWakeups) {
+  CreateHost(0);
+  FakeClient replaced(&testing_clock_, host_.get());
+  std::unique_ptr<FakeClient> removed(
+      new FakeClient(&testing_clock_, host_.get()));
+  host_->ScheduleWakeup(&replaced, Ms(20));
+  host_->ScheduleWakeup(&replaced, Ms(50));
+  host_->ScheduleWakeup(removed.get(), Ms(20));
+  removed.reset();
+
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+  ASSERT_EQ(1u, replaced.wakeup_times().size());
+  EXPECT_EQ(Ms(50), replaced.wakeup_times()[0]);
+
+  // A wakeup may also be brought forward.
+  host_->ScheduleWakeup(&replaced, Ms(1500));
+  host_->ScheduleWakeup(&replaced, Ms(1100));
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+  ASSERT_EQ(2u, replaced.wakeup_times().size());
+  EXPECT_EQ(Ms(1100), replaced.wakeup_times()[1]);
+}
+
+TEST_F(PacingHostTest, WakesManyClientsWithOneTimer) {
+  CreateHost(0);
+  const int kNumClients = 100;
+  std::vector<std::unique_ptr<FakeClient>> clients;
+  for (int i = 0; i < kNumClients; ++i) {
+    clients.emplace_back(new FakeClient(&testing_clock_, host_.get()));
+    clients.back()->set_period(base::TimeDelta::FromMilliseconds(10));
+    // Spread the clients' timers out over the first tick.
+    host_->ScheduleWakeup(clients.back().get(),
+                          Ms(1) + base::TimeDelta::FromMicroseconds(i * 90));
+  }
+
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+  for (const auto& client : clients)
+    EXPECT_EQ(100u, client->wakeup_times().size());
+  // One task per tick wakes all of them.
+  EXPECT_EQ(100, host_->num_ticks_run());
+}
+
+TEST_F(PacingHostTest, UnboundedEgress) {
+  CreateHost(0);
+  FakeClient client(&testing_clock_, host_.get());
+  EXPECT_LT(INT64_C(1) << 40, host_->GetEgressAllowance());
+  host_->OnBytesSent(INT64_C(1) << 30);
+  EXPECT_LT(INT64_C(1) << 40, host_->GetEgressAllowance());
+}
+
+TEST_F(PacingHostTest, BoundsAndSharesEgress) {
+  // 1 MB per second, or 10 kB per tick.
+  const int kMaxEgressBitrate = 8000000;
+  CreateHost(kMaxEgressBitrate);
+  const size_t kNumClients = 10;
+  std::vector<std::unique_ptr<BackloggedClient>> clients;
+  for (size_t i = 0; i < kNumClients; ++i) {
+    clients.emplace_back(new BackloggedClient(host_.get()));
+    clients.back()->OnWakeup();
+  }
+  // The first client took the whole budget, and the others queued behind it.
+  EXPECT_EQ(10000, clients[0]->bytes_sent());
+  EXPECT_EQ(0, clients[1]->bytes_sent());
+
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+  for (const auto& client : clients)
+    client->reset_bytes_sent();
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+
+  int64_t total_bytes_sent = 0;
+  int64_t min_bytes_sent = clients[0]->bytes_sent();
+  int64_t max_bytes_sent = clients[0]->bytes_sent();
+  for (const auto& client : clients) {
+    total_bytes_sent += client->bytes_sent();
+    min_bytes_sent = std::min(min_bytes_sent, client->bytes_sent());
+    max_bytes_sent = std::max(max_bytes_sent, client->bytes_sent());
+  }
+  const int64_t kBytesPerSecond = kMaxEgressBitrate / 8;
+  EXPECT_LE(total_bytes_sent, kBytesPerSecond + 10000);
+  EXPECT_GE(total_bytes_sent, kBytesPerSecond - 10000);
+  // Every client gets its share.
+  EXPECT_LE(max_bytes_sent - min_bytes_sent,
+            kBytesPerSecond / kNumClients / 10);
+
+  // Lowering the bound takes effect at once.
+  host_->SetMaxEgressBitrate(kMaxEgressBitrate / 2);
+  for (const auto& client : clients)
+    client->reset_bytes_sent();
+  task_runner_->Sleep(base::TimeDelta::FromSeconds(1));
+  total_bytes_sent = 0;
+  for (const auto& client : clients)
+    total_bytes_sent += client->bytes_sent();
+  EXPECT_LE(total_bytes_sent, kBytesPerSecond / 2 + 10000);
+  EXPECT_GE(total_bytes_sent, kBytesPerSecond / 2 - 10000);
+  // Packets are too large for every client to send one per tick, but the
+  // clients take turns.
+  for (const auto& client : clients)
+    EXPECT_NEAR(kBytesPerSecond / 2 / kNumClients, client->bytes_sent(), 2000);
+
+  clients.clear();
+}
+
+}  // namespace cast
+}  // namespace media
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
+
 #include "base/big_endian.h"
 #include "base/time/tick_clock.h"
 #include "media/cast/net/rtcp/receiver_rtcp_session.h"
@@ -12,6 +14,14 @@
 namespace media {
 namespace cast {
 
+namespace {
+
+// Bounds the packet arrivals held while transport feedback isn't being sent.
+// This is more than fit in one RTCP packet.
+const size_t kMaxPendingPacketArrivals = 2048;
+
+}  // namespace
+
 ReceiverRtcpSession::ReceiverRtcpSession(base::TickClock* clock,
                                          uint32_t local_ssrc,
                                          uint32_t remote_ssrc)
@@ -94,6 +104,31 @@ void ReceiverRtcpSession::OnReceivedLipSyncInfo(RtpTimeTicks rtp_timestamp,
       (static_cast<uint64_t>(ntp_seconds) << 32) | ntp_fraction;
 }
 
+void ReceiverRtcpSession::OnReceivedRtpPacket(FrameId frame_id,
+                                              uint16_t packet_id) {
+  if (pending_packet_arrivals_.size() >= kMaxPendingPacketArrivals)
+    return;
+  RtcpPacketArrival packet_arrival;
+  packet_arrival.frame_id = frame_id;
+  packet_arrival.packet_id = packet_id;
+  packet_arrival.arrival_time = clock_->NowTicks();
+  pending_packet_arrivals_.push_back(packet_arrival);
+}
+
+bool ReceiverRtcpSession::GetTransportFeedback(
+    RtcpTransportFeedback* feedback) {
+  if (pending_packet_arrivals_.empty())
+    return false;
+  // Arrivals beyond what fits in one RTCP packet are kept for the next call.
+  const auto end =
+      pending_packet_arrivals_.begin() +
+      std::min(pending_packet_arrivals_.size(),
+               kMaxPacketArrivalsPerTransportFeedback);
+  feedback->assign(pending_packet_arrivals_.begin(), end);
+  pending_packet_arrivals_.erase(pending_packet_arrivals_.begin(), end);
+  return true;
+}
+
 bool ReceiverRtcpSession::GetLatestLipSyncTimes(
     RtpTimeTicks* rtp_timestamp,
     base::TimeTicks* reference_time) const {
@@ -52,6 +52,15 @@ class ReceiverRtcpSession : public RtcpSession {
     return time_last_report_received_;
   }
 
+  // Records the arrival of an RTP packet, to be reported to the sender in the
+  // next transport feedback.
+  void OnReceivedRtpPacket(FrameId frame_id, uint16_t packet_id);
+
+  // If any RTP packets have arrived since the last call, returns true and moves
+  // the oldest of their arrivals, as many as fit in one RTCP packet, to
+  // |feedback|.  Callers should repeat until it returns false.
+  bool GetTransportFeedback(RtcpTransportFeedback* feedback);
+
  private:
   // Received NTP timestamps from RTCP SR packets.
   void OnReceivedNtp(uint32_t ntp_seconds, uint32_t ntp_fraction);
@@ -85,6 +94,9 @@ class ReceiverRtcpSession : public RtcpSession {
   RtpTimeTicks lip_sync_rtp_timestamp_;
   uint64_t lip_sync_ntp_timestamp_;
 
+  // Packet arrivals not yet reported in transport feedback.
+  RtcpTransportFeedback pending_packet_arrivals_;
+
   // The RTCP packet parser is re-used when parsing each RTCP packet.  It
   // remembers state about prior RTP timestamps and other sequence values to
   // re-construct "expanded" values.
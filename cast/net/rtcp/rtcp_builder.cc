@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "base/logging.h"
@@ -20,6 +21,33 @@ namespace {
 // 12 bits.
 const int64_t kMaxWireFormatTimeDeltaMs = INT64_C(0xfff);
 
+// Transport feedback sizes, the header including the common RTCP header.
+const size_t kTransportFeedbackHeaderSize = 18;
+const size_t kTransportFeedbackChunkHeaderSize = 4;
+const size_t kTransportFeedbackMaxDeltaSize = 2;
+const size_t kTransportFeedbackMaxPaddingSize = 3;
+const size_t kTransportFeedbackMaxPacketsPerChunk = 256;
+
+// Transport feedback follows a receiver reference time report in its RTCP
+// packet, and must then hold kMaxPacketArrivalsPerTransportFeedback arrivals.
+const size_t kReceiverReferenceTimeReportSize = 20;
+static_assert(kReceiverReferenceTimeReportSize + kTransportFeedbackHeaderSize +
+                      kMaxPacketArrivalsPerTransportFeedback *
+                          (kTransportFeedbackChunkHeaderSize +
+                           kTransportFeedbackMaxDeltaSize) +
+                      kTransportFeedbackMaxPaddingSize <=
+                  kMaxIpPacketSize,
+              "kMaxPacketArrivalsPerTransportFeedback is too large");
+
+// Arrival time deltas are sent in 7 or 15 bits.
+const int64_t kMaxOneByteArrivalDelta = 0x7f;
+const int64_t kMaxArrivalDelta = 0x7fff;
+
+int64_t ToTransportFeedbackTime(base::TimeTicks time) {
+  return (time - base::TimeTicks()).InMicroseconds() /
+         kTransportFeedbackTimeUnitUs;
+}
+
 uint16_t MergeEventTypeAndTimestampForWireFormat(
     const CastLoggingEvent& event,
     const base::TimeDelta& time_delta) {
@@ -392,6 +420,79 @@ void RtcpBuilder::AddReceiverLog(
   DCHECK_EQ(total_number_of_messages_to_send, 0u);
 }
 
+void RtcpBuilder::AddTransportFeedback(const RtcpTransportFeedback& feedback) {
+  if (feedback.empty() ||
+      writer_.remaining() <
+          kTransportFeedbackHeaderSize + kTransportFeedbackChunkHeaderSize +
+              kTransportFeedbackMaxDeltaSize +
+              kTransportFeedbackMaxPaddingSize) {
+    return;
+  }
+
+  AddRtcpHeader(kPacketTypeApplicationDefined, kTransportFeedbackSubtype);
+  writer_.WriteU32(local_ssrc_);  // Add our own SSRC.
+  writer_.WriteU32(kCast);
+  // Only the low 32 bits of the reference time are sent; the parser expands
+  // them relative to the previous report's.  Deltas are computed before
+  // truncation, so they are unaffected by wraparound.
+  int64_t last_arrival_time =
+      ToTransportFeedbackTime(feedback.front().arrival_time);
+  writer_.WriteU32(static_cast<uint32_t>(last_arrival_time));
+  char* const number_of_chunks_pos = writer_.ptr();
+  writer_.WriteU16(0);  // Overwritten with number_of_chunks.
+
+  // Runs of consecutive packets of one frame share a chunk header.
+  size_t number_of_chunks = 0;
+  uint8_t* packet_count_pos = nullptr;
+  size_t packets_in_chunk = 0;
+  FrameId chunk_frame_id;
+  uint16_t next_packet_id = 0;
+  for (const RtcpPacketArrival& packet_arrival : feedback) {
+    const bool new_chunk =
+        !packet_count_pos || packet_arrival.frame_id != chunk_frame_id ||
+        packet_arrival.packet_id != next_packet_id ||
+        packets_in_chunk == kTransportFeedbackMaxPacketsPerChunk;
+    if (writer_.remaining() <
+        (new_chunk ? kTransportFeedbackChunkHeaderSize : 0) +
+            kTransportFeedbackMaxDeltaSize + kTransportFeedbackMaxPaddingSize) {
+      break;  // We are running out of space.
+    }
+    if (new_chunk) {
+      writer_.WriteU8(packet_arrival.frame_id.lower_8_bits());
+      packet_count_pos = reinterpret_cast<uint8_t*>(writer_.ptr());
+      writer_.WriteU8(0);  // Overwritten with the packet count - 1.
+      writer_.WriteU16(packet_arrival.packet_id);
+      chunk_frame_id = packet_arrival.frame_id;
+      packets_in_chunk = 0;
+      ++number_of_chunks;
+    }
+
+    // Packets are recorded in arrival order, but a gap too large to encode is
+    // sent as the largest one possible.
+    const int64_t delta = std::min(
+        std::max<int64_t>(
+            ToTransportFeedbackTime(packet_arrival.arrival_time) -
+                last_arrival_time,
+            0),
+        kMaxArrivalDelta);
+    last_arrival_time += delta;
+    if (delta <= kMaxOneByteArrivalDelta)
+      writer_.WriteU8(static_cast<uint8_t>(delta));
+    else
+      writer_.WriteU16(static_cast<uint16_t>(0x8000 | delta));
+
+    *packet_count_pos = static_cast<uint8_t>(packets_in_chunk++);
+    next_packet_id = packet_arrival.packet_id + 1;
+  }
+  DCHECK_LE(number_of_chunks, std::numeric_limits<uint16_t>::max());
+  *number_of_chunks_pos = static_cast<char>(number_of_chunks >> 8);
+  *(number_of_chunks_pos + 1) = static_cast<char>(number_of_chunks);
+
+  // Pad to a multiple of 32 bits.
+  while ((kMaxIpPacketSize - writer_.remaining()) % 4)
+    writer_.WriteU8(0);
+}
+
 bool RtcpBuilder::GetRtcpReceiverLogMessage(
     const ReceiverRtcpEventSubscriber::RtcpEvents& rtcp_events,
     RtcpReceiverLogMessage* receiver_log_message,
@@ -37,6 +37,8 @@ class RtcpBuilder {
   void AddPli(const RtcpPliMessage& pli_message);
   void AddReceiverLog(
       const ReceiverRtcpEventSubscriber::RtcpEvents& rtcp_events);
+  // Adds as many of the packet arrivals in |feedback| as fit, oldest first.
+  void AddTransportFeedback(const RtcpTransportFeedback& feedback);
   void Start();
   PacketRef Finish();
 
@@ -445,6 +445,162 @@ TEST_F(RtcpBuilderTest, RtcpReceiverReportRedundancy) {
   }
 }
 
+TEST_F(RtcpBuilderTest, TransportFeedbackRoundTrip) {
+  const base::TimeTicks kBaseTime =
+      base::TimeTicks() + base::TimeDelta::FromSeconds(1000);
+  const FrameId kFrameId = FrameId::first() + 300;
+
+  // Runs of packets of several frames, with gaps that need one and two bytes.
+  RtcpTransportFeedback feedback;
+  const struct {
+    FrameId frame_id;
+    uint16_t packet_id;
+    int64_t arrival_time_us;
+  } kPackets[] = {
+      {kFrameId, 0, 0},          {kFrameId, 1, 250},
+      {kFrameId, 2, 250},        {kFrameId, 4, 31750},
+      {kFrameId + 1, 0, 32000},  {kFrameId, 3, 5000000},
+      {kFrameId + 1, 1, 5000250},
+  };
+  for (const auto& packet : kPackets) {
+    RtcpPacketArrival packet_arrival;
+    packet_arrival.frame_id = packet.frame_id;
+    packet_arrival.packet_id = packet.packet_id;
+    packet_arrival.arrival_time =
+        kBaseTime + base::TimeDelta::FromMicroseconds(packet.arrival_time_us);
+    feedback.push_back(packet_arrival);
+  }
+
+  rtcp_builder_->Start();
+  rtcp_builder_->AddTransportFeedback(feedback);
+  PacketRef packet = rtcp_builder_->Finish();
+  EXPECT_EQ(0u, packet->data.size() % 4);
+
+  RtcpParser parser(kMediaSsrc, kSendingSsrc);
+  parser.SetMaxValidFrameId(kFrameId + 1);
+  base::BigEndianReader reader(reinterpret_cast<const char*>(&packet->data[0]),
+                               packet->data.size());
+  ASSERT_TRUE(parser.Parse(&reader));
+  ASSERT_TRUE(parser.has_transport_feedback());
+  ASSERT_EQ(feedback.size(), parser.transport_feedback().size());
+  for (size_t i = 0; i < feedback.size(); ++i) {
+    EXPECT_EQ(feedback[i].frame_id, parser.transport_feedback()[i].frame_id);
+    EXPECT_EQ(feedback[i].packet_id, parser.transport_feedback()[i].packet_id);
+    EXPECT_EQ(feedback[i].arrival_time,
+              parser.transport_feedback()[i].arrival_time);
+  }
+
+  // Without a max valid frame ID, transport feedback is ignored.
+  RtcpParser parser2(kMediaSsrc, kSendingSsrc);
+  base::BigEndianReader reader2(
+      reinterpret_cast<const char*>(&packet->data[0]), packet->data.size());
+  EXPECT_TRUE(parser2.Parse(&reader2));
+  EXPECT_FALSE(parser2.has_transport_feedback());
+}
+
+TEST_F(RtcpBuilderTest, TransportFeedbackLimitedToPacketSize) {
+  const base::TimeTicks kBaseTime =
+      base::TimeTicks() + base::TimeDelta::FromSeconds(1000);
+  const FrameId kFrameId = FrameId::first() + 10;
+
+  // More arrivals, each needing two bytes, than fit in one packet.
+  RtcpTransportFeedback feedback;
+  for (int i = 0; i < 2000; ++i) {
+    RtcpPacketArrival packet_arrival;
+    packet_arrival.frame_id = kFrameId;
+    packet_arrival.packet_id = static_cast<uint16_t>(i);
+    packet_arrival.arrival_time =
+        kBaseTime + base::TimeDelta::FromMilliseconds(50 * i);
+    feedback.push_back(packet_arrival);
+  }
+
+  rtcp_builder_->Start();
+  rtcp_builder_->AddTransportFeedback(feedback);
+  PacketRef packet = rtcp_builder_->Finish();
+  EXPECT_LE(packet->data.size(), kMaxIpPacketSize);
+
+  RtcpParser parser(kMediaSsrc, kSendingSsrc);
+  parser.SetMaxValidFrameId(kFrameId);
+  base::BigEndianReader reader(reinterpret_cast<const char*>(&packet->data[0]),
+                               packet->data.size());
+  ASSERT_TRUE(parser.Parse(&reader));
+  const RtcpTransportFeedback& parsed = parser.transport_feedback();
+  EXPECT_LT(500u, parsed.size());
+  EXPECT_GT(feedback.size(), parsed.size());
+  for (size_t i = 0; i < parsed.size(); ++i) {
+    EXPECT_EQ(feedback[i].packet_id, parsed[i].packet_id);
+    EXPECT_EQ(feedback[i].arrival_time, parsed[i].arrival_time);
+  }
+}
+
+TEST_F(RtcpBuilderTest, TransportFeedbackHoldsMaxPacketArrivals) {
+  const base::TimeTicks kBaseTime =
+      base::TimeTicks() + base::TimeDelta::FromSeconds(1000);
+  const FrameId kFrameId = FrameId::first() + 10;
+
+  // Every arrival starts a new run and needs a two byte delta.
+  RtcpTransportFeedback feedback;
+  for (size_t i = 0; i < kMaxPacketArrivalsPerTransportFeedback; ++i) {
+    RtcpPacketArrival packet_arrival;
+    packet_arrival.frame_id = kFrameId;
+    packet_arrival.packet_id = static_cast<uint16_t>(2 * i);
+    packet_arrival.arrival_time =
+        kBaseTime + base::TimeDelta::FromMilliseconds(50 * i);
+    feedback.push_back(packet_arrival);
+  }
+
+  // As sent by FrameReceiver, after a receiver reference time report.
+  RtcpReceiverReferenceTimeReport rrtr;
+  rrtr.ntp_seconds = kNtpHigh;
+  rrtr.ntp_fraction = kNtpLow;
+  rtcp_builder_->Start();
+  rtcp_builder_->AddRrtr(rrtr);
+  rtcp_builder_->AddTransportFeedback(feedback);
+  PacketRef packet = rtcp_builder_->Finish();
+
+  RtcpParser parser(kMediaSsrc, kSendingSsrc);
+  parser.SetMaxValidFrameId(kFrameId);
+  base::BigEndianReader reader(reinterpret_cast<const char*>(&packet->data[0]),
+                               packet->data.size());
+  ASSERT_TRUE(parser.Parse(&reader));
+  EXPECT_EQ(feedback.size(), parser.transport_feedback().size());
+}
+
+TEST_F(RtcpBuilderTest, TransportFeedbackReferenceTimeWrapsAround) {
+  // The 32-bit reference time, in units of 250 us, wraps around between these
+  // two reports.
+  const base::TimeTicks kWrapTime =
+      base::TimeTicks() + base::TimeDelta::FromMicroseconds(
+                              (INT64_C(1) << 32) * kTransportFeedbackTimeUnitUs);
+  const base::TimeTicks kArrivalTimes[] = {
+      kWrapTime - base::TimeDelta::FromMilliseconds(20),
+      kWrapTime + base::TimeDelta::FromMilliseconds(20)};
+  const FrameId kFrameId = FrameId::first() + 10;
+
+  RtcpParser parser(kMediaSsrc, kSendingSsrc);
+  parser.SetMaxValidFrameId(kFrameId);
+  base::TimeTicks parsed_arrival_times[arraysize(kArrivalTimes)];
+  for (size_t i = 0; i < arraysize(kArrivalTimes); ++i) {
+    RtcpPacketArrival packet_arrival;
+    packet_arrival.frame_id = kFrameId;
+    packet_arrival.packet_id = static_cast<uint16_t>(i);
+    packet_arrival.arrival_time = kArrivalTimes[i];
+    RtcpTransportFeedback feedback(1, packet_arrival);
+
+    rtcp_builder_->Start();
+    rtcp_builder_->AddTransportFeedback(feedback);
+    PacketRef packet = rtcp_builder_->Finish();
+    base::BigEndianReader reader(
+        reinterpret_cast<const char*>(&packet->data[0]), packet->data.size());
+    ASSERT_TRUE(parser.Parse(&reader));
+    ASSERT_EQ(1u, parser.transport_feedback().size());
+    parsed_arrival_times[i] = parser.transport_feedback()[0].arrival_time;
+  }
+
+  EXPECT_EQ(kArrivalTimes[1] - kArrivalTimes[0],
+            parsed_arrival_times[1] - parsed_arrival_times[0]);
+}
+
 TEST_F(RtcpBuilderTest, RtcpSenderReport) {
   RtcpSenderInfo sender_info;
   sender_info.ntp_seconds = kNtpHigh;
@@ -34,6 +34,12 @@ RtcpReceiverReferenceTimeReport::~RtcpReceiverReferenceTimeReport() {}
 RtcpEvent::RtcpEvent() : type(UNKNOWN), packet_id(0u) {}
 RtcpEvent::~RtcpEvent() {}
 
+PacketArrival::PacketArrival() : size(0) {}
+PacketArrival::~PacketArrival() {}
+
+RtcpPacketArrival::RtcpPacketArrival() : packet_id(0) {}
+RtcpPacketArrival::~RtcpPacketArrival() {}
+
 RtpReceiverStatistics::RtpReceiverStatistics() :
     fraction_lost(0),
     cumulative_lost(0),
@@ -91,6 +91,34 @@ struct RtcpReceiverFrameLogMessage {
 
 typedef std::list<RtcpReceiverFrameLogMessage> RtcpReceiverLogMessage;
 
+// When an RTP packet left the sender and when it reached the receiver.  The
+// two times are on different clocks, so only differences between the arrival
+// times of packets are meaningful.
+struct PacketArrival {
+  PacketArrival();
+  ~PacketArrival();
+
+  base::TimeTicks send_time;     // Sender clock.
+  base::TimeTicks arrival_time;  // Receiver clock.
+  size_t size;                   // Bytes, including headers.
+};
+
+// The arrival of one RTP packet, as reported in transport feedback.  Packets
+// are identified by frame and packet ID since Cast RTP packets carry no
+// sequence number common to all of a stream's packets.
+struct RtcpPacketArrival {
+  RtcpPacketArrival();
+  ~RtcpPacketArrival();
+
+  FrameId frame_id;
+  uint16_t packet_id;
+  base::TimeTicks arrival_time;  // Receiver clock.
+};
+
+// The RTP packets received since the previous transport feedback, in the
+// order they arrived.
+typedef std::vector<RtcpPacketArrival> RtcpTransportFeedback;
+
 struct RtcpReceiverReferenceTimeReport {
   RtcpReceiverReferenceTimeReport();
   ~RtcpReceiverReferenceTimeReport();
@@ -0,0 +1,28 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/big_endian.h"
+#include "media/cast/common/frame_id.h"
+#include "media/cast/net/rtcp/rtcp_utility.h"
+
+namespace {
+
+const uint32_t kLocalSsrc = 0x11;
+const uint32_t kRemoteSsrc = 0x22;
+
+}  // namespace
+
+// Entry point for LibFuzzer.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  // Cast Feedback and transport feedback are only parsed once a max valid
+  // frame ID is set.
+  media::cast::RtcpParser parser(kLocalSsrc, kRemoteSsrc);
+  parser.SetMaxValidFrameId(media::cast::FrameId::first() + 1000);
+  base::BigEndianReader reader(reinterpret_cast<const char*>(data), size);
+  parser.Parse(&reader);
+  return 0;
+}
@@ -130,6 +130,11 @@ class RtcpTest : public ::testing::Test, public RtcpObserver {
 
   void OnReceivedPli() override { received_pli_ = true; }
 
+  void OnReceivedTransportFeedback(
+      const RtcpTransportFeedback& feedback) override {
+    last_transport_feedback_ = feedback;
+  }
+
   PacketRef BuildRtcpPacketFromRtpReceiver(
       const RtcpTimeData& time_data,
       const RtcpCastMessage* cast_message,
@@ -188,6 +193,7 @@ class RtcpTest : public ::testing::Test, public RtcpObserver {
   RtcpCastMessage last_cast_message_;
   RtcpReceiverLogMessage last_logs_;
   bool received_pli_;
+  RtcpTransportFeedback last_transport_feedback_;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(RtcpTest);
@@ -378,5 +384,55 @@ TEST_F(RtcpTest, ReportReceiverEvents) {
   EXPECT_EQ(log_msg_ts, event_ts);
 }
 
+TEST_F(RtcpTest, ReportTransportFeedback) {
+  const FrameId kFrameId = FrameId::first() + 7;
+  rtcp_at_rtp_sender_.WillSendFrame(kFrameId);
+
+  RtcpTransportFeedback feedback;
+  EXPECT_FALSE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+  rtcp_at_rtp_receiver_.OnReceivedRtpPacket(kFrameId, 0);
+  sender_clock_->Advance(base::TimeDelta::FromMilliseconds(3));
+  rtcp_at_rtp_receiver_.OnReceivedRtpPacket(kFrameId, 1);
+  ASSERT_TRUE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+  ASSERT_EQ(2u, feedback.size());
+  EXPECT_FALSE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+
+  RtcpBuilder builder(rtcp_at_rtp_receiver_.local_ssrc());
+  builder.Start();
+  builder.AddTransportFeedback(feedback);
+  rtp_receiver_pacer_.SendRtcpPacket(rtcp_at_rtp_receiver_.local_ssrc(),
+                                     builder.Finish());
+
+  ASSERT_EQ(2u, last_transport_feedback_.size());
+  EXPECT_EQ(kFrameId, last_transport_feedback_[0].frame_id);
+  EXPECT_EQ(0, last_transport_feedback_[0].packet_id);
+  EXPECT_EQ(kFrameId, last_transport_feedback_[1].frame_id);
+  EXPECT_EQ(1, last_transport_feedback_[1].packet_id);
+  // Arrival times are sent in units of 250 us.
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(3),
+            last_transport_feedback_[1].arrival_time -
+                last_transport_feedback_[0].arrival_time);
+}
+
+TEST_F(RtcpTest, TransportFeedbackKeepsArrivalsThatDoNotFit) {
+  const FrameId kFrameId = FrameId::first() + 7;
+  const size_t kExtraArrivals = 10;
+  for (size_t i = 0; i < kMaxPacketArrivalsPerTransportFeedback + kExtraArrivals;
+       ++i) {
+    rtcp_at_rtp_receiver_.OnReceivedRtpPacket(kFrameId,
+                                              static_cast<uint16_t>(i));
+  }
+
+  // The oldest arrivals are reported first; the rest are kept.
+  RtcpTransportFeedback feedback;
+  ASSERT_TRUE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+  ASSERT_EQ(kMaxPacketArrivalsPerTransportFeedback, feedback.size());
+  EXPECT_EQ(0, feedback.front().packet_id);
+  ASSERT_TRUE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+  ASSERT_EQ(kExtraArrivals, feedback.size());
+  EXPECT_EQ(kMaxPacketArrivalsPerTransportFeedback, feedback.front().packet_id);
+  EXPECT_FALSE(rtcp_at_rtp_receiver_.GetTransportFeedback(&feedback));
+}
+
 }  // namespace cast
 }  // namespace media
@@ -31,11 +31,14 @@ RtcpParser::RtcpParser(uint32_t local_ssrc, uint32_t remote_ssrc)
     : local_ssrc_(local_ssrc),
       remote_ssrc_(remote_ssrc),
       has_sender_report_(false),
+      fraction_lost_(0),
       has_last_report_(false),
       has_cast_message_(false),
       has_cst2_message_(false),
       has_receiver_reference_time_report_(false),
-      has_picture_loss_indicator_(false) {}
+      has_picture_loss_indicator_(false),
+      has_transport_feedback_reference_time_(false),
+      last_transport_feedback_reference_time_(0) {}
 
 RtcpParser::~RtcpParser() {}
 
@@ -53,6 +56,7 @@ bool RtcpParser::Parse(base::BigEndianReader* reader) {
   has_cst2_message_ = false;
   has_receiver_reference_time_report_ = false;
   has_picture_loss_indicator_ = false;
+  transport_feedback_.clear();
 
   while (reader->remaining()) {
     RtcpCommonHeader header;
@@ -180,13 +184,16 @@ bool RtcpParser::ParseRR(base::BigEndianReader* reader,
 
 bool RtcpParser::ParseReportBlock(base::BigEndianReader* reader) {
   uint32_t ssrc, last_report, delay;
+  uint8_t fraction_lost;
   if (!reader->ReadU32(&ssrc) ||
-      !reader->Skip(12) ||
+      !reader->ReadU8(&fraction_lost) ||
+      !reader->Skip(11) ||
       !reader->ReadU32(&last_report) ||
       !reader->ReadU32(&delay))
     return false;
 
   if (ssrc == local_ssrc_) {
+    fraction_lost_ = fraction_lost;
     last_report_ = last_report;
     delay_since_last_report_ = delay;
     has_last_report_ = true;
@@ -238,6 +245,10 @@ bool RtcpParser::ParseApplicationDefined(base::BigEndianReader* reader,
       if (!ParseCastReceiverLogFrameItem(reader))
         return false;
       break;
+    case kTransportFeedbackSubtype:
+      if (!ParseTransportFeedback(reader))
+        return false;
+      break;
   }
   return true;
 }
@@ -290,6 +301,75 @@ bool RtcpParser::ParseCastReceiverLogFrameItem(
   return true;
 }
 
+bool RtcpParser::ParseTransportFeedback(base::BigEndianReader* reader) {
+  // As with Cast Feedback, the truncated frame IDs can't be expanded without
+  // a reference point.
+  if (max_valid_frame_id_.is_null())
+    return true;
+
+  uint32_t reference_time;
+  uint16_t number_of_chunks;
+  if (!reader->ReadU32(&reference_time) || !reader->ReadU16(&number_of_chunks))
+    return false;
+
+  // Each chunk is a run of consecutive packets of one frame.  Arrival times are
+  // sent as deltas from the previous packet's: one byte if the top bit is
+  // clear, otherwise two bytes holding 15 bits.
+  base::TimeTicks arrival_time =
+      base::TimeTicks() +
+      base::TimeDelta::FromMicroseconds(
+          ExpandTransportFeedbackReferenceTime(reference_time) *
+          kTransportFeedbackTimeUnitUs);
+  for (size_t chunk = 0; chunk < number_of_chunks; ++chunk) {
+    uint8_t truncated_frame_id;
+    uint8_t packet_count_minus_one;
+    uint16_t packet_id;
+    if (!reader->ReadU8(&truncated_frame_id) ||
+        !reader->ReadU8(&packet_count_minus_one) ||
+        !reader->ReadU16(&packet_id))
+      return false;
+    const FrameId frame_id =
+        max_valid_frame_id_.ExpandLessThanOrEqual(truncated_frame_id);
+    for (size_t i = 0; i <= packet_count_minus_one; ++i) {
+      uint8_t byte;
+      if (!reader->ReadU8(&byte))
+        return false;
+      int64_t delta = byte;
+      if (byte & 0x80) {
+        if (!reader->ReadU8(&byte))
+          return false;
+        delta = (delta & 0x7f) << 8 | byte;
+      }
+      arrival_time += base::TimeDelta::FromMicroseconds(
+          delta * kTransportFeedbackTimeUnitUs);
+
+      RtcpPacketArrival packet_arrival;
+      packet_arrival.frame_id = frame_id;
+      packet_arrival.packet_id = packet_id++;
+      packet_arrival.arrival_time = arrival_time;
+      transport_feedback_.push_back(packet_arrival);
+    }
+  }
+  // The rest is padding.
+  return true;
+}
+
+int64_t RtcpParser::ExpandTransportFeedbackReferenceTime(
+    uint32_t reference_time) {
+  // Reports are sent far more often than every 6.2 days, so the expanded time
+  // is the one nearest to the previous report's.
+  int64_t expanded = reference_time;
+  if (has_transport_feedback_reference_time_) {
+    const uint32_t last_truncated =
+        static_cast<uint32_t>(last_transport_feedback_reference_time_);
+    expanded = last_transport_feedback_reference_time_ +
+               static_cast<int32_t>(reference_time - last_truncated);
+  }
+  has_transport_feedback_reference_time_ = true;
+  last_transport_feedback_reference_time_ = expanded;
+  return expanded;
+}
+
 // RFC 4585.
 bool RtcpParser::ParseFeedbackCommon(base::BigEndianReader* reader,
                                      const RtcpCommonHeader& header) {
@@ -25,6 +25,15 @@ static const uint32_t kCast = ('C' << 24) + ('A' << 16) + ('S' << 8) + 'T';
 static const uint32_t kCst2 = ('C' << 24) + ('S' << 16) + ('T' << 8) + '2';
 
 static const uint8_t kReceiverLogSubtype = 2;
+static const uint8_t kTransportFeedbackSubtype = 3;
+
+// Packet arrival times in transport feedback are in units of 250 us.  The
+// reference time is sent in 32 bits and so wraps around every 12.4 days.
+static const int64_t kTransportFeedbackTimeUnitUs = 250;
+
+// The most packet arrivals one transport feedback RTCP packet is sure to hold,
+// even if every arrival starts a new run and needs a two byte delta.
+static const size_t kMaxPacketArrivalsPerTransportFeedback = 240;
 
 static const size_t kRtcpMaxReceiverLogMessages = 256;
 static const size_t kRtcpMaxCastLossFields = 100;
@@ -59,6 +68,9 @@ class RtcpParser {
   bool has_last_report() const { return has_last_report_; }
   uint32_t last_report() const { return last_report_; }
   uint32_t delay_since_last_report() const { return delay_since_last_report_; }
+  // The fraction of our RTP packets lost, in units of 1/256, from the same
+  // report block.
+  uint8_t fraction_lost() const { return fraction_lost_; }
 
   bool has_receiver_log() const { return !receiver_log_.empty(); }
   const RtcpReceiverLogMessage& receiver_log() const { return receiver_log_; }
@@ -82,6 +94,12 @@ class RtcpParser {
     return has_picture_loss_indicator_;
   }
 
+  // Only parsed if a max valid frame ID has been set.
+  bool has_transport_feedback() const { return !transport_feedback_.empty(); }
+  const RtcpTransportFeedback& transport_feedback() const {
+    return transport_feedback_;
+  }
+
  private:
   bool ParseCommonHeader(base::BigEndianReader* reader,
                          RtcpCommonHeader* parsed_header);
@@ -92,6 +110,9 @@ class RtcpParser {
   bool ParseApplicationDefined(base::BigEndianReader* reader,
                                const RtcpCommonHeader& header);
   bool ParseCastReceiverLogFrameItem(base::BigEndianReader* reader);
+  bool ParseTransportFeedback(base::BigEndianReader* reader);
+  // Expands the truncated 32-bit transport feedback |reference_time|.
+  int64_t ExpandTransportFeedbackReferenceTime(uint32_t reference_time);
   bool ParseFeedbackCommon(base::BigEndianReader* reader,
                            const RtcpCommonHeader& header);
   bool ParseExtendedReport(base::BigEndianReader* reader,
@@ -110,6 +131,7 @@ class RtcpParser {
 
   uint32_t last_report_;
   uint32_t delay_since_last_report_;
+  uint8_t fraction_lost_;
   bool has_last_report_;
 
   // |receiver_log_| is a vector vector, no need for has_*.
@@ -133,6 +155,14 @@ class RtcpParser {
   // Indicates if sender received the Pli message from the receiver.
   bool has_picture_loss_indicator_;
 
+  // |transport_feedback_| is a vector, no need for has_*.
+  RtcpTransportFeedback transport_feedback_;
+
+  // The expanded reference time of the last transport feedback, in units of
+  // kTransportFeedbackTimeUnitUs.
+  bool has_transport_feedback_reference_time_;
+  int64_t last_transport_feedback_reference_time_;
+
   DISALLOW_COPY_AND_ASSIGN(RtcpParser);
 };
 
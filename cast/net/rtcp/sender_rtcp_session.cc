@@ -129,9 +129,14 @@ bool SenderRtcpSession::IncomingRtcpPacket(const uint8_t* data, size_t length) {
         rtcp_observer_->OnReceivedReceiverLog(parser_.receiver_log());
       }
     }
+    if (parser_.has_transport_feedback()) {
+      rtcp_observer_->OnReceivedTransportFeedback(
+          parser_.transport_feedback());
+    }
     if (parser_.has_last_report()) {
       OnReceivedDelaySinceLastReport(parser_.last_report(),
                                      parser_.delay_since_last_report());
+      rtcp_observer_->OnReceivedLossFraction(parser_.fraction_lost());
     }
     if (parser_.has_cast_message()) {
       rtcp_observer_->OnReceivedCastMessage(parser_.cast_message());
@@ -4,11 +4,22 @@
 
 #include "media/cast/net/rtp/frame_buffer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 
 namespace media {
 namespace cast {
 
+namespace {
+
+// Size of the field holding the XOR of the packet lengths in an FEC payload.
+const size_t kFecLengthSize = 2;
+
+}  // namespace
+
 FrameBuffer::FrameBuffer()
     : max_packet_id_(0),
       num_packets_received_(0),
@@ -16,46 +27,159 @@ FrameBuffer::FrameBuffer()
       new_playout_delay_ms_(0),
       is_key_frame_(false),
       total_data_size_(0),
-      packets_() {}
+      stride_(0),
+      irregular_(false),
+      received_(1, false),
+      packet_sizes_(1, 0),
+      fec_group_size_(0),
+      num_fec_packets_received_(0) {}
 
 FrameBuffer::~FrameBuffer() {}
 
 bool FrameBuffer::InsertPacket(const uint8_t* payload_data,
                                size_t payload_size,
                                const RtpCastHeader& rtp_header) {
+  DCHECK_LE(payload_size, kMaxIpPacketSize);
+
   // Is this the first packet in the frame?
-  if (packets_.empty()) {
+  if (empty()) {
     frame_id_ = rtp_header.frame_id;
     max_packet_id_ = rtp_header.max_packet_id;
     is_key_frame_ = rtp_header.is_key_frame;
-    new_playout_delay_ms_ = rtp_header.new_playout_delay_ms;
     if (is_key_frame_)
       DCHECK_EQ(rtp_header.frame_id, rtp_header.reference_frame_id);
     last_referenced_frame_id_ = rtp_header.reference_frame_id;
     rtp_timestamp_ = rtp_header.rtp_timestamp;
+    received_.assign(max_packet_id_ + 1, false);
+    packet_sizes_.assign(max_packet_id_ + 1, 0);
   }
   // Is this the correct frame?
   if (rtp_header.frame_id != frame_id_)
     return false;
 
-  // Insert every packet only once.
-  if (packets_.find(rtp_header.packet_id) != packets_.end()) {
+  // The playout delay is sent with the first packet and with the FEC packets,
+  // any of which may be the first to arrive.
+  if (rtp_header.new_playout_delay_ms)
+    new_playout_delay_ms_ = rtp_header.new_playout_delay_ms;
+
+  if (rtp_header.fec_group_size)
+    return InsertFecPacket(payload_data, payload_size, rtp_header);
+
+  // Insert every packet only once, and only packets which fit in the frame.
+  const uint16_t packet_id = rtp_header.packet_id;
+  if (packet_id > max_packet_id_ || received_[packet_id])
+    return false;
+
+  InsertMediaPacket(packet_id, payload_data, payload_size);
+  if (fec_group_size_ && !Complete())
+    RecoverPacket(packet_id / fec_group_size_);
+  return true;
+}
+
+bool FrameBuffer::InsertFecPacket(const uint8_t* payload_data,
+                                  size_t payload_size,
+                                  const RtpCastHeader& rtp_header) {
+  // FEC packets are of no use once the frame is complete, and must all agree
+  // on how the frame is laid out.
+  if (Complete() || rtp_header.max_packet_id != max_packet_id_ ||
+      payload_size < kFecLengthSize ||
+      (fec_group_size_ && rtp_header.fec_group_size != fec_group_size_)) {
+    return false;
+  }
+  const size_t group = rtp_header.packet_id - max_packet_id_ - 1;
+  if (group > max_packet_id_ / rtp_header.fec_group_size)
     return false;
+  if (!fec_group_size_) {
+    fec_group_size_ = rtp_header.fec_group_size;
+    fec_packets_.resize(max_packet_id_ / fec_group_size_ + 1);
   }
+  if (!fec_packets_[group].empty())
+    return false;
+
+  fec_packets_[group].assign(payload_data, payload_data + payload_size);
+  ++num_fec_packets_received_;
+  // The FEC packets are sent after all of the others.
+  max_seen_packet_id_ = max_packet_id_;
+  RecoverPacket(group);
+  return true;
+}
 
-  std::vector<uint8_t> data;
-  std::pair<PacketMap::iterator, bool> retval =
-      packets_.insert(make_pair(rtp_header.packet_id, data));
+void FrameBuffer::InsertMediaPacket(uint16_t packet_id,
+                                    const uint8_t* payload_data,
+                                    size_t payload_size) {
+  if (packet_id != max_packet_id_) {
+    if (!stride_)
+      SetStride(payload_size);
+    else if (payload_size != stride_ && !irregular_)
+      Relayout(kMaxIpPacketSize);
+  } else if (stride_ && payload_size > stride_ && !irregular_) {
+    Relayout(kMaxIpPacketSize);
+  }
 
-  // Insert the packet.
-  retval.first->second.resize(payload_size);
-  std::copy(
-      payload_data, payload_data + payload_size, retval.first->second.begin());
+  // The offset of the last packet isn't known until the size of the others is.
+  if (packet_id == max_packet_id_ && max_packet_id_ > 0 && !stride_)
+    last_packet_.assign(payload_data, payload_data + payload_size);
+  else
+    PlacePacket(packet_id, payload_data, payload_size);
 
+  received_[packet_id] = true;
+  packet_sizes_[packet_id] = static_cast<uint16_t>(payload_size);
   ++num_packets_received_;
-  max_seen_packet_id_ = std::max(max_seen_packet_id_, rtp_header.packet_id);
+  max_seen_packet_id_ = std::max(max_seen_packet_id_, packet_id);
   total_data_size_ += payload_size;
-  return true;
+
+  if (Complete())
+    FinishFrame();
+}
+
+void FrameBuffer::RecoverPacket(size_t group) {
+  const std::string& parity = fec_packets_[group];
+  if (parity.empty())
+    return;
+
+  // XOR parity restores the packet only if it is the only one missing.
+  const int first_packet = group * fec_group_size_;
+  const int last_packet = std::min<int>(first_packet + fec_group_size_ - 1,
+                                        max_packet_id_);
+  int missing_packet = -1;
+  for (int packet = first_packet; packet <= last_packet; ++packet) {
+    if (received_[packet])
+      continue;
+    if (missing_packet >= 0)
+      return;
+    missing_packet = packet;
+  }
+  if (missing_packet < 0)
+    return;
+
+  uint16_t length = static_cast<uint16_t>(
+      static_cast<uint8_t>(parity[0]) << 8 | static_cast<uint8_t>(parity[1]));
+  recovered_packet_.assign(parity, kFecLengthSize, std::string::npos);
+  for (int packet = first_packet; packet <= last_packet; ++packet) {
+    if (packet == missing_packet)
+      continue;
+    const size_t size = packet_sizes_[packet];
+    if (size > recovered_packet_.size())
+      return;  // Not the FEC packet of this frame's packets.
+    length ^= packet_sizes_[packet];
+    const char* const data = GetPacketData(packet);
+    for (size_t i = 0; i < size; ++i)
+      recovered_packet_[i] ^= data[i];
+  }
+  if (length > recovered_packet_.size())
+    return;
+
+  VLOG(2) << "Recovered packet " << missing_packet << " of frame "
+          << frame_id_;
+  InsertMediaPacket(missing_packet,
+                    reinterpret_cast<const uint8_t*>(recovered_packet_.data()),
+                    length);
+}
+
+const char* FrameBuffer::GetPacketData(uint16_t packet_id) const {
+  if (packet_id == max_packet_id_ && max_packet_id_ > 0 && !stride_)
+    return last_packet_.data();
+  return data_.data() + packet_id * stride_;
 }
 
 bool FrameBuffer::Complete() const {
@@ -63,6 +187,14 @@ bool FrameBuffer::Complete() const {
 }
 
 bool FrameBuffer::AssembleEncodedFrame(EncodedFrame* frame) const {
+  if (!GetFrameMetadata(frame))
+    return false;
+
+  frame->data.assign(data_);
+  return true;
+}
+
+bool FrameBuffer::GetFrameMetadata(EncodedFrame* frame) const {
   if (!Complete())
     return false;
 
@@ -77,38 +209,112 @@ bool FrameBuffer::AssembleEncodedFrame(EncodedFrame* frame) const {
   frame->referenced_frame_id = last_referenced_frame_id_;
   frame->rtp_timestamp = rtp_timestamp_;
   frame->new_playout_delay_ms = new_playout_delay_ms_;
+  return true;
+}
+
+bool FrameBuffer::TakeData(std::string* data) {
+  if (!Complete())
+    return false;
 
-  // Build the data vector.
-  frame->data.clear();
-  frame->data.reserve(total_data_size_);
-  PacketMap::const_iterator it;
-  for (it = packets_.begin(); it != packets_.end(); ++it)
-    frame->data.insert(frame->data.end(), it->second.begin(), it->second.end());
+  data->swap(data_);
+  data_.clear();
   return true;
 }
 
+void FrameBuffer::Reset() {
+  max_packet_id_ = 0;
+  num_packets_received_ = 0;
+  max_seen_packet_id_ = 0;
+  new_playout_delay_ms_ = 0;
+  is_key_frame_ = false;
+  total_data_size_ = 0;
+  stride_ = 0;
+  irregular_ = false;
+  data_.clear();
+  last_packet_.clear();
+  received_.assign(1, false);
+  packet_sizes_.assign(1, 0);
+  fec_group_size_ = 0;
+  num_fec_packets_received_ = 0;
+  fec_packets_.clear();
+}
+
 void FrameBuffer::GetMissingPackets(bool newest_frame,
                                     PacketIdSet* missing_packets) const {
   // Missing packets capped by max_seen_packet_id_.
   // (Iff it's the latest frame)
-  int maximum = newest_frame ? max_seen_packet_id_ : max_packet_id_;
-  int packet = 0;
-  for (PacketMap::const_iterator i = packets_.begin();
-       i != packets_.end() && packet <= maximum;
-       ++i) {
-    int end = std::min<int>(i->first, maximum + 1);
-    while (packet < end) {
+  const int maximum = newest_frame ? max_seen_packet_id_ : max_packet_id_;
+  for (int packet = 0; packet <= maximum; ++packet) {
+    if (!received_[packet])
       missing_packets->insert(packet);
-      packet++;
-    }
-    packet++;
   }
-  while (packet <= maximum) {
-    missing_packets->insert(packet);
-    packet++;
+}
+
+void FrameBuffer::SetStride(size_t payload_size) {
+  DCHECK(!stride_);
+
+  // An empty packet gives no hint of where the others go.
+  if (payload_size) {
+    stride_ = payload_size;
+  } else {
+    stride_ = kMaxIpPacketSize;
+    irregular_ = true;
+  }
+  if (received_[max_packet_id_] && last_packet_.size() > stride_) {
+    stride_ = kMaxIpPacketSize;
+    irregular_ = true;
+  }
+  data_.reserve((max_packet_id_ + 1) * stride_);
+
+  if (received_[max_packet_id_]) {
+    PlacePacket(max_packet_id_,
+                reinterpret_cast<const uint8_t*>(last_packet_.data()),
+                last_packet_.size());
   }
 }
 
+void FrameBuffer::PlacePacket(uint16_t packet_id,
+                              const uint8_t* payload_data,
+                              size_t payload_size) {
+  const size_t offset = packet_id * stride_;
+  if (data_.size() < offset + payload_size)
+    data_.resize(offset + payload_size);
+  if (payload_size)
+    memcpy(&data_[offset], payload_data, payload_size);
+}
+
+void FrameBuffer::Relayout(size_t new_stride) {
+  DCHECK(stride_);
+  DCHECK_GE(new_stride, stride_);
+
+  data_.reserve((max_packet_id_ + 1) * new_stride);
+  data_.resize(std::max(data_.size(), (max_seen_packet_id_ + 1) * new_stride));
+  // Work down from the end so that no packet is overwritten before it moves.
+  for (int packet = max_seen_packet_id_; packet > 0; --packet) {
+    if (received_[packet] && packet_sizes_[packet]) {
+      memmove(&data_[packet * new_stride], &data_[packet * stride_],
+              packet_sizes_[packet]);
+    }
+  }
+  stride_ = new_stride;
+  irregular_ = true;
+}
+
+void FrameBuffer::FinishFrame() {
+  if (!irregular_) {
+    data_.resize(max_packet_id_ * stride_ + packet_sizes_[max_packet_id_]);
+  } else {
+    size_t size = 0;
+    for (int packet = 0; packet <= max_packet_id_; ++packet) {
+      if (packet_sizes_[packet]) {
+        memmove(&data_[size], &data_[packet * stride_], packet_sizes_[packet]);
+        size += packet_sizes_[packet];
+      }
+    }
+    data_.resize(size);
+  }
+  DCHECK_EQ(total_data_size_, data_.size());
+}
 
 }  // namespace cast
 }  // namespace media
@@ -8,7 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <map>
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
@@ -19,8 +19,13 @@
 namespace media {
 namespace cast {
 
-typedef std::map<uint16_t, std::vector<uint8_t>> PacketMap;
-
+// Reassembles the packets of one frame.  RtpPacketizer gives every packet of a
+// frame but the last the same payload size, so each packet is copied straight
+// to its final offset in a single buffer and a complete frame needs no further
+// copying.  Packets which don't follow that layout are still accepted, at the
+// cost of moving the data once the frame is complete.  A packet which is lost
+// can be restored from an FEC packet if it is the only one missing from its
+// group; see RtpPacketizer::SetFecGroupSize().
 class FrameBuffer {
  public:
   FrameBuffer();
@@ -38,11 +43,56 @@ class FrameBuffer {
   // remains unchanged.
   bool AssembleEncodedFrame(EncodedFrame* frame) const;
 
+  // Like AssembleEncodedFrame(), but leaves the data field of |frame| alone.
+  bool GetFrameMetadata(EncodedFrame* frame) const;
+
+  // If a frame is complete, swaps its data into |data| without copying and
+  // returns true.  The buffer must not be assembled again until it is Reset().
+  bool TakeData(std::string* data);
+
+  // Returns the buffer to its initial state so it can be reused for another
+  // frame, keeping its allocations.
+  void Reset();
+
+  bool empty() const {
+    return num_packets_received_ == 0 && num_fec_packets_received_ == 0;
+  }
   bool is_key_frame() const { return is_key_frame_; }
   FrameId last_referenced_frame_id() const { return last_referenced_frame_id_; }
   FrameId frame_id() const { return frame_id_; }
 
  private:
+  bool InsertFecPacket(const uint8_t* payload_data,
+                       size_t payload_size,
+                       const RtpCastHeader& rtp_header);
+
+  // Stores a packet which has not been received before.
+  void InsertMediaPacket(uint16_t packet_id,
+                         const uint8_t* payload_data,
+                         size_t payload_size);
+
+  // Restores the packet missing from FEC group |group|, if there is exactly
+  // one and the group's FEC packet has arrived.
+  void RecoverPacket(size_t group);
+
+  // Returns the start of a received packet's payload.
+  const char* GetPacketData(uint16_t packet_id) const;
+
+  // Called with the first packet size seen for a packet other than the last.
+  void SetStride(size_t payload_size);
+
+  // Copies a packet to its offset in |data_|.
+  void PlacePacket(uint16_t packet_id,
+                   const uint8_t* payload_data,
+                   size_t payload_size);
+
+  // Spreads the packets received so far out to |new_stride| apart, for frames
+  // whose packet sizes turn out not to be uniform.
+  void Relayout(size_t new_stride);
+
+  // Closes any gaps left between the packets once they have all arrived.
+  void FinishFrame();
+
   FrameId frame_id_;
   uint16_t max_packet_id_;
   uint16_t num_packets_received_;
@@ -52,7 +102,25 @@ class FrameBuffer {
   size_t total_data_size_;
   FrameId last_referenced_frame_id_;
   RtpTimeTicks rtp_timestamp_;
-  PacketMap packets_;
+
+  // Packet |i| is stored at |i * stride_| in |data_|.  |stride_| is zero until
+  // a packet other than the last has been received; until then the last packet
+  // waits in |last_packet_|.
+  size_t stride_;
+  bool irregular_;
+  std::string data_;
+  std::string last_packet_;
+
+  // Which packets have arrived, and their sizes.
+  std::vector<bool> received_;
+  std::vector<uint16_t> packet_sizes_;
+
+  // The payloads of the FEC packets received, by group, and the number of
+  // packets in each group.  |fec_group_size_| is zero until one has arrived.
+  uint16_t fec_group_size_;
+  uint16_t num_fec_packets_received_;
+  std::vector<std::string> fec_packets_;
+  std::string recovered_packet_;
 
   DISALLOW_COPY_AND_ASSIGN(FrameBuffer);
 };
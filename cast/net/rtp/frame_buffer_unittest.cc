@@ -4,6 +4,9 @@
 
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
 #include "base/macros.h"
 #include "media/cast/net/cast_transport_defines.h"
 #include "media/cast/net/rtp/frame_buffer.h"
@@ -22,6 +25,33 @@ class FrameBufferTest : public ::testing::Test {
 
   ~FrameBufferTest() override {}
 
+  // Inserts packet |packet_id| of the current frame, filled with |value|.
+  bool InsertPacket(uint16_t packet_id, size_t size, char value) {
+    rtp_header_.packet_id = packet_id;
+    rtp_header_.fec_group_size = 0;
+    const std::vector<uint8_t> payload(size, value);
+    return buffer_.InsertPacket(payload.data(), payload.size(), rtp_header_);
+  }
+
+  // Inserts the FEC packet of group |group| of the current frame, protecting
+  // |packets|.  See RtpPacketizer::AppendFecPackets().
+  bool InsertFecPacket(uint16_t group,
+                       uint16_t group_size,
+                       const std::vector<std::string>& packets) {
+    rtp_header_.packet_id = rtp_header_.max_packet_id + 1 + group;
+    rtp_header_.fec_group_size = group_size;
+    std::vector<uint8_t> payload(2 + packets[0].size(), 0);
+    uint16_t length = 0;
+    for (const std::string& packet : packets) {
+      length ^= packet.size();
+      for (size_t i = 0; i < packet.size(); ++i)
+        payload[2 + i] ^= packet[i];
+    }
+    payload[0] = static_cast<uint8_t>(length >> 8);
+    payload[1] = static_cast<uint8_t>(length);
+    return buffer_.InsertPacket(payload.data(), payload.size(), rtp_header_);
+  }
+
   FrameBuffer buffer_;
   std::vector<uint8_t> payload_;
   RtpCastHeader rtp_header_;
@@ -92,5 +122,98 @@ TEST_F(FrameBufferTest, IncompleteFrame) {
   EXPECT_TRUE(buffer_.Complete());
 }
 
+TEST_F(FrameBufferTest, LastPacketFirst) {
+  rtp_header_.max_packet_id = 2;
+  EXPECT_TRUE(InsertPacket(2, 3, 'c'));
+  EXPECT_TRUE(InsertPacket(0, 5, 'a'));
+  EXPECT_FALSE(InsertPacket(2, 3, 'c'));
+  EXPECT_FALSE(buffer_.Complete());
+  EXPECT_TRUE(InsertPacket(1, 5, 'b'));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ("aaaaabbbbbccc", frame.data);
+}
+
+TEST_F(FrameBufferTest, NonUniformPacketSizes) {
+  rtp_header_.max_packet_id = 3;
+  EXPECT_TRUE(InsertPacket(1, 4, 'b'));
+  EXPECT_TRUE(InsertPacket(3, 7, 'd'));
+  EXPECT_TRUE(InsertPacket(0, 6, 'a'));
+  EXPECT_TRUE(InsertPacket(2, 2, 'c'));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ("aaaaaabbbbccddddddd", frame.data);
+}
+
+TEST_F(FrameBufferTest, RejectsPacketBeyondLast) {
+  rtp_header_.max_packet_id = 1;
+  EXPECT_TRUE(InsertPacket(0, 5, 'a'));
+  EXPECT_FALSE(InsertPacket(2, 5, 'c'));
+  EXPECT_FALSE(buffer_.Complete());
+}
+
+TEST_F(FrameBufferTest, TakeDataAndReuse) {
+  rtp_header_.max_packet_id = 1;
+  EXPECT_TRUE(InsertPacket(0, 3, 'a'));
+  std::string data;
+  EXPECT_FALSE(buffer_.TakeData(&data));
+  EXPECT_TRUE(InsertPacket(1, 1, 'b'));
+  EXPECT_TRUE(buffer_.TakeData(&data));
+  EXPECT_EQ("aaab", data);
+
+  buffer_.Reset();
+  EXPECT_TRUE(buffer_.empty());
+  rtp_header_.frame_id = FrameId::first() + 1;
+  rtp_header_.max_packet_id = 0;
+  EXPECT_TRUE(InsertPacket(0, 2, 'c'));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ(FrameId::first() + 1, frame.frame_id);
+  EXPECT_EQ("cc", frame.data);
+}
+
+TEST_F(FrameBufferTest, FecRestoresMissingPacket) {
+  rtp_header_.max_packet_id = 2;
+  const std::vector<std::string> packets = {"aaaa", "bbbb", "cc"};
+  EXPECT_TRUE(InsertPacket(0, 4, 'a'));
+  EXPECT_TRUE(InsertPacket(2, 2, 'c'));
+  EXPECT_FALSE(buffer_.Complete());
+  EXPECT_TRUE(InsertFecPacket(0, 3, packets));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ("aaaabbbbcc", frame.data);
+}
+
+TEST_F(FrameBufferTest, FecRestoresLastPacket) {
+  rtp_header_.max_packet_id = 2;
+  const std::vector<std::string> packets = {"aaaa", "bbbb", "cc"};
+  EXPECT_TRUE(InsertFecPacket(0, 3, packets));
+  EXPECT_FALSE(InsertFecPacket(0, 3, packets));
+  EXPECT_TRUE(InsertPacket(1, 4, 'b'));
+  EXPECT_TRUE(InsertPacket(0, 4, 'a'));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ("aaaabbbbcc", frame.data);
+}
+
+TEST_F(FrameBufferTest, FecRestoresOnePacketPerGroup) {
+  rtp_header_.max_packet_id = 4;
+  EXPECT_TRUE(InsertFecPacket(0, 3, {"aaa", "bbb", "ccc"}));
+  EXPECT_TRUE(InsertFecPacket(1, 3, {"ddd", "e"}));
+  EXPECT_TRUE(InsertPacket(0, 3, 'a'));
+  EXPECT_TRUE(InsertPacket(3, 3, 'd'));
+  EXPECT_FALSE(buffer_.Complete());
+
+  // The FEC packets say that all of the packets were sent.
+  PacketIdSet missing_packets;
+  buffer_.GetMissingPackets(true, &missing_packets);
+  EXPECT_EQ(PacketIdSet({1, 2}), missing_packets);
+
+  EXPECT_TRUE(InsertPacket(2, 3, 'c'));
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ("aaabbbcccddde", frame.data);
+}
+
 }  // namespace media
 }  // namespace cast
@@ -4,6 +4,8 @@
 
 #include "media/cast/net/rtp/framer.h"
 
+#include <utility>
+
 #include "base/logging.h"
 #include "media/cast/constants.h"
 
@@ -16,6 +18,7 @@ Framer::Framer(base::TickClock* clock,
                bool decoder_faster_than_max_frame_rate,
                int max_unacked_frames)
     : decoder_faster_than_max_frame_rate_(decoder_faster_than_max_frame_rate),
+      num_frames_(0),
       cast_msg_builder_(clock,
                         incoming_payload_feedback,
                         this,
@@ -26,6 +29,13 @@ Framer::Framer(base::TickClock* clock,
       last_released_frame_(FrameId::first() - 1),
       newest_frame_id_(FrameId::first() - 1) {
   DCHECK(incoming_payload_feedback) << "Invalid argument";
+
+  // Room for every frame the sender may have in flight, plus the one being
+  // released.
+  size_t ring_size = 1;
+  while (ring_size < static_cast<size_t>(max_unacked_frames) + 1)
+    ring_size *= 2;
+  frames_.resize(ring_size);
 }
 
 Framer::~Framer() {}
@@ -56,21 +66,18 @@ bool Framer::InsertPacket(const uint8_t* payload_data,
   }
 
   // Insert packet.
-  const auto it = frames_.find(rtp_header.frame_id);
-  FrameBuffer* buffer;
-  if (it == frames_.end()) {
-    buffer = new FrameBuffer();
-    frames_.insert(std::make_pair(rtp_header.frame_id,
-                                  std::unique_ptr<FrameBuffer>(buffer)));
-  } else {
-    buffer = it->second.get();
-  }
+  FrameBuffer* buffer = FindFrame(rtp_header.frame_id);
+  const bool new_frame = !buffer;
+  if (new_frame)
+    buffer = AddFrame(rtp_header.frame_id);
   if (!buffer->InsertPacket(payload_data, payload_size, rtp_header)) {
     VLOG(3) << "Packet already received, ignored: frame " << rtp_header.frame_id
             << ", packet " << rtp_header.packet_id;
     *duplicate = true;
     return false;
   }
+  if (new_frame)
+    ++num_frames_;
 
   return buffer->Complete();
 }
@@ -79,6 +86,29 @@ bool Framer::InsertPacket(const uint8_t* payload_data,
 bool Framer::GetEncodedFrame(EncodedFrame* frame,
                              bool* next_frame,
                              bool* have_multiple_decodable_frames) {
+  FrameBuffer* const buffer =
+      FindFrameToEmit(next_frame, have_multiple_decodable_frames);
+  return buffer && buffer->AssembleEncodedFrame(frame);
+}
+
+bool Framer::PeekEncodedFrame(EncodedFrame* frame,
+                              bool* next_frame,
+                              bool* have_multiple_decodable_frames) {
+  FrameBuffer* const buffer =
+      FindFrameToEmit(next_frame, have_multiple_decodable_frames);
+  if (!buffer || !buffer->GetFrameMetadata(frame))
+    return false;
+  frame->data.clear();
+  return true;
+}
+
+bool Framer::TakeFrameData(FrameId frame_id, std::string* data) {
+  FrameBuffer* const buffer = FindFrame(frame_id);
+  return buffer && buffer->TakeData(data);
+}
+
+FrameBuffer* Framer::FindFrameToEmit(bool* next_frame,
+                                     bool* have_multiple_decodable_frames) {
   *have_multiple_decodable_frames = HaveMultipleDecodableFrames();
 
   // Find frame id.
@@ -89,15 +119,15 @@ bool Framer::GetEncodedFrame(EncodedFrame* frame,
   } else {
     // Check if we can skip frames when our decoder is too slow.
     if (!decoder_faster_than_max_frame_rate_)
-      return false;
+      return nullptr;
 
     buffer = FindOldestDecodableFrame();
     if (!buffer)
-      return false;
+      return nullptr;
     *next_frame = false;
   }
 
-  return buffer->AssembleEncodedFrame(frame);
+  return buffer;
 }
 
 void Framer::AckFrame(FrameId frame_id) {
@@ -106,9 +136,20 @@ void Framer::AckFrame(FrameId frame_id) {
 }
 
 void Framer::ReleaseFrame(FrameId frame_id) {
-  const auto it = frames_.begin();
-  const bool skipped_old_frame = it->first < frame_id;
-  frames_.erase(it, frames_.upper_bound(frame_id));
+  bool skipped_old_frame = false;
+  for (FrameId id = oldest_frame_id_; num_frames_ > 0 && id <= frame_id;
+       ++id) {
+    FrameBuffer* const buffer = FindFrame(id);
+    if (!buffer)
+      continue;
+    skipped_old_frame |= id < frame_id;
+    buffer->Reset();
+    --num_frames_;
+  }
+  if (oldest_frame_id_ <= frame_id)
+    oldest_frame_id_ = frame_id + 1;
+  while (num_frames_ > 0 && !FindFrame(oldest_frame_id_))
+    ++oldest_frame_id_;
   last_released_frame_ = frame_id;
   if (skipped_old_frame)
     cast_msg_builder_.UpdateCastMessage();
@@ -123,25 +164,31 @@ void Framer::SendCastMessage() {
 }
 
 FrameBuffer* Framer::FindNextFrameForRelease() {
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsNextFrameForRelease(*entry.second))
-      return entry.second.get();
+  for (FrameId id = oldest_frame_id_; num_frames_ > 0 && id <= newest_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = FindFrame(id);
+    if (buffer && buffer->Complete() && IsNextFrameForRelease(*buffer))
+      return buffer;
   }
   return nullptr;
 }
 
 FrameBuffer* Framer::FindOldestDecodableFrame() {
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsDecodableFrame(*entry.second))
-      return entry.second.get();
+  for (FrameId id = oldest_frame_id_; num_frames_ > 0 && id <= newest_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = FindFrame(id);
+    if (buffer && buffer->Complete() && IsDecodableFrame(*buffer))
+      return buffer;
   }
   return nullptr;
 }
 
 bool Framer::HaveMultipleDecodableFrames() const {
   bool found_one = false;
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsDecodableFrame(*entry.second)) {
+  for (FrameId id = oldest_frame_id_; num_frames_ > 0 && id <= newest_frame_id_;
+       ++id) {
+    const FrameBuffer* const buffer = FindFrame(id);
+    if (buffer && buffer->Complete() && IsDecodableFrame(*buffer)) {
       if (found_one)
         return true;  // Found another.
       else
@@ -151,29 +198,31 @@ bool Framer::HaveMultipleDecodableFrames() const {
   return false;
 }
 
-bool Framer::Empty() const { return frames_.empty(); }
+bool Framer::Empty() const { return num_frames_ == 0; }
 
 int Framer::NumberOfCompleteFrames() const {
   int count = 0;
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete())
+  for (FrameId id = oldest_frame_id_; num_frames_ > 0 && id <= newest_frame_id_;
+       ++id) {
+    const FrameBuffer* const buffer = FindFrame(id);
+    if (buffer && buffer->Complete())
       ++count;
   }
   return count;
 }
 
 bool Framer::FrameExists(FrameId frame_id) const {
-  return frames_.end() != frames_.find(frame_id);
+  return !!FindFrame(frame_id);
 }
 
 void Framer::GetMissingPackets(FrameId frame_id,
                                bool last_frame,
                                PacketIdSet* missing_packets) const {
-  const auto it = frames_.find(frame_id);
-  if (it == frames_.end())
+  const FrameBuffer* const buffer = FindFrame(frame_id);
+  if (!buffer)
     return;
 
-  it->second->GetMissingPackets(last_frame, missing_packets);
+  buffer->GetMissingPackets(last_frame, missing_packets);
 }
 
 bool Framer::IsNextFrameForRelease(const FrameBuffer& buffer) const {
@@ -196,5 +245,43 @@ bool Framer::IsDecodableFrame(const FrameBuffer& buffer) const {
   return buffer.last_referenced_frame_id() <= last_released_frame_;
 }
 
+FrameBuffer* Framer::FindFrame(FrameId frame_id) const {
+  FrameBuffer* const buffer = frames_[IndexOf(frame_id)].get();
+  if (!buffer || buffer->empty() || buffer->frame_id() != frame_id)
+    return nullptr;
+  return buffer;
+}
+
+FrameBuffer* Framer::AddFrame(FrameId frame_id) {
+  if (num_frames_ == 0 || frame_id < oldest_frame_id_)
+    oldest_frame_id_ = frame_id;
+
+  // Frames only arrive ahead of the window when the sender gets far ahead of
+  // the receiver, so growing is rare.
+  const size_t span = (newest_frame_id_ - oldest_frame_id_) + 1;
+  if (span > frames_.size()) {
+    size_t ring_size = frames_.size();
+    while (ring_size < span)
+      ring_size *= 2;
+    std::vector<std::unique_ptr<FrameBuffer>> old_frames(ring_size);
+    old_frames.swap(frames_);
+    for (std::unique_ptr<FrameBuffer>& buffer : old_frames) {
+      if (buffer && !buffer->empty())
+        frames_[IndexOf(buffer->frame_id())] = std::move(buffer);
+    }
+  }
+
+  std::unique_ptr<FrameBuffer>& buffer = frames_[IndexOf(frame_id)];
+  if (!buffer)
+    buffer.reset(new FrameBuffer());
+  DCHECK(buffer->empty());
+  return buffer.get();
+}
+
+size_t Framer::IndexOf(FrameId frame_id) const {
+  return static_cast<size_t>(frame_id - FrameId::first()) &
+         (frames_.size() - 1);
+}
+
 }  // namespace cast
 }  // namespace media
@@ -8,8 +8,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/time/tick_clock.h"
@@ -47,6 +48,17 @@ class Framer {
                        bool* next_frame,
                        bool* have_multiple_complete_frames);
 
+  // Like GetEncodedFrame(), but leaves the data field of |video_frame| empty.
+  // Use TakeFrameData() to move the payload out once the frame is wanted.
+  bool PeekEncodedFrame(EncodedFrame* video_frame,
+                        bool* next_frame,
+                        bool* have_multiple_complete_frames);
+
+  // Swaps the payload of the complete frame |frame_id| into |data| without
+  // copying.  Returns false if there is no such frame.  The frame must be
+  // released before it is retrieved again.
+  bool TakeFrameData(FrameId frame_id, std::string* data);
+
   // TODO(hubbe): Move this elsewhere.
   void AckFrame(FrameId frame_id);
 
@@ -67,6 +79,10 @@ class Framer {
                          PacketIdSet* missing_packets) const;
 
  private:
+  // Helper for GetEncodedFrame() and PeekEncodedFrame().
+  FrameBuffer* FindFrameToEmit(bool* next_frame,
+                               bool* have_multiple_complete_frames);
+
   // Identifies the next frame to be released (rendered) and returns its
   // associated buffer, or returns nullptr there is none.
   FrameBuffer* FindNextFrameForRelease();
@@ -82,8 +98,25 @@ class Framer {
   // Helper for FindOldestDecodableFrame() and HaveMultipleDecodableFrames().
   bool IsDecodableFrame(const FrameBuffer& frame) const;
 
+  // Returns the buffer holding |frame_id|, or nullptr if there is none.
+  FrameBuffer* FindFrame(FrameId frame_id) const;
+
+  // Returns an empty buffer for |frame_id|, growing |frames_| if needed.
+  FrameBuffer* AddFrame(FrameId frame_id);
+
+  // Returns the slot in |frames_| for |frame_id|.
+  size_t IndexOf(FrameId frame_id) const;
+
   const bool decoder_faster_than_max_frame_rate_;
-  std::map<FrameId, std::unique_ptr<FrameBuffer>> frames_;
+
+  // A ring of frames indexed by FrameId.  Its size is a power of two no smaller
+  // than the span from |oldest_frame_id_| to |newest_frame_id_|, so each frame
+  // being received has a slot of its own.  Released buffers stay in their
+  // slots to be reused.
+  std::vector<std::unique_ptr<FrameBuffer>> frames_;
+  int num_frames_;
+  FrameId oldest_frame_id_;
+
   CastMessageBuilder cast_msg_builder_;
   bool waiting_for_key_;
   FrameId last_released_frame_;
@@ -4,6 +4,9 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <string>
+
 #include "base/macros.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/cast/net/cast_transport_defines.h"
@@ -453,5 +456,80 @@ TEST_F(FramerTest, SkipsMissingFramesWhenLaterKeyFramesAreAvailable) {
   framer_.ReleaseFrame(frame.frame_id);
 }
 
+TEST_F(FramerTest, PeekAndTakeFrameData) {
+  EncodedFrame frame;
+  bool next_frame = false;
+  bool multiple = false;
+  bool duplicate = false;
+
+  // A two packet key frame, with the packets out of order.
+  payload_.assign(10, 'a');
+  rtp_header_.is_key_frame = true;
+  rtp_header_.frame_id = FrameId::first();
+  rtp_header_.reference_frame_id = FrameId::first();
+  rtp_header_.max_packet_id = 1;
+  rtp_header_.packet_id = 1;
+  EXPECT_FALSE(framer_.InsertPacket(&payload_[0], 4, rtp_header_, &duplicate));
+  rtp_header_.packet_id = 0;
+  EXPECT_TRUE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                   &duplicate));
+
+  EXPECT_TRUE(framer_.PeekEncodedFrame(&frame, &next_frame, &multiple));
+  EXPECT_TRUE(next_frame);
+  EXPECT_EQ(EncodedFrame::KEY, frame.dependency);
+  EXPECT_EQ(FrameId::first(), frame.frame_id);
+  EXPECT_TRUE(frame.data.empty());
+
+  // Peeking again finds the same frame.
+  EXPECT_TRUE(framer_.PeekEncodedFrame(&frame, &next_frame, &multiple));
+  EXPECT_EQ(FrameId::first(), frame.frame_id);
+
+  EXPECT_FALSE(framer_.TakeFrameData(FrameId::first() + 1, &frame.data));
+  EXPECT_TRUE(framer_.TakeFrameData(FrameId::first(), &frame.data));
+  EXPECT_EQ(std::string(14, 'a'), frame.data);
+  framer_.ReleaseFrame(frame.frame_id);
+  EXPECT_TRUE(framer_.Empty());
+}
+
+TEST_F(FramerTest, ManyFramesInFlight) {
+  EncodedFrame frame;
+  bool next_frame = false;
+  bool multiple = false;
+  bool duplicate = false;
+
+  // Receive the second packet of many frames before any of them completes,
+  // which is more than the ring starts out with room for.
+  const int kNumFrames = 200;
+  rtp_header_.max_packet_id = 1;
+  rtp_header_.packet_id = 1;
+  for (int i = 0; i < kNumFrames; ++i) {
+    rtp_header_.is_key_frame = i == 0;
+    rtp_header_.frame_id = FrameId::first() + i;
+    rtp_header_.reference_frame_id = FrameId::first() + std::max(i - 1, 0);
+    EXPECT_FALSE(framer_.InsertPacket(&payload_[0], payload_.size(),
+                                      rtp_header_, &duplicate));
+  }
+  EXPECT_EQ(0, framer_.NumberOfCompleteFrames());
+
+  rtp_header_.packet_id = 0;
+  for (int i = kNumFrames - 1; i >= 0; --i) {
+    rtp_header_.is_key_frame = i == 0;
+    rtp_header_.frame_id = FrameId::first() + i;
+    rtp_header_.reference_frame_id = FrameId::first() + std::max(i - 1, 0);
+    EXPECT_TRUE(framer_.InsertPacket(&payload_[0], payload_.size(),
+                                     rtp_header_, &duplicate));
+  }
+  EXPECT_EQ(kNumFrames, framer_.NumberOfCompleteFrames());
+
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_TRUE(framer_.GetEncodedFrame(&frame, &next_frame, &multiple));
+    EXPECT_TRUE(next_frame);
+    EXPECT_EQ(FrameId::first() + i, frame.frame_id);
+    EXPECT_EQ(2 * payload_.size(), frame.data.size());
+    framer_.ReleaseFrame(frame.frame_id);
+  }
+  EXPECT_TRUE(framer_.Empty());
+}
+
 }  // namespace cast
 }  // namespace media
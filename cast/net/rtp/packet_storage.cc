@@ -10,13 +10,24 @@
 namespace media {
 namespace cast {
 
-PacketStorage::PacketStorage() : zombie_count_(0) {}
+namespace {
+
+// The initial size of the ring of frames: the smallest power of two that holds
+// the system's limit on unacknowledged frames.
+const size_t kInitialRingSize = 128;
+static_assert(kInitialRingSize >= static_cast<size_t>(kMaxUnackedFrames),
+              "The ring must hold every unacknowledged frame.");
+
+}  // namespace
+
+PacketStorage::PacketStorage()
+    : frames_(kInitialRingSize), num_frames_in_list_(0), zombie_count_(0) {}
 
 PacketStorage::~PacketStorage() {
 }
 
 size_t PacketStorage::GetNumberOfStoredFrames() const {
-  return frames_.size() - zombie_count_;
+  return num_frames_in_list_ - zombie_count_;
 }
 
 void PacketStorage::StoreFrame(FrameId frame_id,
@@ -26,18 +37,30 @@ void PacketStorage::StoreFrame(FrameId frame_id,
     return;
   }
 
-  if (frames_.empty()) {
+  if (!num_frames_in_list_) {
     first_frame_id_in_list_ = frame_id;
   } else {
     // Make sure frame IDs are consecutive.
-    DCHECK_EQ(first_frame_id_in_list_ + frames_.size(), frame_id);
+    DCHECK_EQ(first_frame_id_in_list_ + num_frames_in_list_, frame_id);
     // Make sure we aren't being asked to store more frames than the system's
     // design limit.
-    DCHECK_LT(frames_.size(), static_cast<size_t>(kMaxUnackedFrames));
+    DCHECK_LT(num_frames_in_list_, static_cast<size_t>(kMaxUnackedFrames));
+  }
+
+  // Should the limit be exceeded anyway, make room rather than overwrite.
+  if (num_frames_in_list_ == frames_.size()) {
+    std::vector<SendPacketVector> old_frames(frames_.size() * 2);
+    old_frames.swap(frames_);
+    for (size_t i = 0; i < num_frames_in_list_; ++i) {
+      const FrameId id = first_frame_id_in_list_ + i;
+      frames_[IndexOf(id)].swap(old_frames[(id - FrameId::first()) &
+                                           (old_frames.size() - 1)]);
+    }
   }
 
   // Save new frame to the end of the list.
-  frames_.push_back(packets);
+  frames_[IndexOf(frame_id)] = packets;
+  ++num_frames_in_list_;
 }
 
 void PacketStorage::ReleaseFrame(FrameId frame_id) {
@@ -48,10 +71,11 @@ void PacketStorage::ReleaseFrame(FrameId frame_id) {
   packets->clear();
   ++zombie_count_;
 
-  while (!frames_.empty() && frames_.front().empty()) {
+  while (num_frames_in_list_ &&
+         frames_[IndexOf(first_frame_id_in_list_)].empty()) {
     DCHECK_GT(zombie_count_, 0u);
     --zombie_count_;
-    frames_.pop_front();
+    --num_frames_in_list_;
     ++first_frame_id_in_list_;
   }
 }
@@ -60,11 +84,15 @@ SendPacketVector* PacketStorage::GetFramePackets(FrameId frame_id) {
   if (first_frame_id_in_list_.is_null())
     return nullptr;
   const int64_t offset = frame_id - first_frame_id_in_list_;
-  if (offset < 0 || offset >= static_cast<int64_t>(frames_.size()) ||
-      frames_[offset].empty()) {
+  if (offset < 0 || offset >= static_cast<int64_t>(num_frames_in_list_))
     return nullptr;
-  }
-  return &frames_[offset];
+  SendPacketVector* const packets = &frames_[IndexOf(frame_id)];
+  return packets->empty() ? nullptr : packets;
+}
+
+size_t PacketStorage::IndexOf(FrameId frame_id) const {
+  return static_cast<size_t>(frame_id - FrameId::first()) &
+         (frames_.size() - 1);
 }
 
 }  // namespace cast
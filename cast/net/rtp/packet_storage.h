@@ -8,7 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <deque>
+#include <vector>
 
 #include "base/macros.h"
 #include "media/cast/net/pacing/paced_sender.h"
@@ -34,11 +34,21 @@ class PacketStorage {
   size_t GetNumberOfStoredFrames() const;
 
  private:
-  std::deque<SendPacketVector> frames_;
+  // Returns the slot in |frames_| for |frame_id|.
+  size_t IndexOf(FrameId frame_id) const;
+
+  // A ring of frames indexed by FrameId, large enough for the system's limit on
+  // unacknowledged frames.  Slots keep their capacity when frames are released,
+  // so storing a frame normally doesn't allocate.
+  std::vector<SendPacketVector> frames_;
   FrameId first_frame_id_in_list_;
 
-  // The number of frames whose packets have been released, but the entry in the
-  // |frames_| queue has not yet been popped.
+  // The number of consecutive frames, starting at |first_frame_id_in_list_|,
+  // which occupy the ring.
+  size_t num_frames_in_list_;
+
+  // The number of frames whose packets have been released, but whose slot in
+  // the ring has not yet been freed.
   size_t zombie_count_;
 
   DISALLOW_COPY_AND_ASSIGN(PacketStorage);
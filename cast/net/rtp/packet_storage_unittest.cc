@@ -114,5 +114,27 @@ TEST(PacketStorageTest, FramesReleased) {
   EXPECT_FALSE(storage.GetFramePackets(first_frame_id + 1));
 }
 
+TEST(PacketStorageTest, WrapsAround) {
+  PacketStorage storage;
+
+  // Keep a window of frames in flight while many more than fit in the storage
+  // pass through it.
+  const FrameId first_frame_id = FrameId::first();
+  const int kWindow = kMaxUnackedFrames - 1;
+  StoreFrames(kWindow, first_frame_id, &storage);
+  for (int i = 0; i < 10 * kMaxUnackedFrames; ++i) {
+    storage.ReleaseFrame(first_frame_id + i);
+    EXPECT_FALSE(storage.GetFramePackets(first_frame_id + i));
+    StoreFrames(1, first_frame_id + kWindow + i, &storage);
+    EXPECT_EQ(static_cast<size_t>(kWindow), storage.GetNumberOfStoredFrames());
+    ASSERT_TRUE(storage.GetFramePackets(first_frame_id + i + 1));
+    ASSERT_TRUE(storage.GetFramePackets(first_frame_id + kWindow + i));
+    EXPECT_EQ(first_frame_id + kWindow + i,
+              storage.GetFramePackets(first_frame_id + kWindow + i)
+                  ->front()
+                  .first.frame_id);
+  }
+}
+
 }  // namespace cast
 }  // namespace media
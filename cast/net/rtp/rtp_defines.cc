@@ -15,7 +15,8 @@ RtpCastHeader::RtpCastHeader()
       is_key_frame(false),
       packet_id(0),
       max_packet_id(0),
-      new_playout_delay_ms(0) {}
+      new_playout_delay_ms(0),
+      fec_group_size(0) {}
 
 RtpPayloadFeedback::~RtpPayloadFeedback() {}
 
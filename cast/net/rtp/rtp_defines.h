@@ -27,6 +27,10 @@ static const uint8_t kCastExtensionCountmask = 0x3f;
 
 // Cast RTP extensions.
 static const uint8_t kCastRtpExtensionAdaptiveLatency = 1;
+// Marks an XOR parity packet, which carries an ID past |max_packet_id| and
+// protects a group of consecutive packets of the frame.  The extension holds
+// the number of packets per group.
+static const uint8_t kCastRtpExtensionFec = 2;
 
 struct RtpCastHeader {
   RtpCastHeader();
@@ -47,6 +51,8 @@ struct RtpCastHeader {
   FrameId reference_frame_id;
   uint16_t new_playout_delay_ms;
   uint8_t num_extensions;
+  // Non-zero only for FEC packets; see kCastRtpExtensionFec.
+  uint16_t fec_group_size;
 };
 
 class RtpPayloadFeedback {
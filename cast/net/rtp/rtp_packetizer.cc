@@ -4,16 +4,32 @@
 
 #include "media/cast/net/rtp/rtp_packetizer.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "base/big_endian.h"
 #include "base/logging.h"
+#include "media/cast/common/transport_encryption_handler.h"
 #include "media/cast/net/pacing/paced_sender.h"
 #include "media/cast/net/rtp/rtp_defines.h"
 
 namespace media {
 namespace cast {
 
+namespace {
+
+// Size of the field holding the XOR of the packet lengths in an FEC payload.
+const size_t kFecLengthSize = 2;
+
+// How much larger than the frame's other packets an FEC packet can be: its
+// FEC and playout delay extensions, and the length field.
+const uint16_t kFecPacketOverhead = 4 + 4 + kFecLengthSize;
+
+}  // namespace
+
 RtpPacketizerConfig::RtpPacketizerConfig()
     : payload_type(-1),
       max_payload_length(kMaxIpPacketSize - 28),  // Default is IP-v4/UDP.
@@ -29,6 +45,7 @@ RtpPacketizer::RtpPacketizer(PacedSender* const transport,
       transport_(transport),
       packet_storage_(packet_storage),
       sequence_number_(config_.sequence_number),
+      fec_group_size_(0),
       send_packet_count_(0),
       send_octet_count_(0) {
   DCHECK(transport) << "Invalid argument";
@@ -36,29 +53,38 @@ RtpPacketizer::RtpPacketizer(PacedSender* const transport,
 
 RtpPacketizer::~RtpPacketizer() {}
 
+void RtpPacketizer::SetFecGroupSize(size_t fec_group_size) {
+  DCHECK_LE(fec_group_size, kMaxFecGroupSize);
+  fec_group_size_ = fec_group_size;
+}
+
 uint16_t RtpPacketizer::NextSequenceNumber() {
   ++sequence_number_;
   return sequence_number_ - 1;
 }
 
-void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
+void RtpPacketizer::SendFrameAsPackets(
+    const EncodedFrame& frame,
+    const TransportEncryptionHandler* encryptor) {
+  DCHECK(!encryptor || encryptor->is_activated());
   uint16_t rtp_header_length = kRtpHeaderLength + kCastHeaderLength;
   uint16_t max_length = config_.max_payload_length - rtp_header_length - 1;
+  // Leave room for the extensions and length field of the FEC packets.
+  if (fec_group_size_)
+    max_length -= kFecPacketOverhead;
 
   // Split the payload evenly (round number up).
   size_t num_packets = (frame.data.size() + max_length) / max_length;
   size_t payload_length = (frame.data.size() + num_packets) / num_packets;
   DCHECK_LE(payload_length, max_length) << "Invalid argument";
+  const size_t full_payload_length = payload_length;
 
   SendPacketVector packets;
 
   size_t remaining_size = frame.data.size();
-  std::string::const_iterator data_iter = frame.data.begin();
-
-  uint8_t num_extensions = 0;
-  if (frame.new_playout_delay_ms)
-    num_extensions++;
-  DCHECK_LE(num_extensions, kCastExtensionCountmask);
+  const uint8_t* const frame_data =
+      reinterpret_cast<const uint8_t*>(frame.data.data());
+  size_t offset = 0;
 
   while (remaining_size > 0) {
     PacketRef packet(new base::RefCountedData<Packet>);
@@ -69,40 +95,21 @@ void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
     remaining_size -= payload_length;
     BuildCommonRTPheader(
         &packet->data, remaining_size == 0, frame.rtp_timestamp);
-
-    // Build Cast header.
-    // TODO(miu): Should we always set the ref frame bit and the ref_frame_id?
-    DCHECK_NE(frame.dependency, EncodedFrame::UNKNOWN_DEPENDENCY);
-    uint8_t byte0 = kCastReferenceFrameIdBitMask;
-    if (frame.dependency == EncodedFrame::KEY)
-      byte0 |= kCastKeyFrameBitMask;
-    // Extensions only go on the first packet of the frame
     const uint16_t packet_id = static_cast<uint16_t>(packets.size());
-    if (packet_id == 0)
-      byte0 |= num_extensions;
-    packet->data.push_back(byte0);
-    packet->data.push_back(frame.frame_id.lower_8_bits());
-    size_t start_size = packet->data.size();
-    packet->data.resize(start_size + 4);
-    base::BigEndianWriter big_endian_writer(
-        reinterpret_cast<char*>(&(packet->data[start_size])), 4);
-    big_endian_writer.WriteU16(packet_id);
-    big_endian_writer.WriteU16(static_cast<uint16_t>(num_packets - 1));
-    packet->data.push_back(frame.referenced_frame_id.lower_8_bits());
-    // Add extension details only on the first packet of the frame
-    if (packet_id == 0 && frame.new_playout_delay_ms) {
-      packet->data.push_back(kCastRtpExtensionAdaptiveLatency << 2);
-      packet->data.push_back(2);  // 2 bytes
-      packet->data.push_back(
-          static_cast<uint8_t>(frame.new_playout_delay_ms >> 8));
-      packet->data.push_back(static_cast<uint8_t>(frame.new_playout_delay_ms));
+    BuildCastHeader(frame, packet_id, static_cast<uint16_t>(num_packets - 1),
+                    &packet->data);
+
+    // Copy payload data, encrypting it on the way if need be.
+    const size_t header_length = packet->data.size();
+    packet->data.resize(header_length + payload_length);
+    uint8_t* const payload = &packet->data[header_length];
+    if (encryptor) {
+      encryptor->EncryptRange(frame.frame_id, offset, frame_data + offset,
+                              payload_length, payload);
+    } else {
+      memcpy(payload, frame_data + offset, payload_length);
     }
-
-    // Copy payload data.
-    packet->data.insert(packet->data.end(),
-                        data_iter,
-                        data_iter + payload_length);
-    data_iter += payload_length;
+    offset += payload_length;
 
     packets.push_back(make_pair(PacketKey(frame.reference_time, config_.ssrc,
                                           frame.frame_id, packet_id),
@@ -116,10 +123,113 @@ void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
 
   packet_storage_->StoreFrame(frame.frame_id, packets);
 
+  // FEC packets are not stored, as only the frame's own packets are ever
+  // retransmitted.
+  if (fec_group_size_ && !packets.empty())
+    AppendFecPackets(frame, full_payload_length, &packets);
+
   // Send to network.
   transport_->SendPackets(packets);
 }
 
+void RtpPacketizer::AppendFecPackets(const EncodedFrame& frame,
+                                     size_t payload_length,
+                                     SendPacketVector* packets) {
+  const size_t num_packets = packets->size();
+  const size_t num_groups =
+      (num_packets + fec_group_size_ - 1) / fec_group_size_;
+  // The FEC packet IDs follow the last packet of the frame.
+  if (num_packets + num_groups > std::numeric_limits<uint16_t>::max() + 1u)
+    return;
+  const uint16_t max_packet_id = static_cast<uint16_t>(num_packets - 1);
+
+  for (size_t group = 0; group < num_groups; ++group) {
+    PacketRef packet(new base::RefCountedData<Packet>);
+    BuildCommonRTPheader(&packet->data, false, frame.rtp_timestamp);
+    const uint16_t packet_id = static_cast<uint16_t>(num_packets + group);
+    BuildCastHeader(frame, packet_id, max_packet_id, &packet->data);
+
+    // The payload is the XOR of the lengths of the packets in the group,
+    // followed by the XOR of their payloads, each padded with zeros to the
+    // length of the longest one.
+    const size_t first_packet = group * fec_group_size_;
+    const size_t end_packet =
+        std::min(first_packet + fec_group_size_, num_packets);
+    const size_t parity_length = std::min(
+        payload_length, frame.data.size() - first_packet * payload_length);
+    const size_t start_size = packet->data.size();
+    packet->data.resize(start_size + kFecLengthSize + parity_length, 0);
+    uint8_t* const parity = &packet->data[start_size + kFecLengthSize];
+    uint16_t length_parity = 0;
+    for (size_t i = first_packet; i < end_packet; ++i) {
+      // The payload is at the end of the packet, after the headers.
+      const Packet& media_packet = (*packets)[i].second->data;
+      const size_t length =
+          std::min(payload_length, frame.data.size() - i * payload_length);
+      const uint8_t* const payload =
+          media_packet.data() + media_packet.size() - length;
+      length_parity ^= static_cast<uint16_t>(length);
+      for (size_t j = 0; j < length; ++j)
+        parity[j] ^= payload[j];
+    }
+    base::BigEndianWriter big_endian_writer(
+        reinterpret_cast<char*>(&packet->data[start_size]), kFecLengthSize);
+    big_endian_writer.WriteU16(length_parity);
+
+    packets->push_back(make_pair(PacketKey(frame.reference_time, config_.ssrc,
+                                           frame.frame_id, packet_id),
+                                 packet));
+
+    // Update stats.
+    ++send_packet_count_;
+    send_octet_count_ += kFecLengthSize + parity_length;
+  }
+}
+
+void RtpPacketizer::BuildCastHeader(const EncodedFrame& frame,
+                                    uint16_t packet_id,
+                                    uint16_t max_packet_id,
+                                    Packet* packet) {
+  // TODO(miu): Should we always set the ref frame bit and the ref_frame_id?
+  DCHECK_NE(frame.dependency, EncodedFrame::UNKNOWN_DEPENDENCY);
+  uint8_t byte0 = kCastReferenceFrameIdBitMask;
+  if (frame.dependency == EncodedFrame::KEY)
+    byte0 |= kCastKeyFrameBitMask;
+  // Extensions only go on the first packet of the frame, and on FEC packets,
+  // which may have to stand in for it.
+  const bool is_fec = packet_id > max_packet_id;
+  const bool add_playout_delay =
+      frame.new_playout_delay_ms && (packet_id == 0 || is_fec);
+  uint8_t num_extensions = 0;
+  if (add_playout_delay)
+    num_extensions++;
+  if (is_fec)
+    num_extensions++;
+  DCHECK_LE(num_extensions, kCastExtensionCountmask);
+  byte0 |= num_extensions;
+  packet->push_back(byte0);
+  packet->push_back(frame.frame_id.lower_8_bits());
+  size_t start_size = packet->size();
+  packet->resize(start_size + 4);
+  base::BigEndianWriter big_endian_writer(
+      reinterpret_cast<char*>(&((*packet)[start_size])), 4);
+  big_endian_writer.WriteU16(packet_id);
+  big_endian_writer.WriteU16(max_packet_id);
+  packet->push_back(frame.referenced_frame_id.lower_8_bits());
+  if (add_playout_delay) {
+    packet->push_back(kCastRtpExtensionAdaptiveLatency << 2);
+    packet->push_back(2);  // 2 bytes
+    packet->push_back(static_cast<uint8_t>(frame.new_playout_delay_ms >> 8));
+    packet->push_back(static_cast<uint8_t>(frame.new_playout_delay_ms));
+  }
+  if (is_fec) {
+    packet->push_back(kCastRtpExtensionFec << 2);
+    packet->push_back(2);  // 2 bytes
+    packet->push_back(static_cast<uint8_t>(fec_group_size_ >> 8));
+    packet->push_back(static_cast<uint8_t>(fec_group_size_));
+  }
+}
+
 void RtpPacketizer::BuildCommonRTPheader(Packet* packet,
                                          bool marker_bit,
                                          RtpTimeTicks rtp_timestamp) {
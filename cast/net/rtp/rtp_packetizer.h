@@ -24,6 +24,10 @@ namespace media {
 namespace cast {
 
 class PacedSender;
+class TransportEncryptionHandler;
+
+// The largest number of packets one FEC packet may protect.
+const size_t kMaxFecGroupSize = 32;
 
 struct RtpPacketizerConfig {
   RtpPacketizerConfig();
@@ -48,7 +52,17 @@ class RtpPacketizer {
                 RtpPacketizerConfig rtp_packetizer_config);
   ~RtpPacketizer();
 
-  void SendFrameAsPackets(const EncodedFrame& frame);
+  // Splits |frame| into packets, stores them and sends them.  If |encryptor|
+  // is not null, the payloads are encrypted as they are copied into the
+  // packets, so the frame is never copied in full.
+  void SendFrameAsPackets(const EncodedFrame& frame,
+                          const TransportEncryptionHandler* encryptor);
+
+  // Sets the number of packets protected by each FEC packet, which is the XOR
+  // of their payloads and lets the receiver restore any one of them.  Zero,
+  // the default, sends no FEC packets.
+  void SetFecGroupSize(size_t fec_group_size);
+  size_t fec_group_size() const { return fec_group_size_; }
 
   // Return the next sequence number, and increment by one. Enables unique
   // incremental sequence numbers for every packet (including retransmissions).
@@ -62,11 +76,26 @@ class RtpPacketizer {
                             bool marker_bit,
                             RtpTimeTicks rtp_timestamp);
 
+  // Appends the Cast header for |packet_id|, which is an FEC packet if it is
+  // greater than |max_packet_id|.
+  void BuildCastHeader(const EncodedFrame& frame,
+                       uint16_t packet_id,
+                       uint16_t max_packet_id,
+                       Packet* packet);
+
+  // Appends an FEC packet to |packets| for each group of |fec_group_size_| of
+  // them, computed from their payloads as sent.  |payload_length| is the
+  // payload size of all but the last packet.
+  void AppendFecPackets(const EncodedFrame& frame,
+                        size_t payload_length,
+                        SendPacketVector* packets);
+
   RtpPacketizerConfig config_;
   PacedSender* const transport_;  // Not owned by this class.
   PacketStorage* packet_storage_;
 
   uint16_t sequence_number_;
+  size_t fec_group_size_;
 
   size_t send_packet_count_;
   size_t send_octet_count_;
@@ -12,7 +12,9 @@
 #include "base/macros.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/base/fake_single_thread_task_runner.h"
+#include "media/cast/common/transport_encryption_handler.h"
 #include "media/cast/net/pacing/paced_sender.h"
+#include "media/cast/net/rtp/frame_buffer.h"
 #include "media/cast/net/rtp/packet_storage.h"
 #include "media/cast/net/rtp/rtp_parser.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -35,6 +37,8 @@ class TestRtpPacketTransport : public PacketTransport {
       : config_(config),
         sequence_number_(kSeqNum),
         packets_sent_(0),
+        fec_packets_sent_(0),
+        packet_to_drop_(-1),
         expected_number_of_packets_(0),
         expected_packet_id_(0),
         expected_frame_id_(FrameId::first() + 1) {}
@@ -71,14 +75,30 @@ class TestRtpPacketTransport : public PacketTransport {
     RtpCastHeader rtp_header;
     const uint8_t* payload_data;
     size_t payload_size;
-    parser.ParsePacket(&packet->data[0], packet->data.size(), &rtp_header,
-                       &payload_data, &payload_size);
-    VerifyRtpHeader(rtp_header);
+    EXPECT_TRUE(parser.ParsePacket(&packet->data[0], packet->data.size(),
+                                   &rtp_header, &payload_data, &payload_size));
+    if (rtp_header.fec_group_size) {
+      VerifyFecRtpHeader(rtp_header);
+      ++fec_packets_sent_;
+    } else {
+      VerifyRtpHeader(rtp_header);
+      ++expected_packet_id_;
+    }
     ++sequence_number_;
-    ++expected_packet_id_;
+    if (rtp_header.packet_id != packet_to_drop_)
+      frame_buffer_.InsertPacket(payload_data, payload_size, rtp_header);
     return true;
   }
 
+  void VerifyFecRtpHeader(const RtpCastHeader& rtp_header) {
+    VerifyCommonRtpHeader(rtp_header);
+    EXPECT_FALSE(rtp_header.marker);
+    EXPECT_EQ(expected_frame_id_, rtp_header.frame_id);
+    EXPECT_EQ(expected_number_of_packets_ - 1, rtp_header.max_packet_id);
+    EXPECT_EQ(expected_number_of_packets_ + fec_packets_sent_,
+              rtp_header.packet_id);
+  }
+
   int64_t GetBytesSent() final { return 0; }
 
   void StartReceiving(
@@ -87,6 +107,11 @@ class TestRtpPacketTransport : public PacketTransport {
   void StopReceiving() final {}
 
   size_t number_of_packets_received() const { return packets_sent_; }
+  size_t number_of_fec_packets_received() const { return fec_packets_sent_; }
+
+  // The packet with |packet_id| is not passed on to |frame_buffer()|.
+  void set_packet_to_drop(int packet_id) { packet_to_drop_ = packet_id; }
+  FrameBuffer* frame_buffer() { return &frame_buffer_; }
 
   void set_expected_number_of_packets(size_t expected_number_of_packets) {
     expected_number_of_packets_ = expected_number_of_packets;
@@ -99,6 +124,9 @@ class TestRtpPacketTransport : public PacketTransport {
   RtpPacketizerConfig config_;
   uint32_t sequence_number_;
   size_t packets_sent_;
+  size_t fec_packets_sent_;
+  int packet_to_drop_;
+  FrameBuffer frame_buffer_;
   size_t number_of_packets_;
   size_t expected_number_of_packets_;
   // Assuming packets arrive in sequence.
@@ -160,7 +188,7 @@ TEST_F(RtpPacketizerTest, SendStandardPackets) {
 
   testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
   video_frame_.reference_time = testing_clock_.NowTicks();
-  rtp_packetizer_->SendFrameAsPackets(video_frame_);
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, nullptr);
   RunTasks(33 + 1);
   EXPECT_EQ(expected_num_of_packets, transport_->number_of_packets_received());
 }
@@ -173,7 +201,7 @@ TEST_F(RtpPacketizerTest, SendPacketsWithAdaptivePlayoutExtension) {
   testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
   video_frame_.reference_time = testing_clock_.NowTicks();
   video_frame_.new_playout_delay_ms = 500;
-  rtp_packetizer_->SendFrameAsPackets(video_frame_);
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, nullptr);
   RunTasks(33 + 1);
   EXPECT_EQ(expected_num_of_packets, transport_->number_of_packets_received());
 }
@@ -188,12 +216,92 @@ TEST_F(RtpPacketizerTest, Stats) {
 
   testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
   video_frame_.reference_time = testing_clock_.NowTicks();
-  rtp_packetizer_->SendFrameAsPackets(video_frame_);
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, nullptr);
   RunTasks(33 + 1);
   EXPECT_EQ(expected_num_of_packets, rtp_packetizer_->send_packet_count());
   EXPECT_EQ(kFrameSize, rtp_packetizer_->send_octet_count());
   EXPECT_EQ(expected_num_of_packets, transport_->number_of_packets_received());
 }
 
+TEST_F(RtpPacketizerTest, SendFecPackets) {
+  size_t expected_num_of_packets = kFrameSize / kMaxPacketLength + 1;
+  transport_->set_expected_number_of_packets(expected_num_of_packets);
+  transport_->set_rtp_timestamp(video_frame_.rtp_timestamp);
+  rtp_packetizer_->SetFecGroupSize(2);
+
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
+  video_frame_.reference_time = testing_clock_.NowTicks();
+  video_frame_.new_playout_delay_ms = 500;
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, nullptr);
+  RunTasks(33 + 1);
+  const size_t expected_num_of_fec_packets = (expected_num_of_packets + 1) / 2;
+  EXPECT_EQ(expected_num_of_packets + expected_num_of_fec_packets,
+            transport_->number_of_packets_received());
+  EXPECT_EQ(expected_num_of_fec_packets,
+            transport_->number_of_fec_packets_received());
+  EXPECT_EQ(expected_num_of_packets + expected_num_of_fec_packets,
+            rtp_packetizer_->send_packet_count());
+
+  // Only the frame's own packets are kept for retransmission.
+  const SendPacketVector* stored_packets =
+      packet_storage_.GetFramePackets(video_frame_.frame_id);
+  ASSERT_TRUE(stored_packets);
+  EXPECT_EQ(expected_num_of_packets, stored_packets->size());
+}
+
+TEST_F(RtpPacketizerTest, FecRestoresLostPacket) {
+  size_t expected_num_of_packets = kFrameSize / kMaxPacketLength + 1;
+  transport_->set_expected_number_of_packets(expected_num_of_packets);
+  transport_->set_rtp_timestamp(video_frame_.rtp_timestamp);
+  rtp_packetizer_->SetFecGroupSize(kMaxFecGroupSize);
+  for (size_t i = 0; i < video_frame_.data.size(); ++i)
+    video_frame_.data[i] = static_cast<char>(i * 7);
+  // The first packet carries the playout delay, which the FEC packet repeats.
+  transport_->set_packet_to_drop(0);
+
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
+  video_frame_.reference_time = testing_clock_.NowTicks();
+  video_frame_.new_playout_delay_ms = 500;
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, nullptr);
+  RunTasks(33 + 1);
+  EXPECT_EQ(1u, transport_->number_of_fec_packets_received());
+
+  EncodedFrame frame;
+  ASSERT_TRUE(transport_->frame_buffer()->AssembleEncodedFrame(&frame));
+  EXPECT_EQ(video_frame_.data, frame.data);
+  EXPECT_EQ(video_frame_.frame_id, frame.frame_id);
+  EXPECT_EQ(500, frame.new_playout_delay_ms);
+}
+
+TEST_F(RtpPacketizerTest, EncryptsPayloadsAndFec) {
+  size_t expected_num_of_packets = kFrameSize / kMaxPacketLength + 1;
+  transport_->set_expected_number_of_packets(expected_num_of_packets);
+  transport_->set_rtp_timestamp(video_frame_.rtp_timestamp);
+  rtp_packetizer_->SetFecGroupSize(kMaxFecGroupSize);
+  for (size_t i = 0; i < video_frame_.data.size(); ++i)
+    video_frame_.data[i] = static_cast<char>(i * 7);
+  transport_->set_packet_to_drop(1);
+
+  TransportEncryptionHandler encryptor;
+  ASSERT_TRUE(encryptor.Initialize(std::string(16, 'k'), std::string(16, 'm')));
+
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
+  video_frame_.reference_time = testing_clock_.NowTicks();
+  rtp_packetizer_->SendFrameAsPackets(video_frame_, &encryptor);
+  RunTasks(33 + 1);
+  EXPECT_EQ(1u, transport_->number_of_fec_packets_received());
+
+  // The packets carry the whole frame encrypted, and the FEC packet restores
+  // the lost one from the encrypted payloads.
+  EncodedFrame frame;
+  ASSERT_TRUE(transport_->frame_buffer()->AssembleEncodedFrame(&frame));
+  std::string expected_data;
+  ASSERT_TRUE(encryptor.Encrypt(video_frame_.frame_id, video_frame_.data,
+                                &expected_data));
+  EXPECT_EQ(expected_data, frame.data);
+  ASSERT_TRUE(encryptor.DecryptInPlace(frame.frame_id, &frame.data));
+  EXPECT_EQ(video_frame_.data, frame.data);
+}
+
 }  // namespace cast
 }  // namespace media
@@ -85,9 +85,6 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
       !reader.ReadU16(&header->max_packet_id)) {
     return false;
   }
-  // Sanity-check: Do the packet ID values make sense w.r.t. each other?
-  if (header->max_packet_id < header->packet_id)
-    return false;
   uint8_t truncated_reference_frame_id;
   if (!header->is_reference) {
     // By default, a key frame only references itself; and non-key frames
@@ -100,6 +97,7 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
   }
 
   header->num_extensions = bits & kCastExtensionCountmask;
+  header->fec_group_size = 0;
   for (int i = 0; i < header->num_extensions; i++) {
     uint16_t type_and_size;
     if (!reader.ReadU16(&type_and_size))
@@ -112,9 +110,21 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
       case kCastRtpExtensionAdaptiveLatency:
         if (!chunk.ReadU16(&header->new_playout_delay_ms))
           return false;
+        break;
+      case kCastRtpExtensionFec:
+        if (!chunk.ReadU16(&header->fec_group_size) || !header->fec_group_size)
+          return false;
+        break;
     }
   }
 
+  // Sanity-check: Do the packet ID values make sense w.r.t. each other?  Only
+  // FEC packets follow the last packet of the frame.
+  if ((header->max_packet_id < header->packet_id) !=
+      (header->fec_group_size != 0)) {
+    return false;
+  }
+
   last_parsed_rtp_timestamp_ = header->rtp_timestamp;
 
   header->frame_id = last_parsed_frame_id_.Expand(truncated_frame_id);
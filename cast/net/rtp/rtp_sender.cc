@@ -4,6 +4,8 @@
 
 #include "media/cast/net/rtp/rtp_sender.h"
 
+#include <algorithm>
+
 #include "base/big_endian.h"
 #include "base/logging.h"
 #include "base/rand_util.h"
@@ -23,6 +25,24 @@ PacketRef FastCopyPacket(const PacketRef& packet) {
   return make_scoped_refptr(new base::RefCountedData<Packet>(packet->data));
 }
 
+// Weight given to each new loss report when smoothing the loss fraction.
+const double kLossFractionWeight = 0.3;
+
+// Below this loss fraction, lost packets are left to retransmission.
+const double kMinLossFractionForFec = 0.005;
+
+// FEC groups are sized for about one lost packet per ten groups, so that few
+// groups lose more than the one packet their FEC packet can restore.
+const double kTargetLossesPerFecGroup = 0.1;
+
+size_t FecGroupSizeForLoss(double loss_fraction) {
+  if (loss_fraction < kMinLossFractionForFec)
+    return 0;
+  const size_t group_size =
+      static_cast<size_t>(kTargetLossesPerFecGroup / loss_fraction);
+  return std::min(std::max<size_t>(group_size, 2), kMaxFecGroupSize);
+}
+
 }  // namespace
 
 RtpSender::RtpSender(
@@ -30,6 +50,8 @@ RtpSender::RtpSender(
     PacedSender* const transport)
     : transport_(transport),
       transport_task_runner_(transport_task_runner),
+      fec_enabled_(false),
+      loss_fraction_(0),
       weak_factory_(this) {
   // Randomly set sequence number start value.
   config_.sequence_number = base::RandInt(0, 65535);
@@ -48,12 +70,27 @@ bool RtpSender::Initialize(const CastTransportRtpConfig& config) {
   else
     config_.payload_type = 96;
   packetizer_.reset(new RtpPacketizer(transport_, &storage_, config_));
+  fec_enabled_ = config.enable_fec;
   return true;
 }
 
-void RtpSender::SendFrame(const EncodedFrame& frame) {
+void RtpSender::OnReceivedLossFraction(uint8_t fraction_lost) {
+  if (!fec_enabled_ || !packetizer_)
+    return;
+  loss_fraction_ += kLossFractionWeight * (fraction_lost / 256.0 -
+                                           loss_fraction_);
+  const size_t fec_group_size = FecGroupSizeForLoss(loss_fraction_);
+  if (fec_group_size != packetizer_->fec_group_size()) {
+    VLOG(1) << "SSRC " << config_.ssrc << ": FEC group size changed to "
+            << fec_group_size << " at a loss fraction of " << loss_fraction_;
+    packetizer_->SetFecGroupSize(fec_group_size);
+  }
+}
+
+void RtpSender::SendFrame(const EncodedFrame& frame,
+                          const TransportEncryptionHandler* encryptor) {
   DCHECK(packetizer_);
-  packetizer_->SendFrameAsPackets(frame);
+  packetizer_->SendFrameAsPackets(frame, encryptor);
   LOG_IF(DFATAL, storage_.GetNumberOfStoredFrames() > kMaxUnackedFrames)
       << "Possible bug: Frames are not being actively released from storage.";
 }
@@ -81,6 +118,25 @@ void RtpSender::ResendPackets(
     if (!stored_packets)
       continue;
 
+    // Packets are stored in packet ID order, so when nothing is to be canceled
+    // the requested ones can be looked up directly instead of scanning the
+    // whole frame.
+    if (!resend_all && !cancel_rtx_if_not_in_list) {
+      for (uint16_t packet_id : missing_packet_set) {
+        if (packet_id >= stored_packets->size())
+          continue;
+        DCHECK_EQ(packet_id, (*stored_packets)[packet_id].first.packet_id);
+        AddPacketToResend((*stored_packets)[packet_id], &packets_to_resend);
+      }
+      if (resend_last &&
+          missing_packet_set.find(stored_packets->back().first.packet_id) ==
+              missing_packet_set.end()) {
+        AddPacketToResend(stored_packets->back(), &packets_to_resend);
+      }
+      transport_->ResendPackets(packets_to_resend, dedup_info);
+      continue;
+    }
+
     for (SendPacketVector::const_iterator it = stored_packets->begin();
          it != stored_packets->end(); ++it) {
       const PacketKey& packet_key = it->first;
@@ -102,12 +158,7 @@ void RtpSender::ResendPackets(
       }
 
       if (resend) {
-        // Resend packet to the network.
-        VLOG(3) << "Resend " << frame_id << ":" << packet_id;
-        // Set a unique incremental sequence number for every packet.
-        PacketRef packet_copy = FastCopyPacket(it->second);
-        UpdateSequenceNumber(&packet_copy->data);
-        packets_to_resend.push_back(std::make_pair(packet_key, packet_copy));
+        AddPacketToResend(*it, &packets_to_resend);
       } else if (cancel_rtx_if_not_in_list) {
         transport_->CancelSendingPacket(it->first);
       }
@@ -156,6 +207,17 @@ void RtpSender::UpdateSequenceNumber(Packet* packet) {
   big_endian_writer.WriteU16(packetizer_->NextSequenceNumber());
 }
 
+void RtpSender::AddPacketToResend(const std::pair<PacketKey, PacketRef>& packet,
+                                  SendPacketVector* packets_to_resend) {
+  // Resend packet to the network.
+  VLOG(3) << "Resend " << packet.first.frame_id << ":"
+          << packet.first.packet_id;
+  // Set a unique incremental sequence number for every packet.
+  PacketRef packet_copy = FastCopyPacket(packet.second);
+  UpdateSequenceNumber(&packet_copy->data);
+  packets_to_resend->push_back(std::make_pair(packet.first, packet_copy));
+}
+
 int64_t RtpSender::GetLastByteSentForFrame(FrameId frame_id) {
   const SendPacketVector* stored_packets = storage_.GetFramePackets(frame_id);
   if (!stored_packets)
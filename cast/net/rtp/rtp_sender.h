@@ -27,6 +27,8 @@
 namespace media {
 namespace cast {
 
+class TransportEncryptionHandler;
+
 // This object is only called from the main cast thread.
 // This class handles splitting encoded audio and video frames into packets and
 // add an RTP header to each packet. The sent packets are stored until they are
@@ -43,7 +45,9 @@ class RtpSender {
   // configuration is invalid.
   bool Initialize(const CastTransportRtpConfig& config);
 
-  void SendFrame(const EncodedFrame& frame);
+  // Sends |frame|, encrypting it with |encryptor| unless that is null.
+  void SendFrame(const EncodedFrame& frame,
+                 const TransportEncryptionHandler* encryptor);
 
   void ResendPackets(const MissingFramesAndPacketsMap& missing_packets,
                      bool cancel_rtx_if_not_in_list,
@@ -59,6 +63,10 @@ class RtpSender {
 
   void ResendFrameForKickstart(FrameId frame_id, base::TimeDelta dedupe_window);
 
+  // Called with the fraction of packets lost, in units of 1/256, from each
+  // receiver report.  Sets the FEC redundancy, if FEC is enabled.
+  void OnReceivedLossFraction(uint8_t fraction_lost);
+
   size_t send_packet_count() const {
     return packetizer_ ? packetizer_->send_packet_count() : 0;
   }
@@ -70,12 +78,22 @@ class RtpSender {
  private:
   void UpdateSequenceNumber(Packet* packet);
 
+  // Appends a copy of the stored |packet|, with a new sequence number, to
+  // |packets_to_resend|.
+  void AddPacketToResend(const std::pair<PacketKey, PacketRef>& packet,
+                         SendPacketVector* packets_to_resend);
+
   RtpPacketizerConfig config_;
   PacketStorage storage_;
   std::unique_ptr<RtpPacketizer> packetizer_;
   PacedSender* const transport_;
   scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
 
+  bool fec_enabled_;
+
+  // The smoothed fraction of packets lost, from the receiver reports.
+  double loss_fraction_;
+
   // NOTE: Weak pointers must be invalidated before all other member variables.
   base::WeakPtrFactory<RtpSender> weak_factory_;
 
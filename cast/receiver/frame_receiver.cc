@@ -51,6 +51,8 @@ FrameReceiver::FrameReceiver(
           base::TimeDelta::FromMilliseconds(config.rtp_max_delay_ms)),
       expected_frame_duration_(
           base::TimeDelta::FromSecondsD(1.0 / config.target_frame_rate)),
+      transport_feedback_interval_(base::TimeDelta::FromMilliseconds(
+          config.transport_feedback_interval_ms)),
       reports_are_scheduled_(false),
       framer_(cast_environment->Clock(),
               this,
@@ -100,6 +102,8 @@ bool FrameReceiver::ProcessPacket(std::unique_ptr<Packet> packet) {
       return false;
     }
 
+    if (!transport_feedback_interval_.is_zero())
+      rtcp_.OnReceivedRtpPacket(rtp_header.frame_id, rtp_header.packet_id);
     ProcessParsedPacket(rtp_header, payload_data, payload_size);
     stats_.UpdateStatistics(rtp_header, rtp_timebase_);
   }
@@ -107,6 +111,8 @@ bool FrameReceiver::ProcessPacket(std::unique_ptr<Packet> packet) {
   if (!reports_are_scheduled_) {
     ScheduleNextRtcpReport();
     ScheduleNextCastMessage();
+    if (!transport_feedback_interval_.is_zero())
+      ScheduleNextTransportFeedback();
     reports_are_scheduled_ = true;
   }
 
@@ -205,15 +211,14 @@ void FrameReceiver::EmitAvailableEncodedFrames() {
   DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
 
   while (!frame_request_queue_.empty()) {
-    // Attempt to peek at the next completed frame from the |framer_|.
-    // TODO(miu): We should only be peeking at the metadata, and not copying the
-    // payload yet!  Or, at least, peek using a StringPiece instead of a copy.
+    // Attempt to peek at the next completed frame from the |framer_|.  Only
+    // the metadata is needed until the frame is known to be wanted.
     std::unique_ptr<EncodedFrame> encoded_frame(new EncodedFrame());
     bool is_consecutively_next_frame = false;
     bool have_multiple_complete_frames = false;
-    if (!framer_.GetEncodedFrame(encoded_frame.get(),
-                                 &is_consecutively_next_frame,
-                                 &have_multiple_complete_frames)) {
+    if (!framer_.PeekEncodedFrame(encoded_frame.get(),
+                                  &is_consecutively_next_frame,
+                                  &have_multiple_complete_frames)) {
       VLOG(1) << "Wait for more packets to produce a completed frame.";
       return;  // ProcessParsedPacket() will invoke this method in the future.
     }
@@ -256,18 +261,15 @@ void FrameReceiver::EmitAvailableEncodedFrames() {
     // frame from somewhere later in the stream, AND we have given up
     // on waiting for any frames in between, so now we can ACK the frame.
     framer_.AckFrame(encoded_frame->frame_id);
+    framer_.TakeFrameData(encoded_frame->frame_id, &encoded_frame->data);
 
-    // Decrypt the payload data in the frame, if crypto is being used.
-    if (decryptor_.is_activated()) {
-      std::string decrypted_data;
-      if (!decryptor_.Decrypt(encoded_frame->frame_id,
-                              encoded_frame->data,
-                              &decrypted_data)) {
-        // Decryption failed.  Give up on this frame.
-        framer_.ReleaseFrame(encoded_frame->frame_id);
-        continue;
-      }
-      encoded_frame->data.swap(decrypted_data);
+    // Decrypt the payload data in the frame, in place, if crypto is being used.
+    if (decryptor_.is_activated() &&
+        !decryptor_.DecryptInPlace(encoded_frame->frame_id,
+                                   &encoded_frame->data)) {
+      // Decryption failed.  Give up on this frame.
+      framer_.ReleaseFrame(encoded_frame->frame_id);
+      continue;
     }
 
     // At this point, we have a decrypted EncodedFrame ready to be emitted.
@@ -356,6 +358,30 @@ void FrameReceiver::SendNextRtcpReport() {
   ScheduleNextRtcpReport();
 }
 
+void FrameReceiver::ScheduleNextTransportFeedback() {
+  DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
+
+  cast_environment_->PostDelayedTask(
+      CastEnvironment::MAIN, FROM_HERE,
+      base::Bind(&FrameReceiver::SendNextTransportFeedback,
+                 weak_factory_.GetWeakPtr()),
+      transport_feedback_interval_);
+}
+
+void FrameReceiver::SendNextTransportFeedback() {
+  DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
+  // Arrivals which don't fit in one RTCP packet are sent in further ones.
+  RtcpTransportFeedback feedback;
+  while (rtcp_.GetTransportFeedback(&feedback)) {
+    const base::TimeTicks now = cast_environment_->Clock()->NowTicks();
+    transport_->InitializeRtpReceiverRtcpBuilder(rtcp_.local_ssrc(),
+                                                 CreateRtcpTimeData(now));
+    transport_->AddTransportFeedback(feedback);
+    transport_->SendRtcpFromRtpReceiver();
+  }
+  ScheduleNextTransportFeedback();
+}
+
 void FrameReceiver::SendRtcpReport(
     uint32_t rtp_receiver_ssrc,
     uint32_t rtp_sender_ssrc,
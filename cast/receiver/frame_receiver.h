@@ -115,6 +115,12 @@ class FrameReceiver : public RtpPayloadFeedback,
   // Actually send the next RTCP report.
   void SendNextRtcpReport();
 
+  // Schedule timing for the next transport feedback.
+  void ScheduleNextTransportFeedback();
+
+  // Actually send the next transport feedback, if any packets have arrived.
+  void SendNextTransportFeedback();
+
   // Interface to send RTCP reports.
   // |cast_message|, |rtcp_events| and |rtp_receiver_statistics| are optional;
   // if |cast_message| is provided the RTCP receiver report will contain a Cast
@@ -165,6 +171,9 @@ class FrameReceiver : public RtpPayloadFeedback,
   // time.
   const base::TimeDelta expected_frame_duration_;
 
+  // How often transport feedback is sent, or zero if it isn't.
+  const base::TimeDelta transport_feedback_interval_;
+
   // Set to false initially, then set to true after scheduling the periodic
   // sending of reports back to the sender.  Reports are first scheduled just
   // after receiving a first packet (since the first packet identifies the
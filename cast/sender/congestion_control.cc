@@ -16,7 +16,9 @@
 #include "media/cast/sender/congestion_control.h"
 
 #include <algorithm>
+#include <cmath>
 #include <deque>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/macros.h"
@@ -44,6 +46,7 @@ class AdaptiveCongestionControl : public CongestionControl {
   void AckFrame(FrameId frame_id, base::TimeTicks when) final;
   void AckLaterFrames(std::vector<FrameId> received_frames,
                       base::TimeTicks when) final;
+  void AckPackets(const std::vector<PacketArrival>& arrivals) final {}
   int GetBitrate(base::TimeTicks playout_time,
                  base::TimeDelta playout_delay) final;
 
@@ -109,6 +112,7 @@ class FixedCongestionControl : public CongestionControl {
   void AckFrame(FrameId frame_id, base::TimeTicks when) final {}
   void AckLaterFrames(std::vector<FrameId> received_frames,
                       base::TimeTicks when) final {}
+  void AckPackets(const std::vector<PacketArrival>& arrivals) final {}
   int GetBitrate(base::TimeTicks playout_time,
                  base::TimeDelta playout_delay) final {
     return bitrate_;
@@ -120,6 +124,101 @@ class FixedCongestionControl : public CongestionControl {
   DISALLOW_COPY_AND_ASSIGN(FixedCongestionControl);
 };
 
+// Estimates the available bandwidth from the one-way delay of packets, in the
+// manner of Google Congestion Control (draft-ietf-rmcat-gcc): packets are
+// grouped by when they were sent, and the variation in the delay between
+// consecutive groups is smoothed and fitted with a line.  A rising line means
+// that a queue is building up on the network path, so the bitrate is cut; a
+// flat one means there is room to grow, so it is raised slowly.  Unlike
+// AdaptiveCongestionControl, this backs off before any frame arrives late.
+class DelayBasedCongestionControl : public CongestionControl {
+ public:
+  DelayBasedCongestionControl(base::TickClock* clock,
+                              int max_bitrate_configured,
+                              int min_bitrate_configured,
+                              int start_bitrate);
+
+  ~DelayBasedCongestionControl() final;
+
+  // CongestionControl implementation.
+  void UpdateRtt(base::TimeDelta rtt) final;
+  void UpdateTargetPlayoutDelay(base::TimeDelta delay) final {}
+  void SendFrameToTransport(FrameId frame_id,
+                            size_t frame_size_in_bits,
+                            base::TimeTicks when) final;
+  void AckFrame(FrameId frame_id, base::TimeTicks when) final {}
+  void AckLaterFrames(std::vector<FrameId> received_frames,
+                      base::TimeTicks when) final {}
+  void AckPackets(const std::vector<PacketArrival>& arrivals) final;
+  int GetBitrate(base::TimeTicks playout_time,
+                 base::TimeDelta playout_delay) final;
+
+ private:
+  enum BandwidthUsage {
+    BANDWIDTH_NORMAL,
+    BANDWIDTH_OVERUSING,
+    BANDWIDTH_UNDERUSING,
+  };
+
+  // Packets sent close enough together to have left in one burst.
+  struct PacketGroup {
+    base::TimeTicks first_send_time;
+    base::TimeTicks last_send_time;
+    base::TimeTicks last_arrival_time;
+  };
+
+  // Called with how much longer (or shorter) the packets of a group took to
+  // arrive than those of the group before, once the group is complete.
+  void OnDelayVariation(double delay_variation_ms,
+                        base::TimeTicks arrival_time);
+
+  // Updates |usage_| from the latest delay trend.
+  void DetectOveruse(double trend,
+                     double modified_trend,
+                     base::TimeTicks arrival_time);
+
+  // Adapts |overuse_threshold_ms_| so that the detector neither starves the
+  // stream when competing with loss-based flows nor ignores real queues.
+  void UpdateThreshold(double modified_trend, base::TimeTicks arrival_time);
+
+  // Raises or lowers |bitrate_| according to |usage_|.
+  void UpdateBitrate();
+
+  base::TickClock* const clock_;  // Not owned by this class.
+  const int max_bitrate_configured_;
+  const int min_bitrate_configured_;
+  base::TimeDelta rtt_;
+
+  // The times and sizes of the frames sent recently, to measure the rate the
+  // encoder is actually producing.
+  std::deque<std::pair<base::TimeTicks, size_t>> recent_frames_;
+  size_t bits_in_recent_frames_;
+  base::TimeTicks first_frame_time_;
+
+  PacketGroup current_group_;
+  PacketGroup previous_group_;
+
+  // The sum of the delay variations so far, its exponential average, and a
+  // window of the recent averages against arrival time, to fit a line to.
+  double accumulated_delay_ms_;
+  double smoothed_delay_ms_;
+  std::deque<std::pair<double, double>> delay_history_;
+  base::TimeTicks first_arrival_time_;
+  size_t num_delay_variations_;
+  double previous_trend_;
+
+  BandwidthUsage usage_;
+  double overuse_threshold_ms_;
+  base::TimeTicks last_threshold_update_time_;
+  int num_overusing_groups_;
+
+  double bitrate_;
+  base::TimeTicks last_update_time_;
+  base::TimeTicks last_decrease_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayBasedCongestionControl);
+};
+
 
 CongestionControl* NewAdaptiveCongestionControl(
     base::TickClock* clock,
@@ -136,6 +235,17 @@ CongestionControl* NewFixedCongestionControl(int bitrate) {
   return new FixedCongestionControl(bitrate);
 }
 
+CongestionControl* NewDelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate) {
+  return new DelayBasedCongestionControl(clock,
+                                         max_bitrate_configured,
+                                         min_bitrate_configured,
+                                         start_bitrate);
+}
+
 // This means that we *try* to keep our buffer 90% empty.
 // If it is less full, we increase the bandwidth, if it is more
 // we decrease the bandwidth. Making this smaller makes the
@@ -399,5 +509,268 @@ int AdaptiveCongestionControl::GetBitrate(base::TimeTicks playout_time,
   return bits_per_second;
 }
 
+// Packets sent within this many milliseconds of the first packet of a group
+// belong to the group.  PacedSender sends a burst every 10 ms.
+static const int kPacketGroupIntervalMs = 5;
+
+// The number of packet groups to fit the delay trend over.
+static const size_t kTrendlineWindowSize = 20;
+
+// The weight of the previous value in the average of the accumulated delay.
+static const double kTrendlineSmoothing = 0.9;
+
+// The slope of the delay trend is scaled by this times the number of delay
+// variations seen (up to kMaxTrendlineDeltas) before it is compared with the
+// overuse threshold.
+static const double kTrendlineThresholdGain = 4.0;
+static const size_t kMaxTrendlineDeltas = 60;
+
+// How the overuse threshold starts, how fast it follows the trend when the
+// trend is above (increase) or below (decrease) it, and its bounds, all in
+// milliseconds.
+static const double kInitialOveruseThresholdMs = 12.5;
+static const double kOveruseThresholdIncrease = 0.0087;
+static const double kOveruseThresholdDecrease = 0.039;
+static const double kMinOveruseThresholdMs = 6.0;
+static const double kMaxOveruseThresholdMs = 600.0;
+
+// The number of consecutive packet groups the delay must grow over before it
+// counts as overuse, so that a single late burst doesn't cut the bitrate.
+static const int kOverusingGroupsNeeded = 2;
+
+// On overuse the bitrate is multiplied by this, at most once per round trip.
+static const double kBitrateDecreaseFactor = 0.85;
+
+// Otherwise it grows by this fraction per second, as long as it isn't already
+// well above what the encoder is producing.  Without that limit, the bitrate
+// would climb without bound while the content is easy to encode, and then
+// flood the network once it isn't.
+static const double kBitrateIncreasePerSecond = 0.08;
+static const double kMaxBitrateOverSendRate = 1.5;
+
+// The send rate is measured over this many milliseconds.
+static const int kSendRateWindowMs = 1000;
+
+// Returns the slope of the least squares fit of a line to |points|.
+static double LinearFitSlope(
+    const std::deque<std::pair<double, double>>& points) {
+  double sum_x = 0;
+  double sum_y = 0;
+  for (const auto& point : points) {
+    sum_x += point.first;
+    sum_y += point.second;
+  }
+  const double mean_x = sum_x / points.size();
+  const double mean_y = sum_y / points.size();
+  double numerator = 0;
+  double denominator = 0;
+  for (const auto& point : points) {
+    numerator += (point.first - mean_x) * (point.second - mean_y);
+    denominator += (point.first - mean_x) * (point.first - mean_x);
+  }
+  return denominator > 0 ? numerator / denominator : 0;
+}
+
+DelayBasedCongestionControl::DelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate)
+    : clock_(clock),
+      max_bitrate_configured_(max_bitrate_configured),
+      min_bitrate_configured_(min_bitrate_configured),
+      bits_in_recent_frames_(0),
+      accumulated_delay_ms_(0),
+      smoothed_delay_ms_(0),
+      num_delay_variations_(0),
+      previous_trend_(0),
+      usage_(BANDWIDTH_NORMAL),
+      overuse_threshold_ms_(kInitialOveruseThresholdMs),
+      num_overusing_groups_(0),
+      bitrate_(std::max(std::min(start_bitrate, max_bitrate_configured),
+                        min_bitrate_configured)) {
+  DCHECK_GE(max_bitrate_configured, min_bitrate_configured) << "Invalid config";
+  DCHECK_GT(min_bitrate_configured, 0);
+}
+
+DelayBasedCongestionControl::~DelayBasedCongestionControl() {}
+
+void DelayBasedCongestionControl::UpdateRtt(base::TimeDelta rtt) {
+  rtt_ = (7 * rtt_ + rtt) / 8;
+}
+
+void DelayBasedCongestionControl::SendFrameToTransport(
+    FrameId frame_id,
+    size_t frame_size_in_bits,
+    base::TimeTicks when) {
+  if (first_frame_time_.is_null())
+    first_frame_time_ = when;
+  recent_frames_.push_back(std::make_pair(when, frame_size_in_bits));
+  bits_in_recent_frames_ += frame_size_in_bits;
+  const base::TimeDelta window =
+      base::TimeDelta::FromMilliseconds(kSendRateWindowMs);
+  while (when - recent_frames_.front().first > window) {
+    bits_in_recent_frames_ -= recent_frames_.front().second;
+    recent_frames_.pop_front();
+  }
+}
+
+void DelayBasedCongestionControl::AckPackets(
+    const std::vector<PacketArrival>& arrivals) {
+  const base::TimeDelta group_interval =
+      base::TimeDelta::FromMilliseconds(kPacketGroupIntervalMs);
+  for (const PacketArrival& arrival : arrivals) {
+    // Packets reported after those sent later than them are of no use, as
+    // their group has already been measured.
+    if (arrival.send_time < current_group_.first_send_time)
+      continue;
+
+    if (!current_group_.first_send_time.is_null() &&
+        arrival.send_time - current_group_.first_send_time <= group_interval) {
+      current_group_.last_send_time =
+          std::max(current_group_.last_send_time, arrival.send_time);
+      current_group_.last_arrival_time =
+          std::max(current_group_.last_arrival_time, arrival.arrival_time);
+      continue;
+    }
+
+    // |arrival| starts a new group, which completes the current one.
+    if (!previous_group_.first_send_time.is_null()) {
+      const base::TimeDelta arrival_delta =
+          current_group_.last_arrival_time - previous_group_.last_arrival_time;
+      const base::TimeDelta send_delta =
+          current_group_.last_send_time - previous_group_.last_send_time;
+      OnDelayVariation((arrival_delta - send_delta).InMillisecondsF(),
+                       current_group_.last_arrival_time);
+    }
+    if (!current_group_.first_send_time.is_null())
+      previous_group_ = current_group_;
+    current_group_.first_send_time = arrival.send_time;
+    current_group_.last_send_time = arrival.send_time;
+    current_group_.last_arrival_time = arrival.arrival_time;
+  }
+
+  UpdateBitrate();
+}
+
+void DelayBasedCongestionControl::OnDelayVariation(
+    double delay_variation_ms,
+    base::TimeTicks arrival_time) {
+  if (first_arrival_time_.is_null())
+    first_arrival_time_ = arrival_time;
+  accumulated_delay_ms_ += delay_variation_ms;
+  smoothed_delay_ms_ = kTrendlineSmoothing * smoothed_delay_ms_ +
+                       (1 - kTrendlineSmoothing) * accumulated_delay_ms_;
+  delay_history_.push_back(std::make_pair(
+      (arrival_time - first_arrival_time_).InMillisecondsF(),
+      smoothed_delay_ms_));
+  if (delay_history_.size() > kTrendlineWindowSize)
+    delay_history_.pop_front();
+  ++num_delay_variations_;
+
+  double trend = previous_trend_;
+  if (delay_history_.size() == kTrendlineWindowSize)
+    trend = LinearFitSlope(delay_history_);
+  const double modified_trend =
+      std::min(num_delay_variations_, kMaxTrendlineDeltas) * trend *
+      kTrendlineThresholdGain;
+  VLOG(3) << "DV:" << delay_variation_ms << " T:" << modified_trend
+          << " TH:" << overuse_threshold_ms_;
+  DetectOveruse(trend, modified_trend, arrival_time);
+  previous_trend_ = trend;
+}
+
+void DelayBasedCongestionControl::DetectOveruse(double trend,
+                                                double modified_trend,
+                                                base::TimeTicks arrival_time) {
+  if (modified_trend > overuse_threshold_ms_) {
+    // Only call it overuse while the delay isn't already growing more slowly.
+    if (trend >= previous_trend_ &&
+        ++num_overusing_groups_ >= kOverusingGroupsNeeded) {
+      usage_ = BANDWIDTH_OVERUSING;
+    }
+  } else if (modified_trend < -overuse_threshold_ms_) {
+    num_overusing_groups_ = 0;
+    usage_ = BANDWIDTH_UNDERUSING;
+  } else {
+    num_overusing_groups_ = 0;
+    usage_ = BANDWIDTH_NORMAL;
+  }
+  UpdateThreshold(modified_trend, arrival_time);
+}
+
+void DelayBasedCongestionControl::UpdateThreshold(
+    double modified_trend,
+    base::TimeTicks arrival_time) {
+  if (last_threshold_update_time_.is_null())
+    last_threshold_update_time_ = arrival_time;
+
+  // Don't let sudden spikes, such as a route change, move the threshold.
+  const double magnitude = std::abs(modified_trend);
+  if (magnitude > overuse_threshold_ms_ + 15) {
+    last_threshold_update_time_ = arrival_time;
+    return;
+  }
+
+  const double k = magnitude < overuse_threshold_ms_
+                       ? kOveruseThresholdDecrease
+                       : kOveruseThresholdIncrease;
+  const double elapsed_ms = std::min(
+      (arrival_time - last_threshold_update_time_).InMillisecondsF(), 100.0);
+  overuse_threshold_ms_ += k * (magnitude - overuse_threshold_ms_) * elapsed_ms;
+  overuse_threshold_ms_ = std::max(overuse_threshold_ms_,
+                                   kMinOveruseThresholdMs);
+  overuse_threshold_ms_ = std::min(overuse_threshold_ms_,
+                                   kMaxOveruseThresholdMs);
+  last_threshold_update_time_ = arrival_time;
+}
+
+void DelayBasedCongestionControl::UpdateBitrate() {
+  const base::TimeTicks now = clock_->NowTicks();
+  if (last_update_time_.is_null())
+    last_update_time_ = now;
+
+  switch (usage_) {
+    case BANDWIDTH_OVERUSING: {
+      // Give the previous cut a round trip to take effect.
+      const base::TimeDelta hold_time =
+          std::max(rtt_, base::TimeDelta::FromMilliseconds(100));
+      if (last_decrease_time_.is_null() ||
+          now - last_decrease_time_ >= hold_time) {
+        bitrate_ *= kBitrateDecreaseFactor;
+        last_decrease_time_ = now;
+      }
+      break;
+    }
+    case BANDWIDTH_UNDERUSING:
+      // A queue is draining; hold until it is empty.
+      break;
+    case BANDWIDTH_NORMAL: {
+      const base::TimeDelta window =
+          base::TimeDelta::FromMilliseconds(kSendRateWindowMs);
+      const double send_rate =
+          bits_in_recent_frames_ / window.InSecondsF();
+      if (!first_frame_time_.is_null() && now - first_frame_time_ >= window &&
+          bitrate_ > kMaxBitrateOverSendRate * send_rate) {
+        break;
+      }
+      const double elapsed_seconds =
+          std::min((now - last_update_time_).InSecondsF(), 1.0);
+      bitrate_ *= 1 + kBitrateIncreasePerSecond * elapsed_seconds;
+      break;
+    }
+  }
+  last_update_time_ = now;
+
+  bitrate_ = std::max(bitrate_, static_cast<double>(min_bitrate_configured_));
+  bitrate_ = std::min(bitrate_, static_cast<double>(max_bitrate_configured_));
+  TRACE_COUNTER_ID1("cast.stream", "Delay Based Bitrate", this, bitrate_);
+}
+
+int DelayBasedCongestionControl::GetBitrate(base::TimeTicks playout_time,
+                                            base::TimeDelta playout_delay) {
+  return static_cast<int>(bitrate_);
+}
+
 }  // namespace cast
 }  // namespace media
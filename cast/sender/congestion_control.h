@@ -14,6 +14,7 @@
 #include "base/time/tick_clock.h"
 #include "base/time/time.h"
 #include "media/cast/common/frame_id.h"
+#include "media/cast/net/rtcp/rtcp_defines.h"
 
 namespace media {
 namespace cast {
@@ -41,6 +42,10 @@ class CongestionControl {
   virtual void AckLaterFrames(std::vector<FrameId> received_frames,
                               base::TimeTicks when) = 0;
 
+  // Called with the send and arrival times of packets the receiver reported,
+  // ordered by send time.
+  virtual void AckPackets(const std::vector<PacketArrival>& arrivals) = 0;
+
   // Returns the bitrate we should use for the next frame.
   virtual int GetBitrate(base::TimeTicks playout_time,
                          base::TimeDelta playout_delay) = 0;
@@ -54,6 +59,15 @@ CongestionControl* NewAdaptiveCongestionControl(
 
 CongestionControl* NewFixedCongestionControl(int bitrate);
 
+// Returns a controller which lowers the bitrate when the one-way delay of
+// packets grows, which means that a queue is building up somewhere on the
+// network path, and raises it slowly otherwise.
+CongestionControl* NewDelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate);
+
 }  // namespace cast
 }  // namespace media
 
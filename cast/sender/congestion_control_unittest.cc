@@ -4,6 +4,9 @@
 
 #include <stddef.h>
 #include <stdint.h>
+
+#include <algorithm>
+#include <deque>
 #include <vector>
 
 #include "base/bind.h"
@@ -143,5 +146,117 @@ TEST_F(CongestionControlTest, SimpleRun) {
               safe_bitrate * 0.05);
 }
 
+class DelayBasedCongestionControlTest : public ::testing::Test {
+ protected:
+  DelayBasedCongestionControlTest()
+      : average_bitrate_(0), max_queuing_delay_ms_(0) {
+    testing_clock_.Advance(
+        base::TimeDelta::FromMilliseconds(kStartMillisecond));
+    congestion_control_.reset(NewDelayBasedCongestionControl(
+        &testing_clock_, kMaxBitrateConfigured, kMinBitrateConfigured,
+        kMinBitrateConfigured * 2));
+  }
+
+  // Streams for |duration| over a link of |capacity| bits per second with a
+  // 20 ms propagation delay.  Packets leave in 10 ms bursts, as PacedSender
+  // sends them, and their arrivals are reported every 100 ms.  Sets
+  // |average_bitrate_| and |max_queuing_delay_ms_| over the second half.
+  void Run(int capacity, base::TimeDelta duration) {
+    const size_t kPacketSize = 1200;
+    const base::TimeDelta kPropagationDelay =
+        base::TimeDelta::FromMilliseconds(20);
+    const base::TimeDelta kFeedbackDelay =
+        base::TimeDelta::FromMilliseconds(10);
+
+    std::deque<size_t> send_queue;
+    std::deque<PacketArrival> in_flight;
+    std::vector<PacketArrival> arrivals;
+    base::TimeTicks link_free_time = testing_clock_.NowTicks();
+    FrameId frame_id = FrameId::first();
+    double bitrate_sum = 0;
+    int num_frames = 0;
+    const int64_t duration_ms = duration.InMilliseconds();
+    for (int64_t ms = 0; ms < duration_ms; ++ms) {
+      testing_clock_.Advance(base::TimeDelta::FromMilliseconds(1));
+      const base::TimeTicks now = testing_clock_.NowTicks();
+      if (ms % kFrameDelayMs == 0) {
+        const int bitrate = congestion_control_->GetBitrate(
+            now + base::TimeDelta::FromMilliseconds(300),
+            base::TimeDelta::FromMilliseconds(300));
+        size_t frame_size = bitrate * kFrameDelayMs / 1000 / 8;
+        congestion_control_->SendFrameToTransport(frame_id++, frame_size * 8,
+                                                  now);
+        for (; frame_size > 0; frame_size -= std::min(frame_size, kPacketSize))
+          send_queue.push_back(std::min(frame_size, kPacketSize));
+        if (ms >= duration_ms / 2) {
+          bitrate_sum += bitrate;
+          ++num_frames;
+        }
+      }
+      if (ms % 10 == 0) {
+        for (int i = 0; i < 20 && !send_queue.empty(); ++i) {
+          PacketArrival packet;
+          packet.send_time = now;
+          packet.size = send_queue.front();
+          send_queue.pop_front();
+          link_free_time =
+              std::max(link_free_time, now) +
+              base::TimeDelta::FromMicroseconds(packet.size * 8 *
+                                                INT64_C(1000000) / capacity);
+          packet.arrival_time = link_free_time + kPropagationDelay;
+          in_flight.push_back(packet);
+        }
+        if (ms >= duration_ms / 2) {
+          max_queuing_delay_ms_ = std::max(
+              max_queuing_delay_ms_, (link_free_time - now).InMillisecondsF());
+        }
+      }
+      while (!in_flight.empty() &&
+             in_flight.front().arrival_time + kFeedbackDelay <= now) {
+        arrivals.push_back(in_flight.front());
+        in_flight.pop_front();
+      }
+      if (ms % 100 == 0 && !arrivals.empty()) {
+        congestion_control_->AckPackets(arrivals);
+        arrivals.clear();
+      }
+    }
+    average_bitrate_ = bitrate_sum / num_frames;
+  }
+
+  base::SimpleTestTickClock testing_clock_;
+  std::unique_ptr<CongestionControl> congestion_control_;
+  double average_bitrate_;
+  double max_queuing_delay_ms_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayBasedCongestionControlTest);
+};
+
+// Tests that the bitrate keeps rising while packets aren't being queued.
+TEST_F(DelayBasedCongestionControlTest, IncreasesWithoutQueuing) {
+  const int start_bitrate = congestion_control_->GetBitrate(
+      testing_clock_.NowTicks(), base::TimeDelta::FromMilliseconds(300));
+  Run(100 * kMaxBitrateConfigured, base::TimeDelta::FromSeconds(10));
+  EXPECT_GT(average_bitrate_, 1.5 * start_bitrate);
+  EXPECT_LT(max_queuing_delay_ms_, 1.0);
+
+  // But never beyond the configured maximum.
+  Run(100 * kMaxBitrateConfigured, base::TimeDelta::FromSeconds(60));
+  EXPECT_EQ(kMaxBitrateConfigured,
+            congestion_control_->GetBitrate(
+                testing_clock_.NowTicks(),
+                base::TimeDelta::FromMilliseconds(300)));
+}
+
+// Tests that the bitrate settles just below the capacity of a bottleneck,
+// without letting a long queue build up in front of it.
+TEST_F(DelayBasedCongestionControlTest, StaysBelowBottleneck) {
+  const int kCapacity = 2000000;
+  Run(kCapacity, base::TimeDelta::FromSeconds(60));
+  EXPECT_GT(average_bitrate_, 0.7 * kCapacity);
+  EXPECT_LT(average_bitrate_, kCapacity);
+  EXPECT_LT(max_queuing_delay_ms_, 150.0);
+}
+
 }  // namespace cast
 }  // namespace media
@@ -53,6 +53,12 @@ void FrameSender::RtcpClient::OnReceivedPli() {
     frame_sender_->OnReceivedPli();
 }
 
+void FrameSender::RtcpClient::OnReceivedPacketArrivals(
+    const std::vector<PacketArrival>& arrivals) {
+  if (frame_sender_)
+    frame_sender_->OnReceivedPacketArrivals(arrivals);
+}
+
 FrameSender::FrameSender(scoped_refptr<CastEnvironment> cast_environment,
                          CastTransport* const transport_sender,
                          const FrameSenderConfig& config,
@@ -93,6 +99,7 @@ FrameSender::FrameSender(scoped_refptr<CastEnvironment> cast_environment,
   transport_config.rtp_payload_type = config.rtp_payload_type;
   transport_config.aes_key = config.aes_key;
   transport_config.aes_iv_mask = config.aes_iv_mask;
+  transport_config.enable_fec = config.enable_fec;
 
   transport_sender->InitializeStream(
       transport_config,
@@ -426,6 +433,11 @@ void FrameSender::OnReceivedPli() {
   picture_lost_at_receiver_ = true;
 }
 
+void FrameSender::OnReceivedPacketArrivals(
+    const std::vector<PacketArrival>& arrivals) {
+  congestion_control_->AckPackets(arrivals);
+}
+
 bool FrameSender::ShouldDropNextFrame(base::TimeDelta frame_duration) const {
   // Check that accepting the next frame won't cause more frames to become
   // in-flight than the system's design limit.
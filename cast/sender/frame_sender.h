@@ -11,6 +11,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
@@ -65,6 +67,8 @@ class FrameSender {
     void OnReceivedCastMessage(const RtcpCastMessage& cast_message) override;
     void OnReceivedRtt(base::TimeDelta round_trip_time) override;
     void OnReceivedPli() override;
+    void OnReceivedPacketArrivals(
+        const std::vector<PacketArrival>& arrivals) override;
 
    private:
     const base::WeakPtr<FrameSender> frame_sender_;
@@ -79,6 +83,9 @@ class FrameSender {
   // Called when a Pli message is received.
   void OnReceivedPli();
 
+  // Called with the send and arrival times of packets the receiver reported.
+  void OnReceivedPacketArrivals(const std::vector<PacketArrival>& arrivals);
+
   void OnMeasuredRoundTripTime(base::TimeDelta rtt);
 
   const scoped_refptr<CastEnvironment> cast_environment_;
@@ -0,0 +1,225 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/sender/video_quality_controller.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+struct QualityLevel {
+  // The scale applied to both dimensions of the frames.
+  double scale;
+  // The fraction of the maximum frame rate.
+  double frame_rate_fraction;
+};
+
+// Resolution is given up before frame rate: for the same number of pixels per
+// second, motion suffers more from a lower frame rate than detail does from a
+// smaller frame, most of which the quantizer would have discarded anyway.
+const QualityLevel kLevels[] = {
+    {1.0, 1.0}, {0.75, 1.0}, {0.5, 1.0}, {0.5, 2.0 / 3.0}, {0.375, 0.5},
+};
+
+// The levels used when frames may not change size.
+const QualityLevel kFrameRateOnlyLevels[] = {
+    {1.0, 1.0}, {1.0, 2.0 / 3.0}, {1.0, 0.5},
+};
+
+const QualityLevel& GetQualityLevel(bool can_change_frame_size,
+                                    size_t level) {
+  return can_change_frame_size ? kLevels[level] : kFrameRateOnlyLevels[level];
+}
+
+// The half-life of the averaged feedback.
+const int kFeedbackHalfLifeMs = 500;
+
+// The limits above which the controller moves down a level.  The encoder
+// utilization is well below 1.0, the point at which frames start to queue up
+// in the encoder, to leave room for the more complex frames.  A lossy
+// utilization of 0.8 corresponds to a quantizer of about 50 out of 63.
+const double kMaxEncoderUtilization = 0.8;
+const double kMaxLossyUtilization = 0.8;
+const double kMaxDropRate = 0.1;
+
+// The controller moves up a level only when the feedback, scaled to the level
+// above, would be below this fraction of the limits, and almost no frames are
+// being dropped.  This keeps it from moving back and forth between levels.
+const double kStepUpHeadroom = 0.7;
+const double kMaxDropRateToStepUp = 0.01;
+
+// How long the controller stays at a level before it may leave it.  Moving up
+// takes longer, since a mistake there costs dropped frames.
+const int kMinTimeBeforeStepDownMs = 500;
+const int kMinTimeBeforeStepUpMs = 3000;
+
+}  // namespace
+
+VideoQualityController::VideoQualityController(
+    const FrameSenderConfig& video_config)
+    : max_frame_rate_(video_config.max_frame_rate),
+      can_change_frame_size_(!video_config.use_external_encoder),
+      level_(0),
+      target_bitrate_(video_config.start_bitrate),
+      encoder_utilization_(
+          base::TimeDelta::FromMilliseconds(kFeedbackHalfLifeMs)),
+      lossy_bitrate_(base::TimeDelta::FromMilliseconds(kFeedbackHalfLifeMs)),
+      drop_rate_(base::TimeDelta::FromMilliseconds(kFeedbackHalfLifeMs)) {
+  DCHECK_GT(max_frame_rate_, 0.0);
+}
+
+VideoQualityController::~VideoQualityController() {}
+
+size_t VideoQualityController::num_levels() const {
+  return can_change_frame_size_ ? arraysize(kLevels)
+                                : arraysize(kFrameRateOnlyLevels);
+}
+
+gfx::Size VideoQualityController::GetFrameSize(
+    const gfx::Size& source_size) const {
+  const double scale = GetQualityLevel(can_change_frame_size_, level_).scale;
+  if (scale == 1.0)
+    return source_size;
+  // I420 frames have even dimensions.
+  return gfx::Size(
+      std::max(2, static_cast<int>(source_size.width() * scale / 2 + 0.5) * 2),
+      std::max(2,
+               static_cast<int>(source_size.height() * scale / 2 + 0.5) * 2));
+}
+
+double VideoQualityController::GetMaxFrameRate() const {
+  return max_frame_rate_ *
+         GetQualityLevel(can_change_frame_size_, level_).frame_rate_fraction;
+}
+
+bool VideoQualityController::ShouldSkipFrame(base::TimeTicks reference_time) {
+  if (level_change_time_.is_null())
+    ChangeLevel(0, reference_time);
+  latest_reference_time_ = reference_time;
+
+  const double frame_rate = GetMaxFrameRate();
+  if (frame_rate >= max_frame_rate_) {
+    next_frame_time_ = base::TimeTicks();
+    return false;
+  }
+
+  // Keep frames on a grid of the lower frame rate, with some tolerance for
+  // jitter in the capture times.  After a pause, the grid starts again.
+  const base::TimeDelta interval =
+      base::TimeDelta::FromSecondsD(1.0 / frame_rate);
+  if (!next_frame_time_.is_null() &&
+      reference_time < next_frame_time_ - interval / 4) {
+    return true;
+  }
+  if (next_frame_time_.is_null() ||
+      reference_time - next_frame_time_ > interval) {
+    next_frame_time_ = reference_time + interval;
+  } else {
+    next_frame_time_ += interval;
+  }
+  return false;
+}
+
+void VideoQualityController::OnFrameAdmitted(base::TimeTicks reference_time,
+                                             bool dropped) {
+  DCHECK(!level_change_time_.is_null());
+  drop_rate_.Update(dropped ? 1.0 : 0.0, reference_time);
+  MaybeChangeLevel(latest_reference_time_);
+}
+
+void VideoQualityController::SetTargetBitrate(int bitrate) {
+  DCHECK_GT(bitrate, 0);
+  target_bitrate_ = bitrate;
+}
+
+void VideoQualityController::OnFrameEncoded(base::TimeTicks reference_time,
+                                            bool is_key_frame,
+                                            int encoder_bitrate,
+                                            double encoder_utilization,
+                                            double lossy_utilization) {
+  DCHECK(!level_change_time_.is_null());
+  // Frames captured before the level last changed say little about the
+  // current one.  Key frames are atypical, and are ignored too.
+  if (reference_time <= level_change_time_ || is_key_frame)
+    return;
+  if (encoder_utilization >= 0.0)
+    encoder_utilization_.Update(encoder_utilization, reference_time);
+  if (lossy_utilization >= 0.0 && encoder_bitrate > 0)
+    lossy_bitrate_.Update(lossy_utilization * encoder_bitrate, reference_time);
+  MaybeChangeLevel(latest_reference_time_);
+}
+
+void VideoQualityController::ChangeLevel(size_t level, base::TimeTicks now) {
+  DCHECK_LT(level, num_levels());
+  if (level_change_time_.is_null()) {
+    encoder_utilization_.Reset(0.0, now);
+    lossy_bitrate_.Reset(0.0, now);
+  } else {
+    // Predict the feedback at the new level from the number of pixels per
+    // second it encodes, rather than wait for it to be measured.
+    const double cost_ratio = GetRelativeCost(level) / GetRelativeCost(level_);
+    encoder_utilization_.Reset(encoder_utilization_.current() * cost_ratio,
+                               now);
+    lossy_bitrate_.Reset(lossy_bitrate_.current() * cost_ratio, now);
+    VLOG(1) << "Video quality level " << level_ << " --> " << level << ": "
+            << "scale="
+            << GetQualityLevel(can_change_frame_size_, level).scale
+            << ", frame_rate_fraction="
+            << GetQualityLevel(can_change_frame_size_, level)
+                   .frame_rate_fraction;
+  }
+  // Frames dropped at the old level must not count against the new one.
+  drop_rate_.Reset(0.0, now);
+  level_ = level;
+  level_change_time_ = now;
+}
+
+void VideoQualityController::MaybeChangeLevel(base::TimeTicks now) {
+  const base::TimeDelta time_at_level = now - level_change_time_;
+  const double encoder_utilization = encoder_utilization_.current();
+  const double lossy_utilization =
+      lossy_bitrate_.current() / std::max(target_bitrate_, 1);
+  const double drop_rate = drop_rate_.current();
+
+  if (level_ + 1 < num_levels() &&
+      time_at_level >=
+          base::TimeDelta::FromMilliseconds(kMinTimeBeforeStepDownMs) &&
+      (encoder_utilization > kMaxEncoderUtilization ||
+       lossy_utilization > kMaxLossyUtilization || drop_rate > kMaxDropRate)) {
+    VLOG(1) << "Stepping down: encoder_utilization=" << encoder_utilization
+            << ", lossy_utilization=" << lossy_utilization
+            << ", drop_rate=" << drop_rate;
+    ChangeLevel(level_ + 1, now);
+    return;
+  }
+
+  if (level_ > 0 &&
+      time_at_level >=
+          base::TimeDelta::FromMilliseconds(kMinTimeBeforeStepUpMs)) {
+    const double cost_ratio =
+        GetRelativeCost(level_ - 1) / GetRelativeCost(level_);
+    if (encoder_utilization * cost_ratio <
+            kMaxEncoderUtilization * kStepUpHeadroom &&
+        lossy_utilization * cost_ratio <
+            kMaxLossyUtilization * kStepUpHeadroom &&
+        drop_rate < kMaxDropRateToStepUp) {
+      ChangeLevel(level_ - 1, now);
+    }
+  }
+}
+
+double VideoQualityController::GetRelativeCost(size_t level) const {
+  const QualityLevel& quality_level =
+      GetQualityLevel(can_change_frame_size_, level);
+  return quality_level.scale * quality_level.scale *
+         quality_level.frame_rate_fraction;
+}
+
+}  // namespace cast
+}  // namespace media
@@ -0,0 +1,115 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_SENDER_VIDEO_QUALITY_CONTROLLER_H_
+#define MEDIA_CAST_SENDER_VIDEO_QUALITY_CONTROLLER_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/feedback_signal_accumulator.h"
+#include "media/cast/cast_config.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+namespace cast {
+
+// Chooses the resolution and frame rate a VideoSender encodes at, so that it
+// backs off before the encoder falls behind real time or the network forces
+// frames to be dropped, and steps back up once there is room again.
+//
+// The controller works down a fixed ladder of levels, each of which encodes
+// fewer pixels per second than the one before.  It moves down a level when
+// any of these signals, averaged over the last second or so, is too high:
+//
+//   * The encoder utilization: the time taken to encode a frame, relative to
+//     its duration.
+//   * The lossy utilization: the quantizer the encoder would have needed to
+//     meet its target bitrate, relative to the largest one.  This is scaled
+//     by the bitrate each frame was encoded at, and divided by the current
+//     target, so that changes in the bitrate the network allows take effect
+//     at once, rather than once frames encoded at the new rate are measured.
+//   * The fraction of frames dropped because too much media is in flight.
+//
+// It moves up a level only when the utilizations, scaled by how many more
+// pixels per second the level above encodes, would still be comfortably
+// below their limits.  The encoder's own rate control keeps choosing the
+// quantizer of each frame; the controller keeps that quantizer in a range
+// where it does not need to discard much detail.
+class VideoQualityController {
+ public:
+  explicit VideoQualityController(const FrameSenderConfig& video_config);
+  ~VideoQualityController();
+
+  // Returns the size to encode a frame of |source_size| at.
+  gfx::Size GetFrameSize(const gfx::Size& source_size) const;
+
+  // Returns the highest frame rate to encode at.
+  double GetMaxFrameRate() const;
+
+  // Returns true if the frame captured at |reference_time| should be skipped
+  // to keep to GetMaxFrameRate().  Must be called for every frame, in order.
+  bool ShouldSkipFrame(base::TimeTicks reference_time);
+
+  // Called for every frame not skipped, with whether it was dropped because
+  // too much media was in flight.
+  void OnFrameAdmitted(base::TimeTicks reference_time, bool dropped);
+
+  // Called with the target bitrate of the next frame to be encoded.
+  void SetTargetBitrate(int bitrate);
+
+  // Called with the encoder's feedback for each encoded frame.
+  void OnFrameEncoded(base::TimeTicks reference_time,
+                      bool is_key_frame,
+                      int encoder_bitrate,
+                      double encoder_utilization,
+                      double lossy_utilization);
+
+  // The current level, where zero is the full resolution and frame rate.
+  size_t level() const { return level_; }
+  size_t num_levels() const;
+
+ private:
+  // Moves to |level|, and restarts the feedback from where it is predicted to
+  // be at |level| as of |now|.
+  void ChangeLevel(size_t level, base::TimeTicks now);
+
+  // Moves a level down or up if the feedback as of |now| calls for it.
+  void MaybeChangeLevel(base::TimeTicks now);
+
+  // Returns the number of pixels per second at |level|, relative to level 0.
+  double GetRelativeCost(size_t level) const;
+
+  const double max_frame_rate_;
+
+  // The software encoder can switch frame sizes cheaply, but a hardware
+  // encoder has to be re-created.  Only the frame rate is changed for the
+  // latter.
+  const bool can_change_frame_size_;
+
+  size_t level_;
+  base::TimeTicks level_change_time_;
+
+  // The capture time of the latest frame, which is the controller's notion of
+  // the current time.
+  base::TimeTicks latest_reference_time_;
+
+  int target_bitrate_;
+
+  FeedbackSignalAccumulator<base::TimeTicks> encoder_utilization_;
+  // The lossy utilization multiplied by the bitrate it was measured at.
+  FeedbackSignalAccumulator<base::TimeTicks> lossy_bitrate_;
+  FeedbackSignalAccumulator<base::TimeTicks> drop_rate_;
+
+  // The time at which the next frame is due, at GetMaxFrameRate().
+  base::TimeTicks next_frame_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(VideoQualityController);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_SENDER_VIDEO_QUALITY_CONTROLLER_H_
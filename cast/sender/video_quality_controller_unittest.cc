@@ -0,0 +1,176 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/sender/video_quality_controller.h"
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/macros.h"
+#include "media/cast/test/utility/default_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const int64_t kStartMillisecond = INT64_C(12345678900000);
+const int kStartBitrate = 2000000;
+
+}  // namespace
+
+class VideoQualityControllerTest : public ::testing::Test {
+ protected:
+  VideoQualityControllerTest()
+      : source_size_(1280, 720),
+        now_(base::TimeTicks() +
+             base::TimeDelta::FromMilliseconds(kStartMillisecond)),
+        encoder_cost_(0.0),
+        lossy_cost_(0.0),
+        drop_every_nth_frame_(0),
+        num_frames_(0),
+        num_frames_skipped_(0) {}
+
+  void CreateController(bool use_external_encoder) {
+    FrameSenderConfig video_config = GetDefaultVideoSenderConfig();
+    video_config.max_frame_rate = 30;
+    video_config.start_bitrate = kStartBitrate;
+    video_config.use_external_encoder = use_external_encoder;
+    controller_.reset(new VideoQualityController(video_config));
+  }
+
+  // Returns the pixels per second encoded at the controller's current level,
+  // relative to the full frame size and frame rate.
+  double GetRelativeCost() const {
+    const gfx::Size frame_size = controller_->GetFrameSize(source_size_);
+    return static_cast<double>(frame_size.GetArea()) /
+           source_size_.GetArea() * controller_->GetMaxFrameRate() / 30;
+  }
+
+  // Captures 30 frames per second for |duration|, and has the encoder report
+  // utilizations in proportion to the pixels per second encoded.
+  void RunFrames(base::TimeDelta duration) {
+    const base::TimeTicks end_time = now_ + duration;
+    while (now_ < end_time) {
+      now_ += base::TimeDelta::FromMicroseconds(33333);
+      ++num_frames_;
+      if (controller_->ShouldSkipFrame(now_)) {
+        ++num_frames_skipped_;
+        continue;
+      }
+      const bool dropped =
+          drop_every_nth_frame_ && num_frames_ % drop_every_nth_frame_ == 0;
+      controller_->OnFrameAdmitted(now_, dropped);
+      if (dropped)
+        continue;
+      controller_->SetTargetBitrate(kStartBitrate);
+      const double cost = GetRelativeCost();
+      controller_->OnFrameEncoded(now_, false, kStartBitrate,
+                                  encoder_cost_ * cost, lossy_cost_ * cost);
+    }
+  }
+
+  const gfx::Size source_size_;
+  base::TimeTicks now_;
+  std::unique_ptr<VideoQualityController> controller_;
+
+  // The utilizations the encoder reports at full size and frame rate.
+  double encoder_cost_;
+  double lossy_cost_;
+
+  int drop_every_nth_frame_;
+  int num_frames_;
+  int num_frames_skipped_;
+
+  DISALLOW_COPY_AND_ASSIGN(VideoQualityControllerTest);
+};
+
+TEST_F(VideoQualityControllerTest, KeepsFullQualityWithRoomToSpare) {
+  CreateController(false);
+  encoder_cost_ = 0.5;
+  lossy_cost_ = 0.5;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(0u, controller_->level());
+  EXPECT_EQ(source_size_, controller_->GetFrameSize(source_size_));
+  EXPECT_EQ(0, num_frames_skipped_);
+}
+
+TEST_F(VideoQualityControllerTest, ScalesDownForTheEncoder) {
+  CreateController(false);
+  // The encoder can only keep up with a quarter of the pixels.
+  encoder_cost_ = 1.6;
+  lossy_cost_ = 0.3;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(2u, controller_->level());
+  EXPECT_EQ(gfx::Size(640, 360), controller_->GetFrameSize(source_size_));
+  EXPECT_EQ(0, num_frames_skipped_);
+
+  // It stays there, since the level above would overload the encoder.
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(2u, controller_->level());
+
+  // Once the encoder has time to spare, the quality comes back.
+  encoder_cost_ = 0.3;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(0u, controller_->level());
+}
+
+TEST_F(VideoQualityControllerTest, ScalesDownForTheNetwork) {
+  CreateController(false);
+  encoder_cost_ = 0.3;
+  lossy_cost_ = 1.5;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(2u, controller_->level());
+
+  // The content becomes simpler to encode, which leaves room for more pixels.
+  lossy_cost_ = 0.75;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(1u, controller_->level());
+}
+
+TEST_F(VideoQualityControllerTest, ReactsToTheTargetBitrateAtOnce) {
+  CreateController(false);
+  encoder_cost_ = 0.3;
+  lossy_cost_ = 0.6;
+  RunFrames(base::TimeDelta::FromSeconds(5));
+  EXPECT_EQ(0u, controller_->level());
+
+  // The network allows only half of the bitrate the feedback was measured at.
+  // The controller steps down with the next frame, without waiting for frames
+  // encoded at the lower bitrate.
+  controller_->SetTargetBitrate(kStartBitrate / 2);
+  now_ += base::TimeDelta::FromMicroseconds(33333);
+  EXPECT_FALSE(controller_->ShouldSkipFrame(now_));
+  controller_->OnFrameAdmitted(now_, false);
+  EXPECT_EQ(1u, controller_->level());
+}
+
+TEST_F(VideoQualityControllerTest, ScalesDownWhenFramesAreDropped) {
+  CreateController(false);
+  encoder_cost_ = 0.3;
+  lossy_cost_ = 0.3;
+  drop_every_nth_frame_ = 4;
+  RunFrames(base::TimeDelta::FromSeconds(2));
+  EXPECT_LT(0u, controller_->level());
+}
+
+TEST_F(VideoQualityControllerTest, ReducesOnlyTheFrameRateForHardware) {
+  CreateController(true);
+  encoder_cost_ = 1.0;
+  lossy_cost_ = 0.3;
+  RunFrames(base::TimeDelta::FromSeconds(10));
+  EXPECT_EQ(1u, controller_->level());
+  EXPECT_EQ(source_size_, controller_->GetFrameSize(source_size_));
+  EXPECT_DOUBLE_EQ(20.0, controller_->GetMaxFrameRate());
+
+  // One frame in three is skipped.
+  num_frames_ = num_frames_skipped_ = 0;
+  RunFrames(base::TimeDelta::FromSeconds(3));
+  EXPECT_NEAR(num_frames_ / 3, num_frames_skipped_, 1);
+}
+
+}  // namespace cast
+}  // namespace media
@@ -16,6 +16,8 @@
 #include "media/cast/net/cast_transport_config.h"
 #include "media/cast/sender/performance_metrics_overlay.h"
 #include "media/cast/sender/video_encoder.h"
+#include "media/cast/sender/video_quality_controller.h"
+#include "third_party/libyuv/include/libyuv/scale.h"
 
 namespace media {
 namespace cast {
@@ -46,6 +48,30 @@ const int kTargetUtilizationPercentage = 75;
 // frame or receiving multiple Pli messages in a short period.
 const int64_t kMinKeyFrameRequestOnPliIntervalMs = 500;
 
+// Note, we use a fixed bitrate value when external video encoder is used.
+// Some hardware encoder shows bad behavior if we set the bitrate too
+// frequently, e.g. quality drop, not abiding by target bitrate, etc.
+// See details: crbug.com/392086.
+CongestionControl* NewVideoCongestionControl(
+    base::TickClock* clock,
+    const FrameSenderConfig& video_config) {
+  if (video_config.use_external_encoder) {
+    return NewFixedCongestionControl(
+        (video_config.min_bitrate + video_config.max_bitrate) / 2);
+  }
+  switch (video_config.congestion_control) {
+    case CONGESTION_CONTROL_ADAPTIVE:
+      break;
+    case CONGESTION_CONTROL_DELAY_BASED:
+      return NewDelayBasedCongestionControl(
+          clock, video_config.max_bitrate, video_config.min_bitrate,
+          video_config.start_bitrate);
+  }
+  return NewAdaptiveCongestionControl(clock, video_config.max_bitrate,
+                                      video_config.min_bitrate,
+                                      video_config.max_frame_rate);
+}
+
 // Extract capture begin/end timestamps from |video_frame|'s metadata and log
 // it.
 void LogVideoCaptureTimestamps(CastEnvironment* cast_environment,
@@ -82,10 +108,6 @@ void LogVideoCaptureTimestamps(CastEnvironment* cast_environment,
 
 }  // namespace
 
-// Note, we use a fixed bitrate value when external video encoder is used.
-// Some hardware encoder shows bad behavior if we set the bitrate too
-// frequently, e.g. quality drop, not abiding by target bitrate, etc.
-// See details: crbug.com/392086.
 VideoSender::VideoSender(
     scoped_refptr<CastEnvironment> cast_environment,
     const FrameSenderConfig& video_config,
@@ -98,13 +120,7 @@ VideoSender::VideoSender(
           cast_environment,
           transport_sender,
           video_config,
-          video_config.use_external_encoder
-              ? NewFixedCongestionControl(
-                    (video_config.min_bitrate + video_config.max_bitrate) / 2)
-              : NewAdaptiveCongestionControl(cast_environment->Clock(),
-                                             video_config.max_bitrate,
-                                             video_config.min_bitrate,
-                                             video_config.max_frame_rate)),
+          NewVideoCongestionControl(cast_environment->Clock(), video_config)),
       frames_in_encoder_(0),
       last_bitrate_(0),
       playout_delay_change_cb_(playout_delay_change_cb),
@@ -124,6 +140,8 @@ VideoSender::VideoSender(
         FROM_HERE,
         base::Bind(status_change_cb, STATUS_UNSUPPORTED_CODEC));
   }
+  if (video_config.enable_quality_scaling)
+    quality_controller_.reset(new VideoQualityController(video_config));
 }
 
 VideoSender::~VideoSender() {
@@ -177,6 +195,16 @@ void VideoSender::InsertRawVideoFrame(
     return;
   }
 
+  // Skip the frame if the quality controller has lowered the frame rate.
+  if (quality_controller_ &&
+      quality_controller_->ShouldSkipFrame(reference_time)) {
+    TRACE_EVENT_INSTANT2("cast.stream", "Video Frame Drop",
+                         TRACE_EVENT_SCOPE_THREAD,
+                         "rtp_timestamp", rtp_timestamp.lower_32_bits(),
+                         "reason", "frame rate limit");
+    return;
+  }
+
   // Request a key frame when a Pli message was received, and it has been passed
   // long enough from the last time sending key frame request on receiving a Pli
   // message.
@@ -201,7 +229,10 @@ void VideoSender::InsertRawVideoFrame(
       reference_time - last_enqueued_frame_reference_time_ :
       base::TimeDelta::FromSecondsD(1.0 / max_frame_rate_);
 
-  if (ShouldDropNextFrame(duration_added_by_next_frame)) {
+  const bool drop_frame = ShouldDropNextFrame(duration_added_by_next_frame);
+  if (quality_controller_)
+    quality_controller_->OnFrameAdmitted(reference_time, drop_frame);
+  if (drop_frame) {
     base::TimeDelta new_target_delay = std::min(
         current_round_trip_time_ * kRoundTripsNeeded +
         base::TimeDelta::FromMilliseconds(kConstantTimeMs),
@@ -250,13 +281,23 @@ void VideoSender::InsertRawVideoFrame(
 
   TRACE_COUNTER_ID1("cast.stream", "Video Target Bitrate", this, bitrate);
 
+  scoped_refptr<media::VideoFrame> frame_to_encode = video_frame;
+  if (quality_controller_) {
+    quality_controller_->SetTargetBitrate(bitrate);
+    TRACE_COUNTER_ID1("cast.stream", "Video Quality Level", this,
+                      quality_controller_->level());
+    frame_to_encode = MaybeScaleVideoFrame(video_frame);
+  }
+
   MaybeRenderPerformanceMetricsOverlay(
       GetTargetPlayoutDelay(), low_latency_mode_, bitrate,
       frames_in_encoder_ + 1, last_reported_encoder_utilization_,
-      last_reported_lossy_utilization_, video_frame.get());
+      last_reported_lossy_utilization_, frame_to_encode.get());
 
+  // The original frame is passed on to OnEncodedVideoFrame(), so that the
+  // resource utilization is reported back to its producer.
   if (video_encoder_->EncodeVideoFrame(
-          video_frame,
+          frame_to_encode,
           reference_time,
           base::Bind(&VideoSender::OnEncodedVideoFrame,
                      weak_factory_.GetWeakPtr(),
@@ -276,6 +317,41 @@ void VideoSender::InsertRawVideoFrame(
   }
 }
 
+scoped_refptr<media::VideoFrame> VideoSender::MaybeScaleVideoFrame(
+    const scoped_refptr<media::VideoFrame>& video_frame) {
+  const gfx::Size source_size = video_frame->visible_rect().size();
+  const gfx::Size frame_size = quality_controller_->GetFrameSize(source_size);
+  if (frame_size == source_size)
+    return video_frame;
+  if (video_frame->format() != PIXEL_FORMAT_I420 ||
+      !video_frame->IsMappable()) {
+    VLOG(1) << "Cannot scale video frames of format "
+            << VideoPixelFormatToString(video_frame->format());
+    return video_frame;
+  }
+
+  const scoped_refptr<media::VideoFrame> scaled_frame =
+      scaled_frame_pool_.CreateFrame(PIXEL_FORMAT_I420, frame_size,
+                                     gfx::Rect(frame_size), frame_size,
+                                     video_frame->timestamp());
+  libyuv::I420Scale(
+      video_frame->visible_data(VideoFrame::kYPlane),
+      video_frame->stride(VideoFrame::kYPlane),
+      video_frame->visible_data(VideoFrame::kUPlane),
+      video_frame->stride(VideoFrame::kUPlane),
+      video_frame->visible_data(VideoFrame::kVPlane),
+      video_frame->stride(VideoFrame::kVPlane), source_size.width(),
+      source_size.height(), scaled_frame->visible_data(VideoFrame::kYPlane),
+      scaled_frame->stride(VideoFrame::kYPlane),
+      scaled_frame->visible_data(VideoFrame::kUPlane),
+      scaled_frame->stride(VideoFrame::kUPlane),
+      scaled_frame->visible_data(VideoFrame::kVPlane),
+      scaled_frame->stride(VideoFrame::kVPlane), frame_size.width(),
+      frame_size.height(), libyuv::kFilterBox);
+  scaled_frame->metadata()->MergeMetadataFrom(video_frame->metadata());
+  return scaled_frame;
+}
+
 std::unique_ptr<VideoFrameFactory> VideoSender::CreateVideoFrameFactory() {
   return video_encoder_ ? video_encoder_->CreateVideoFrameFactory() : nullptr;
 }
@@ -313,6 +389,13 @@ void VideoSender::OnEncodedVideoFrame(
   last_reported_encoder_utilization_ = encoded_frame->encoder_utilization;
   last_reported_lossy_utilization_ = encoded_frame->lossy_utilization;
 
+  if (quality_controller_) {
+    quality_controller_->OnFrameEncoded(
+        encoded_frame->reference_time,
+        encoded_frame->dependency == EncodedFrame::KEY, encoder_bitrate,
+        last_reported_encoder_utilization_, last_reported_lossy_utilization_);
+  }
+
   TRACE_EVENT_ASYNC_END2("cast.stream", "Video Encode", video_frame.get(),
                          "encoder_utilization",
                          last_reported_encoder_utilization_,
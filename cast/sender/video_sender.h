@@ -14,6 +14,7 @@
 #include "base/threading/non_thread_safe.h"
 #include "base/time/tick_clock.h"
 #include "base/time/time.h"
+#include "media/base/video_frame_pool.h"
 #include "media/cast/cast_config.h"
 #include "media/cast/cast_sender.h"
 #include "media/cast/common/rtp_time.h"
@@ -29,6 +30,7 @@ namespace cast {
 class CastTransport;
 class VideoEncoder;
 class VideoFrameFactory;
+class VideoQualityController;
 
 typedef base::Callback<void(base::TimeDelta)> PlayoutDelayChangeCB;
 
@@ -68,6 +70,12 @@ class VideoSender : public FrameSender,
   base::TimeDelta GetInFlightMediaDuration() const final;
 
  private:
+  // Returns |video_frame| downscaled to the size chosen by
+  // |quality_controller_|, or |video_frame| itself if it is to be encoded at
+  // its own size, or cannot be scaled.
+  scoped_refptr<media::VideoFrame> MaybeScaleVideoFrame(
+      const scoped_refptr<media::VideoFrame>& video_frame);
+
   // Called by the |video_encoder_| with the next EncodedFrame to send.
   void OnEncodedVideoFrame(const scoped_refptr<media::VideoFrame>& video_frame,
                            int encoder_bitrate,
@@ -78,6 +86,13 @@ class VideoSender : public FrameSender,
   // a hardware-based encoder.
   std::unique_ptr<VideoEncoder> video_encoder_;
 
+  // Chooses the resolution and frame rate to encode at.  Null unless
+  // FrameSenderConfig::enable_quality_scaling is set.
+  std::unique_ptr<VideoQualityController> quality_controller_;
+
+  // Provides the frames that downscaled video is written to.
+  VideoFramePool scaled_frame_pool_;
+
   // The number of frames queued for encoding, but not yet sent.
   int frames_in_encoder_;
 
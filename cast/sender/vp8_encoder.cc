@@ -9,6 +9,7 @@
 #include "base/format_macros.h"
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
+#include "base/time/default_tick_clock.h"
 #include "media/base/video_frame.h"
 #include "media/cast/constants.h"
 #include "third_party/libvpx/source/libvpx/vpx/vp8cx.h"
@@ -54,6 +55,33 @@ const double kEquivalentEncodingSpeedStepPerQpStep = 1 / 20.0;
 const int kHighestEncodingSpeed = 12;
 const int kLowestEncodingSpeed = 6;
 
+// The frame sizes from which more than one encoding thread is used from the
+// start.  libvpx splits the work between threads by macroblock rows, and for
+// smaller frames the synchronization between them costs more than it saves.
+const int kMinAreaForTwoThreads = 640 * 480 + 1;
+const int kMinAreaForFourThreads = 1920 * 1080;
+
+int GetInitialNumberOfThreads(const gfx::Size& frame_size, int max_threads) {
+  int num_threads = 1;
+  if (frame_size.GetArea() >= kMinAreaForFourThreads)
+    num_threads = 4;
+  else if (frame_size.GetArea() >= kMinAreaForTwoThreads)
+    num_threads = 2;
+  return std::max(1, std::min(num_threads, max_threads));
+}
+
+// Returns the token partitioning for |num_threads|: one partition per thread,
+// so that receivers can decode the partitions in parallel too.
+vp8e_token_partitions GetTokenPartitions(int num_threads) {
+  if (num_threads >= 8)
+    return VP8_EIGHT_TOKENPARTITION;
+  if (num_threads >= 4)
+    return VP8_FOUR_TOKENPARTITION;
+  if (num_threads >= 2)
+    return VP8_TWO_TOKENPARTITION;
+  return VP8_ONE_TOKENPARTITION;
+}
+
 bool HasSufficientFeedback(
     const FeedbackSignalAccumulator<base::TimeDelta>& accumulator) {
   const base::TimeDelta amount_of_history =
@@ -71,13 +99,15 @@ Vp8Encoder::Vp8Encoder(const FrameSenderConfig& video_config)
               : (video_config.video_codec_params.number_of_encode_threads > 1
                      ? kMidTargetEncoderUtilization
                      : kLoTargetEncoderUtilization)),
+      tick_clock_(new base::DefaultTickClock()),
       key_frame_requested_(true),
       bitrate_kbit_(cast_config_.start_bitrate / 1000),
       next_frame_id_(FrameId::first()),
       has_seen_zero_length_encoded_frame_(false),
       encoding_speed_acc_(
           base::TimeDelta::FromMicroseconds(kEncodingSpeedAccHalfLife)),
-      encoding_speed_(kHighestEncodingSpeed) {
+      encoding_speed_(kHighestEncodingSpeed),
+      num_threads_(1) {
   config_.g_timebase.den = 0;  // Not initialized.
   DCHECK_LE(cast_config_.video_codec_params.min_qp,
             cast_config_.video_codec_params.max_cpu_saver_qp);
@@ -105,9 +135,14 @@ void Vp8Encoder::ConfigureForNewFrameSize(const gfx::Size& frame_size) {
     // Workaround for VP8 bug: If the new size is strictly less-than-or-equal to
     // the old size, in terms of area, the existing encoder instance can
     // continue.  Otherwise, completely tear-down and re-create a new encoder to
-    // avoid a shutdown crash.
-    if (frame_size.GetArea() <= gfx::Size(config_.g_w, config_.g_h).GetArea()) {
-      DVLOG(1) << "Continuing to use existing encoder at smaller frame size: "
+    // avoid a shutdown crash.  Sizes that fit within the one the encoder was
+    // created for are safe too; this lets senders that scale the video down
+    // and back up again do so without re-creating the encoder.
+    if (frame_size.GetArea() <=
+            gfx::Size(config_.g_w, config_.g_h).GetArea() ||
+        (frame_size.width() <= initial_frame_size_.width() &&
+         frame_size.height() <= initial_frame_size_.height())) {
+      DVLOG(1) << "Continuing to use existing encoder at new frame size: "
                << gfx::Size(config_.g_w, config_.g_h).ToString() << " --> "
                << frame_size.ToString();
       config_.g_w = frame_size.width();
@@ -115,7 +150,7 @@ void Vp8Encoder::ConfigureForNewFrameSize(const gfx::Size& frame_size) {
       config_.rc_min_quantizer = cast_config_.video_codec_params.min_qp;
       if (vpx_codec_enc_config_set(&encoder_, &config_) == VPX_CODEC_OK)
         return;
-      DVLOG(1) << "libvpx rejected the attempt to use a smaller frame size in "
+      DVLOG(1) << "libvpx rejected the attempt to use a new frame size in "
                   "the current instance.";
     }
 
@@ -132,9 +167,14 @@ void Vp8Encoder::ConfigureForNewFrameSize(const gfx::Size& frame_size) {
   CHECK_EQ(vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &config_, 0),
            VPX_CODEC_OK);
 
-  config_.g_threads = cast_config_.video_codec_params.number_of_encode_threads;
+  const int max_threads =
+      cast_config_.video_codec_params.number_of_encode_threads;
+  num_threads_ = std::max(num_threads_,
+                          GetInitialNumberOfThreads(frame_size, max_threads));
+  config_.g_threads = num_threads_;
   config_.g_w = frame_size.width();
   config_.g_h = frame_size.height();
+  initial_frame_size_ = frame_size;
   // Set the timebase to match that of base::TimeDelta.
   config_.g_timebase.num = 1;
   config_.g_timebase.den = base::Time::kMicrosecondsPerSecond;
@@ -175,6 +215,15 @@ void Vp8Encoder::ConfigureForNewFrameSize(const gfx::Size& frame_size) {
   CHECK_EQ(vpx_codec_control(&encoder_, VP8E_SET_STATIC_THRESHOLD, 1),
            VPX_CODEC_OK);
 
+  CHECK_EQ(vpx_codec_control(&encoder_, VP8E_SET_TOKEN_PARTITIONS,
+                             GetTokenPartitions(num_threads_)),
+           VPX_CODEC_OK);
+
+  if (cast_config_.video_codec_params.is_screen_content) {
+    CHECK_EQ(vpx_codec_control(&encoder_, VP8E_SET_SCREEN_CONTENT_MODE, 1),
+             VPX_CODEC_OK);
+  }
+
   // This cpu_used setting is a trade-off between cpu usage and encoded video
   // quality. The default is zero, with increasingly less CPU to be used as the
   // value is more negative or more positive. The encoder does some automatic
@@ -197,7 +246,7 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
   // Note: This is used to compute the |encoder_utilization| and so it uses the
   // real-world clock instead of the CastEnvironment clock, the latter of which
   // might be simulated.
-  const base::TimeTicks start_time = base::TimeTicks::Now();
+  const base::TimeTicks start_time = tick_clock_->NowTicks();
 
   // Initialize on-demand.  Later, if the video frame size has changed, update
   // the encoder configuration.
@@ -312,7 +361,8 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
 
   // Compute encoder utilization as the real-world time elapsed divided by the
   // frame duration.
-  const base::TimeDelta processing_time = base::TimeTicks::Now() - start_time;
+  const base::TimeDelta processing_time =
+      tick_clock_->NowTicks() - start_time;
   encoded_frame->encoder_utilization =
       processing_time.InSecondsF() / predicted_frame_duration.InSecondsF();
 
@@ -366,6 +416,22 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
     // When CPU is constrained, increase encoding speed and increase
     // |min_quantizer| if needed.
     double next_encoding_speed = encoding_speed_acc_.current();
+
+    // If even the highest encoding speed takes too long, spread the work over
+    // another thread before trading quality for CPU.  libvpx starts its
+    // threads when the encoder is created, so the next frame re-creates it,
+    // and is a key frame.
+    if (next_encoding_speed > kHighestEncodingSpeed &&
+        num_threads_ <
+            cast_config_.video_codec_params.number_of_encode_threads) {
+      ++num_threads_;
+      DVLOG(1) << "Re-creating encoder with " << num_threads_ << " threads.";
+      vpx_codec_destroy(&encoder_);
+      config_.g_timebase.den = 0;  // Not initialized.
+      key_frame_requested_ = true;
+      return;
+    }
+
     int next_min_qp;
     if (next_encoding_speed > kHighestEncodingSpeed) {
       double remainder = next_encoding_speed - kHighestEncodingSpeed;
@@ -395,14 +461,18 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
 void Vp8Encoder::UpdateRates(uint32_t new_bitrate) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
+  // Saved for when the encoder is next created, which may be for the first
+  // frame.
+  uint32_t new_bitrate_kbit = new_bitrate / 1000;
+  bitrate_kbit_ = new_bitrate_kbit;
+
   if (!is_initialized())
     return;
 
-  uint32_t new_bitrate_kbit = new_bitrate / 1000;
   if (config_.rc_target_bitrate == new_bitrate_kbit)
     return;
 
-  config_.rc_target_bitrate = bitrate_kbit_ = new_bitrate_kbit;
+  config_.rc_target_bitrate = new_bitrate_kbit;
 
   // Update encoder context.
   if (vpx_codec_enc_config_set(&encoder_, &config_)) {
@@ -417,5 +487,10 @@ void Vp8Encoder::GenerateKeyFrame() {
   key_frame_requested_ = true;
 }
 
+void Vp8Encoder::SetTickClockForTesting(
+    std::unique_ptr<base::TickClock> tick_clock) {
+  tick_clock_.swap(tick_clock);
+}
+
 }  // namespace cast
 }  // namespace media
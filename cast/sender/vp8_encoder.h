@@ -11,6 +11,7 @@
 
 #include "base/macros.h"
 #include "base/threading/thread_checker.h"
+#include "base/time/tick_clock.h"
 #include "media/base/feedback_signal_accumulator.h"
 #include "media/cast/cast_config.h"
 #include "media/cast/sender/software_video_encoder.h"
@@ -38,6 +39,11 @@ class Vp8Encoder : public SoftwareVideoEncoder {
   void UpdateRates(uint32_t new_bitrate) final;
   void GenerateKeyFrame() final;
 
+  // Replaces the clock used to measure how long encoding takes.
+  void SetTickClockForTesting(std::unique_ptr<base::TickClock> tick_clock);
+
+  int num_threads_for_testing() const { return num_threads_; }
+
  private:
   bool is_initialized() const {
     // ConfigureForNewFrameSize() sets the timebase denominator value to
@@ -55,11 +61,19 @@ class Vp8Encoder : public SoftwareVideoEncoder {
 
   const double target_encoder_utilization_;
 
+  // Measures the real-world time spent encoding, for |encoder_utilization|.
+  std::unique_ptr<base::TickClock> tick_clock_;
+
   // VP8 internal objects.  These are valid for use only while is_initialized()
   // returns true.
   vpx_codec_enc_cfg_t config_;
   vpx_codec_ctx_t encoder_;
 
+  // The frame size the |encoder_| instance was created for.  libvpx allocates
+  // its buffers for this size, so smaller frames can be encoded without
+  // re-creating the instance, even after a switch to a smaller size.
+  gfx::Size initial_frame_size_;
+
   // Set to true to request the next frame emitted by Vp8Encoder be a key frame.
   bool key_frame_requested_;
 
@@ -88,6 +102,10 @@ class Vp8Encoder : public SoftwareVideoEncoder {
   // The higher the speed, the less CPU usage, and the lower quality.
   int encoding_speed_;
 
+  // The number of threads the |encoder_| was created with.  This only grows,
+  // up to VideoCodecParams::number_of_encode_threads.
+  int num_threads_;
+
   DISALLOW_COPY_AND_ASSIGN(Vp8Encoder);
 };
 
@@ -0,0 +1,151 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/sender/vp8_encoder.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/time/tick_clock.h"
+#include "media/base/video_frame.h"
+#include "media/cast/sender/sender_encoded_frame.h"
+#include "media/cast/test/utility/default_config.h"
+#include "media/cast/test/utility/video_utility.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const int kFrameRate = 30;
+
+// Advances by |step| every time it is read, so that every frame appears to take
+// |step| to encode.
+class SteppingTickClock : public base::TickClock {
+ public:
+  explicit SteppingTickClock(base::TimeDelta step) : step_(step) {}
+  ~SteppingTickClock() override {}
+
+  base::TimeTicks NowTicks() override {
+    now_ += step_;
+    return now_;
+  }
+
+ private:
+  const base::TimeDelta step_;
+  base::TimeTicks now_;
+
+  DISALLOW_COPY_AND_ASSIGN(SteppingTickClock);
+};
+
+}  // namespace
+
+class Vp8EncoderTest : public ::testing::Test {
+ protected:
+  Vp8EncoderTest() : frame_size_(320, 240), num_frames_(0) {
+    config_ = GetDefaultVideoSenderConfig();
+    config_.max_frame_rate = kFrameRate;
+  }
+
+  void CreateEncoder() {
+    encoder_.reset(new Vp8Encoder(config_));
+    encoder_->Initialize();
+  }
+
+  // Encodes the next frame of a noisy 30 fps video into |encoded_frame|.
+  void EncodeFrame(SenderEncodedFrame* encoded_frame) {
+    const base::TimeDelta timestamp =
+        base::TimeDelta::FromSeconds(num_frames_++) / kFrameRate;
+    const scoped_refptr<VideoFrame> frame =
+        VideoFrame::CreateFrame(PIXEL_FORMAT_I420, frame_size_,
+                                gfx::Rect(frame_size_), frame_size_, timestamp);
+    PopulateVideoFrameWithNoise(frame.get());
+    encoder_->Encode(frame, base::TimeTicks() + timestamp, encoded_frame);
+  }
+
+  const gfx::Size frame_size_;
+  FrameSenderConfig config_;
+  std::unique_ptr<Vp8Encoder> encoder_;
+  int num_frames_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Vp8EncoderTest);
+};
+
+TEST_F(Vp8EncoderTest, AddsThreadsUpToTheLimitWhenEncodingIsSlow) {
+  config_.video_codec_params.number_of_encode_threads = 2;
+  CreateEncoder();
+  // Every frame takes three frame durations to encode, more than even the
+  // highest encoding speed can make up for.
+  encoder_->SetTickClockForTesting(base::MakeUnique<SteppingTickClock>(
+      base::TimeDelta::FromMilliseconds(100)));
+
+  std::vector<FrameId> key_frame_ids;
+  for (int i = 0; i < 2 * kFrameRate; ++i) {
+    SenderEncodedFrame encoded_frame;
+    EncodeFrame(&encoded_frame);
+    ASSERT_FALSE(encoded_frame.data.empty());
+    if (encoded_frame.dependency == EncodedFrame::KEY) {
+      EXPECT_EQ(encoded_frame.frame_id, encoded_frame.referenced_frame_id);
+      key_frame_ids.push_back(encoded_frame.frame_id);
+    }
+  }
+
+  // Small frames start out with one thread.  Once the encoder has seen enough
+  // slow frames it is re-created with a second one, and the frame after that is
+  // a key frame.  It isn't re-created again, since that's as many threads as
+  // allowed.
+  EXPECT_EQ(2, encoder_->num_threads_for_testing());
+  ASSERT_EQ(2u, key_frame_ids.size());
+  EXPECT_EQ(FrameId::first(), key_frame_ids[0]);
+  EXPECT_LT(FrameId::first() + 1, key_frame_ids[1]);
+}
+
+TEST_F(Vp8EncoderTest, KeepsOneThreadWhenEncodingIsFast) {
+  config_.video_codec_params.number_of_encode_threads = 2;
+  CreateEncoder();
+  encoder_->SetTickClockForTesting(base::MakeUnique<SteppingTickClock>(
+      base::TimeDelta::FromMilliseconds(1)));
+
+  for (int i = 0; i < 2 * kFrameRate; ++i) {
+    SenderEncodedFrame encoded_frame;
+    EncodeFrame(&encoded_frame);
+    EXPECT_EQ(i == 0 ? EncodedFrame::KEY : EncodedFrame::DEPENDENT,
+              encoded_frame.dependency);
+  }
+  EXPECT_EQ(1, encoder_->num_threads_for_testing());
+}
+
+TEST_F(Vp8EncoderTest, UsesBitrateSetBeforeTheFirstFrame) {
+  config_.start_bitrate = 2000000;
+  CreateEncoder();
+  size_t start_bitrate_bytes = 0;
+  for (int i = 0; i < kFrameRate; ++i) {
+    SenderEncodedFrame encoded_frame;
+    EncodeFrame(&encoded_frame);
+    start_bitrate_bytes += encoded_frame.data.size();
+  }
+
+  // The encoder is only created for the first frame, but must still use a
+  // bitrate set before then.
+  num_frames_ = 0;
+  CreateEncoder();
+  encoder_->UpdateRates(200000);
+  size_t updated_bitrate_bytes = 0;
+  for (int i = 0; i < kFrameRate; ++i) {
+    SenderEncodedFrame encoded_frame;
+    EncodeFrame(&encoded_frame);
+    updated_bitrate_bytes += encoded_frame.data.size();
+  }
+  EXPECT_LT(updated_bitrate_bytes * 4, start_bitrate_bytes);
+}
+
+}  // namespace cast
+}  // namespace media
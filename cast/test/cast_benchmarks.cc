@@ -14,6 +14,12 @@
 // represent bandwidth (in megabits) the blue axis will be packet drop
 // (in percent) and the green axis will be latency (in milliseconds).
 //
+// With --udp-loopback, it instead measures how fast UdpTransport (and on Linux,
+// BatchedUdpTransport) can send bursts of packets to itself over loopback.
+// With --framer, it measures how fast the receiver reassembles frames.
+// With --vp8, it measures how fast the software VP8 encoder encodes frames of
+// a few sizes, with one thread and with the encoder choosing its threads.
+//
 // This program can also be used for profiling. On linux it has
 // built-in support for this. Simply set the environment variable
 // PROFILE_FILE before running it, like so:
@@ -25,7 +31,9 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -36,6 +44,7 @@
 #include "base/debug/profiler.h"
 #include "base/memory/ptr_util.h"
 #include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "base/stl_util.h"
@@ -43,7 +52,9 @@
 #include "base/strings/stringprintf.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "base/time/tick_clock.h"
+#include "build/build_config.h"
 #include "media/base/audio_bus.h"
 #include "media/base/fake_single_thread_task_runner.h"
 #include "media/base/video_frame.h"
@@ -51,21 +62,32 @@
 #include "media/cast/cast_environment.h"
 #include "media/cast/cast_receiver.h"
 #include "media/cast/cast_sender.h"
+#include "media/cast/constants.h"
 #include "media/cast/logging/simple_event_subscriber.h"
 #include "media/cast/net/cast_transport.h"
 #include "media/cast/net/cast_transport_config.h"
 #include "media/cast/net/cast_transport_defines.h"
 #include "media/cast/net/cast_transport_impl.h"
+#include "media/cast/net/rtp/framer.h"
+#include "media/cast/net/udp_transport.h"
+#include "media/cast/sender/sender_encoded_frame.h"
+#include "media/cast/sender/vp8_encoder.h"
 #include "media/cast/test/loopback_transport.h"
 #include "media/cast/test/skewed_single_thread_task_runner.h"
 #include "media/cast/test/skewed_tick_clock.h"
 #include "media/cast/test/utility/audio_utility.h"
 #include "media/cast/test/utility/default_config.h"
+#include "media/cast/test/utility/net_utility.h"
 #include "media/cast/test/utility/test_util.h"
 #include "media/cast/test/utility/udp_proxy.h"
 #include "media/cast/test/utility/video_utility.h"
+#include "net/base/ip_address.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+#if defined(OS_LINUX)
+#include "media/cast/net/batched_udp_transport_linux.h"
+#endif
+
 namespace media {
 namespace cast {
 
@@ -164,6 +186,10 @@ class CastTransportWrapper : public CastTransport {
     transport_->AddPli(pli_message);
   }
 
+  void AddTransportFeedback(const RtcpTransportFeedback& feedback) final {
+    transport_->AddTransportFeedback(feedback);
+  }
+
   void SendRtcpFromRtpReceiver() final {
     transport_->SendRtcpFromRtpReceiver();
   }
@@ -714,12 +740,258 @@ class CastBenchmark {
   base::Lock lock_;
 };
 
+// Sends bursts of full-size packets from one transport to another over
+// loopback, one burst per task as PacedSender would, and reports the time spent
+// sending and the rate at which packets arrive.
+class UdpLoopbackBenchmark {
+ public:
+  UdpLoopbackBenchmark()
+      : packets_sent_(0), packets_received_(0), weak_factory_(this) {}
+
+  void Run(const std::string& name,
+           PacketTransport* sender,
+           PacketTransport* receiver) {
+    receiver->StartReceiving(base::Bind(&UdpLoopbackBenchmark::OnPacket,
+                                        base::Unretained(this)));
+    sender->StartReceiving(PacketReceiverCallbackWithStatus());
+    sender_ = sender;
+
+    start_time_ = base::TimeTicks::Now();
+    SendNextBurst();
+    base::RunLoop().Run();
+    receiver->StopReceiving();
+
+    fprintf(stdout,
+            "%s: %.2f us per burst of %d sent, %.0f packets/s received "
+            "(%.1f%% of %d)\n",
+            name.c_str(),
+            send_time_.InMicrosecondsF() * kBurstSize / kNumPackets,
+            kBurstSize,
+            packets_received_ /
+                (last_receive_time_ - start_time_).InSecondsF(),
+            100.0 * packets_received_ / kNumPackets, kNumPackets);
+    fflush(stdout);
+  }
+
+ private:
+  static const int kNumPackets = 100000;
+  static const int kBurstSize = 20;
+
+  void SendNextBurst() {
+    PacketList burst;
+    for (int i = 0; i < kBurstSize && packets_sent_ < kNumPackets; ++i) {
+      burst.push_back(new base::RefCountedData<Packet>(
+          Packet(kMaxIpPacketSize, static_cast<uint8_t>(packets_sent_))));
+      ++packets_sent_;
+    }
+
+    const base::Closure next_burst = base::Bind(
+        &UdpLoopbackBenchmark::SendNextBurst, weak_factory_.GetWeakPtr());
+    const base::TimeTicks send_start = base::TimeTicks::Now();
+    size_t num_sent = 0;
+    const bool blocked = !sender_->SendPackets(burst, next_burst, &num_sent);
+    send_time_ += base::TimeTicks::Now() - send_start;
+    packets_sent_ -= burst.size() - num_sent;
+    if (blocked)
+      return;
+
+    // Let the receiver drain its socket between bursts, and give it a moment
+    // to catch up at the end.
+    if (packets_sent_ < kNumPackets) {
+      base::ThreadTaskRunnerHandle::Get()->PostTask(FROM_HERE, next_burst);
+    } else {
+      base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+          FROM_HERE, base::MessageLoop::QuitWhenIdleClosure(),
+          base::TimeDelta::FromMilliseconds(200));
+    }
+  }
+
+  bool OnPacket(std::unique_ptr<Packet> packet) {
+    ++packets_received_;
+    last_receive_time_ = base::TimeTicks::Now();
+    return true;
+  }
+
+  PacketTransport* sender_;
+  int packets_sent_;
+  int packets_received_;
+  base::TimeTicks start_time_;
+  base::TimeTicks last_receive_time_;
+  base::TimeDelta send_time_;
+  base::WeakPtrFactory<UdpLoopbackBenchmark> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpLoopbackBenchmark);
+};
+
+void RunUdpLoopbackBenchmarks() {
+  base::MessageLoopForIO message_loop;
+  const net::IPEndPoint any_addr(net::IPAddress::IPv4AllZeros(), 0);
+  {
+    const net::IPEndPoint send_addr = test::GetFreeLocalPort();
+    const net::IPEndPoint recv_addr = test::GetFreeLocalPort();
+    UdpTransport sender(nullptr, message_loop.task_runner(), send_addr,
+                        recv_addr, CastTransportStatusCallback());
+    UdpTransport receiver(nullptr, message_loop.task_runner(), recv_addr,
+                          any_addr, CastTransportStatusCallback());
+    UdpLoopbackBenchmark().Run("UdpTransport", &sender, &receiver);
+  }
+#if defined(OS_LINUX)
+  {
+    const net::IPEndPoint send_addr = test::GetFreeLocalPort();
+    const net::IPEndPoint recv_addr = test::GetFreeLocalPort();
+    BatchedUdpTransport sender(message_loop.task_runner(), send_addr,
+                               recv_addr, CastTransportStatusCallback());
+    BatchedUdpTransport receiver(message_loop.task_runner(), recv_addr,
+                                 any_addr, CastTransportStatusCallback());
+    UdpLoopbackBenchmark().Run("BatchedUdpTransport", &sender, &receiver);
+  }
+#endif
+}
+
+class NullRtpPayloadFeedback : public RtpPayloadFeedback {
+ public:
+  void CastFeedback(const RtcpCastMessage& cast_feedback) final {}
+};
+
+// Feeds the packets of a stream of video frames through a Framer, with one
+// packet in ten arriving after the rest of its frame, and reports how many
+// packets per second are reassembled into frames.
+void RunFramerBenchmark(bool zero_copy) {
+  const int kNumFrames = 5000;
+  const int kPacketsPerFrame = 40;
+  const size_t kPayloadSize = 1400;
+
+  base::SimpleTestTickClock clock;
+  NullRtpPayloadFeedback feedback;
+  Framer framer(&clock, &feedback, 1, true, kMaxUnackedFrames);
+  const std::vector<uint8_t> payload(kPayloadSize, 0x5a);
+  RtpCastHeader header;
+  header.max_packet_id = kPacketsPerFrame - 1;
+  EncodedFrame frame;
+  bool duplicate = false;
+  bool next_frame = false;
+  bool multiple = false;
+  size_t bytes = 0;
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumFrames; ++i) {
+    header.frame_id = FrameId::first() + i;
+    header.reference_frame_id = FrameId::first() + std::max(i - 1, 0);
+    header.is_key_frame = i == 0;
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int packet = 0; packet < kPacketsPerFrame; ++packet) {
+        if ((packet % 10 == 3) != (pass == 1))
+          continue;
+        header.packet_id = packet;
+        framer.InsertPacket(&payload[0], payload.size(), header, &duplicate);
+      }
+    }
+
+    const bool have_frame =
+        zero_copy ? framer.PeekEncodedFrame(&frame, &next_frame, &multiple) &&
+                        framer.TakeFrameData(frame.frame_id, &frame.data)
+                  : framer.GetEncodedFrame(&frame, &next_frame, &multiple);
+    CHECK(have_frame);
+    bytes += frame.data.size();
+    framer.ReleaseFrame(frame.frame_id);
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  CHECK_EQ(static_cast<size_t>(kNumFrames) * kPacketsPerFrame * kPayloadSize,
+           bytes);
+
+  fprintf(stdout, "Framer (%s): %.0f packets/s\n",
+          zero_copy ? "PeekEncodedFrame + TakeFrameData" : "GetEncodedFrame",
+          kNumFrames * kPacketsPerFrame / elapsed.InSecondsF());
+  fflush(stdout);
+}
+
+// Encodes a 30 fps stream of |frame_size| frames with the software VP8
+// encoder as fast as it can, and reports the frames encoded per second and the
+// time taken to encode each frame.  Screen content changes only every tenth
+// frame.
+void RunVp8EncoderBenchmark(const gfx::Size& frame_size,
+                            int max_threads,
+                            bool is_screen_content) {
+  const int kNumFrames = 300;
+  const int kNumSourceFrames = 10;
+
+  FrameSenderConfig video_config = GetDefaultVideoSenderConfig();
+  video_config.max_frame_rate = 30;
+  video_config.video_codec_params.number_of_encode_threads = max_threads;
+  video_config.video_codec_params.is_screen_content = is_screen_content;
+  Vp8Encoder encoder(video_config);
+  encoder.Initialize();
+  encoder.UpdateRates(video_config.max_bitrate);
+
+  std::vector<scoped_refptr<VideoFrame>> source_frames;
+  for (int i = 0; i < kNumSourceFrames; ++i) {
+    source_frames.push_back(VideoFrame::CreateFrame(
+        PIXEL_FORMAT_I420, frame_size, gfx::Rect(frame_size), frame_size,
+        base::TimeDelta()));
+    PopulateVideoFrame(source_frames.back().get(), i * 7);
+  }
+
+  std::vector<base::TimeDelta> latencies;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumFrames; ++i) {
+    const scoped_refptr<VideoFrame>& frame =
+        source_frames[(is_screen_content ? i / 10 : i) % kNumSourceFrames];
+    const base::TimeDelta timestamp =
+        base::TimeDelta::FromMicroseconds(i * INT64_C(33333));
+    frame->set_timestamp(timestamp);
+    SenderEncodedFrame encoded_frame;
+    const base::TimeTicks encode_start = base::TimeTicks::Now();
+    encoder.Encode(frame, start + timestamp, &encoded_frame);
+    latencies.push_back(base::TimeTicks::Now() - encode_start);
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::sort(latencies.begin(), latencies.end());
+  base::TimeDelta total_latency;
+  for (const base::TimeDelta& latency : latencies)
+    total_latency += latency;
+  fprintf(stdout,
+          "VP8 %s %s, up to %d threads: %.1f frames/s, encode time "
+          "mean %.2f ms, 95th percentile %.2f ms, max %.2f ms\n",
+          frame_size.ToString().c_str(),
+          is_screen_content ? "screen" : "video", max_threads,
+          kNumFrames / elapsed.InSecondsF(),
+          total_latency.InMillisecondsF() / kNumFrames,
+          latencies[kNumFrames * 95 / 100].InMillisecondsF(),
+          latencies.back().InMillisecondsF());
+  fflush(stdout);
+}
+
+void RunVp8EncoderBenchmarks() {
+  const gfx::Size kFrameSizes[] = {gfx::Size(640, 360), gfx::Size(1280, 720),
+                                   gfx::Size(1920, 1080)};
+  for (const gfx::Size& frame_size : kFrameSizes) {
+    for (int max_threads : {1, 4}) {
+      RunVp8EncoderBenchmark(frame_size, max_threads, false);
+      RunVp8EncoderBenchmark(frame_size, max_threads, true);
+    }
+  }
+}
+
 }  // namespace cast
 }  // namespace media
 
 int main(int argc, char** argv) {
   base::AtExitManager at_exit;
   base::CommandLine::Init(argc, argv);
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch("udp-loopback")) {
+    media::cast::RunUdpLoopbackBenchmarks();
+    return 0;
+  }
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch("framer")) {
+    media::cast::RunFramerBenchmark(false);
+    media::cast::RunFramerBenchmark(true);
+    return 0;
+  }
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch("vp8")) {
+    media::cast::RunVp8EncoderBenchmarks();
+    return 0;
+  }
   media::cast::CastBenchmark benchmark;
   if (getenv("PROFILE_FILE")) {
     std::string profile_file(getenv("PROFILE_FILE"));
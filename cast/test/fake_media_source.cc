@@ -243,7 +243,8 @@ void FakeMediaSource::Start(scoped_refptr<AudioFrameInput> audio_frame_input,
   }
 
   // Send transcoding streams.
-  audio_algo_.Initialize(source_audio_params_);
+  audio_algo_.Initialize(source_audio_params_,
+                         AudioRendererAlgorithm::Quality::kNormal);
   audio_algo_.FlushBuffers();
   audio_fifo_input_bus_ = AudioBus::Create(
       source_audio_params_.channels(),
@@ -29,6 +29,22 @@
 //   File path to write YUV decoded frames in YUV4MPEG2 format.
 // --no-simulation
 //   Do not run network simulation.
+// --packet-loss=
+//   Percentage of the packets sent to the receiver to drop at random, on top of
+//   the network simulation.  Optional; default is 0.
+// --fec
+//   Send FEC packets with audio and video frames.
+// --congestion-control=
+//   How the video sender chooses its bitrate: "adaptive" or "delay" (see
+//   NewDelayBasedCongestionControl()).  Optional; default is "adaptive".
+// --min-video-bitrate=
+// --max-video-bitrate=
+//   The range of video bitrates, in kbps, for the congestion control to choose
+//   from.  Optional; defaults are 2000 and 2500.
+// --quality-scaling
+//   Let the video sender lower the resolution and frame rate it encodes at
+//   when the encoder or the network cannot keep up.  Decoded frames are scaled
+//   back up to the source size for the quality metrics.
 //
 // Output:
 // - Raw event log of the simulation session tagged with the unique test ID,
@@ -84,6 +100,7 @@
 #include "media/cast/test/utility/test_util.h"
 #include "media/cast/test/utility/udp_proxy.h"
 #include "media/cast/test/utility/video_utility.h"
+#include "third_party/libyuv/include/libyuv/scale.h"
 
 using media::cast::proto::IPPModel;
 using media::cast::proto::NetworkSimulationModel;
@@ -92,12 +109,18 @@ using media::cast::proto::NetworkSimulationModelType;
 namespace media {
 namespace cast {
 namespace {
+const char kCongestionControl[] = "congestion-control";
+const char kEnableFec[] = "fec";
 const char kLibDir[] = "lib-dir";
 const char kModelPath[] = "model";
 const char kMetricsOutputPath[] = "metrics-output";
 const char kOutputPath[] = "output";
 const char kMaxFrameRate[] = "max-frame-rate";
+const char kMaxVideoBitrate[] = "max-video-bitrate";
+const char kMinVideoBitrate[] = "min-video-bitrate";
 const char kNoSimulation[] = "no-simulation";
+const char kPacketLoss[] = "packet-loss";
+const char kQualityScaling[] = "quality-scaling";
 const char kRunTime[] = "run-time";
 const char kSimulationId[] = "sim-id";
 const char kSourcePath[] = "source";
@@ -240,11 +263,40 @@ void AppendYuvToFile(const base::FilePath& path,
           frame->rows(media::VideoFrame::kVPlane));
 }
 
+// Returns a copy of the I420 |video_frame|, scaled to |visible_rect|.
+scoped_refptr<media::VideoFrame> ScaleVideoFrame(
+    const scoped_refptr<media::VideoFrame>& video_frame,
+    const gfx::Rect& visible_rect) {
+  const scoped_refptr<media::VideoFrame> scaled_frame =
+      media::VideoFrame::CreateFrame(
+          media::PIXEL_FORMAT_I420, visible_rect.size(), visible_rect,
+          visible_rect.size(), video_frame->timestamp());
+  libyuv::I420Scale(
+      video_frame->visible_data(media::VideoFrame::kYPlane),
+      video_frame->stride(media::VideoFrame::kYPlane),
+      video_frame->visible_data(media::VideoFrame::kUPlane),
+      video_frame->stride(media::VideoFrame::kUPlane),
+      video_frame->visible_data(media::VideoFrame::kVPlane),
+      video_frame->stride(media::VideoFrame::kVPlane),
+      video_frame->visible_rect().width(), video_frame->visible_rect().height(),
+      scaled_frame->visible_data(media::VideoFrame::kYPlane),
+      scaled_frame->stride(media::VideoFrame::kYPlane),
+      scaled_frame->visible_data(media::VideoFrame::kUPlane),
+      scaled_frame->stride(media::VideoFrame::kUPlane),
+      scaled_frame->visible_data(media::VideoFrame::kVPlane),
+      scaled_frame->stride(media::VideoFrame::kVPlane), visible_rect.width(),
+      visible_rect.height(), libyuv::kFilterBox);
+  return scaled_frame;
+}
+
 // A container to save output of GotVideoFrame() for computation based
 // on output frames.
 struct GotVideoFrameOutput {
-  GotVideoFrameOutput() : counter(0) {}
+  GotVideoFrameOutput() : counter(0), total_width(0), total_height(0) {}
   int counter;
+  // The sums of the decoded frames' dimensions, before any scaling.
+  int64_t total_width;
+  int64_t total_height;
   std::vector<double> psnr;
   std::vector<double> ssim;
 };
@@ -258,6 +310,8 @@ void GotVideoFrame(
     const base::TimeTicks& render_time,
     bool continuous) {
   ++metrics_output->counter;
+  metrics_output->total_width += video_frame->visible_rect().width();
+  metrics_output->total_height += video_frame->visible_rect().height();
   cast_receiver->RequestDecodedVideoFrame(
       base::Bind(&GotVideoFrame, metrics_output, yuv_output,
                  video_frame_tracker, cast_receiver));
@@ -267,8 +321,13 @@ void GotVideoFrame(
   if (video_frame_tracker) {
     scoped_refptr<media::VideoFrame> src_frame =
         video_frame_tracker->PopOldestEncodedFrame();
-    metrics_output->psnr.push_back(I420PSNR(src_frame, video_frame));
-    metrics_output->ssim.push_back(I420SSIM(src_frame, video_frame));
+    // Frames encoded at a lower resolution are compared with the source the
+    // way a receiver would display them: scaled back up.
+    scoped_refptr<media::VideoFrame> output_frame = video_frame;
+    if (src_frame->visible_rect().size() != video_frame->visible_rect().size())
+      output_frame = ScaleVideoFrame(video_frame, src_frame->visible_rect());
+    metrics_output->psnr.push_back(I420PSNR(src_frame, output_frame));
+    metrics_output->ssim.push_back(I420SSIM(src_frame, output_frame));
   }
 
   if (!yuv_output.empty()) {
@@ -369,19 +428,43 @@ void RunSimulation(const base::FilePath& source_path,
 
   // Video sender config.
   FrameSenderConfig video_sender_config = GetDefaultVideoSenderConfig();
-  video_sender_config.max_bitrate = 2500000;
-  video_sender_config.min_bitrate = 2000000;
-  video_sender_config.start_bitrate = 2000000;
+  video_sender_config.max_bitrate =
+      GetIntegerSwitchValue(kMaxVideoBitrate, 2500) * 1000;
+  video_sender_config.min_bitrate =
+      GetIntegerSwitchValue(kMinVideoBitrate, 2000) * 1000;
+  CHECK_LE(video_sender_config.min_bitrate, video_sender_config.max_bitrate);
+  video_sender_config.start_bitrate = video_sender_config.min_bitrate;
   video_sender_config.min_playout_delay =
       video_sender_config.max_playout_delay =
           audio_sender_config.max_playout_delay;
   video_sender_config.max_frame_rate = GetIntegerSwitchValue(kMaxFrameRate, 30);
 
+  audio_sender_config.enable_fec = video_sender_config.enable_fec =
+      base::CommandLine::ForCurrentProcess()->HasSwitch(kEnableFec);
+
+  video_sender_config.enable_quality_scaling =
+      base::CommandLine::ForCurrentProcess()->HasSwitch(kQualityScaling);
+
+  const std::string congestion_control =
+      base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+          kCongestionControl);
+  if (congestion_control == "delay") {
+    video_sender_config.congestion_control = CONGESTION_CONTROL_DELAY_BASED;
+  } else {
+    LOG_IF(FATAL, !congestion_control.empty() &&
+                      congestion_control != "adaptive")
+        << "Unknown congestion control: " << congestion_control;
+  }
+
   // Video receiver config.
   FrameReceiverConfig video_receiver_config =
       GetDefaultVideoReceiverConfig();
   video_receiver_config.rtp_max_delay_ms =
       video_sender_config.max_playout_delay.InMilliseconds();
+  // Delay-based congestion control works best with the arrival time of every
+  // packet.
+  if (video_sender_config.congestion_control == CONGESTION_CONTROL_DELAY_BASED)
+    video_receiver_config.transport_feedback_interval_ms = 50;
 
   // Loopback transport. Owned by CastTransport.
   LoopBackTransport* receiver_to_sender = new LoopBackTransport(receiver_env);
@@ -408,6 +491,14 @@ void RunSimulation(const base::FilePath& source_path,
   std::unique_ptr<CastSender> cast_sender(
       CastSender::Create(sender_env, transport_sender.get()));
 
+  // Random packet loss, which FEC and retransmission have to recover from.
+  const int packet_loss_percent = GetIntegerSwitchValue(kPacketLoss, 0);
+  std::unique_ptr<test::PacketPipe> packet_loss;
+  if (packet_loss_percent > 0) {
+    LOG(INFO) << "Dropping " << packet_loss_percent << "% of packets.";
+    packet_loss = test::NewRandomDrop(packet_loss_percent / 100.0);
+  }
+
   // Initialize network simulation model.
   const bool use_network_simulation =
       model.type() == media::cast::proto::INTERRUPTED_POISSON_PROCESS;
@@ -425,8 +516,12 @@ void RunSimulation(const base::FilePath& source_path,
     receiver_to_sender->Initialize(ipp->NewBuffer(128 * 1024),
                                    transport_sender->PacketReceiverForTesting(),
                                    task_runner, &testing_clock);
+    std::unique_ptr<test::PacketPipe> sender_to_receiver_pipe =
+        ipp->NewBuffer(128 * 1024);
+    if (packet_loss)
+      sender_to_receiver_pipe->AppendToPipe(std::move(packet_loss));
     sender_to_receiver->Initialize(
-        ipp->NewBuffer(128 * 1024),
+        std::move(sender_to_receiver_pipe),
         transport_receiver->PacketReceiverForTesting(), task_runner,
         &testing_clock);
   } else {
@@ -435,7 +530,7 @@ void RunSimulation(const base::FilePath& source_path,
                                    transport_sender->PacketReceiverForTesting(),
                                    task_runner, &testing_clock);
     sender_to_receiver->Initialize(
-        std::unique_ptr<test::PacketPipe>(),
+        std::move(packet_loss),
         transport_receiver->PacketReceiverForTesting(), task_runner,
         &testing_clock);
   }
@@ -586,6 +681,14 @@ void RunSimulation(const base::FilePath& source_path,
             << " ms)";
   LOG(INFO) << "Average encoded bitrate (kbps): " << avg_encoded_bitrate;
   LOG(INFO) << "Average target bitrate (kbps): " << avg_target_bitrate;
+  LOG(INFO) << "Encoded video frame rate (fps): "
+            << (elapsed_time <= base::TimeDelta() ? 0 :
+                    encoded_video_frames / elapsed_time.InSecondsF());
+  if (metrics_output.counter > 0) {
+    LOG(INFO) << "Average decoded frame size: "
+              << metrics_output.total_width / metrics_output.counter << "x"
+              << metrics_output.total_height / metrics_output.counter;
+  }
   LOG(INFO) << "Writing log: " << log_output_path.value();
 
   // Truncate file and then write serialized log.
@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+// MSVC++ requires this to be set before any other includes to get M_PI.
+#define _USE_MATH_DEFINES
+
 #include "media/filters/audio_renderer_algorithm.h"
 
 #include <algorithm>
@@ -43,6 +46,21 @@ namespace media {
 //    |search_block_center_offset_| = |output_index_| * |playback_rate|, and
 //    |search_block_index_| = |search_block_center_offset_| -
 //        |search_block_center_offset_|.
+//
+// Quality::kLow and Quality::kHigh search a single candidate block, i.e. they
+// skip steps 3) and 4) and use the block centered at |output_index_| *
+// |playback_rate|. Quality::kHigh additionally replaces the block by its phase
+// vocoded version before step 5):
+//
+// a) Transform the Hann windowed block of every channel.
+//
+// b) For every frequency bin, estimate the instantaneous frequency of the sum
+//    of all channels from its phase advance since the previous block, and
+//    advance the synthesis phase by that frequency times |ola_hop_size_|.
+//
+// c) Rotate the bin of every channel by the same synthesis phase correction,
+//    which keeps phase differences between channels intact, then transform
+//    back and window again for overlap-and-add with 75% overlap.
 
 // Max/min supported playback rates for fast/slow audio. Audio outside of these
 // ranges are muted.
@@ -50,9 +68,21 @@ namespace media {
 static const double kMinPlaybackRate = 0.5;
 static const double kMaxPlaybackRate = 4.0;
 
+// The phase vocoder stretches slow playback without the audible repetition of
+// the time domain methods.
+static const double kMinPhaseVocoderPlaybackRate = 0.25;
+
 // Overlap-and-add window size in milliseconds.
 static const int kOlaWindowSizeMs = 20;
 
+// Overlap-and-add window size of Quality::kLow in milliseconds. Without a
+// search, shorter windows limit the smearing of transients.
+static const int kLowQualityOlaWindowSizeMs = 10;
+
+// Minimum window size of Quality::kHigh in milliseconds, rounded up to a power
+// of two frames for the FFT. Longer windows resolve harmonics more accurately.
+static const int kPhaseVocoderWindowSizeMs = 40;
+
 // Size of search interval in milliseconds. The search interval is
 // [-delta delta] around |output_index_| * |playback_rate|. So the search
 // interval is 2 * delta.
@@ -65,7 +95,10 @@ static const int kMaxCapacityInSeconds = 3;
 static const int kStartingCapacityInMs = 200;
 
 AudioRendererAlgorithm::AudioRendererAlgorithm()
-    : channels_(0),
+    : quality_(Quality::kNormal),
+      min_playback_rate_(kMinPlaybackRate),
+      max_playback_rate_(kMaxPlaybackRate),
+      channels_(0),
       samples_per_second_(0),
       muted_partial_frame_(0),
       capacity_(0),
@@ -77,14 +110,24 @@ AudioRendererAlgorithm::AudioRendererAlgorithm()
       ola_window_size_(0),
       ola_hop_size_(0),
       num_complete_frames_(0),
+      last_analysis_index_(0),
+      phase_vocoder_primed_(false),
       initial_capacity_(0),
       max_capacity_(0) {}
 
 AudioRendererAlgorithm::~AudioRendererAlgorithm() {}
 
-void AudioRendererAlgorithm::Initialize(const AudioParameters& params) {
+void AudioRendererAlgorithm::Initialize(const AudioParameters& params,
+                                        Quality quality) {
   CHECK(params.IsValid());
 
+  quality_ = quality;
+  min_playback_rate_ = quality_ == Quality::kHigh
+                           ? kMinPhaseVocoderPlaybackRate
+                           : kMinPlaybackRate;
+  max_playback_rate_ = kMaxPlaybackRate;
+  time_stretch_duration_ = base::TimeDelta();
+
   channels_ = params.channels();
   samples_per_second_ = params.sample_rate();
   initial_capacity_ = capacity_ =
@@ -92,12 +135,29 @@ void AudioRendererAlgorithm::Initialize(const AudioParameters& params) {
                ConvertMillisecondsToFrames(kStartingCapacityInMs));
   max_capacity_ =
       std::max(initial_capacity_, kMaxCapacityInSeconds * samples_per_second_);
-  num_candidate_blocks_ = ConvertMillisecondsToFrames(kWsolaSearchIntervalMs);
-  ola_window_size_ = ConvertMillisecondsToFrames(kOlaWindowSizeMs);
+  switch (quality_) {
+    case Quality::kLow:
+      num_candidate_blocks_ = 1;
+      ola_window_size_ =
+          ConvertMillisecondsToFrames(kLowQualityOlaWindowSizeMs);
+      break;
+    case Quality::kNormal:
+      num_candidate_blocks_ =
+          ConvertMillisecondsToFrames(kWsolaSearchIntervalMs);
+      ola_window_size_ = ConvertMillisecondsToFrames(kOlaWindowSizeMs);
+      break;
+    case Quality::kHigh:
+      num_candidate_blocks_ = 1;
+      ola_window_size_ = internal::GetFftSize(
+          ConvertMillisecondsToFrames(kPhaseVocoderWindowSizeMs));
+      break;
+  }
 
   // Make sure window size in an even number.
   ola_window_size_ += ola_window_size_ & 1;
-  ola_hop_size_ = ola_window_size_ / 2;
+
+  // The phase vocoder overlaps four windows, the time domain methods two.
+  ola_hop_size_ = ola_window_size_ / (quality_ == Quality::kHigh ? 4 : 2);
 
   // |num_candidate_blocks_| / 2 is the offset of the center of the search
   // block to the center of the first (left most) candidate block. The offset
@@ -137,6 +197,32 @@ void AudioRendererAlgorithm::Initialize(const AudioParameters& params) {
   search_block_ = AudioBus::Create(
       channels_, num_candidate_blocks_ + (ola_window_size_ - 1));
   target_block_ = AudioBus::Create(channels_, ola_window_size_);
+  search_fft_state_.reset(new internal::FftCorrelationState(
+      internal::GetFftSize(search_block_->frames())));
+
+  if (quality_ == Quality::kHigh) {
+    const int fft_size = ola_window_size_;
+    fft_cos_table_.reset(new float[fft_size / 2]);
+    fft_sin_table_.reset(new float[fft_size / 2]);
+    internal::GetFftTwiddleFactors(fft_size, fft_cos_table_.get(),
+                                   fft_sin_table_.get());
+
+    // Four squared Hann windows overlapping by 75% add up to 1.5.
+    vocoder_window_.reset(new float[fft_size]);
+    internal::GetSymmetricHanningWindow(fft_size, vocoder_window_.get());
+    const float window_scale = std::sqrt(1.0f / 1.5f);
+    for (int n = 0; n < fft_size; ++n)
+      vocoder_window_[n] *= window_scale;
+
+    spectrum_real_.reset(new float[channels_ * fft_size]);
+    spectrum_imag_.reset(new float[channels_ * fft_size]);
+    analysis_phase_.reset(new float[fft_size / 2 + 1]);
+    synthesis_phase_.reset(new float[fft_size / 2 + 1]);
+    bin_magnitude_.reset(new float[fft_size / 2 + 1]);
+    bin_phase_.reset(new float[fft_size / 2 + 1]);
+    spectral_peaks_.reserve(fft_size / 2 + 1);
+  }
+  phase_vocoder_primed_ = false;
 }
 
 int AudioRendererAlgorithm::FillBuffer(AudioBus* dest,
@@ -151,7 +237,11 @@ int AudioRendererAlgorithm::FillBuffer(AudioBus* dest,
 
   // Optimize the muted case to issue a single clear instead of performing
   // the full crossfade and clearing each crossfaded frame.
-  if (playback_rate < kMinPlaybackRate || playback_rate > kMaxPlaybackRate) {
+  if (playback_rate < min_playback_rate_ ||
+      playback_rate > max_playback_rate_) {
+    // Skipping input breaks phase continuity.
+    phase_vocoder_primed_ = false;
+
     int frames_to_render =
         std::min(static_cast<int>(audio_buffer_.frames() / playback_rate),
                  requested_frames);
@@ -183,6 +273,7 @@ int AudioRendererAlgorithm::FillBuffer(AudioBus* dest,
   // Optimize the most common |playback_rate| ~= 1 case to use a single copy
   // instead of copying frame by frame.
   if (ola_window_size_ <= faster_step && slower_step >= ola_window_size_) {
+    phase_vocoder_primed_ = false;
     const int frames_to_copy =
         std::min(audio_buffer_.frames(), requested_frames);
     const int frames_read =
@@ -191,6 +282,7 @@ int AudioRendererAlgorithm::FillBuffer(AudioBus* dest,
     return frames_read;
   }
 
+  const base::TimeTicks start = base::TimeTicks::Now();
   int rendered_frames = 0;
   do {
     rendered_frames +=
@@ -198,6 +290,7 @@ int AudioRendererAlgorithm::FillBuffer(AudioBus* dest,
                                dest_offset + rendered_frames, dest);
   } while (rendered_frames < requested_frames &&
            RunOneWsolaIteration(playback_rate));
+  time_stretch_duration_ += base::TimeTicks::Now() - start;
   return rendered_frames;
 }
 
@@ -209,6 +302,7 @@ void AudioRendererAlgorithm::FlushBuffers() {
   target_block_index_ = 0;
   wsola_output_->Zero();
   num_complete_frames_ = 0;
+  phase_vocoder_primed_ = false;
 
   // Reset |capacity_| so growth triggered by underflows doesn't penalize seek
   // time.
@@ -237,6 +331,11 @@ int64_t AudioRendererAlgorithm::GetMemoryUsage() const {
 bool AudioRendererAlgorithm::CanPerformWsola() const {
   const int search_block_size = num_candidate_blocks_ + (ola_window_size_ - 1);
   const int frames = audio_buffer_.frames();
+
+  // Only WSOLA reads |target_block_|.
+  if (quality_ != Quality::kNormal)
+    return search_block_index_ + search_block_size <= frames;
+
   return target_block_index_ + ola_window_size_ <= frames &&
       search_block_index_ + search_block_size <= frames;
 }
@@ -252,6 +351,22 @@ bool AudioRendererAlgorithm::RunOneWsolaIteration(double playback_rate) {
 
   GetOptimalBlock();
 
+  if (quality_ == Quality::kHigh) {
+    // The vocoded block is already windowed, so it is added as is. Frames past
+    // the incomplete ones are kept zeroed by WriteCompletedFramesTo().
+    for (int k = 0; k < channels_; ++k) {
+      const float* const ch_opt_frame = optimal_block_->channel(k);
+      float* ch_output = wsola_output_->channel(k) + num_complete_frames_;
+      for (int n = 0; n < ola_window_size_; ++n)
+        ch_output[n] += ch_opt_frame[n];
+    }
+
+    num_complete_frames_ += ola_hop_size_;
+    UpdateOutputTime(playback_rate, ola_hop_size_);
+    RemoveOldInputFrames(playback_rate);
+    return true;
+  }
+
   // Overlap-and-add.
   for (int k = 0; k < channels_; ++k) {
     const float* const ch_opt_frame = optimal_block_->channel(k);
@@ -290,6 +405,7 @@ void AudioRendererAlgorithm::RemoveOldInputFrames(double playback_rate) {
   // Remove frames from input and adjust indices accordingly.
   audio_buffer_.SeekFrames(earliest_used_index);
   target_block_index_ -= earliest_used_index;
+  last_analysis_index_ -= earliest_used_index;
 
   // Adjust output index.
   double output_time_change = static_cast<double>(earliest_used_index) /
@@ -313,6 +429,7 @@ int AudioRendererAlgorithm::WriteCompletedFramesTo(
     float* ch = wsola_output_->channel(k);
     memmove(ch, &ch[rendered_frames], sizeof(*ch) * frames_to_move);
   }
+  wsola_output_->ZeroFramesPartial(frames_to_move, rendered_frames);
   num_complete_frames_ -= rendered_frames;
   return rendered_frames;
 }
@@ -328,6 +445,16 @@ bool AudioRendererAlgorithm::TargetIsWithinSearchRegion() const {
 void AudioRendererAlgorithm::GetOptimalBlock() {
   int optimal_index = 0;
 
+  if (quality_ != Quality::kNormal) {
+    // There is a single candidate block, centered at the playback position.
+    optimal_index = search_block_index_;
+    PeekAudioWithZeroPrepend(optimal_index, optimal_block_.get());
+    if (quality_ == Quality::kHigh)
+      PhaseVocodeOptimalBlock(optimal_index);
+    target_block_index_ = optimal_index + ola_hop_size_;
+    return;
+  }
+
   // An interval around last optimal block which is excluded from the search.
   // This is to reduce the buzzy sound. The number 160 is rather arbitrary and
   // derived heuristically.
@@ -346,8 +473,9 @@ void AudioRendererAlgorithm::GetOptimalBlock() {
 
     // |optimal_index| is in frames and it is relative to the beginning of the
     // |search_block_|.
-    optimal_index = internal::OptimalIndex(
-        search_block_.get(), target_block_.get(), exclude_iterval);
+    optimal_index =
+        internal::OptimalIndex(search_block_.get(), target_block_.get(),
+                               exclude_iterval, search_fft_state_.get());
 
     // Translate |index| w.r.t. the beginning of |audio_buffer_| and extract the
     // optimal block.
@@ -376,6 +504,158 @@ void AudioRendererAlgorithm::GetOptimalBlock() {
   target_block_index_ = optimal_index + ola_hop_size_;
 }
 
+void AudioRendererAlgorithm::PhaseVocodeOptimalBlock(int analysis_index) {
+  const int fft_size = ola_window_size_;
+  const int num_bins = fft_size / 2 + 1;
+  const float kTwoPi = 2.0f * M_PI;
+
+  // Transform two channels at a time, as the real and imaginary parts of a
+  // single complex signal, and separate their spectra using the symmetry of
+  // real signals:
+  //   X1[k] = (Z[k] + conj(Z[-k])) / 2
+  //   X2[k] = (Z[k] - conj(Z[-k])) / 2i
+  for (int ch = 0; ch < channels_; ch += 2) {
+    float* real = &spectrum_real_[ch * fft_size];
+    float* imag = &spectrum_imag_[ch * fft_size];
+    const float* first = optimal_block_->channel(ch);
+    const bool has_second = ch + 1 < channels_;
+    const float* second = has_second ? optimal_block_->channel(ch + 1) : first;
+    for (int n = 0; n < fft_size; ++n) {
+      real[n] = first[n] * vocoder_window_[n];
+      imag[n] = has_second ? second[n] * vocoder_window_[n] : 0;
+    }
+    internal::Fft(fft_size, false, fft_cos_table_.get(), fft_sin_table_.get(),
+                  real, imag);
+    if (!has_second)
+      continue;
+
+    // Only the first |num_bins| bins are written, so mirrored bins are still
+    // intact when they are read.
+    float* second_real = &spectrum_real_[(ch + 1) * fft_size];
+    float* second_imag = &spectrum_imag_[(ch + 1) * fft_size];
+    for (int k = 0; k < num_bins; ++k) {
+      const int mirror = (fft_size - k) & (fft_size - 1);
+      const float a_real = real[k];
+      const float a_imag = imag[k];
+      const float b_real = real[mirror];
+      const float b_imag = imag[mirror];
+      real[k] = 0.5f * (a_real + b_real);
+      imag[k] = 0.5f * (a_imag - b_imag);
+      second_real[k] = 0.5f * (a_imag + b_imag);
+      second_imag[k] = 0.5f * (b_real - a_real);
+    }
+  }
+
+  // Measure the sum of all channels, and rotate every channel by the same
+  // amount below.
+  for (int k = 0; k < num_bins; ++k) {
+    float sum_real = 0;
+    float sum_imag = 0;
+    for (int ch = 0; ch < channels_; ++ch) {
+      sum_real += spectrum_real_[ch * fft_size + k];
+      sum_imag += spectrum_imag_[ch * fft_size + k];
+    }
+    bin_magnitude_[k] = sum_real * sum_real + sum_imag * sum_imag;
+    bin_phase_[k] = std::atan2(sum_imag, sum_real);
+  }
+
+  // Advance the synthesis phase of every spectral peak by its instantaneous
+  // frequency. Advancing every bin on its own lets the phases of bins sharing
+  // a sinusoid drift apart, which audibly attenuates it; instead, the other
+  // bins are locked to the rotation of their nearest peak.
+  spectral_peaks_.clear();
+  const int analysis_hop = analysis_index - last_analysis_index_;
+  if (phase_vocoder_primed_ && analysis_hop > 0) {
+    for (int k = 0; k < num_bins; ++k) {
+      const float magnitude = bin_magnitude_[k];
+      if (magnitude <= 0 ||
+          (k > 0 && magnitude <= bin_magnitude_[k - 1]) ||
+          (k > 1 && magnitude <= bin_magnitude_[k - 2]) ||
+          (k + 1 < num_bins && magnitude < bin_magnitude_[k + 1]) ||
+          (k + 2 < num_bins && magnitude < bin_magnitude_[k + 2])) {
+        continue;
+      }
+      spectral_peaks_.push_back(k);
+
+      const float bin_frequency = kTwoPi * k / fft_size;
+      float deviation =
+          bin_phase_[k] - analysis_phase_[k] - bin_frequency * analysis_hop;
+      deviation -= kTwoPi * std::floor(deviation / kTwoPi + 0.5f);
+      const float frequency = bin_frequency + deviation / analysis_hop;
+      float synthesis_phase = synthesis_phase_[k] + frequency * ola_hop_size_;
+      synthesis_phase -= kTwoPi * std::floor(synthesis_phase / kTwoPi + 0.5f);
+      synthesis_phase_[k] = synthesis_phase;
+    }
+  }
+
+  size_t peak = 0;
+  for (int k = 0; k < num_bins; ++k) {
+    float rotation = 0;
+    if (!spectral_peaks_.empty()) {
+      while (peak + 1 < spectral_peaks_.size() &&
+             spectral_peaks_[peak + 1] - k < k - spectral_peaks_[peak]) {
+        ++peak;
+      }
+      const int peak_bin = spectral_peaks_[peak];
+      rotation = synthesis_phase_[peak_bin] - bin_phase_[peak_bin];
+    }
+    analysis_phase_[k] = bin_phase_[k];
+    synthesis_phase_[k] = bin_phase_[k] + rotation;
+
+    const float rotation_real = std::cos(rotation);
+    const float rotation_imag = std::sin(rotation);
+    for (int ch = 0; ch < channels_; ++ch) {
+      float* real = &spectrum_real_[ch * fft_size + k];
+      float* imag = &spectrum_imag_[ch * fft_size + k];
+      const float x_real = *real;
+      const float x_imag = *imag;
+      *real = x_real * rotation_real - x_imag * rotation_imag;
+      *imag = x_real * rotation_imag + x_imag * rotation_real;
+    }
+  }
+  last_analysis_index_ = analysis_index;
+  phase_vocoder_primed_ = true;
+
+  // Transform back two channels at a time; as both outputs are real, they end
+  // up in the real and imaginary parts of Y1 + i * Y2.
+  const float scale = 1.0f / fft_size;
+  for (int ch = 0; ch < channels_; ch += 2) {
+    float* real = &spectrum_real_[ch * fft_size];
+    float* imag = &spectrum_imag_[ch * fft_size];
+    const bool has_second = ch + 1 < channels_;
+    for (int k = 0; k < num_bins; ++k) {
+      const float first_real = real[k];
+      const float first_imag = imag[k];
+      const float second_real =
+          has_second ? spectrum_real_[(ch + 1) * fft_size + k] : 0;
+      const float second_imag =
+          has_second ? spectrum_imag_[(ch + 1) * fft_size + k] : 0;
+      const int mirror = fft_size - k;
+      if (k == 0 || mirror == k) {
+        // The DC and Nyquist bins of real signals are real.
+        real[k] = first_real;
+        imag[k] = second_real;
+        continue;
+      }
+      real[k] = first_real - second_imag;
+      imag[k] = first_imag + second_real;
+      real[mirror] = first_real + second_imag;
+      imag[mirror] = second_real - first_imag;
+    }
+    internal::Fft(fft_size, true, fft_cos_table_.get(), fft_sin_table_.get(),
+                  real, imag);
+
+    float* first = optimal_block_->channel(ch);
+    for (int n = 0; n < fft_size; ++n)
+      first[n] = real[n] * scale * vocoder_window_[n];
+    if (has_second) {
+      float* second = optimal_block_->channel(ch + 1);
+      for (int n = 0; n < fft_size; ++n)
+        second[n] = imag[n] * scale * vocoder_window_[n];
+    }
+  }
+}
+
 void AudioRendererAlgorithm::PeekAudioWithZeroPrepend(
     int read_offset_frames, AudioBus* dest) {
   CHECK_LE(read_offset_frames + dest->frames(), audio_buffer_.frames());
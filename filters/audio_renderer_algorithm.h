@@ -17,6 +17,9 @@
 // description of the algorithm.
 //
 // Audio at very low or very high playback rates are muted to preserve quality.
+//
+// Besides WSOLA, a cheaper plain overlap-and-add and a more expensive phase
+// vocoder can be selected per stream through Initialize(); see Quality.
 
 #ifndef MEDIA_FILTERS_AUDIO_RENDERER_ALGORITHM_H_
 #define MEDIA_FILTERS_AUDIO_RENDERER_ALGORITHM_H_
@@ -24,9 +27,11 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/time/time.h"
 #include "media/base/audio_buffer.h"
 #include "media/base/audio_buffer_queue.h"
 #include "media/base/audio_parameters.h"
@@ -35,13 +40,34 @@ namespace media {
 
 class AudioBus;
 
+namespace internal {
+struct FftCorrelationState;
+}
+
 class MEDIA_EXPORT AudioRendererAlgorithm {
  public:
+  // Time stretching algorithms, in order of increasing CPU cost and quality.
+  enum class Quality {
+    // Overlap-and-add of short blocks taken at the playback position, without
+    // any similarity search. Needs the least buffered input, but smears
+    // periodic content.
+    kLow,
+
+    // WSOLA, as described above.
+    kNormal,
+
+    // Phase vocoder with 75% overlapping windows. Phases are advanced in the
+    // frequency domain and shared across channels to preserve the stereo
+    // image. Also supports slower playback rates than the other tiers.
+    kHigh,
+  };
+
   AudioRendererAlgorithm();
   ~AudioRendererAlgorithm();
 
-  // Initializes this object with information about the audio stream.
-  void Initialize(const AudioParameters& params);
+  // Initializes this object with information about the audio stream, using
+  // the time stretching algorithm selected by |quality|.
+  void Initialize(const AudioParameters& params, Quality quality);
 
   // Tries to fill |requested_frames| frames into |dest| with possibly scaled
   // data from our |audio_buffer_|. Data is scaled based on |playback_rate|,
@@ -84,6 +110,16 @@ class MEDIA_EXPORT AudioRendererAlgorithm {
   // Returns the samples per second for this audio stream.
   int samples_per_second() { return samples_per_second_; }
 
+  Quality quality() const { return quality_; }
+
+  // Returns the total wall time FillBuffer() spent in its time stretching loop
+  // since Initialize(), i.e. running the |quality_| algorithm and copying its
+  // output to the destination. Calls which mute or which copy the input as is,
+  // at playback rates close to 1.0, are not counted.
+  base::TimeDelta time_stretch_duration() const {
+    return time_stretch_duration_;
+  }
+
  private:
   // Within |search_block_|, find the block of data that is most similar to
   // |target_block_|, and write it in |optimal_block_|. This method assumes that
@@ -107,9 +143,15 @@ class MEDIA_EXPORT AudioRendererAlgorithm {
 
   // Run one iteration of WSOLA, if there are sufficient frames. This will
   // overlap-and-add one block to |wsola_output_|, hence, |num_complete_frames_|
-  // is incremented by |ola_hop_size_|.
+  // is incremented by |ola_hop_size_|. The other quality tiers run through the
+  // same iteration, differing only in how |optimal_block_| is produced and
+  // overlap-and-added.
   bool RunOneWsolaIteration(double playback_rate);
 
+  // Replaces |optimal_block_|, the analysis block at |analysis_index|, by its
+  // phase vocoded version, windowed for overlap-and-add.
+  void PhaseVocodeOptimalBlock(int analysis_index);
+
   // Seek |audio_buffer_| forward to remove frames from input that are not used
   // any more. State of the WSOLA will be updated accordingly.
   void RemoveOldInputFrames(double playback_rate);
@@ -128,6 +170,14 @@ class MEDIA_EXPORT AudioRendererAlgorithm {
   // Converts a time in milliseconds to frames using |samples_per_second_|.
   int ConvertMillisecondsToFrames(int ms) const;
 
+  // Time stretching algorithm and the playback rates it supports.
+  Quality quality_;
+  double min_playback_rate_;
+  double max_playback_rate_;
+
+  // See time_stretch_duration().
+  base::TimeDelta time_stretch_duration_;
+
   // Number of channels in audio stream.
   int channels_;
 
@@ -207,6 +257,39 @@ class MEDIA_EXPORT AudioRendererAlgorithm {
   // |target_block_|.
   std::unique_ptr<AudioBus> target_block_;
 
+  // Twiddle factors and scratch buffers for FFT searches of |search_block_|.
+  std::unique_ptr<internal::FftCorrelationState> search_fft_state_;
+
+  // Phase vocoder state, only used by Quality::kHigh. The FFT size equals
+  // |ola_window_size_|.
+
+  // FFT twiddle factors and the Hann window applied both before analysis and
+  // after synthesis, scaled such that overlapping windows add up to one.
+  std::unique_ptr<float[]> fft_cos_table_;
+  std::unique_ptr<float[]> fft_sin_table_;
+  std::unique_ptr<float[]> vocoder_window_;
+
+  // Spectra of all channels of the current analysis block, |channels_| times
+  // |ola_window_size_| values each.
+  std::unique_ptr<float[]> spectrum_real_;
+  std::unique_ptr<float[]> spectrum_imag_;
+
+  // Per frequency bin, the phase of the previous analysis block and the
+  // accumulated synthesis phase, both of the sum of all channels.
+  std::unique_ptr<float[]> analysis_phase_;
+  std::unique_ptr<float[]> synthesis_phase_;
+
+  // Per frequency bin, the magnitude and phase of the sum of all channels of
+  // the current analysis block, and the bins holding spectral peaks.
+  std::unique_ptr<float[]> bin_magnitude_;
+  std::unique_ptr<float[]> bin_phase_;
+  std::vector<int> spectral_peaks_;
+
+  // Index of the previous analysis block in |audio_buffer_|, valid only when
+  // |phase_vocoder_primed_| is true.
+  int last_analysis_index_;
+  bool phase_vocoder_primed_;
+
   // The initial and maximum capacity calculated by Initialize().
   int initial_capacity_;
   int max_capacity_;
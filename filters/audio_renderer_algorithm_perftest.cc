@@ -0,0 +1,108 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "media/base/audio_buffer.h"
+#include "media/base/audio_bus.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/channel_layout.h"
+#include "media/base/test_helpers.h"
+#include "media/base/timestamp_constants.h"
+#include "media/filters/audio_renderer_algorithm.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kInputFrames = 480;
+static const int kOutputDurationInSec = 10;
+
+static const char* QualityToString(AudioRendererAlgorithm::Quality quality) {
+  switch (quality) {
+    case AudioRendererAlgorithm::Quality::kLow:
+      return "_low";
+    case AudioRendererAlgorithm::Quality::kNormal:
+      return "";
+    case AudioRendererAlgorithm::Quality::kHigh:
+      return "_high";
+  }
+  NOTREACHED();
+  return "";
+}
+
+// Renders |kOutputDurationInSec| seconds of stereo audio at |sample_rate| in
+// 10ms buffers with the given |playback_rate| and |quality|, and reports how
+// many times faster than real time FillBuffer() runs.
+static void RunFillBufferBenchmark(AudioRendererAlgorithm::Quality quality,
+                                   int sample_rate,
+                                   double playback_rate) {
+  const ChannelLayout kChannelLayout = CHANNEL_LAYOUT_STEREO;
+  const int kChannels = ChannelLayoutToChannelCount(kChannelLayout);
+  const int frames_per_buffer = sample_rate / 100;
+
+  AudioRendererAlgorithm algorithm;
+  algorithm.Initialize(AudioParameters(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                                       kChannelLayout, sample_rate, 32,
+                                       frames_per_buffer),
+                       quality);
+
+  // A sawtooth rather than silence, so that WSOLA has something to match.
+  auto fill_queue = [&]() {
+    while (!algorithm.IsQueueFull()) {
+      algorithm.EnqueueBuffer(MakeAudioBuffer<float>(
+          kSampleFormatPlanarF32, kChannelLayout, kChannels, sample_rate,
+          -1.0f, 2.0f / kInputFrames, kInputFrames, kNoTimestamp));
+    }
+  };
+
+  std::unique_ptr<AudioBus> bus =
+      AudioBus::Create(kChannels, frames_per_buffer);
+  const int total_frames = kOutputDurationInSec * sample_rate;
+  base::TimeDelta total_time;
+  for (int frames_rendered = 0; frames_rendered < total_frames;) {
+    fill_queue();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    const int frames_written =
+        algorithm.FillBuffer(bus.get(), 0, frames_per_buffer, playback_rate);
+    total_time += base::TimeTicks::Now() - start;
+    ASSERT_GT(frames_written, 0);
+    frames_rendered += frames_written;
+  }
+
+  perf_test::PrintResult(
+      "audio_renderer_algorithm", QualityToString(quality),
+      base::StringPrintf("%dhz_%.2fx", sample_rate, playback_rate),
+      kOutputDurationInSec / total_time.InSecondsF(), "x_realtime", true);
+}
+
+TEST(AudioRendererAlgorithmPerfTest, FillBuffer) {
+  // 96kHz and above search large enough windows to use FFT based matching.
+  for (int sample_rate : {48000, 96000, 192000}) {
+    for (double playback_rate : {0.5, 0.75, 1.0, 1.25, 1.5, 2.0}) {
+      RunFillBufferBenchmark(AudioRendererAlgorithm::Quality::kNormal,
+                             sample_rate, playback_rate);
+    }
+  }
+}
+
+TEST(AudioRendererAlgorithmPerfTest, FillBufferQualityTiers) {
+  // The CPU cost of each tier; only the phase vocoder supports 0.25x.
+  for (auto quality : {AudioRendererAlgorithm::Quality::kLow,
+                       AudioRendererAlgorithm::Quality::kNormal,
+                       AudioRendererAlgorithm::Quality::kHigh}) {
+    for (double playback_rate : {0.25, 0.5, 1.5, 2.0}) {
+      if (playback_rate < 0.5 &&
+          quality != AudioRendererAlgorithm::Quality::kHigh) {
+        continue;
+      }
+      RunFillBufferBenchmark(quality, 48000, playback_rate);
+    }
+  }
+}
+
+}  // namespace media
@@ -8,6 +8,9 @@
 // correct rate.  We always pass in a very large destination buffer with the
 // expectation that FillBuffer() will fill as much as it can but no more.
 
+// MSVC++ requires this to be set before any other includes to get M_PI.
+#define _USE_MATH_DEFINES
+
 #include "media/filters/audio_renderer_algorithm.h"
 
 #include <stddef.h>
@@ -89,7 +92,9 @@ class AudioRendererAlgorithmTest : public testing::Test {
   void Initialize(ChannelLayout channel_layout,
                   SampleFormat sample_format,
                   int samples_per_second,
-                  int frames_per_buffer) {
+                  int frames_per_buffer,
+                  AudioRendererAlgorithm::Quality quality =
+                      AudioRendererAlgorithm::Quality::kNormal) {
     channels_ = ChannelLayoutToChannelCount(channel_layout);
     samples_per_second_ = samples_per_second;
     channel_layout_ = channel_layout;
@@ -98,7 +103,7 @@ class AudioRendererAlgorithmTest : public testing::Test {
     AudioParameters params(media::AudioParameters::AUDIO_PCM_LINEAR,
                            channel_layout, samples_per_second,
                            bytes_per_sample_ * 8, frames_per_buffer);
-    algorithm_.Initialize(params);
+    algorithm_.Initialize(params, quality);
     FillAlgorithmQueue();
   }
 
@@ -181,7 +186,11 @@ class AudioRendererAlgorithmTest : public testing::Test {
       return;
     }
 
-    bool expect_muted = (playback_rate < 0.5 || playback_rate > 4);
+    const double min_playback_rate =
+        algorithm_.quality() == AudioRendererAlgorithm::Quality::kHigh ? 0.25
+                                                                       : 0.5;
+    bool expect_muted =
+        (playback_rate < min_playback_rate || playback_rate > 4);
 
     int frames_remaining = total_frames_requested;
     bool first_fill_buffer = true;
@@ -240,7 +249,7 @@ class AudioRendererAlgorithmTest : public testing::Test {
     channels_ = ChannelLayoutToChannelCount(kChannelLayout);
     AudioParameters params(AudioParameters::AUDIO_PCM_LINEAR, kChannelLayout,
                            kSampleRateHz, kBytesPerSample * 8, kNumFrames);
-    algorithm_.Initialize(params);
+    algorithm_.Initialize(params, AudioRendererAlgorithm::Quality::kNormal);
 
     // A pulse is 6 milliseconds (even number of samples).
     const int kPulseWidthSamples = 6 * kSampleRateHz / 1000;
@@ -309,6 +318,65 @@ class AudioRendererAlgorithmTest : public testing::Test {
     }
   }
 
+  // Renders a stereo tone at |playback_rate|, and verifies that its frequency
+  // is preserved within a fraction of |tolerance| and that the level
+  // difference between the channels is preserved.
+  void PitchTest(AudioRendererAlgorithm::Quality quality,
+                 double playback_rate,
+                 double tolerance) {
+    const int kSampleRateHz = 48000;
+    const ChannelLayout kChannelLayout = CHANNEL_LAYOUT_STEREO;
+    const int kBytesPerSample = 4;
+    const int kNumFrames = kSampleRateHz / 100;  // 10 milliseconds.
+    const int kToneHz = 1000;  // An integer number of periods per buffer.
+    const float kRightChannelLevel = 0.5f;
+
+    channels_ = ChannelLayoutToChannelCount(kChannelLayout);
+    AudioParameters params(AudioParameters::AUDIO_PCM_LINEAR, kChannelLayout,
+                           kSampleRateHz, kBytesPerSample * 8, kNumFrames);
+    algorithm_.Initialize(params, quality);
+
+    scoped_refptr<AudioBuffer> input = AudioBuffer::CreateBuffer(
+        kSampleFormatPlanarF32, kChannelLayout, channels_, kSampleRateHz,
+        kNumFrames);
+    float* left = reinterpret_cast<float*>(input->channel_data()[0]);
+    float* right = reinterpret_cast<float*>(input->channel_data()[1]);
+    for (int n = 0; n < kNumFrames; ++n) {
+      left[n] = std::sin(2 * M_PI * kToneHz * n / kSampleRateHz);
+      right[n] = kRightChannelLevel * left[n];
+    }
+
+    // Render one second of audio.
+    std::unique_ptr<AudioBus> output = AudioBus::Create(channels_,
+                                                        kSampleRateHz);
+    int frames_rendered = 0;
+    while (frames_rendered < kSampleRateHz) {
+      while (!algorithm_.IsQueueFull())
+        algorithm_.EnqueueBuffer(input);
+      const int frames_written = algorithm_.FillBuffer(
+          output.get(), frames_rendered,
+          std::min(kNumFrames, kSampleRateHz - frames_rendered),
+          playback_rate);
+      ASSERT_GT(frames_written, 0);
+      frames_rendered += frames_written;
+    }
+
+    // Analyze the second half, after the output has settled.
+    const float* output_left = output->channel(0);
+    const float* output_right = output->channel(1);
+    int rising_zero_crossings = 0;
+    float max_left = 0;
+    float max_right = 0;
+    for (int n = kSampleRateHz / 2; n < kSampleRateHz; ++n) {
+      if (output_left[n - 1] < 0 && output_left[n] >= 0)
+        ++rising_zero_crossings;
+      max_left = std::max(max_left, std::abs(output_left[n]));
+      max_right = std::max(max_right, std::abs(output_right[n]));
+    }
+    EXPECT_NEAR(kToneHz / 2, rising_zero_crossings, kToneHz / 2 * tolerance);
+    EXPECT_NEAR(kRightChannelLevel, max_right / max_left, 0.01);
+  }
+
  protected:
   AudioRendererAlgorithm algorithm_;
   int frames_enqueued_;
@@ -428,6 +496,29 @@ TEST_F(AudioRendererAlgorithmTest, FillBuffer_LargeBufferSize) {
   TestPlaybackRate(1.5);
 }
 
+TEST_F(AudioRendererAlgorithmTest, FillBuffer_LowQuality) {
+  Initialize(CHANNEL_LAYOUT_STEREO, kSampleFormatS16, kSamplesPerSecond,
+             kSamplesPerSecond / 100, AudioRendererAlgorithm::Quality::kLow);
+  TestPlaybackRate(1.0);
+  TestPlaybackRate(0.5);
+  TestPlaybackRate(0.75);
+  TestPlaybackRate(1.5);
+  TestPlaybackRate(2.0);
+  TestPlaybackRate(0.25);
+}
+
+TEST_F(AudioRendererAlgorithmTest, FillBuffer_HighQuality) {
+  Initialize(CHANNEL_LAYOUT_STEREO, kSampleFormatS16, kSamplesPerSecond,
+             kSamplesPerSecond / 100, AudioRendererAlgorithm::Quality::kHigh);
+  TestPlaybackRate(1.0);
+  TestPlaybackRate(0.5);
+  TestPlaybackRate(0.75);
+  TestPlaybackRate(1.5);
+  TestPlaybackRate(2.0);
+  TestPlaybackRate(0.25);
+  TestPlaybackRate(0.2);
+}
+
 TEST_F(AudioRendererAlgorithmTest, FillBuffer_LowerQualityAudio) {
   Initialize(CHANNEL_LAYOUT_MONO, kSampleFormatU8, kSamplesPerSecond,
              kSamplesPerSecond / 100);
@@ -600,8 +691,94 @@ TEST_F(AudioRendererAlgorithmTest, FullAndDecimatedSearch) {
       4, exclude_interval, target.get(), search_region.get(),
       energy_target.get(), energy_candid_blocks.get()));
 
+  internal::FftCorrelationState fft_state(
+      internal::GetFftSize(kFramesInSearchRegion));
   EXPECT_EQ(5, internal::OptimalIndex(search_region.get(), target.get(),
-                                      exclude_interval));
+                                      exclude_interval, &fft_state));
+
+  // The FFT search is exhaustive, so it agrees with the full search.
+  EXPECT_EQ(5, internal::FftSearch(exclude_interval, target.get(),
+                                   search_region.get(), energy_target.get(),
+                                   energy_candid_blocks.get(), &fft_state));
+
+  // The state is reused across searches.
+  exclude_interval = std::make_pair(2, 5);
+  EXPECT_EQ(7, internal::FftSearch(exclude_interval, target.get(),
+                                   search_region.get(), energy_target.get(),
+                                   energy_candid_blocks.get(), &fft_state));
+}
+
+TEST_F(AudioRendererAlgorithmTest, CrossCorrelation) {
+  const int kChannels = 2;
+  const int kFramesPerBlock = 37;
+  const int kFramesInSearchRegion = 301;
+  const int kNumCandidBlocks = kFramesInSearchRegion - (kFramesPerBlock - 1);
+
+  std::unique_ptr<AudioBus> target =
+      AudioBus::Create(kChannels, kFramesPerBlock);
+  std::unique_ptr<AudioBus> search_region =
+      AudioBus::Create(kChannels, kFramesInSearchRegion);
+  FillWithSquarePulseTrain(3, 0, 0, target.get());
+  FillWithSquarePulseTrain(5, 2, 1, target.get());
+  for (int n = 0; n < kFramesInSearchRegion; ++n) {
+    search_region->channel(0)[n] = sin(0.1 * n);
+    search_region->channel(1)[n] = cos(0.37 * n) * (n % 7) / 7.0;
+  }
+
+  std::unique_ptr<float[]> cross_correlation(
+      new float[kNumCandidBlocks * kChannels]);
+  internal::FftCorrelationState fft_state(
+      internal::GetFftSize(kFramesInSearchRegion));
+  internal::MultiChannelCrossCorrelation(target.get(), search_region.get(),
+                                         &fft_state, cross_correlation.get());
+
+  // Every candidate block matches the direct dot-product.
+  std::unique_ptr<float[]> dot_prod(new float[kChannels]);
+  for (int n = 0; n < kNumCandidBlocks; ++n) {
+    internal::MultiChannelDotProduct(target.get(), 0, search_region.get(), n,
+                                     kFramesPerBlock, dot_prod.get());
+    for (int k = 0; k < kChannels; ++k) {
+      EXPECT_NEAR(dot_prod[k], cross_correlation[n * kChannels + k], 1e-4)
+          << "n=" << n << ", k=" << k;
+    }
+  }
+}
+
+TEST_F(AudioRendererAlgorithmTest, SummedCrossCorrelation) {
+  const int kChannels = 3;
+  const int kFramesPerBlock = 29;
+  const int kFramesInSearchRegion = 211;
+  const int kNumCandidBlocks = kFramesInSearchRegion - (kFramesPerBlock - 1);
+
+  std::unique_ptr<AudioBus> target =
+      AudioBus::Create(kChannels, kFramesPerBlock);
+  std::unique_ptr<AudioBus> search_region =
+      AudioBus::Create(kChannels, kFramesInSearchRegion);
+  FillWithSquarePulseTrain(3, 0, 0, target.get());
+  FillWithSquarePulseTrain(5, 2, 1, target.get());
+  FillWithSquarePulseTrain(2, 1, 2, target.get());
+  for (int n = 0; n < kFramesInSearchRegion; ++n) {
+    search_region->channel(0)[n] = sin(0.1 * n);
+    search_region->channel(1)[n] = cos(0.37 * n) * (n % 7) / 7.0;
+    search_region->channel(2)[n] = sin(0.05 * n) * cos(0.7 * n);
+  }
+
+  std::unique_ptr<float[]> cross_correlation(new float[kNumCandidBlocks]);
+  internal::FftCorrelationState fft_state(
+      internal::GetFftSize(kFramesInSearchRegion));
+  internal::SummedCrossCorrelation(target.get(), search_region.get(),
+                                   &fft_state, cross_correlation.get());
+
+  // Every candidate block matches the sum of the per channel dot-products.
+  std::unique_ptr<float[]> dot_prod(new float[kChannels]);
+  for (int n = 0; n < kNumCandidBlocks; ++n) {
+    internal::MultiChannelDotProduct(target.get(), 0, search_region.get(), n,
+                                     kFramesPerBlock, dot_prod.get());
+    float sum = 0;
+    for (int k = 0; k < kChannels; ++k)
+      sum += dot_prod[k];
+    EXPECT_NEAR(sum, cross_correlation[n], 1e-4) << "n=" << n;
+  }
 }
 
 TEST_F(AudioRendererAlgorithmTest, QuadraticInterpolation) {
@@ -650,6 +827,25 @@ TEST_F(AudioRendererAlgorithmTest, WsolaSpeedup) {
   WsolaTest(1.6);
 }
 
+// Without a search, Quality::kLow overlaps blocks that are not aligned to the
+// period of the tone, which bends its pitch by a few percent.
+TEST_F(AudioRendererAlgorithmTest, LowQualityPitch) {
+  PitchTest(AudioRendererAlgorithm::Quality::kLow, 0.5, 0.1);
+  PitchTest(AudioRendererAlgorithm::Quality::kLow, 1.5, 0.1);
+}
+
+TEST_F(AudioRendererAlgorithmTest, NormalQualityPitch) {
+  PitchTest(AudioRendererAlgorithm::Quality::kNormal, 0.5, 0.01);
+  PitchTest(AudioRendererAlgorithm::Quality::kNormal, 1.5, 0.01);
+}
+
+TEST_F(AudioRendererAlgorithmTest, HighQualityPitch) {
+  PitchTest(AudioRendererAlgorithm::Quality::kHigh, 0.25, 0.01);
+  PitchTest(AudioRendererAlgorithm::Quality::kHigh, 0.5, 0.01);
+  PitchTest(AudioRendererAlgorithm::Quality::kHigh, 1.5, 0.01);
+  PitchTest(AudioRendererAlgorithm::Quality::kHigh, 2.0, 0.01);
+}
+
 TEST_F(AudioRendererAlgorithmTest, FillBufferOffset) {
   Initialize();
 
@@ -0,0 +1,93 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/decode_ahead_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/logging.h"
+
+namespace media {
+
+// Number of samples averaged for decode times and consumption intervals.
+static const size_t kSampleHistory = 32;
+
+// Adapted ready frame targets are at most this multiple of the default.
+static const size_t kMaxReadyFramesFactor = 3;
+
+DecodeAheadController::DecodeAheadController(size_t default_ready_frames)
+    : default_ready_frames_(default_ready_frames),
+      decode_time_(kSampleHistory),
+      frame_interval_(kSampleHistory) {
+  DCHECK_GE(default_ready_frames_, static_cast<size_t>(kMinReadyFrames));
+}
+
+DecodeAheadController::~DecodeAheadController() {}
+
+void DecodeAheadController::AddDecodeTime(base::TimeDelta decode_time) {
+  base::AutoLock auto_lock(lock_);
+  decode_time_.AddSample(decode_time);
+}
+
+void DecodeAheadController::AddConsumedFrames(size_t frames,
+                                              base::TimeTicks now) {
+  if (!frames)
+    return;
+
+  base::AutoLock auto_lock(lock_);
+  if (!last_consumption_time_.is_null() && now > last_consumption_time_)
+    frame_interval_.AddSample((now - last_consumption_time_) / frames);
+  last_consumption_time_ = now;
+}
+
+void DecodeAheadController::OnConsumptionStopped() {
+  base::AutoLock auto_lock(lock_);
+  last_consumption_time_ = base::TimeTicks();
+}
+
+int DecodeAheadController::GetDecodeAheadDepth(int max_decode_requests) {
+  base::AutoLock auto_lock(lock_);
+  const int frames_per_decode = GetFramesConsumedPerDecode();
+  if (!frames_per_decode)
+    return max_decode_requests;
+
+  // Keep enough decodes in flight to deliver a frame every frame interval,
+  // plus one to hide the time it takes to issue the next request.
+  return std::max(std::min(frames_per_decode + 1, max_decode_requests), 1);
+}
+
+size_t DecodeAheadController::GetReadyFramesTarget() {
+  base::AutoLock auto_lock(lock_);
+  const int frames_per_decode = GetFramesConsumedPerDecode();
+  if (!frames_per_decode)
+    return default_ready_frames_;
+
+  // The frame being displayed, plus those consumed while the next one decodes.
+  const size_t target = static_cast<size_t>(frames_per_decode) + 1;
+  const size_t max_target = kMaxReadyFramesFactor * default_ready_frames_;
+  return std::max(std::min(target, max_target),
+                  static_cast<size_t>(kMinReadyFrames));
+}
+
+int DecodeAheadController::GetFramesConsumedPerDecode() const {
+  lock_.AssertAcquired();
+  if (decode_time_.count() < kMinSamples ||
+      frame_interval_.count() < kMinSamples) {
+    return 0;
+  }
+
+  const base::TimeDelta frame_interval = frame_interval_.Average();
+  if (frame_interval <= base::TimeDelta())
+    return 0;
+
+  const base::TimeDelta padded_decode_time =
+      decode_time_.Average() + decode_time_.Deviation() * 2;
+  return std::max(
+      static_cast<int>(std::ceil(padded_decode_time.InMicrosecondsF() /
+                                 frame_interval.InMicrosecondsF())),
+      1);
+}
+
+}  // namespace media
@@ -0,0 +1,83 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FILTERS_DECODE_AHEAD_CONTROLLER_H_
+#define MEDIA_FILTERS_DECODE_AHEAD_CONTROLLER_H_
+
+#include <stddef.h>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+#include "media/base/moving_average.h"
+
+namespace media {
+
+// Sizes how far ahead of the renderer a video stream is decoded.  With fixed
+// limits a fast decoder keeps more frames in memory than it needs, while a slow
+// or bursty decoder (e.g. one with expensive keyframes) runs dry and underflows.
+//
+// The decoder reports how long each decode takes and the renderer reports how
+// fast it consumes frames.  From the ratio of the two, i.e. the number of frames
+// the renderer consumes while one frame is being decoded, the controller derives
+// both the number of decode requests kept in flight and the number of decoded
+// frames the renderer should keep queued.  Decode times are padded by twice
+// their standard deviation to absorb jitter.  Until enough samples have been
+// collected the previous fixed limits are used.
+//
+// This class is thread safe; decode times are reported on the media thread and
+// consumption on the compositor thread.
+class MEDIA_EXPORT DecodeAheadController {
+ public:
+  // Number of samples of both kinds required before the limits adapt.
+  enum { kMinSamples = 8 };
+
+  // Bounds of GetReadyFramesTarget() once it adapts.
+  enum { kMinReadyFrames = 2 };
+
+  // |default_ready_frames| is returned by GetReadyFramesTarget() before enough
+  // samples have been collected; adapted targets never exceed three times it.
+  explicit DecodeAheadController(size_t default_ready_frames);
+  ~DecodeAheadController();
+
+  // Reports the wall clock time the decoder spent on one buffer: from when it
+  // was submitted, or when the previous decode completed if that was later,
+  // until its decode completed.
+  void AddDecodeTime(base::TimeDelta decode_time);
+
+  // Reports that the renderer consumed, i.e. displayed or dropped, |frames|
+  // frames by |now|.  The consumption interval is measured between calls which
+  // consume at least one frame.
+  void AddConsumedFrames(size_t frames, base::TimeTicks now);
+
+  // Forgets the time of the last consumption, so that a pause in rendering is
+  // not mistaken for slow consumption.
+  void OnConsumptionStopped();
+
+  // Returns how many decode requests, including decoded outputs not yet read,
+  // should be in flight; never more than |max_decode_requests|.
+  int GetDecodeAheadDepth(int max_decode_requests);
+
+  // Returns how many decoded frames the renderer should keep queued.
+  size_t GetReadyFramesTarget();
+
+ private:
+  // Returns the number of frames consumed during one padded decode time, or 0
+  // if not enough samples have been collected yet.  |lock_| must be held.
+  int GetFramesConsumedPerDecode() const;
+
+  const size_t default_ready_frames_;
+
+  base::Lock lock_;
+  MovingAverage decode_time_;
+  MovingAverage frame_interval_;
+  base::TimeTicks last_consumption_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecodeAheadController);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_DECODE_AHEAD_CONTROLLER_H_
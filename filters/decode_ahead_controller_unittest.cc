@@ -0,0 +1,128 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/decode_ahead_controller.h"
+
+#include "base/macros.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static const size_t kDefaultReadyFrames = 4;
+static const int kMaxDecodeRequests = 8;
+
+class DecodeAheadControllerTest : public testing::Test {
+ public:
+  DecodeAheadControllerTest() : controller_(kDefaultReadyFrames) {
+    now_ += base::TimeDelta::FromSeconds(1);
+  }
+
+ protected:
+  void AddDecodeTimes(int count, base::TimeDelta decode_time) {
+    for (int i = 0; i < count; ++i)
+      controller_.AddDecodeTime(decode_time);
+  }
+
+  // Consumes one frame every |frame_interval|, |count| times.
+  void ConsumeFrames(int count, base::TimeDelta frame_interval) {
+    for (int i = 0; i < count; ++i) {
+      now_ += frame_interval;
+      controller_.AddConsumedFrames(1, now_);
+    }
+  }
+
+  DecodeAheadController controller_;
+  base::TimeTicks now_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DecodeAheadControllerTest);
+};
+
+TEST_F(DecodeAheadControllerTest, DefaultsWithoutSamples) {
+  EXPECT_EQ(kMaxDecodeRequests,
+            controller_.GetDecodeAheadDepth(kMaxDecodeRequests));
+  EXPECT_EQ(kDefaultReadyFrames, controller_.GetReadyFramesTarget());
+
+  // Decode times alone are not enough.
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(1));
+  EXPECT_EQ(kMaxDecodeRequests,
+            controller_.GetDecodeAheadDepth(kMaxDecodeRequests));
+  EXPECT_EQ(kDefaultReadyFrames, controller_.GetReadyFramesTarget());
+}
+
+TEST_F(DecodeAheadControllerTest, FastDecoderBuffersLess) {
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(2));
+  ConsumeFrames(DecodeAheadController::kMinSamples + 1,
+                base::TimeDelta::FromMilliseconds(16));
+  EXPECT_EQ(2, controller_.GetDecodeAheadDepth(kMaxDecodeRequests));
+  EXPECT_EQ(static_cast<size_t>(DecodeAheadController::kMinReadyFrames),
+            controller_.GetReadyFramesTarget());
+}
+
+TEST_F(DecodeAheadControllerTest, SlowDecoderBuffersMore) {
+  // Decodes take three to four frame intervals.
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(50));
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(60));
+  ConsumeFrames(DecodeAheadController::kMinSamples + 1,
+                base::TimeDelta::FromMilliseconds(16));
+
+  // The average of 55ms is padded by twice the 5ms deviation to 65ms, which
+  // covers five frame intervals.
+  EXPECT_EQ(6, controller_.GetDecodeAheadDepth(kMaxDecodeRequests));
+  EXPECT_EQ(6u, controller_.GetReadyFramesTarget());
+
+  // The depth is capped by the decoder, the ready frames by the default.
+  EXPECT_EQ(1, controller_.GetDecodeAheadDepth(1));
+  AddDecodeTimes(32, base::TimeDelta::FromMilliseconds(500));
+  EXPECT_EQ(3 * kDefaultReadyFrames, controller_.GetReadyFramesTarget());
+}
+
+TEST_F(DecodeAheadControllerTest, FollowsConsumptionRate) {
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(20));
+  ConsumeFrames(32, base::TimeDelta::FromMilliseconds(40));
+  EXPECT_EQ(2u, controller_.GetReadyFramesTarget());
+
+  // E.g. a higher playback rate consumes frames faster.
+  ConsumeFrames(32, base::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(3u, controller_.GetReadyFramesTarget());
+}
+
+TEST_F(DecodeAheadControllerTest, PausesAreNotConsumption) {
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(20));
+  ConsumeFrames(32, base::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(3u, controller_.GetReadyFramesTarget());
+
+  controller_.OnConsumptionStopped();
+  now_ += base::TimeDelta::FromSeconds(10);
+  controller_.AddConsumedFrames(1, now_);
+  ConsumeFrames(1, base::TimeDelta::FromMilliseconds(10));
+  EXPECT_EQ(3u, controller_.GetReadyFramesTarget());
+}
+
+TEST_F(DecodeAheadControllerTest, ConsumptionIsMeasuredPerFrame) {
+  AddDecodeTimes(DecodeAheadController::kMinSamples,
+                 base::TimeDelta::FromMilliseconds(20));
+
+  // 30fps content on a 60Hz display consumes a frame every other vsync.
+  for (int i = 0; i < 32; ++i) {
+    now_ += base::TimeDelta::FromMilliseconds(16);
+    controller_.AddConsumedFrames(i % 2, now_);
+  }
+  EXPECT_EQ(2u, controller_.GetReadyFramesTarget());
+
+  // Dropping frames consumes several per vsync.
+  for (int i = 0; i < 32; ++i) {
+    now_ += base::TimeDelta::FromMilliseconds(16);
+    controller_.AddConsumedFrames(2, now_);
+  }
+  EXPECT_EQ(4u, controller_.GetReadyFramesTarget());
+}
+
+}  // namespace media
@@ -0,0 +1,206 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/decode_thread_budget.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <string>
+
+#include "base/command_line.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/sys_info.h"
+#include "media/base/media_switches.h"
+#include "media/base/moving_average.h"
+
+namespace media {
+
+namespace {
+
+// Leave two execution contexts for the rest of the process, but never budget
+// fewer than two threads in total.
+const int kReservedProcessors = 2;
+const int kMinTotalThreads = 2;
+
+// Number of decode time samples averaged per decoder.
+const size_t kDecodeTimeHistory = 32;
+
+// Rough single threaded decode time of a 1080p frame; used to convert pixel
+// counts into the same unit as measured decode times before enough samples
+// have been collected.
+const int kEstimatedDecodeTimeFor1080pUs = 12000;
+
+// How far, in threads, a decoder's share must move beyond the rounding point
+// before its thread count is changed.  Keeps decoders whose share sits near
+// x.5 threads from recreating their codec at every keyframe.
+const double kThreadCountHysteresis = 0.25;
+
+int GetDefaultTotalThreads() {
+  return std::max(base::SysInfo::NumberOfProcessors() - kReservedProcessors,
+                  kMinTotalThreads);
+}
+
+class DefaultDecodeThreadBudget : public DecodeThreadBudget {
+ public:
+  DefaultDecodeThreadBudget() : DecodeThreadBudget(GetDefaultTotalThreads()) {}
+};
+
+base::LazyInstance<DefaultDecodeThreadBudget>::Leaky g_decode_thread_budget =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+struct DecodeThreadBudget::Client {
+  Client(const gfx::Size& coded_size, int min_threads, int max_threads)
+      : coded_size(coded_size),
+        min_threads(min_threads),
+        max_threads(max_threads),
+        current_threads(max_threads),
+        has_thread_count(false),
+        decode_time(kDecodeTimeHistory) {}
+
+  gfx::Size coded_size;
+  int min_threads;
+  int max_threads;
+
+  // Thread count last handed out by GetThreadCount(), or |max_threads| until
+  // |has_thread_count| is set.
+  int current_threads;
+  bool has_thread_count;
+
+  // Decode times scaled by |current_threads| at the time of the sample, so
+  // that they approximate the total CPU time spent per decode.
+  MovingAverage decode_time;
+};
+
+// static
+DecodeThreadBudget* DecodeThreadBudget::GetInstance() {
+  return g_decode_thread_budget.Pointer();
+}
+
+// static
+bool DecodeThreadBudget::HasThreadCountOverride() {
+  int decode_threads;
+  const base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  std::string threads(cmd_line->GetSwitchValueASCII(switches::kVideoThreads));
+  return !threads.empty() && base::StringToInt(threads, &decode_threads);
+}
+
+DecodeThreadBudget::DecodeThreadBudget(int total_threads)
+    : total_threads_(total_threads), next_client_id_(kInvalidClientId + 1) {
+  DCHECK_GT(total_threads_, 0);
+}
+
+DecodeThreadBudget::~DecodeThreadBudget() {}
+
+DecodeThreadBudget::ClientId DecodeThreadBudget::RegisterDecoder(
+    const gfx::Size& coded_size,
+    int min_threads,
+    int max_threads) {
+  DCHECK_GE(min_threads, 0);
+  DCHECK_GE(max_threads, min_threads);
+
+  base::AutoLock auto_lock(lock_);
+  const ClientId id = next_client_id_++;
+  clients_[id] = base::MakeUnique<Client>(coded_size, min_threads, max_threads);
+  return id;
+}
+
+void DecodeThreadBudget::UnregisterDecoder(ClientId id) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK(clients_.count(id));
+  clients_.erase(id);
+}
+
+void DecodeThreadBudget::UpdateDecoder(ClientId id,
+                                       const gfx::Size& coded_size,
+                                       int max_threads) {
+  base::AutoLock auto_lock(lock_);
+  auto it = clients_.find(id);
+  DCHECK(it != clients_.end());
+  Client* client = it->second.get();
+  client->coded_size = coded_size;
+  client->max_threads = std::max(max_threads, client->min_threads);
+  client->has_thread_count = false;
+  client->decode_time.Reset();
+}
+
+void DecodeThreadBudget::AddDecodeTimeSample(ClientId id,
+                                             base::TimeDelta decode_time) {
+  base::AutoLock auto_lock(lock_);
+  auto it = clients_.find(id);
+  DCHECK(it != clients_.end());
+  Client* client = it->second.get();
+  client->decode_time.AddSample(decode_time *
+                                std::max(client->current_threads, 1));
+}
+
+int DecodeThreadBudget::GetThreadCount(ClientId id) {
+  base::AutoLock auto_lock(lock_);
+  auto it = clients_.find(id);
+  DCHECK(it != clients_.end());
+  Client* client = it->second.get();
+
+  // Water-fill the budget: decoders whose proportional share exceeds what they
+  // asked for are capped and the remainder is redistributed among the others.
+  std::map<ClientId, double> uncapped;
+  for (const auto& entry : clients_)
+    uncapped[entry.first] = GetWeight(*entry.second);
+
+  double remaining_threads = total_threads_;
+  bool capped_any = true;
+  while (capped_any && uncapped.count(id)) {
+    capped_any = false;
+    double total_weight = 0;
+    for (const auto& entry : uncapped)
+      total_weight += entry.second;
+    if (total_weight <= 0)
+      break;
+
+    for (auto entry = uncapped.begin(); entry != uncapped.end();) {
+      const int max_threads = clients_[entry->first]->max_threads;
+      if (entry->second / total_weight * remaining_threads >= max_threads) {
+        remaining_threads -= max_threads;
+        entry = uncapped.erase(entry);
+        capped_any = true;
+      } else {
+        ++entry;
+      }
+    }
+  }
+
+  double share = client->max_threads;
+  if (uncapped.count(id)) {
+    double total_weight = 0;
+    for (const auto& entry : uncapped)
+      total_weight += entry.second;
+    if (total_weight > 0)
+      share = uncapped[id] / total_weight * std::max(remaining_threads, 0.0);
+  }
+  share = std::min(share, static_cast<double>(client->max_threads));
+  share = std::max(share, static_cast<double>(client->min_threads));
+
+  if (!client->has_thread_count ||
+      std::abs(share - client->current_threads) >
+          0.5 + kThreadCountHysteresis) {
+    client->current_threads = static_cast<int>(std::lround(share));
+    client->has_thread_count = true;
+  }
+  return client->current_threads;
+}
+
+double DecodeThreadBudget::GetWeight(const Client& client) const {
+  lock_.AssertAcquired();
+  if (client.decode_time.count() >= kMinDecodeTimeSamples)
+    return client.decode_time.Average().InMicroseconds();
+
+  return static_cast<double>(client.coded_size.GetArea()) /
+         (1920 * 1080) * kEstimatedDecodeTimeFor1080pUs;
+}
+
+}  // namespace media
@@ -0,0 +1,102 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FILTERS_DECODE_THREAD_BUDGET_H_
+#define MEDIA_FILTERS_DECODE_THREAD_BUDGET_H_
+
+#include <map>
+#include <memory>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+class MovingAverage;
+
+// Splits a process-wide budget of software video decode threads among all
+// active decoders.  Without it every FFmpegVideoDecoder and VpxVideoDecoder
+// sizes its thread pool as if it were alone in the process, so pages with many
+// concurrent streams (e.g. video walls) heavily oversubscribe the CPU.
+//
+// Each decoder registers with the resolution it is decoding and the thread
+// count it would pick on its own.  The budget is then distributed in proportion
+// to each decoder's weight; the weight is estimated from the pixel count until
+// enough decode time samples have been reported, after which the measured
+// average decode time is used instead.  A decoder never receives more than the
+// thread count it asked for, nor fewer than its minimum; the latter means the
+// budget may be exceeded when there are more decoders than threads.
+//
+// Decoders should query GetThreadCount() at initialization and again at
+// keyframes (where reconfiguring the codec is cheap) to follow load changes.
+// Since every change in thread count recreates the codec, a decoder's count is
+// only changed once its share of the budget has moved well past the next
+// whole thread; small shifts in the measured decode times are ignored.
+//
+// This class is thread safe; decoders may live on different threads.
+class MEDIA_EXPORT DecodeThreadBudget {
+ public:
+  using ClientId = int;
+  enum { kInvalidClientId = 0 };
+
+  // Number of decode time samples required before measured decode time
+  // replaces the resolution based estimate of a decoder's weight.
+  enum { kMinDecodeTimeSamples = 8 };
+
+  // Returns the process-wide instance, sized from the number of processors.
+  static DecodeThreadBudget* GetInstance();
+
+  // Returns true if the command line has a valid --video-threads flag, in
+  // which case decoders should use it and bypass the budget entirely.
+  static bool HasThreadCountOverride();
+
+  // Creates a budget of |total_threads| threads; exposed for testing.
+  explicit DecodeThreadBudget(int total_threads);
+  ~DecodeThreadBudget();
+
+  // Registers a decoder of |coded_size| which would use |max_threads| if it
+  // were the only decoder and needs at least |min_threads|.  Returns an id to
+  // be passed to the other methods.
+  ClientId RegisterDecoder(const gfx::Size& coded_size,
+                           int min_threads,
+                           int max_threads);
+
+  // Unregisters |id|; its share of the budget is returned to other decoders.
+  void UnregisterDecoder(ClientId id);
+
+  // Updates the resolution and unconstrained thread count of |id| after a
+  // config change.  Previously reported decode times are discarded.
+  void UpdateDecoder(ClientId id, const gfx::Size& coded_size, int max_threads);
+
+  // Reports the wall clock time a single decode call of |id| took.  Decoders
+  // whose decode calls return before the frame is decoded, e.g. with FFmpeg
+  // frame threading, should not report samples.
+  void AddDecodeTimeSample(ClientId id, base::TimeDelta decode_time);
+
+  // Returns the number of threads |id| should currently use.
+  int GetThreadCount(ClientId id);
+
+  int total_threads() const { return total_threads_; }
+
+ private:
+  struct Client;
+
+  // Returns the relative cost of |client|.  |lock_| must be held.
+  double GetWeight(const Client& client) const;
+
+  const int total_threads_;
+
+  base::Lock lock_;
+  ClientId next_client_id_;
+  std::map<ClientId, std::unique_ptr<Client>> clients_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecodeThreadBudget);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_DECODE_THREAD_BUDGET_H_
@@ -0,0 +1,138 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/decode_thread_budget.h"
+
+#include "base/macros.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static const gfx::Size k1080p(1920, 1080);
+static const gfx::Size k720p(1280, 720);
+static const gfx::Size k360p(640, 360);
+
+class DecodeThreadBudgetTest : public testing::Test {
+ public:
+  DecodeThreadBudgetTest() : budget_(8) {}
+
+ protected:
+  void AddSamples(DecodeThreadBudget::ClientId id,
+                  int count,
+                  base::TimeDelta decode_time) {
+    for (int i = 0; i < count; ++i)
+      budget_.AddDecodeTimeSample(id, decode_time);
+  }
+
+  DecodeThreadBudget budget_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DecodeThreadBudgetTest);
+};
+
+TEST_F(DecodeThreadBudgetTest, SingleDecoderGetsRequestedThreads) {
+  DecodeThreadBudget::ClientId id = budget_.RegisterDecoder(k1080p, 1, 3);
+  EXPECT_EQ(3, budget_.GetThreadCount(id));
+  budget_.UnregisterDecoder(id);
+}
+
+TEST_F(DecodeThreadBudgetTest, SingleDecoderCappedByBudget) {
+  DecodeThreadBudget::ClientId id = budget_.RegisterDecoder(k1080p, 1, 12);
+  EXPECT_EQ(budget_.total_threads(), budget_.GetThreadCount(id));
+  budget_.UnregisterDecoder(id);
+}
+
+TEST_F(DecodeThreadBudgetTest, EqualDecodersSplitEvenly) {
+  DecodeThreadBudget::ClientId ids[4];
+  for (auto& id : ids)
+    id = budget_.RegisterDecoder(k1080p, 1, 16);
+  for (auto id : ids)
+    EXPECT_EQ(2, budget_.GetThreadCount(id));
+  for (auto id : ids)
+    budget_.UnregisterDecoder(id);
+}
+
+TEST_F(DecodeThreadBudgetTest, SplitByResolution) {
+  DecodeThreadBudget::ClientId large = budget_.RegisterDecoder(k1080p, 1, 16);
+  DecodeThreadBudget::ClientId small = budget_.RegisterDecoder(k360p, 1, 16);
+  EXPECT_EQ(7, budget_.GetThreadCount(large));
+  EXPECT_EQ(1, budget_.GetThreadCount(small));
+  budget_.UnregisterDecoder(large);
+  budget_.UnregisterDecoder(small);
+}
+
+TEST_F(DecodeThreadBudgetTest, UnusedShareIsRedistributed) {
+  DecodeThreadBudget::ClientId capped = budget_.RegisterDecoder(k1080p, 1, 2);
+  DecodeThreadBudget::ClientId other = budget_.RegisterDecoder(k720p, 1, 16);
+  EXPECT_EQ(2, budget_.GetThreadCount(capped));
+  EXPECT_EQ(6, budget_.GetThreadCount(other));
+  budget_.UnregisterDecoder(capped);
+  budget_.UnregisterDecoder(other);
+}
+
+TEST_F(DecodeThreadBudgetTest, MinimumIsHonoredWhenOversubscribed) {
+  DecodeThreadBudget::ClientId ids[16];
+  for (auto& id : ids)
+    id = budget_.RegisterDecoder(k720p, 2, 4);
+  for (auto id : ids)
+    EXPECT_EQ(2, budget_.GetThreadCount(id));
+  for (auto id : ids)
+    budget_.UnregisterDecoder(id);
+}
+
+TEST_F(DecodeThreadBudgetTest, UnregisterReturnsShare) {
+  DecodeThreadBudget::ClientId first = budget_.RegisterDecoder(k1080p, 1, 16);
+  DecodeThreadBudget::ClientId second = budget_.RegisterDecoder(k1080p, 1, 16);
+  EXPECT_EQ(4, budget_.GetThreadCount(first));
+  budget_.UnregisterDecoder(second);
+  EXPECT_EQ(8, budget_.GetThreadCount(first));
+  budget_.UnregisterDecoder(first);
+}
+
+TEST_F(DecodeThreadBudgetTest, MeasuredDecodeTimeOverridesResolution) {
+  DecodeThreadBudget::ClientId first = budget_.RegisterDecoder(k720p, 1, 16);
+  DecodeThreadBudget::ClientId second = budget_.RegisterDecoder(k720p, 1, 16);
+  EXPECT_EQ(4, budget_.GetThreadCount(first));
+  EXPECT_EQ(4, budget_.GetThreadCount(second));
+
+  // Both decoders run with four threads; the first is three times as costly.
+  AddSamples(first, DecodeThreadBudget::kMinDecodeTimeSamples,
+             base::TimeDelta::FromMilliseconds(9));
+  AddSamples(second, DecodeThreadBudget::kMinDecodeTimeSamples,
+             base::TimeDelta::FromMilliseconds(3));
+  EXPECT_EQ(6, budget_.GetThreadCount(first));
+  EXPECT_EQ(2, budget_.GetThreadCount(second));
+
+  // A config change discards the measurements.
+  budget_.UpdateDecoder(first, k720p, 16);
+  budget_.UpdateDecoder(second, k720p, 16);
+  EXPECT_EQ(4, budget_.GetThreadCount(first));
+  EXPECT_EQ(4, budget_.GetThreadCount(second));
+
+  budget_.UnregisterDecoder(first);
+  budget_.UnregisterDecoder(second);
+}
+
+TEST_F(DecodeThreadBudgetTest, SmallShiftsDoNotChangeThreadCount) {
+  DecodeThreadBudget::ClientId first = budget_.RegisterDecoder(k720p, 1, 16);
+  DecodeThreadBudget::ClientId second = budget_.RegisterDecoder(k720p, 1, 16);
+  EXPECT_EQ(4, budget_.GetThreadCount(first));
+  EXPECT_EQ(4, budget_.GetThreadCount(second));
+
+  // The shares are now 4.6 and 3.4 threads, which would round to 5 and 3 but
+  // are not far enough from the current count to recreate the codecs.
+  AddSamples(first, DecodeThreadBudget::kMinDecodeTimeSamples,
+             base::TimeDelta::FromMilliseconds(23));
+  AddSamples(second, DecodeThreadBudget::kMinDecodeTimeSamples,
+             base::TimeDelta::FromMilliseconds(17));
+  EXPECT_EQ(4, budget_.GetThreadCount(first));
+  EXPECT_EQ(4, budget_.GetThreadCount(second));
+
+  // Once the share has moved past the hysteresis the count follows it.
+  budget_.UnregisterDecoder(second);
+  EXPECT_EQ(8, budget_.GetThreadCount(first));
+  budget_.UnregisterDecoder(first);
+}
+
+}  // namespace media
@@ -4,6 +4,7 @@
 
 #include "media/filters/decoder_stream.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
@@ -17,9 +18,11 @@
 #include "media/base/decoder_buffer.h"
 #include "media/base/limits.h"
 #include "media/base/media_log.h"
+#include "media/base/pipeline_latency_histograms.h"
 #include "media/base/timestamp_constants.h"
 #include "media/base/video_decoder.h"
 #include "media/base/video_frame.h"
+#include "media/filters/decode_ahead_controller.h"
 #include "media/filters/decrypting_demuxer_stream.h"
 
 namespace media {
@@ -59,7 +62,10 @@ DecoderStream<StreamType>::DecoderStream(
       active_splice_(false),
       decoding_eos_(false),
       pending_decode_requests_(0),
+      decode_ahead_controller_(nullptr),
+      latency_histograms_(nullptr),
       duration_tracker_(8),
+      preroll_target_(kNoTimestamp),
       received_config_change_during_reinit_(false),
       pending_demuxer_read_(false),
       weak_factory_(this),
@@ -144,6 +150,12 @@ void DecoderStream<StreamType>::Read(const ReadCB& read_cb) {
     task_runner_->PostTask(FROM_HERE,
                            base::Bind(read_cb, OK, ready_outputs_.front()));
     ready_outputs_.pop_front();
+    if (latency_histograms_) {
+      latency_histograms_->AddSample(
+          PipelineLatencyHistograms::OUTPUT_QUEUE,
+          base::TimeTicks::Now() - ready_output_times_.front());
+    }
+    ready_output_times_.pop_front();
   } else {
     read_cb_ = read_cb;
   }
@@ -168,6 +180,10 @@ void DecoderStream<StreamType>::Reset(const base::Closure& closure) {
   }
 
   ready_outputs_.clear();
+  ready_output_times_.clear();
+  preroll_target_ = kNoTimestamp;
+  last_preroll_output_ = nullptr;
+  preroll_lookahead_ = nullptr;
   traits_.OnStreamReset(stream_);
 
   // It's possible to have received a DECODE_ERROR and entered STATE_ERROR right
@@ -203,6 +219,15 @@ void DecoderStream<StreamType>::Reset(const base::Closure& closure) {
   ResetDecoder();
 }
 
+template <DemuxerStream::Type StreamType>
+void DecoderStream<StreamType>::SetPrerollTarget(base::TimeDelta timestamp) {
+  FUNCTION_DVLOG(2) << ": " << timestamp.InMilliseconds() << " ms";
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(reset_cb_.is_null());
+  preroll_target_ = timestamp;
+  last_preroll_output_ = nullptr;
+}
+
 template <DemuxerStream::Type StreamType>
 bool DecoderStream<StreamType>::CanReadWithoutStalling() const {
   DCHECK(task_runner_->BelongsToCurrentThread());
@@ -225,6 +250,14 @@ int DecoderStream<DemuxerStream::AUDIO>::GetMaxDecodeRequests() const {
   return 1;
 }
 
+template <DemuxerStream::Type StreamType>
+int DecoderStream<StreamType>::GetDecodeAheadDepth() const {
+  const int max_decode_requests = GetMaxDecodeRequests();
+  if (!decode_ahead_controller_)
+    return max_decode_requests;
+  return decode_ahead_controller_->GetDecodeAheadDepth(max_decode_requests);
+}
+
 template <DemuxerStream::Type StreamType>
 bool DecoderStream<StreamType>::CanDecodeMore() const {
   DCHECK(task_runner_->BelongsToCurrentThread());
@@ -236,7 +269,7 @@ bool DecoderStream<StreamType>::CanDecodeMore() const {
   // empty.
   int num_decodes =
       static_cast<int>(ready_outputs_.size()) + pending_decode_requests_;
-  return buffers_left && num_decodes < GetMaxDecodeRequests();
+  return buffers_left && num_decodes < GetDecodeAheadDepth();
 }
 
 template <DemuxerStream::Type StreamType>
@@ -246,6 +279,18 @@ base::TimeDelta DecoderStream<StreamType>::AverageDuration() const {
                                    : base::TimeDelta();
 }
 
+template <DemuxerStream::Type StreamType>
+bool DecoderStream<StreamType>::IsBeforePrerollTarget(
+    const scoped_refptr<DecoderBuffer>& buffer) const {
+  if (buffer->end_of_stream() || preroll_target_ == kNoTimestamp)
+    return false;
+
+  // Matches the check in OnDecodeOutputReady().
+  const base::TimeDelta duration = AverageDuration();
+  return duration > base::TimeDelta() &&
+         buffer->timestamp() + duration < preroll_target_;
+}
+
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::SelectDecoder(CdmContext* cdm_context) {
   decoder_selector_->SelectDecoder(
@@ -280,6 +325,7 @@ void DecoderStream<StreamType>::OnDecoderSelected(
   decoder_ = std::move(selected_decoder);
   if (decrypting_demuxer_stream) {
     decrypting_demuxer_stream_ = std::move(decrypting_demuxer_stream);
+    decrypting_demuxer_stream_->set_latency_histograms(latency_histograms_);
     stream_ = decrypting_demuxer_stream_.get();
   }
 
@@ -332,7 +378,8 @@ void DecoderStream<StreamType>::SatisfyRead(
 
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::Decode(
-    const scoped_refptr<DecoderBuffer>& buffer) {
+    const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output) {
   FUNCTION_DVLOG(2);
 
   // We don't know if the decoder will error out on first decode yet. Save the
@@ -344,25 +391,28 @@ void DecoderStream<StreamType>::Decode(
   // fallback decoder successfully completed its initialization. At this point
   // |pending_buffers_| has already been copied to |fallback_buffers_| and we
   // need to append it ourselves.
+  // The hint belongs to |buffer| and is dropped along the way.
   if (!fallback_buffers_.empty()) {
     fallback_buffers_.push_back(buffer);
 
     scoped_refptr<DecoderBuffer> temp = fallback_buffers_.front();
     fallback_buffers_.pop_front();
-    DecodeInternal(temp);
+    DecodeInternal(temp, false);
   } else {
-    DecodeInternal(buffer);
+    DecodeInternal(buffer, discard_output);
   }
 }
 
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::DecodeInternal(
-    const scoped_refptr<DecoderBuffer>& buffer) {
+    const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output) {
   FUNCTION_DVLOG(2);
   DCHECK(state_ == STATE_NORMAL || state_ == STATE_FLUSHING_DECODER) << state_;
   DCHECK_LT(pending_decode_requests_, GetMaxDecodeRequests());
   DCHECK(reset_cb_.is_null());
   DCHECK(buffer.get());
+  DCHECK(!discard_output || !buffer->end_of_stream());
 
   traits_.OnDecode(buffer);
 
@@ -379,21 +429,23 @@ void DecoderStream<StreamType>::DecodeInternal(
     duration_tracker_.AddSample(buffer->duration());
 
   ++pending_decode_requests_;
-  decoder_->Decode(buffer, base::Bind(&DecoderStream<StreamType>::OnDecodeDone,
-                                      fallback_weak_factory_.GetWeakPtr(),
-                                      buffer_size, buffer->end_of_stream()));
+  traits_.Decode(decoder_.get(), buffer, discard_output,
+                 base::Bind(&DecoderStream<StreamType>::OnDecodeDone,
+                            fallback_weak_factory_.GetWeakPtr(), buffer_size,
+                            buffer->end_of_stream(), base::TimeTicks::Now()));
 }
 
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::FlushDecoder() {
   // Send the EOS directly to the decoder, bypassing a potential add to
   // |pending_buffers_|.
-  DecodeInternal(DecoderBuffer::CreateEOSBuffer());
+  DecodeInternal(DecoderBuffer::CreateEOSBuffer(), false);
 }
 
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::OnDecodeDone(int buffer_size,
                                              bool end_of_stream,
+                                             base::TimeTicks decode_start,
                                              DecodeStatus status) {
   FUNCTION_DVLOG(2) << ": " << status;
   DCHECK(state_ == STATE_NORMAL || state_ == STATE_FLUSHING_DECODER ||
@@ -403,6 +455,14 @@ void DecoderStream<StreamType>::OnDecodeDone(int buffer_size,
 
   --pending_decode_requests_;
 
+  // Unlike |decode_time|, the latency includes the time spent queued behind
+  // earlier requests.
+  const base::TimeTicks decode_done = base::TimeTicks::Now();
+  const base::TimeDelta decode_time =
+      decode_done - std::max(decode_start, last_decode_done_time_);
+  const base::TimeDelta decode_latency = decode_done - decode_start;
+  last_decode_done_time_ = decode_done;
+
   TRACE_EVENT_ASYNC_END0("media", GetTraceString<StreamType>(), this);
 
   if (end_of_stream) {
@@ -429,6 +489,12 @@ void DecoderStream<StreamType>::OnDecodeDone(int buffer_size,
         // from being called back.
         fallback_weak_factory_.InvalidateWeakPtrs();
 
+        // The fallback decoder gets the held buffer along with the rest.
+        if (preroll_lookahead_) {
+          pending_buffers_.push_back(preroll_lookahead_);
+          preroll_lookahead_ = nullptr;
+        }
+
         state_ = STATE_REINITIALIZING_DECODER;
         decoder_selector_->SelectDecoder(
             &traits_, stream_, nullptr,
@@ -442,6 +508,7 @@ void DecoderStream<StreamType>::OnDecodeDone(int buffer_size,
       state_ = STATE_ERROR;
       MEDIA_LOG(ERROR, media_log_) << GetStreamTypeString() << " decode error";
       ready_outputs_.clear();
+      ready_output_times_.clear();
       if (!read_cb_.is_null())
         SatisfyRead(DECODE_ERROR, NULL);
       return;
@@ -456,8 +523,26 @@ void DecoderStream<StreamType>::OnDecodeDone(int buffer_size,
       if (buffer_size > 0)
         StreamTraits::ReportStatistics(statistics_cb_, buffer_size);
 
+      if (!end_of_stream) {
+        if (decode_ahead_controller_)
+          decode_ahead_controller_->AddDecodeTime(decode_time);
+        if (latency_histograms_) {
+          latency_histograms_->AddSample(PipelineLatencyHistograms::DECODE,
+                                         decode_latency);
+        }
+      }
+
       if (state_ == STATE_NORMAL) {
         if (end_of_stream) {
+          // Nothing reached the preroll target; returning the last output is
+          // better than returning none.
+          if (last_preroll_output_) {
+            preroll_target_ = kNoTimestamp;
+            scoped_refptr<Output> output;
+            output.swap(last_preroll_output_);
+            QueueOutput(output);
+          }
+
           state_ = STATE_END_OF_STREAM;
           if (ready_outputs_.empty() && !read_cb_.is_null())
             SatisfyRead(OK, StreamTraits::CreateEOSOutput());
@@ -504,16 +589,40 @@ void DecoderStream<StreamType>::OnDecodeOutputReady(
   // reading from there before requesting new buffers from |stream_|.
   pending_buffers_.clear();
 
+  // Drop outputs which end before the preroll target.  Without a duration
+  // estimate there is no telling, so everything is kept.
+  if (preroll_target_ != kNoTimestamp) {
+    const base::TimeDelta duration = AverageDuration();
+    if (duration > base::TimeDelta() &&
+        output->timestamp() + duration < preroll_target_) {
+      last_preroll_output_ = output;
+      return;
+    }
+    preroll_target_ = kNoTimestamp;
+    last_preroll_output_ = nullptr;
+  }
+
+  QueueOutput(output);
+}
+
+template <DemuxerStream::Type StreamType>
+void DecoderStream<StreamType>::QueueOutput(
+    const scoped_refptr<Output>& output) {
   if (!read_cb_.is_null()) {
     // If |ready_outputs_| was non-empty, the read would have already been
     // satisifed by Read().
     DCHECK(ready_outputs_.empty());
+    if (latency_histograms_) {
+      latency_histograms_->AddSample(PipelineLatencyHistograms::OUTPUT_QUEUE,
+                                     base::TimeDelta());
+    }
     SatisfyRead(OK, output);
     return;
   }
 
   // Store decoded output.
   ready_outputs_.push_back(output);
+  ready_output_times_.push_back(base::TimeTicks::Now());
 
   // Destruct any previous decoder once we've decoded enough frames to ensure
   // that it's no longer in use.
@@ -535,7 +644,16 @@ void DecoderStream<StreamType>::ReadFromDemuxerStream() {
     fallback_buffers_.pop_front();
 
     // Decode the buffer without re-appending it to |pending_buffers_|.
-    DecodeInternal(buffer);
+    DecodeInternal(buffer, false);
+    return;
+  }
+
+  // A held buffer which is no longer discardable, because the preroll target
+  // has been reached or it is waiting on a free decode slot, goes next.
+  if (preroll_lookahead_ && !IsBeforePrerollTarget(preroll_lookahead_)) {
+    scoped_refptr<DecoderBuffer> buffer;
+    buffer.swap(preroll_lookahead_);
+    Decode(buffer, false);
     return;
   }
 
@@ -544,6 +662,7 @@ void DecoderStream<StreamType>::ReadFromDemuxerStream() {
     return;
 
   pending_demuxer_read_ = true;
+  demuxer_read_start_ = base::TimeTicks::Now();
   stream_->Read(base::Bind(&DecoderStream<StreamType>::OnBufferReady,
                            weak_factory_.GetWeakPtr()));
 }
@@ -568,6 +687,12 @@ void DecoderStream<StreamType>::OnBufferReady(
   DCHECK_EQ(buffer.get() != NULL, status == DemuxerStream::kOk) << status;
   pending_demuxer_read_ = false;
 
+  if (latency_histograms_ && status == DemuxerStream::kOk) {
+    latency_histograms_->AddSample(
+        PipelineLatencyHistograms::DEMUXER_READ,
+        base::TimeTicks::Now() - demuxer_read_start_);
+  }
+
   // If parallel decode requests are supported, multiple read requests might
   // have been sent to the demuxer. The buffers might arrive while the decoder
   // is reinitializing after falling back on first decode error.
@@ -612,6 +737,11 @@ void DecoderStream<StreamType>::OnBufferReady(
 
   state_ = STATE_NORMAL;
 
+  // A held buffer precedes the preroll target and anything following a config
+  // change or abort; nothing is lost by dropping it.
+  if (status != DemuxerStream::kOk)
+    preroll_lookahead_ = nullptr;
+
   if (status == DemuxerStream::kConfigChanged) {
     FUNCTION_DVLOG(2) << ": " << "ConfigChanged";
     DCHECK(stream_->SupportsConfigChanges());
@@ -675,13 +805,37 @@ void DecoderStream<StreamType>::OnBufferReady(
   }
 
   DCHECK(status == DemuxerStream::kOk) << status;
-  Decode(buffer);
+  DecodeWithPrerollLookahead(buffer);
 
   // Read more data if the decoder supports multiple parallel decoding requests.
   if (CanDecodeMore())
     ReadFromDemuxerStream();
 }
 
+template <DemuxerStream::Type StreamType>
+void DecoderStream<StreamType>::DecodeWithPrerollLookahead(
+    const scoped_refptr<DecoderBuffer>& buffer) {
+  scoped_refptr<DecoderBuffer> lookahead;
+  lookahead.swap(preroll_lookahead_);
+  if (lookahead) {
+    DCHECK(!lookahead->end_of_stream());
+    // Something follows |lookahead|, so unless that is the end of stream, a
+    // later output will be shown instead of |lookahead|'s.
+    Decode(lookahead,
+           IsBeforePrerollTarget(lookahead) && !buffer->end_of_stream());
+  }
+
+  // |buffer| is held if it may be discardable, or if decoding |lookahead| used
+  // up the last decode slot.
+  if (IsBeforePrerollTarget(buffer) ||
+      (lookahead && pending_decode_requests_ >= GetMaxDecodeRequests())) {
+    preroll_lookahead_ = buffer;
+    return;
+  }
+
+  Decode(buffer, false);
+}
+
 template <DemuxerStream::Type StreamType>
 void DecoderStream<StreamType>::ReinitializeDecoder() {
   FUNCTION_DVLOG(2);
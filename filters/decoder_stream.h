@@ -32,7 +32,9 @@ class SingleThreadTaskRunner;
 namespace media {
 
 class CdmContext;
+class DecodeAheadController;
 class DecryptingDemuxerStream;
+class PipelineLatencyHistograms;
 
 // Wraps a DemuxerStream and a list of Decoders and provides decoded
 // output to its client (e.g. Audio/VideoRendererImpl).
@@ -99,9 +101,34 @@ class MEDIA_EXPORT DecoderStream {
   // Returns maximum concurrent decode requests for the current |decoder_|.
   int GetMaxDecodeRequests() const;
 
+  // Returns how many decode requests, including decoded outputs which have not
+  // been read yet, are currently allowed; at most GetMaxDecodeRequests().
+  int GetDecodeAheadDepth() const;
+
+  // Lets |controller| adapt GetDecodeAheadDepth() to measured decode times,
+  // which are reported to it.  |controller| must outlive this object.  Without
+  // a controller, GetMaxDecodeRequests() decodes are always allowed.
+  void set_decode_ahead_controller(DecodeAheadController* controller) {
+    decode_ahead_controller_ = controller;
+  }
+
+  // Records the demuxer read, decrypt, decode and output queue latency of each
+  // buffer into |histograms|, which must outlive this object.
+  void set_latency_histograms(PipelineLatencyHistograms* histograms) {
+    latency_histograms_ = histograms;
+  }
+
   // Returns true if one more decode request can be submitted to the decoder.
   bool CanDecodeMore() const;
 
+  // After a seek, decoding starts from the keyframe preceding |timestamp|.
+  // Outputs which end before |timestamp| are dropped rather than queued or
+  // returned, until the first one which doesn't; if the stream ends first, the
+  // last of them is returned.  Buffers whose output would be dropped are also
+  // decoded with VideoDecoder::DecodeDiscardingOutput(), letting the decoder
+  // skip producing it.  Cleared by Reset().
+  void SetPrerollTarget(base::TimeDelta timestamp);
+
   base::TimeDelta AverageDuration() const;
 
   // Allows callers to register for notification of splice buffers from the
@@ -160,22 +187,38 @@ class MEDIA_EXPORT DecoderStream {
                    const scoped_refptr<Output>& output);
 
   // Decodes |buffer| and returns the result via OnDecodeOutputReady().
-  // Saves |buffer| into |pending_buffers_| if appropriate.
-  void Decode(const scoped_refptr<DecoderBuffer>& buffer);
+  // Saves |buffer| into |pending_buffers_| if appropriate.  If
+  // |discard_output|, the decoder is told that the output of |buffer| will be
+  // dropped; see SetPrerollTarget().
+  void Decode(const scoped_refptr<DecoderBuffer>& buffer, bool discard_output);
 
   // Performs the heavy lifting of the decode call.
-  void DecodeInternal(const scoped_refptr<DecoderBuffer>& buffer);
+  void DecodeInternal(const scoped_refptr<DecoderBuffer>& buffer,
+                      bool discard_output);
 
   // Flushes the decoder with an EOS buffer to retrieve internally buffered
   // decoder output.
   void FlushDecoder();
 
-  // Callback for Decoder::Decode().
-  void OnDecodeDone(int buffer_size, bool end_of_stream, DecodeStatus status);
+  // Callback for Decoder::Decode(). |decode_start| is when the buffer was
+  // submitted; see |last_decode_done_time_|.
+  void OnDecodeDone(int buffer_size,
+                    bool end_of_stream,
+                    base::TimeTicks decode_start,
+                    DecodeStatus status);
 
   // Output callback passed to Decoder::Initialize().
   void OnDecodeOutputReady(const scoped_refptr<Output>& output);
 
+  // Returns |output| to the pending Read() or queues it in |ready_outputs_|.
+  void QueueOutput(const scoped_refptr<Output>& output);
+
+  // Returns true if |buffer| ends before the preroll target.
+  bool IsBeforePrerollTarget(const scoped_refptr<DecoderBuffer>& buffer) const;
+
+  // Decodes |buffer| from the demuxer, first decoding |preroll_lookahead_|.
+  void DecodeWithPrerollLookahead(const scoped_refptr<DecoderBuffer>& buffer);
+
   // Reads a buffer from |stream_| and returns the result via OnBufferReady().
   void ReadFromDemuxerStream();
 
@@ -237,12 +280,42 @@ class MEDIA_EXPORT DecoderStream {
   // parallel decoding.
   std::list<scoped_refptr<Output> > ready_outputs_;
 
+  // When each of |ready_outputs_| was decoded.
+  std::deque<base::TimeTicks> ready_output_times_;
+
   // Number of outstanding decode requests sent to the |decoder_|.
   int pending_decode_requests_;
 
+  // When the last decode request completed.  A request queued behind others
+  // in the decoder is only timed from then, so that decode times don't include
+  // the time spent waiting on earlier requests.
+  base::TimeTicks last_decode_done_time_;
+
+  // Adapts the number of decode requests in flight, if set.
+  DecodeAheadController* decode_ahead_controller_;
+
+  // Receives per-buffer latencies, if set.
+  PipelineLatencyHistograms* latency_histograms_;
+
+  // When the pending demuxer read was issued.
+  base::TimeTicks demuxer_read_start_;
+
   // Tracks the duration of incoming packets over time.
   MovingAverage duration_tracker_;
 
+  // See SetPrerollTarget(); kNoTimestamp when not prerolling.
+  base::TimeDelta preroll_target_;
+
+  // The most recently dropped preroll output.
+  scoped_refptr<Output> last_preroll_output_;
+
+  // A buffer read from the demuxer but not yet decoded.  While prerolling, a
+  // buffer is held until the next one arrives, since its output is only
+  // discardable if it is not the last before end of stream.  Also holds a
+  // buffer which could not be decoded immediately after the held one because
+  // the decoder was saturated; ReadFromDemuxerStream() decodes it.
+  scoped_refptr<DecoderBuffer> preroll_lookahead_;
+
   // Stores buffers that might be reused if the decoder fails right after
   // Initialize().
   std::deque<scoped_refptr<DecoderBuffer>> pending_buffers_;
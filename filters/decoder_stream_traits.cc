@@ -33,6 +33,15 @@ bool DecoderStreamTraits<DemuxerStream::AUDIO>::NeedsBitstreamConversion(
   return decoder->NeedsBitstreamConversion();
 }
 
+void DecoderStreamTraits<DemuxerStream::AUDIO>::Decode(
+    DecoderType* decoder,
+    const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output,
+    const DecodeCB& decode_cb) {
+  // Audio decoders take no hint; dropping their output is cheap anyway.
+  decoder->Decode(buffer, decode_cb);
+}
+
 void DecoderStreamTraits<DemuxerStream::AUDIO>::ReportStatistics(
     const StatisticsCB& statistics_cb,
     int bytes_decoded) {
@@ -67,6 +76,17 @@ bool DecoderStreamTraits<DemuxerStream::VIDEO>::NeedsBitstreamConversion(
   return decoder->NeedsBitstreamConversion();
 }
 
+void DecoderStreamTraits<DemuxerStream::VIDEO>::Decode(
+    DecoderType* decoder,
+    const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output,
+    const DecodeCB& decode_cb) {
+  if (discard_output)
+    decoder->DecodeDiscardingOutput(buffer, decode_cb);
+  else
+    decoder->Decode(buffer, decode_cb);
+}
+
 void DecoderStreamTraits<DemuxerStream::VIDEO>::ReportStatistics(
     const StatisticsCB& statistics_cb,
     int bytes_decoded) {
@@ -6,6 +6,7 @@
 #define MEDIA_FILTERS_DECODER_STREAM_TRAITS_H_
 
 #include "media/base/cdm_context.h"
+#include "media/base/decode_status.h"
 #include "media/base/demuxer_stream.h"
 #include "media/base/pipeline_status.h"
 #include "media/base/video_decoder_config.h"
@@ -33,6 +34,7 @@ class MEDIA_EXPORT DecoderStreamTraits<DemuxerStream::AUDIO> {
   typedef DecryptingAudioDecoder DecryptingDecoderType;
   typedef base::Callback<void(bool success)> InitCB;
   typedef base::Callback<void(const scoped_refptr<OutputType>&)> OutputCB;
+  typedef base::Callback<void(DecodeStatus)> DecodeCB;
 
   explicit DecoderStreamTraits(const scoped_refptr<MediaLog>& media_log);
 
@@ -43,6 +45,10 @@ class MEDIA_EXPORT DecoderStreamTraits<DemuxerStream::AUDIO> {
                          const InitCB& init_cb,
                          const OutputCB& output_cb);
   static bool NeedsBitstreamConversion(DecoderType* decoder);
+  static void Decode(DecoderType* decoder,
+                     const scoped_refptr<DecoderBuffer>& buffer,
+                     bool discard_output,
+                     const DecodeCB& decode_cb);
   void OnDecode(const scoped_refptr<DecoderBuffer>& buffer);
   void OnDecodeDone(const scoped_refptr<OutputType>& buffer);
   void OnStreamReset(DemuxerStream* stream);
@@ -67,6 +73,7 @@ class MEDIA_EXPORT DecoderStreamTraits<DemuxerStream::VIDEO> {
   typedef DecryptingVideoDecoder DecryptingDecoderType;
   typedef base::Callback<void(bool success)> InitCB;
   typedef base::Callback<void(const scoped_refptr<OutputType>&)> OutputCB;
+  typedef base::Callback<void(DecodeStatus)> DecodeCB;
 
   explicit DecoderStreamTraits(const scoped_refptr<MediaLog>& media_log) {}
 
@@ -77,6 +84,10 @@ class MEDIA_EXPORT DecoderStreamTraits<DemuxerStream::VIDEO> {
                          const InitCB& init_cb,
                          const OutputCB& output_cb);
   static bool NeedsBitstreamConversion(DecoderType* decoder);
+  static void Decode(DecoderType* decoder,
+                     const scoped_refptr<DecoderBuffer>& buffer,
+                     bool discard_output,
+                     const DecodeCB& decode_cb);
   void OnDecode(const scoped_refptr<DecoderBuffer>& buffer) {}
   void OnDecodeDone(const scoped_refptr<OutputType>& buffer) {}
   void OnStreamReset(DemuxerStream* stream) {}
@@ -14,6 +14,7 @@
 #include "media/base/decoder_buffer.h"
 #include "media/base/media_log.h"
 #include "media/base/media_util.h"
+#include "media/base/pipeline_latency_histograms.h"
 
 namespace media {
 
@@ -37,6 +38,7 @@ DecryptingDemuxerStream::DecryptingDemuxerStream(
       demuxer_stream_(NULL),
       decryptor_(NULL),
       key_added_while_decrypt_pending_(false),
+      latency_histograms_(nullptr),
       weak_factory_(this) {}
 
 std::string DecryptingDemuxerStream::GetDisplayName() const {
@@ -258,6 +260,7 @@ void DecryptingDemuxerStream::DecryptBuffer(
 void DecryptingDemuxerStream::DecryptPendingBuffer() {
   DCHECK(task_runner_->BelongsToCurrentThread());
   DCHECK_EQ(state_, kPendingDecrypt) << state_;
+  decrypt_start_ = base::TimeTicks::Now();
   decryptor_->Decrypt(
       GetDecryptorStreamType(),
       pending_buffer_to_decrypt_,
@@ -318,6 +321,11 @@ void DecryptingDemuxerStream::DeliverBuffer(
 
   DCHECK_EQ(status, Decryptor::kSuccess);
 
+  if (latency_histograms_) {
+    latency_histograms_->AddSample(PipelineLatencyHistograms::DECRYPT,
+                                   base::TimeTicks::Now() - decrypt_start_);
+  }
+
   // Copy the key frame flag from the encrypted to decrypted buffer, assuming
   // that the decryptor initialized the flag to false.
   if (pending_buffer_to_decrypt_->is_key_frame())
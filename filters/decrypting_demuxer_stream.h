@@ -9,6 +9,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "media/base/audio_decoder_config.h"
 #include "media/base/cdm_context.h"
 #include "media/base/decryptor.h"
@@ -24,6 +25,7 @@ namespace media {
 
 class DecoderBuffer;
 class MediaLog;
+class PipelineLatencyHistograms;
 
 // Decryptor-based DemuxerStream implementation that converts a potentially
 // encrypted demuxer stream to a clear demuxer stream.
@@ -53,6 +55,12 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
   // Returns the name of this class for logging purpose.
   std::string GetDisplayName() const;
 
+  // Records how long each decryption takes into |histograms|, which must
+  // outlive this object.
+  void set_latency_histograms(PipelineLatencyHistograms* histograms) {
+    latency_histograms_ = histograms;
+  }
+
   // DemuxerStream implementation.
   void Read(const ReadCB& read_cb) override;
   AudioDecoderConfig audio_decoder_config() override;
@@ -131,6 +139,12 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
   // decrypting again in case the newly added key is the correct decryption key.
   bool key_added_while_decrypt_pending_;
 
+  // Receives decryption latencies, if set.
+  PipelineLatencyHistograms* latency_histograms_;
+
+  // When the pending buffer was last submitted to the |decryptor_|.
+  base::TimeTicks decrypt_start_;
+
   base::WeakPtr<DecryptingDemuxerStream> weak_this_;
   base::WeakPtrFactory<DecryptingDemuxerStream> weak_factory_;
 
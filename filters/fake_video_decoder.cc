@@ -19,6 +19,7 @@ FakeVideoDecoder::FakeVideoDecoder(int decoding_delay,
       state_(STATE_UNINITIALIZED),
       hold_decode_(false),
       total_bytes_decoded_(0),
+      num_discard_output_buffers_(0),
       fail_to_initialize_(false),
       weak_factory_(this) {
   DCHECK_GE(decoding_delay, 0);
@@ -109,6 +110,13 @@ void FakeVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
   RunOrHoldDecode(wrapped_decode_cb);
 }
 
+void FakeVideoDecoder::DecodeDiscardingOutput(
+    const scoped_refptr<DecoderBuffer>& buffer,
+    const DecodeCB& decode_cb) {
+  ++num_discard_output_buffers_;
+  Decode(buffer, decode_cb);
+}
+
 void FakeVideoDecoder::Reset(const base::Closure& closure) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(reset_cb_.IsNull());
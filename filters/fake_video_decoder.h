@@ -52,6 +52,8 @@ class FakeVideoDecoder : public VideoDecoder {
                   const OutputCB& output_cb) override;
   void Decode(const scoped_refptr<DecoderBuffer>& buffer,
               const DecodeCB& decode_cb) override;
+  void DecodeDiscardingOutput(const scoped_refptr<DecoderBuffer>& buffer,
+                              const DecodeCB& decode_cb) override;
   void Reset(const base::Closure& closure) override;
   int GetMaxDecodeRequests() const override;
 
@@ -75,6 +77,10 @@ class FakeVideoDecoder : public VideoDecoder {
 
   int total_bytes_decoded() const { return total_bytes_decoded_; }
 
+  // Number of buffers passed to DecodeDiscardingOutput().  Their output is
+  // still produced.
+  int num_discard_output_buffers() const { return num_discard_output_buffers_; }
+
  private:
   enum State {
     STATE_UNINITIALIZED,
@@ -118,6 +124,7 @@ class FakeVideoDecoder : public VideoDecoder {
   std::list<scoped_refptr<VideoFrame> > decoded_frames_;
 
   int total_bytes_decoded_;
+  int num_discard_output_buffers_;
 
   bool fail_to_initialize_;
 
@@ -12,6 +12,7 @@
 #include "base/base64.h"
 #include "base/bind.h"
 #include "base/callback_helpers.h"
+#include "base/feature_list.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/metrics/histogram_macros.h"
@@ -29,6 +30,7 @@
 #include "media/base/decrypt_config.h"
 #include "media/base/limits.h"
 #include "media/base/media_log.h"
+#include "media/base/media_switches.h"
 #include "media/base/media_tracks.h"
 #include "media/base/timestamp_constants.h"
 #include "media/base/video_codecs.h"
@@ -47,6 +49,10 @@
 
 namespace media {
 
+// Upper bound on how much a stream prefetches when it has no keyframe to end
+// its first GOP, e.g. audio or a long GOP.
+static const int kMaxPrefetchDurationMs = 2000;
+
 static base::Time ExtractTimelineOffset(AVFormatContext* format_context) {
   if (strstr(format_context->iformat->name, "webm") ||
       strstr(format_context->iformat->name, "matroska")) {
@@ -280,6 +286,7 @@ FFmpegDemuxerStream::FFmpegDemuxerStream(
       video_rotation_(VIDEO_ROTATION_0),
       is_enabled_(true),
       waiting_for_keyframe_(false),
+      prefetching_(false),
       fixup_negative_timestamps_(false) {
   DCHECK(demuxer_);
 
@@ -573,13 +580,25 @@ void FFmpegDemuxerStream::EnqueuePacket(ScopedAVPacket packet) {
   last_packet_timestamp_ = buffer->timestamp();
   last_packet_duration_ = buffer->duration();
 
+  // A video keyframe following queued buffers completes the first GOP.
+  const bool completes_gop = type_ == VIDEO && buffer->is_key_frame() &&
+                             !buffer_queue_.IsEmpty();
   buffer_queue_.Push(buffer);
+  if (prefetching_ &&
+      (completes_gop ||
+       buffer_queue_.Duration() >=
+           base::TimeDelta::FromMilliseconds(kMaxPrefetchDurationMs))) {
+    DVLOG(2) << "Prefetched " << buffer_queue_.Duration().InMilliseconds()
+             << "ms";
+    prefetching_ = false;
+  }
   SatisfyPendingRead();
 }
 
 void FFmpegDemuxerStream::SetEndOfStream() {
   DCHECK(task_runner_->BelongsToCurrentThread());
   end_of_stream_ = true;
+  prefetching_ = false;
   SatisfyPendingRead();
 }
 
@@ -594,6 +613,7 @@ void FFmpegDemuxerStream::FlushBuffers() {
 
   buffer_queue_.Clear();
   end_of_stream_ = false;
+  prefetching_ = false;
   last_packet_timestamp_ = kNoTimestamp;
   last_packet_duration_ = kNoTimestamp;
 }
@@ -613,6 +633,7 @@ void FFmpegDemuxerStream::Stop() {
   demuxer_ = NULL;
   stream_ = NULL;
   end_of_stream_ = true;
+  prefetching_ = false;
 }
 
 DemuxerStream::Type FFmpegDemuxerStream::type() const {
@@ -731,6 +752,8 @@ void FFmpegDemuxerStream::set_enabled(bool enabled, base::TimeDelta timestamp) {
   is_enabled_ = enabled;
   if (is_enabled_) {
     waiting_for_keyframe_ = true;
+  } else {
+    prefetching_ = false;
   }
   if (!is_enabled_ && !read_cb_.is_null()) {
     DVLOG(1) << "Read from disabled stream, returning EOS";
@@ -784,7 +807,7 @@ bool FFmpegDemuxerStream::HasAvailableCapacity() {
   // after our data sources support canceling/concurrent reads, see
   // http://crbug.com/165762 for details.
 #if 1
-  return !read_cb_.is_null();
+  return !read_cb_.is_null() || prefetching_;
 #else
   // Try to have one second's worth of encoded data per stream.
   const base::TimeDelta kCapacity = base::TimeDelta::FromSeconds(1);
@@ -792,6 +815,12 @@ bool FFmpegDemuxerStream::HasAvailableCapacity() {
 #endif
 }
 
+void FFmpegDemuxerStream::StartPrefetch() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(is_enabled_);
+  prefetching_ = !end_of_stream_;
+}
+
 size_t FFmpegDemuxerStream::MemoryUsage() const {
   return buffer_queue_.data_size();
 }
@@ -846,6 +875,8 @@ FFmpegDemuxer::FFmpegDemuxer(
       start_time_(kNoTimestamp),
       text_enabled_(false),
       duration_known_(false),
+      prefetch_on_initialize_(
+          base::FeatureList::IsEnabled(kFastStartPipeline)),
       encrypted_media_init_data_cb_(encrypted_media_init_data_cb),
       media_tracks_updated_cb_(media_tracks_updated_cb),
       cancel_pending_seek_factory_(this),
@@ -1468,6 +1499,18 @@ void FFmpegDemuxer::OnFindStreamInfoDone(const PipelineStatusCB& status_cb,
   LogMetadata(format_context, max_duration);
   media_tracks_updated_cb_.Run(std::move(media_tracks));
 
+  if (prefetch_on_initialize_) {
+    // Reading is bounded by the video GOP when there is one; packets of the
+    // other streams are queued as they are encountered.
+    FFmpegDemuxerStream* stream = GetFFmpegStream(DemuxerStream::VIDEO);
+    if (!stream)
+      stream = GetFFmpegStream(DemuxerStream::AUDIO);
+    if (stream) {
+      stream->StartPrefetch();
+      ReadFrameIfNeeded();
+    }
+  }
+
   status_cb.Run(PIPELINE_OK);
 }
 
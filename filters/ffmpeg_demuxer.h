@@ -129,6 +129,11 @@ class FFmpegDemuxerStream : public DemuxerStream {
   // Returns true if this stream has capacity for additional data.
   bool HasAvailableCapacity();
 
+  // Makes this stream ask for data even without a pending Read() until its
+  // first GOP has been queued, so that it is buffered by the time the decoder
+  // is ready for it.  Cancelled by flushing or disabling the stream.
+  void StartPrefetch();
+
   // Returns the total buffer size FFMpegDemuxerStream is holding onto.
   size_t MemoryUsage() const;
 
@@ -185,6 +190,7 @@ class FFmpegDemuxerStream : public DemuxerStream {
   VideoRotation video_rotation_;
   bool is_enabled_;
   bool waiting_for_keyframe_;
+  bool prefetching_;
 
   DecoderBufferQueue buffer_queue_;
   ReadCB read_cb_;
@@ -245,6 +251,14 @@ class MEDIA_EXPORT FFmpegDemuxer : public Demuxer {
   // timeline.
   base::TimeDelta start_time() const { return start_time_; }
 
+  // Whether to start reading the first GOP as soon as initialization completes
+  // rather than waiting for the first Read(), overlapping it with decoder
+  // initialization.  Defaults to whether kFastStartPipeline is enabled.  Must
+  // be called before Initialize().
+  void set_prefetch_on_initialize(bool enabled) {
+    prefetch_on_initialize_ = enabled;
+  }
+
  private:
   // To allow tests access to privates.
   friend class FFmpegDemuxerTest;
@@ -345,6 +359,9 @@ class MEDIA_EXPORT FFmpegDemuxer : public Demuxer {
   // stream -- at this moment we definitely know duration.
   bool duration_known_;
 
+  // See set_prefetch_on_initialize().
+  bool prefetch_on_initialize_;
+
   // FFmpegURLProtocol implementation and corresponding glue bits.
   std::unique_ptr<BlockingUrlProtocol> url_protocol_;
   std::unique_ptr<FFmpegGlue> glue_;
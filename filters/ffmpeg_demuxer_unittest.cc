@@ -463,6 +463,26 @@ TEST_F(FFmpegDemuxerTest, Read_Audio) {
   EXPECT_EQ(22084, demuxer_->GetMemoryUsage());
 }
 
+TEST_F(FFmpegDemuxerTest, PrefetchOnInitialize) {
+  CreateDemuxer("bear-320x240.webm");
+  demuxer_->set_prefetch_on_initialize(true);
+  InitializeDemuxer();
+
+  // Reading continues without any Read() until the first GOP is queued.
+  FFmpegDemuxerStream* video = static_cast<FFmpegDemuxerStream*>(
+      demuxer_->GetStream(DemuxerStream::VIDEO));
+  while (video->prefetching_ || demuxer_->pending_read_)
+    base::RunLoop().RunUntilIdle();
+  EXPECT_GT(demuxer_->GetMemoryUsage(), 22084 + 1057);
+
+  // Prefetched buffers are returned in order.
+  video->Read(NewReadCB(FROM_HERE, 22084, 0, true));
+  base::RunLoop().Run();
+
+  video->Read(NewReadCB(FROM_HERE, 1057, 33000, false));
+  base::RunLoop().Run();
+}
+
 TEST_F(FFmpegDemuxerTest, Read_Video) {
   // We test that on a successful video packet read.
   CreateDemuxer("bear-320x240.webm");
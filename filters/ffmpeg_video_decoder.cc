@@ -17,6 +17,7 @@
 #include "base/single_thread_task_runner.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/sys_info.h"
+#include "base/time/time.h"
 #include "media/base/bind_to_current_loop.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/limits.h"
@@ -25,6 +26,7 @@
 #include "media/base/video_frame.h"
 #include "media/base/video_util.h"
 #include "media/ffmpeg/ffmpeg_common.h"
+#include "media/filters/decode_thread_budget.h"
 #include "media/filters/ffmpeg_glue.h"
 
 namespace media {
@@ -38,7 +40,12 @@ namespace media {
 // decoding thread, FFmpeg treats having one thread the same as having zero
 // threads (i.e., avcodec_decode_video() will execute on the calling thread).
 // Yet another reason for having two threads :)
+//
+// The exception is when many decoders are active at once: DecodeThreadBudget
+// may then hand out a single thread, since decoding on the calling thread is
+// preferable to oversubscribing every core in the machine.
 static const int kDecodeThreads = 2;
+static const int kMinBudgetedDecodeThreads = 1;
 static const int kMaxDecodeThreads = 16;
 
 // Returns the number of threads given the FFmpeg CodecID. Also inspects the
@@ -91,7 +98,11 @@ bool FFmpegVideoDecoder::IsCodecSupported(VideoCodec codec) {
 }
 
 FFmpegVideoDecoder::FFmpegVideoDecoder()
-    : state_(kUninitialized), decode_nalus_(false) {
+    : state_(kUninitialized),
+      low_delay_(false),
+      thread_count_(0),
+      thread_budget_id_(DecodeThreadBudget::kInvalidClientId),
+      decode_nalus_(false) {
   thread_checker_.DetachFromThread();
 }
 
@@ -217,6 +228,8 @@ void FFmpegVideoDecoder::Initialize(const VideoDecoderConfig& config,
 
   FFmpegGlue::InitializeFFmpeg();
   config_ = config;
+  low_delay_ = low_delay;
+  RegisterWithThreadBudget();
 
   // TODO(xhwang): Only set |config_| after we successfully configure the
   // decoder.
@@ -234,6 +247,20 @@ void FFmpegVideoDecoder::Initialize(const VideoDecoderConfig& config,
 
 void FFmpegVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
                                 const DecodeCB& decode_cb) {
+  DecodeBuffer(buffer, false, decode_cb);
+}
+
+void FFmpegVideoDecoder::DecodeDiscardingOutput(
+    const scoped_refptr<DecoderBuffer>& buffer,
+    const DecodeCB& decode_cb) {
+  DCHECK(!buffer->end_of_stream());
+  DecodeBuffer(buffer, true, decode_cb);
+}
+
+void FFmpegVideoDecoder::DecodeBuffer(
+    const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output,
+    const DecodeCB& decode_cb) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(buffer.get());
   DCHECK(!decode_cb.is_null());
@@ -253,6 +280,15 @@ void FFmpegVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
 
   DCHECK_EQ(state_, kNormal);
 
+  // Keyframes are the only points where the codec can be reopened without
+  // losing reference frames, so follow changes in the thread budget there.
+  if (!buffer->end_of_stream() && buffer->is_key_frame() &&
+      !MaybeApplyThreadBudget()) {
+    state_ = kError;
+    decode_cb_bound.Run(DecodeStatus::DECODE_ERROR);
+    return;
+  }
+
   // During decode, because reads are issued asynchronously, it is possible to
   // receive multiple end of stream buffers since each decode is acked. When the
   // first end of stream buffer is read, FFmpeg may still have frames queued
@@ -277,7 +313,7 @@ void FFmpegVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
   bool has_produced_frame;
   do {
     has_produced_frame = false;
-    if (!FFmpegDecode(buffer, &has_produced_frame)) {
+    if (!FFmpegDecode(buffer, discard_output, &has_produced_frame)) {
       state_ = kError;
       decode_cb_bound.Run(DecodeStatus::DECODE_ERROR);
       return;
@@ -307,10 +343,52 @@ FFmpegVideoDecoder::~FFmpegVideoDecoder() {
 
   if (state_ != kUninitialized)
     ReleaseFFmpegResources();
+
+  if (thread_budget_id_ != DecodeThreadBudget::kInvalidClientId)
+    DecodeThreadBudget::GetInstance()->UnregisterDecoder(thread_budget_id_);
+}
+
+void FFmpegVideoDecoder::RegisterWithThreadBudget() {
+  if (DecodeThreadBudget::HasThreadCountOverride())
+    return;
+
+  DecodeThreadBudget* budget = DecodeThreadBudget::GetInstance();
+  const int max_threads =
+      std::max(GetThreadCount(config_), kMinBudgetedDecodeThreads);
+  if (thread_budget_id_ == DecodeThreadBudget::kInvalidClientId) {
+    thread_budget_id_ = budget->RegisterDecoder(
+        config_.coded_size(), kMinBudgetedDecodeThreads, max_threads);
+  } else {
+    budget->UpdateDecoder(thread_budget_id_, config_.coded_size(),
+                          max_threads);
+  }
+}
+
+bool FFmpegVideoDecoder::MaybeApplyThreadBudget() {
+  if (thread_budget_id_ == DecodeThreadBudget::kInvalidClientId)
+    return true;
+
+  const int thread_count =
+      DecodeThreadBudget::GetInstance()->GetThreadCount(thread_budget_id_);
+  if (thread_count == thread_count_)
+    return true;
+
+  // Frame threading may hold several frames in flight; drain them before the
+  // codec is reopened so that they are still output in order.
+  scoped_refptr<DecoderBuffer> eos_buffer = DecoderBuffer::CreateEOSBuffer();
+  bool has_produced_frame;
+  do {
+    has_produced_frame = false;
+    if (!FFmpegDecode(eos_buffer, false, &has_produced_frame))
+      return false;
+  } while (has_produced_frame);
+
+  return ConfigureDecoder(low_delay_);
 }
 
 bool FFmpegVideoDecoder::FFmpegDecode(
     const scoped_refptr<DecoderBuffer>& buffer,
+    bool discard_output,
     bool* has_produced_frame) {
   DCHECK(!*has_produced_frame);
 
@@ -329,11 +407,28 @@ bool FFmpegVideoDecoder::FFmpegDecode(
     codec_context_->reordered_opaque = buffer->timestamp().InMicroseconds();
   }
 
+  // Non-reference frames whose output will not be shown needn't be decoded at
+  // all.  Reference frames are decoded in full, since skipping their loop
+  // filter would corrupt every frame predicted from them.
+  codec_context_->skip_frame =
+      discard_output ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+
   int frame_decoded = 0;
+  const base::TimeTicks decode_start = base::TimeTicks::Now();
   int result = avcodec_decode_video2(codec_context_.get(),
                                      av_frame_.get(),
                                      &frame_decoded,
                                      &packet);
+  // With frame threading avcodec_decode_video2() only hands the packet to a
+  // worker thread and returns whichever earlier frame has finished, so its
+  // duration says nothing about the cost of decoding; such decoders keep the
+  // resolution based weight.
+  if (thread_budget_id_ != DecodeThreadBudget::kInvalidClientId &&
+      !buffer->end_of_stream() &&
+      !(codec_context_->active_thread_type & FF_THREAD_FRAME)) {
+    DecodeThreadBudget::GetInstance()->AddDecodeTimeSample(
+        thread_budget_id_, base::TimeTicks::Now() - decode_start);
+  }
   // Log the problem if we can't decode a video frame and exit early.
   if (result < 0) {
     LOG(ERROR) << "Error decoding video: " << buffer->AsHumanReadableString();
@@ -391,7 +486,11 @@ bool FFmpegVideoDecoder::ConfigureDecoder(bool low_delay) {
   codec_context_.reset(avcodec_alloc_context3(NULL));
   VideoDecoderConfigToAVCodecContext(config_, codec_context_.get());
 
-  codec_context_->thread_count = GetThreadCount(config_);
+  thread_count_ =
+      thread_budget_id_ != DecodeThreadBudget::kInvalidClientId
+          ? DecodeThreadBudget::GetInstance()->GetThreadCount(thread_budget_id_)
+          : GetThreadCount(config_);
+  codec_context_->thread_count = thread_count_;
   codec_context_->thread_type =
       FF_THREAD_SLICE | (low_delay ? 0 : FF_THREAD_FRAME);
   codec_context_->opaque = this;
@@ -15,6 +15,7 @@
 #include "media/base/video_decoder_config.h"
 #include "media/base/video_frame_pool.h"
 #include "media/ffmpeg/ffmpeg_deleters.h"
+#include "media/filters/decode_thread_budget.h"
 
 struct AVCodecContext;
 struct AVFrame;
@@ -47,6 +48,8 @@ class MEDIA_EXPORT FFmpegVideoDecoder : public VideoDecoder {
                   const OutputCB& output_cb) override;
   void Decode(const scoped_refptr<DecoderBuffer>& buffer,
               const DecodeCB& decode_cb) override;
+  void DecodeDiscardingOutput(const scoped_refptr<DecoderBuffer>& buffer,
+                              const DecodeCB& decode_cb) override;
   void Reset(const base::Closure& closure) override;
 
   // Callback called from within FFmpeg to allocate a buffer based on
@@ -64,8 +67,15 @@ class MEDIA_EXPORT FFmpegVideoDecoder : public VideoDecoder {
     kError
   };
 
-  // Handles decoding an unencrypted encoded buffer.
+  // Implements Decode() and DecodeDiscardingOutput().
+  void DecodeBuffer(const scoped_refptr<DecoderBuffer>& buffer,
+                    bool discard_output,
+                    const DecodeCB& decode_cb);
+
+  // Handles decoding an unencrypted encoded buffer.  If |discard_output|, the
+  // codec may skip decoding |buffer| if no other frame references it.
   bool FFmpegDecode(const scoped_refptr<DecoderBuffer>& buffer,
+                    bool discard_output,
                     bool* has_produced_frame);
 
   // Handles (re-)initializing the decoder with a (new) config.
@@ -76,6 +86,15 @@ class MEDIA_EXPORT FFmpegVideoDecoder : public VideoDecoder {
   // and resets them to NULL.
   void ReleaseFFmpegResources();
 
+  // Registers |config_| with the process-wide DecodeThreadBudget, unless the
+  // thread count was forced on the command line.
+  void RegisterWithThreadBudget();
+
+  // Reopens the codec if the thread budget now allots a different number of
+  // threads than |thread_count_|.  Must only be called before decoding a
+  // keyframe.  Returns false if the codec could not be reopened.
+  bool MaybeApplyThreadBudget();
+
   base::ThreadChecker thread_checker_;
 
   DecoderState state_;
@@ -88,6 +107,13 @@ class MEDIA_EXPORT FFmpegVideoDecoder : public VideoDecoder {
 
   VideoDecoderConfig config_;
 
+  bool low_delay_;
+
+  // Number of threads |codec_context_| was opened with.
+  int thread_count_;
+
+  DecodeThreadBudget::ClientId thread_budget_id_;
+
   VideoFramePool frame_pool_;
 
   bool decode_nalus_;
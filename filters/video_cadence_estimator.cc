@@ -88,6 +88,8 @@ void VideoCadenceEstimator::Reset() {
   pending_cadence_.clear();
   cadence_changes_ = render_intervals_cadence_held_ = 0;
   first_update_call_ = true;
+  last_render_interval_ = base::TimeDelta();
+  last_candidate_cadence_.clear();
 }
 
 bool VideoCadenceEstimator::UpdateCadenceEstimate(
@@ -117,9 +119,9 @@ bool VideoCadenceEstimator::UpdateCadenceEstimate(
   base::TimeDelta time_until_max_drift;
 
   // See if we can find a cadence which fits the data.
-  Cadence new_cadence =
-      CalculateCadence(render_interval, frame_duration, max_acceptable_drift,
-                       &time_until_max_drift);
+  const Cadence& new_cadence =
+      GetCandidateCadence(render_interval, frame_duration, max_acceptable_drift,
+                          &time_until_max_drift);
 
   // If this is the first time UpdateCadenceEstimate() has been called,
   // initialize the histogram with a zero count for cadence changes; this
@@ -147,7 +149,7 @@ bool VideoCadenceEstimator::UpdateCadenceEstimate(
       DVLOG(1) << "Cadence switch: " << CadenceToString(cadence_) << " -> "
                << CadenceToString(new_cadence)
                << " :: Time until drift exceeded: " << time_until_max_drift;
-      cadence_.swap(new_cadence);
+      cadence_ = new_cadence;
 
       // Note: Because this class is transitively owned by a garbage collected
       // object, WebMediaPlayer, we log cadence changes as they are encountered.
@@ -163,7 +165,7 @@ bool VideoCadenceEstimator::UpdateCadenceEstimate(
            << CadenceToString(new_cadence);
 
   if (update_pending_cadence) {
-    pending_cadence_.swap(new_cadence);
+    pending_cadence_ = new_cadence;
     render_intervals_cadence_held_ = 1;
   }
 
@@ -175,6 +177,30 @@ int VideoCadenceEstimator::GetCadenceForFrame(uint64_t frame_number) const {
   return cadence_[frame_number % cadence_.size()];
 }
 
+const VideoCadenceEstimator::Cadence&
+VideoCadenceEstimator::GetCandidateCadence(
+    base::TimeDelta render_interval,
+    base::TimeDelta frame_duration,
+    base::TimeDelta max_acceptable_drift,
+    base::TimeDelta* time_until_max_drift) {
+  if (render_interval != last_render_interval_ ||
+      frame_duration != last_frame_duration_ ||
+      max_acceptable_drift != last_max_acceptable_drift_ ||
+      minimum_time_until_max_drift_ != last_minimum_time_until_max_drift_) {
+    last_render_interval_ = render_interval;
+    last_frame_duration_ = frame_duration;
+    last_max_acceptable_drift_ = max_acceptable_drift;
+    last_minimum_time_until_max_drift_ = minimum_time_until_max_drift_;
+    last_time_until_max_drift_ = base::TimeDelta();
+    last_candidate_cadence_ =
+        CalculateCadence(render_interval, frame_duration, max_acceptable_drift,
+                         &last_time_until_max_drift_);
+  }
+
+  *time_until_max_drift = last_time_until_max_drift_;
+  return last_candidate_cadence_;
+}
+
 VideoCadenceEstimator::Cadence VideoCadenceEstimator::CalculateCadence(
     base::TimeDelta render_interval,
     base::TimeDelta frame_duration,
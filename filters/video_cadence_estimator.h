@@ -131,6 +131,14 @@ class MEDIA_EXPORT VideoCadenceEstimator {
   // "[a: b: ...: z]".
   std::string CadenceToString(const Cadence& cadence) const;
 
+  // Returns the cadence for the given values; reuses the previous
+  // CalculateCadence() result when they're unchanged, which is the common case
+  // once the frame duration estimate has settled.
+  const Cadence& GetCandidateCadence(base::TimeDelta render_interval,
+                                     base::TimeDelta frame_duration,
+                                     base::TimeDelta max_acceptable_drift,
+                                     base::TimeDelta* time_until_max_drift);
+
   // The approximate best N-frame cadence for all frames seen thus far; updated
   // by UpdateCadenceEstimate().  Empty when no cadence has been detected.
   Cadence cadence_;
@@ -160,6 +168,15 @@ class MEDIA_EXPORT VideoCadenceEstimator {
 
   bool is_variable_frame_rate_;
 
+  // Inputs and result of the last CalculateCadence() call; see
+  // GetCandidateCadence().  |last_render_interval_| is zero when unset.
+  base::TimeDelta last_render_interval_;
+  base::TimeDelta last_frame_duration_;
+  base::TimeDelta last_max_acceptable_drift_;
+  base::TimeDelta last_minimum_time_until_max_drift_;
+  base::TimeDelta last_time_until_max_drift_;
+  Cadence last_candidate_cadence_;
+
   DISALLOW_COPY_AND_ASSIGN(VideoCadenceEstimator);
 };
 
@@ -442,6 +442,54 @@ TEST_P(VideoFrameStreamTest, Read_AfterReset) {
   Read();
 }
 
+TEST_P(VideoFrameStreamTest, Read_PrerollTarget) {
+  Initialize();
+
+  // Buffers are 30ms long, so the frames at 0, 30 and 60ms end before 100ms
+  // and are dropped.
+  video_frame_stream_->SetPrerollTarget(base::TimeDelta::FromMilliseconds(100));
+  ReadOneFrame();
+  ASSERT_TRUE(frame_read_.get());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(90), frame_read_->timestamp());
+  EXPECT_EQ(1, num_decoded_frames_);
+
+  // Later frames are returned as usual.
+  ReadOneFrame();
+  ASSERT_TRUE(frame_read_.get());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(120), frame_read_->timestamp());
+}
+
+TEST_P(VideoFrameStreamTest, Read_PrerollTargetDiscardsOutput) {
+  Initialize();
+
+  // The duration of the first buffer is not known until it is decoded, so only
+  // the buffers at 30 and 60ms are marked.  The one at 90ms is shown.
+  video_frame_stream_->SetPrerollTarget(base::TimeDelta::FromMilliseconds(100));
+  ReadOneFrame();
+  ASSERT_TRUE(frame_read_.get());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(90), frame_read_->timestamp());
+  EXPECT_EQ(2, decoder1_->num_discard_output_buffers());
+
+  // Nothing is marked once the target is reached.
+  ReadAllFrames(kNumConfigs * kNumBuffersInOneConfig - 3);
+  EXPECT_EQ(2, decoder1_->num_discard_output_buffers());
+}
+
+TEST_P(VideoFrameStreamTest, Read_PrerollTargetAfterEndOfStream) {
+  Initialize();
+
+  // Only the last frame is returned when the target is never reached.
+  video_frame_stream_->SetPrerollTarget(base::TimeDelta::FromSeconds(10));
+  ReadAllFrames(1);
+}
+
+TEST_P(VideoFrameStreamTest, Read_PrerollTargetClearedByReset) {
+  Initialize();
+  video_frame_stream_->SetPrerollTarget(base::TimeDelta::FromSeconds(10));
+  Reset();
+  ReadAllFrames();
+}
+
 TEST_P(VideoFrameStreamTest, Read_BlockedDemuxer) {
   Initialize();
   demuxer_stream_->HoldNextRead();
@@ -406,6 +406,22 @@ void VideoRendererAlgorithm::EnqueueFrame(
 #endif
 }
 
+bool VideoRendererAlgorithm::IsFramePlannedForDrop(
+    base::TimeDelta timestamp) const {
+  if (frame_dropping_disabled_ || !cadence_estimator_.has_cadence() ||
+      frame_queue_.empty() || !have_rendered_frames_) {
+    return false;
+  }
+
+  // Only frames which will be appended to the queue have a predictable cadence
+  // position; out of order frames are rare and not worth planning for.
+  if (timestamp <= frame_queue_.back().frame->timestamp())
+    return false;
+
+  return !cadence_estimator_.GetCadenceForFrame(cadence_frame_counter_ +
+                                                frame_queue_.size());
+}
+
 void VideoRendererAlgorithm::AccountForMissedIntervals(
     base::TimeTicks deadline_min,
     base::TimeTicks deadline_max) {
@@ -445,23 +461,29 @@ void VideoRendererAlgorithm::AccountForMissedIntervals(
 void VideoRendererAlgorithm::UpdateFrameStatistics() {
   DCHECK(!frame_queue_.empty());
 
-  // Figure out all current ready frame times at once.
-  std::vector<base::TimeDelta> media_timestamps;
-  media_timestamps.reserve(frame_queue_.size());
+  // Figure out all current ready frame times at once.  The scratch vectors are
+  // members so that their storage is reused across Render() calls.
+  std::vector<base::TimeDelta>& media_timestamps = media_timestamps_;
+  media_timestamps.clear();
   for (const auto& ready_frame : frame_queue_)
     media_timestamps.push_back(ready_frame.frame->timestamp());
 
-  std::vector<base::TimeTicks> wall_clock_times;
+  std::vector<base::TimeTicks>& wall_clock_times = wall_clock_times_;
+  wall_clock_times.clear();
   was_time_moving_ =
       wall_clock_time_cb_.Run(media_timestamps, &wall_clock_times);
 
-  // Transfer the converted wall clock times into our frame queue.
+  // Transfer the converted wall clock times into our frame queue.  Each frame
+  // ends where the next one starts, so checking that every frame ends no
+  // earlier than it starts keeps the queue sorted by end time, as required by
+  // FindFirstFrameEndingAtOrAfter().
   DCHECK_EQ(wall_clock_times.size(), frame_queue_.size());
   for (size_t i = 0; i < frame_queue_.size() - 1; ++i) {
     ReadyFrame& frame = frame_queue_[i];
     const bool new_sample = frame.has_estimated_end_time;
     frame.start_time = wall_clock_times[i];
     frame.end_time = wall_clock_times[i + 1];
+    DCHECK_LE(frame.start_time, frame.end_time);
     frame.has_estimated_end_time = false;
     if (new_sample)
       frame_duration_calculator_.AddSample(frame.end_time - frame.start_time);
@@ -574,43 +596,43 @@ int VideoRendererAlgorithm::FindBestFrameByCoverage(
   // deadline_max]. Frames outside of the interval are considered to have no
   // coverage, while those which completely overlap the interval have complete
   // coverage.
+  //
+  // Frames are contiguous and sorted, so every frame before the first one which
+  // ends at or after |deadline_min| has zero coverage; only the handful of
+  // frames overlapping the interval need to be visited, regardless of how deep
+  // the queue is.
+  const size_t first_frame = FindFirstFrameEndingAtOrAfter(deadline_min);
+  size_t last_frame = first_frame;
   int best_frame_by_coverage = -1;
   base::TimeDelta best_coverage;
-  std::vector<base::TimeDelta> coverage(frame_queue_.size(), base::TimeDelta());
-  for (size_t i = 0; i < frame_queue_.size(); ++i) {
-    const ReadyFrame& frame = frame_queue_[i];
-
+  for (; last_frame < frame_queue_.size(); ++last_frame) {
     // Frames which start after the deadline interval have zero coverage.
-    if (frame.start_time > deadline_max)
+    if (frame_queue_[last_frame].start_time > deadline_max)
       break;
 
-    // Clamp frame end times to a maximum of |deadline_max|.
-    const base::TimeTicks end_time = std::min(deadline_max, frame.end_time);
-
-    // Frames entirely before the deadline interval have zero coverage.
-    if (end_time < deadline_min)
-      continue;
-
-    // If we're here, the current frame overlaps the deadline in some way; so
-    // compute the duration of the interval which is covered.
-    const base::TimeDelta duration =
-        end_time - std::max(deadline_min, frame.start_time);
-
-    coverage[i] = duration;
-    if (coverage[i] > best_coverage) {
-      best_frame_by_coverage = i;
-      best_coverage = coverage[i];
+    const base::TimeDelta coverage =
+        CalculateCoverageForFrame(deadline_min, deadline_max, last_frame);
+    if (coverage > best_coverage) {
+      best_frame_by_coverage = last_frame;
+      best_coverage = coverage;
     }
   }
 
-  // Find the second best frame by coverage; done by zeroing the coverage for
-  // the previous best and recomputing the maximum.
+  // Find the second best frame by coverage; i.e. the earliest frame with the
+  // maximum coverage once the best frame is excluded.
   *second_best = -1;
+  base::TimeDelta second_best_coverage;
   if (best_frame_by_coverage >= 0) {
-    coverage[best_frame_by_coverage] = base::TimeDelta();
-    auto it = std::max_element(coverage.begin(), coverage.end());
-    if (*it > base::TimeDelta())
-      *second_best = it - coverage.begin();
+    for (size_t i = first_frame; i < last_frame; ++i) {
+      if (static_cast<int>(i) == best_frame_by_coverage)
+        continue;
+      const base::TimeDelta coverage =
+          CalculateCoverageForFrame(deadline_min, deadline_max, i);
+      if (coverage > second_best_coverage) {
+        *second_best = i;
+        second_best_coverage = coverage;
+      }
+    }
   }
 
   // If two frames have coverage within half a millisecond, prefer the earliest
@@ -621,8 +643,7 @@ int VideoRendererAlgorithm::FindBestFrameByCoverage(
   const base::TimeDelta kAllowableJitter =
       base::TimeDelta::FromMicroseconds(500);
   if (*second_best >= 0 && best_frame_by_coverage > *second_best &&
-      (best_coverage - coverage[*second_best]).magnitude() <=
-          kAllowableJitter) {
+      (best_coverage - second_best_coverage).magnitude() <= kAllowableJitter) {
     std::swap(best_frame_by_coverage, *second_best);
   }
 
@@ -642,22 +663,60 @@ int VideoRendererAlgorithm::FindBestFrameByDrift(
     base::TimeDelta* selected_frame_drift) const {
   DCHECK(!frame_queue_.empty());
 
+  // Frames ending before |deadline_min| drift less the later they are, while
+  // frames ending at or after it drift more the later they start; so the best
+  // frame is either the last frame before |first_frame| or the latest frame
+  // sharing the drift of |first_frame|.  We prefer the latest frame with
+  // minimum drift.
+  const size_t first_frame = FindFirstFrameEndingAtOrAfter(deadline_min);
+
   int best_frame_by_drift = -1;
   *selected_frame_drift = base::TimeDelta::Max();
+  if (first_frame > 0) {
+    best_frame_by_drift = first_frame - 1;
+    *selected_frame_drift =
+        CalculateAbsoluteDriftForFrame(deadline_min, best_frame_by_drift);
+  }
 
-  for (size_t i = 0; i < frame_queue_.size(); ++i) {
+  for (size_t i = first_frame; i < frame_queue_.size(); ++i) {
     const base::TimeDelta drift =
         CalculateAbsoluteDriftForFrame(deadline_min, i);
-    // We use <= here to prefer the latest frame with minimum drift.
-    if (drift <= *selected_frame_drift) {
-      *selected_frame_drift = drift;
-      best_frame_by_drift = i;
-    }
+    if (drift > *selected_frame_drift)
+      break;
+    *selected_frame_drift = drift;
+    best_frame_by_drift = i;
   }
 
   return best_frame_by_drift;
 }
 
+size_t VideoRendererAlgorithm::FindFirstFrameEndingAtOrAfter(
+    base::TimeTicks deadline) const {
+  return std::lower_bound(frame_queue_.begin(), frame_queue_.end(), deadline,
+                          [](const ReadyFrame& frame, base::TimeTicks time) {
+                            return frame.end_time < time;
+                          }) -
+         frame_queue_.begin();
+}
+
+base::TimeDelta VideoRendererAlgorithm::CalculateCoverageForFrame(
+    base::TimeTicks deadline_min,
+    base::TimeTicks deadline_max,
+    int frame_index) const {
+  const ReadyFrame& frame = frame_queue_[frame_index];
+
+  // Clamp frame end times to a maximum of |deadline_max|.
+  const base::TimeTicks end_time = std::min(deadline_max, frame.end_time);
+
+  // Frames entirely outside of the deadline interval have zero coverage.
+  if (end_time < deadline_min || frame.start_time > deadline_max)
+    return base::TimeDelta();
+
+  // If we're here, the current frame overlaps the deadline in some way; so
+  // compute the duration of the interval which is covered.
+  return end_time - std::max(deadline_min, frame.start_time);
+}
+
 base::TimeDelta VideoRendererAlgorithm::CalculateAbsoluteDriftForFrame(
     base::TimeTicks deadline_min,
     int frame_index) const {
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <deque>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/macros.h"
@@ -103,6 +104,13 @@ class MEDIA_EXPORT VideoRendererAlgorithm {
   // is relatively accurate immediately after this call.
   void EnqueueFrame(const scoped_refptr<VideoFrame>& frame);
 
+  // Returns true if a frame with |timestamp| enqueued next would, under the
+  // current cadence, never be displayed; i.e. it lands on a zero entry of the
+  // cadence's render plan.  Clients may use this to skip expensive per-frame
+  // work (e.g. copies into GPU memory) for such frames; they must still be
+  // passed to EnqueueFrame() so cadence and drop accounting stay correct.
+  bool IsFramePlannedForDrop(base::TimeDelta timestamp) const;
+
   // Removes all frames from the |frame_queue_| and clears predictors.  The
   // algorithm will be as if freshly constructed after this call.  By default
   // everything is reset, but if kPreserveNextFrameEstimates is specified, then
@@ -222,10 +230,11 @@ class MEDIA_EXPORT VideoRendererAlgorithm {
   // it should only be displayed twice instead of thrice, so it's overage is 1.
   int FindBestFrameByCadence(int* remaining_overage) const;
 
-  // Iterates over |frame_queue_| and finds the frame which covers the most of
-  // the deadline interval.  If multiple frames have coverage of the interval,
-  // |second_best| will be set to the index of the frame with the next highest
-  // coverage.  Returns -1 if no frame has any coverage of the current interval.
+  // Finds the frame in |frame_queue_| which covers the most of the deadline
+  // interval; only frames overlapping the interval are visited.  If multiple
+  // frames have coverage of the interval, |second_best| will be set to the
+  // index of the frame with the next highest coverage.  Returns -1 if no frame
+  // has any coverage of the current interval.
   //
   // Prefers the earliest frame if multiple frames have similar coverage (within
   // a few percent of each other).
@@ -233,9 +242,10 @@ class MEDIA_EXPORT VideoRendererAlgorithm {
                               base::TimeTicks deadline_max,
                               int* second_best) const;
 
-  // Iterates over |frame_queue_| and find the frame which drifts the least from
-  // |deadline_min|.  There's always a best frame by drift, so the return value
-  // is always a valid frame index.  |selected_frame_drift| will be set to the
+  // Finds the frame in |frame_queue_| which drifts the least from
+  // |deadline_min|; only frames adjacent to |deadline_min| are visited.
+  // There's always a best frame by drift, so the return value is always a
+  // valid frame index.  |selected_frame_drift| will be set to the
   // drift of the chosen frame.
   //
   // Note: Drift calculations assume contiguous frames in the time domain, so
@@ -255,6 +265,18 @@ class MEDIA_EXPORT VideoRendererAlgorithm {
   base::TimeDelta CalculateAbsoluteDriftForFrame(base::TimeTicks deadline_min,
                                                  int frame_index) const;
 
+  // Returns the portion of [deadline_min, deadline_max] covered by the given
+  // |frame_index|.
+  base::TimeDelta CalculateCoverageForFrame(base::TimeTicks deadline_min,
+                                            base::TimeTicks deadline_max,
+                                            int frame_index) const;
+
+  // Binary searches |frame_queue_| for the index of the first frame whose
+  // |end_time| is at or after |deadline|; returns frames_queued() if none.
+  // Relies on frames being sorted and contiguous, so it's only valid after
+  // UpdateFrameStatistics() has assigned end times to every frame.
+  size_t FindFirstFrameEndingAtOrAfter(base::TimeTicks deadline) const;
+
   // Updates |effective_frames_queued_| which is typically called far more
   // frequently (~4x) than the value changes.  This must be called whenever
   // frames are added or removed from the queue or when any property of a
@@ -328,6 +350,11 @@ class MEDIA_EXPORT VideoRendererAlgorithm {
   // to UpdateEffectiveFramesQueued() whenever the |frame_queue_| is changed.
   size_t effective_frames_queued_;
 
+  // Scratch space for UpdateFrameStatistics(); kept to avoid reallocating on
+  // every Render() call.
+  std::vector<base::TimeDelta> media_timestamps_;
+  std::vector<base::TimeTicks> wall_clock_times_;
+
   DISALLOW_COPY_AND_ASSIGN(VideoRendererAlgorithm);
 };
 
@@ -0,0 +1,86 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "base/time/time.h"
+#include "media/base/video_frame_pool.h"
+#include "media/base/wall_clock_time_source.h"
+#include "media/filters/video_renderer_algorithm.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkIntervals = 100000;
+
+// Simulates a display refreshing at |display_hz| rendering |fps| content while
+// the decoder keeps |queue_depth| frames buffered, and reports the number of
+// Render() calls per second the algorithm can sustain.
+static void RunRenderBenchmark(double display_hz,
+                               double fps,
+                               size_t queue_depth) {
+  base::SimpleTestTickClock tick_clock;
+  tick_clock.Advance(base::TimeDelta::FromMicroseconds(10000));
+
+  WallClockTimeSource time_source;
+  time_source.set_tick_clock_for_testing(&tick_clock);
+  VideoRendererAlgorithm algorithm(base::Bind(
+      &WallClockTimeSource::GetWallClockTimes, base::Unretained(&time_source)));
+
+  VideoFramePool frame_pool;
+  const gfx::Size natural_size(8, 8);
+  const base::TimeDelta frame_duration =
+      base::TimeDelta::FromSecondsD(1.0 / fps);
+  base::TimeDelta next_timestamp;
+  auto enqueue_frames = [&]() {
+    while (algorithm.frames_queued() < queue_depth) {
+      algorithm.EnqueueFrame(frame_pool.CreateFrame(
+          PIXEL_FORMAT_YV12, natural_size, gfx::Rect(natural_size),
+          natural_size, next_timestamp));
+      next_timestamp += frame_duration;
+    }
+  };
+  enqueue_frames();
+  time_source.StartTicking();
+
+  const base::TimeDelta render_interval =
+      base::TimeDelta::FromSecondsD(1.0 / display_hz);
+  base::TimeDelta total_render_time;
+  size_t frames_dropped = 0;
+  for (int i = 0; i < kBenchmarkIntervals; ++i) {
+    const base::TimeTicks deadline_min = tick_clock.NowTicks();
+    const base::TimeTicks deadline_max = deadline_min + render_interval;
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_TRUE(algorithm.Render(deadline_min, deadline_max, &frames_dropped));
+    total_render_time += base::TimeTicks::Now() - start;
+
+    algorithm.RemoveExpiredFrames(deadline_min);
+    enqueue_frames();
+    tick_clock.Advance(render_interval);
+  }
+
+  perf_test::PrintResult(
+      "video_renderer_algorithm", "",
+      base::StringPrintf("%.0fhz_%.2ffps_depth%d", display_hz, fps,
+                         static_cast<int>(queue_depth)),
+      kBenchmarkIntervals / total_render_time.InSecondsF(), "renders/s", true);
+}
+
+TEST(VideoRendererAlgorithmPerfTest, Render) {
+  // 240Hz displays with cadence based (60fps, 120fps) and coverage based
+  // (50fps, 59.94fps) selection, at shallow and deep queue depths.
+  for (double fps : {50.0, 60.0 / 1.001, 60.0, 120.0}) {
+    for (size_t queue_depth : {4, 16, 64}) {
+      RunRenderBenchmark(240, fps, queue_depth);
+    }
+  }
+}
+
+}  // namespace media
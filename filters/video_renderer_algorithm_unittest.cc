@@ -1538,4 +1538,43 @@ TEST_F(VideoRendererAlgorithmTest, CadenceForFutureFrames) {
   ASSERT_TRUE(is_using_cadence());
 }
 
+TEST_F(VideoRendererAlgorithmTest, FramesPlannedForDrop) {
+  TickGenerator display_tg(tick_clock_->NowTicks(), 60);
+  TickGenerator frame_tg(base::TimeTicks(), 120);
+  time_source_.StartTicking();
+  disable_cadence_hysteresis();
+
+  // Nothing is planned for drop before cadence has been detected.
+  algorithm_.EnqueueFrame(CreateFrame(frame_tg.interval(0)));
+  algorithm_.EnqueueFrame(CreateFrame(frame_tg.interval(1)));
+  EXPECT_FALSE(algorithm_.IsFramePlannedForDrop(frame_tg.interval(2)));
+
+  size_t frames_dropped = 0;
+  ASSERT_TRUE(RenderAndStep(&display_tg, &frames_dropped));
+  ASSERT_TRUE(is_using_cadence());
+  ASSERT_TRUE(IsCadenceBelowOne());
+
+  // 120fps in 60Hz has a [1:0] cadence, so every other appended frame will
+  // never be displayed.
+  bool last_planned_for_drop =
+      algorithm_.IsFramePlannedForDrop(frame_tg.interval(2));
+  algorithm_.EnqueueFrame(CreateFrame(frame_tg.interval(2)));
+  for (int i = 3; i < 10; ++i) {
+    const bool planned_for_drop =
+        algorithm_.IsFramePlannedForDrop(frame_tg.interval(i));
+    EXPECT_NE(last_planned_for_drop, planned_for_drop);
+    last_planned_for_drop = planned_for_drop;
+    algorithm_.EnqueueFrame(CreateFrame(frame_tg.interval(i)));
+  }
+
+  // Frames which would be inserted out of order are never planned for drop.
+  EXPECT_FALSE(algorithm_.IsFramePlannedForDrop(frame_tg.interval(1)));
+  EXPECT_FALSE(algorithm_.IsFramePlannedForDrop(frame_tg.interval(9)));
+
+  // Nor is anything once frame dropping has been disabled.
+  algorithm_.disable_frame_dropping();
+  EXPECT_FALSE(algorithm_.IsFramePlannedForDrop(frame_tg.interval(10)));
+  EXPECT_FALSE(algorithm_.IsFramePlannedForDrop(frame_tg.interval(11)));
+}
+
 }  // namespace media
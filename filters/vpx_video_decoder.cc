@@ -15,6 +15,7 @@
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/command_line.h"
+#include "base/feature_list.h"
 #include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/logging.h"
@@ -24,6 +25,8 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/sys_byteorder.h"
 #include "base/sys_info.h"
+#include "base/task_scheduler/post_task.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "base/threading/thread.h"
 #include "base/trace_event/memory_allocator_dump.h"
 #include "base/trace_event/memory_dump_manager.h"
@@ -33,6 +36,7 @@
 #include "media/base/bind_to_current_loop.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/media_switches.h"
+#include "media/filters/decode_thread_budget.h"
 
 // Include libvpx header files.
 // VPX_CODEC_DISABLE_COMPAT excludes parts of the libvpx API that provide
@@ -49,6 +53,23 @@ extern "C" {
 
 namespace media {
 
+// Posts |closure| to |task_runner|; used to return frame buffers to the
+// sequence which decoded into them.
+static void PostToTaskRunner(
+    const scoped_refptr<base::SequencedTaskRunner>& task_runner,
+    const base::Closure& closure) {
+  task_runner->PostTask(FROM_HERE, closure);
+}
+
+// Blocks until all tasks posted to |task_runner| before this call have run.
+static void WaitForOutstandingTasks(base::SequencedTaskRunner* task_runner) {
+  base::WaitableEvent waiter(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                             base::WaitableEvent::InitialState::NOT_SIGNALED);
+  task_runner->PostTask(FROM_HERE, base::Bind(&base::WaitableEvent::Signal,
+                                              base::Unretained(&waiter)));
+  waiter.Wait();
+}
+
 // High resolution VP9 decodes can block the main task runner for too long,
 // preventing demuxing, audio decoding, and other control activities.  In those
 // cases share a thread per process for higher resolution decodes.
@@ -68,23 +89,11 @@ class VpxOffloadThread {
     return offload_thread_.task_runner();
   }
 
-  void WaitForOutstandingTasks() {
-    DCHECK(thread_checker_.CalledOnValidThread());
-    DCHECK(offload_thread_users_);
-    DCHECK(offload_thread_.IsRunning());
-    base::WaitableEvent waiter(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                               base::WaitableEvent::InitialState::NOT_SIGNALED);
-    offload_thread_.task_runner()->PostTask(
-        FROM_HERE,
-        base::Bind(&base::WaitableEvent::Signal, base::Unretained(&waiter)));
-    waiter.Wait();
-  }
-
   void WaitForOutstandingTasksAndReleaseOffloadThread() {
     DCHECK(thread_checker_.CalledOnValidThread());
     DCHECK(offload_thread_users_);
     DCHECK(offload_thread_.IsRunning());
-    WaitForOutstandingTasks();
+    WaitForOutstandingTasks(offload_thread_.task_runner().get());
     if (!--offload_thread_users_) {
       // Don't shut down the thread immediately in case we're in the middle of
       // a configuration change.
@@ -112,12 +121,31 @@ class VpxOffloadThread {
 static base::LazyInstance<VpxOffloadThread>::Leaky g_vpx_offload_thread =
     LAZY_INSTANCE_INITIALIZER;
 
+// Alternative to VpxOffloadThread for processes running many small decoders,
+// e.g. video conferencing grids.  Rather than every decoder spinning up its own
+// libvpx threads, all decodes are posted to the TaskScheduler, whose workers
+// are sized to the machine; each decoder gets its own sequence so its buffers
+// are still decoded in order and never concurrently.  Idle workers pick up
+// whichever decoder's work is pending, so load is balanced across decoders.
+static scoped_refptr<base::SequencedTaskRunner> CreateDecodeSequence() {
+  return base::CreateSequencedTaskRunnerWithTraits(
+      base::TaskTraits().WithPriority(base::TaskPriority::USER_BLOCKING));
+}
+
+// Decoders narrower than this run a single libvpx thread when decoding on the
+// shared pool; the pool provides parallelism across decoders instead.
+static const int kMinWidthForPoolDecodeThreads = 1024;
+
 // Always try to use three threads for video decoding.  There is little reason
 // not to since current day CPUs tend to be multi-core and we measured
 // performance benefits on older machines such as P4s with hyperthreading.
 static const int kDecodeThreads = 2;
 static const int kMaxDecodeThreads = 16;
 
+// libvpx decodes on the calling thread when given a single thread, which is
+// what DecodeThreadBudget falls back to when many decoders are active.
+static const int kMinBudgetedDecodeThreads = 1;
+
 // Returns the number of threads.
 static int GetThreadCount(const VideoDecoderConfig& config) {
   // Refer to http://crbug.com/93932 for tsan suppressions on decoding.
@@ -147,12 +175,13 @@ static int GetThreadCount(const VideoDecoderConfig& config) {
 }
 
 static vpx_codec_ctx* InitializeVpxContext(vpx_codec_ctx* context,
-                                           const VideoDecoderConfig& config) {
+                                           const VideoDecoderConfig& config,
+                                           int thread_count) {
   context = new vpx_codec_ctx();
   vpx_codec_dec_cfg_t vpx_config = {0};
   vpx_config.w = config.coded_size().width();
   vpx_config.h = config.coded_size().height();
-  vpx_config.threads = GetThreadCount(config);
+  vpx_config.threads = thread_count;
 
   vpx_codec_err_t status = vpx_codec_dec_init(
       context,
@@ -166,6 +195,24 @@ static vpx_codec_ctx* InitializeVpxContext(vpx_codec_ctx* context,
   return nullptr;
 }
 
+// Signals the end of the stream to |context|, finishing any decoding still in
+// flight so that the context can be destroyed.  Returns false on error.
+static bool FlushVpxContext(vpx_codec_ctx* context) {
+  vpx_codec_err_t status = vpx_codec_decode(context, nullptr, 0, nullptr, 0);
+  if (status != VPX_CODEC_OK) {
+    DLOG(ERROR) << "vpx_codec_decode() flush error: "
+                << vpx_codec_err_to_string(status);
+    return false;
+  }
+
+  // Frame parallel mode is never enabled and every decode call is followed by
+  // vpx_codec_get_frame(), so no frame is held back.
+  vpx_codec_iter_t iter = nullptr;
+  const vpx_image_t* vpx_image = vpx_codec_get_frame(context, &iter);
+  DCHECK(!vpx_image);
+  return true;
+}
+
 // MemoryPool is a pool of simple CPU memory, allocated by hand and used by both
 // VP9 and any data consumers. This class needs to be ref-counted to hold on to
 // allocated memory via the memory-release callback of CreateFrameCallback().
@@ -208,7 +255,6 @@ class VpxVideoDecoder::MemoryPool
   struct VP9FrameBuffer {
     VP9FrameBuffer() : ref_cnt(0) {}
     std::vector<uint8_t> data;
-    std::vector<uint8_t> alpha_data;
     uint32_t ref_cnt;
   };
 
@@ -300,7 +346,10 @@ base::Closure VpxVideoDecoder::MemoryPool::CreateFrameCallback(
     void* fb_priv_data) {
   VP9FrameBuffer* frame_buffer = static_cast<VP9FrameBuffer*>(fb_priv_data);
   ++frame_buffer->ref_cnt;
-  return BindToCurrentLoop(
+  // Decoding may run on a TaskScheduler sequence rather than a thread, so bind
+  // to the current sequence instead of using BindToCurrentLoop().
+  return base::Bind(
+      &PostToTaskRunner, base::SequencedTaskRunnerHandle::Get(),
       base::Bind(&MemoryPool::OnVideoFrameDestroyed, this, frame_buffer));
 }
 
@@ -317,18 +366,28 @@ bool VpxVideoDecoder::MemoryPool::OnMemoryDump(
                             ->system_allocator_pool_name());
   size_t bytes_used = 0;
   size_t bytes_reserved = 0;
+  size_t buffers_used = 0;
   for (const auto& frame_buffer : frame_buffers_) {
-    if (frame_buffer->ref_cnt)
+    if (frame_buffer->ref_cnt) {
       bytes_used += frame_buffer->data.size();
+      ++buffers_used;
+    }
     bytes_reserved += frame_buffer->data.size();
   }
 
   memory_dump->AddScalar(base::trace_event::MemoryAllocatorDump::kNameSize,
                          base::trace_event::MemoryAllocatorDump::kUnitsBytes,
                          bytes_reserved);
+  memory_dump->AddScalar(
+      base::trace_event::MemoryAllocatorDump::kNameObjectCount,
+      base::trace_event::MemoryAllocatorDump::kUnitsObjects,
+      frame_buffers_.size());
   used_memory_dump->AddScalar(
       base::trace_event::MemoryAllocatorDump::kNameSize,
       base::trace_event::MemoryAllocatorDump::kUnitsBytes, bytes_used);
+  used_memory_dump->AddScalar(
+      base::trace_event::MemoryAllocatorDump::kNameObjectCount,
+      base::trace_event::MemoryAllocatorDump::kUnitsObjects, buffers_used);
 
   return true;
 }
@@ -339,7 +398,12 @@ void VpxVideoDecoder::MemoryPool::OnVideoFrameDestroyed(
 }
 
 VpxVideoDecoder::VpxVideoDecoder()
-    : state_(kUninitialized), vpx_codec_(nullptr), vpx_codec_alpha_(nullptr) {
+    : state_(kUninitialized),
+      vpx_codec_(nullptr),
+      vpx_codec_alpha_(nullptr),
+      thread_count_(0),
+      thread_budget_id_(DecodeThreadBudget::kInvalidClientId),
+      use_decode_pool_(base::FeatureList::IsEnabled(kVpxSharedDecodePool)) {
   thread_checker_.DetachFromThread();
 }
 
@@ -348,6 +412,9 @@ VpxVideoDecoder::~VpxVideoDecoder() {
   CloseDecoder();
   // Ensure CloseDecoder() released the offload thread.
   DCHECK(!offload_task_runner_);
+
+  if (thread_budget_id_ != DecodeThreadBudget::kInvalidClientId)
+    DecodeThreadBudget::GetInstance()->UnregisterDecoder(thread_budget_id_);
 }
 
 std::string VpxVideoDecoder::GetDisplayName() const {
@@ -377,6 +444,7 @@ void VpxVideoDecoder::Initialize(const VideoDecoderConfig& config,
 }
 
 void VpxVideoDecoder::DecodeBuffer(const scoped_refptr<DecoderBuffer>& buffer,
+                                   bool discard_output,
                                    const DecodeCB& bound_decode_cb) {
   DCHECK_NE(state_, kUninitialized)
       << "Called Decode() before successful Initialize()";
@@ -398,7 +466,7 @@ void VpxVideoDecoder::DecodeBuffer(const scoped_refptr<DecoderBuffer>& buffer,
   }
 
   scoped_refptr<VideoFrame> video_frame;
-  if (!VpxDecode(buffer, &video_frame)) {
+  if (!VpxDecode(buffer, discard_output, &video_frame)) {
     state_ = kError;
     bound_decode_cb.Run(DecodeStatus::DECODE_ERROR);
     return;
@@ -418,6 +486,19 @@ void VpxVideoDecoder::DecodeBuffer(const scoped_refptr<DecoderBuffer>& buffer,
 
 void VpxVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
                              const DecodeCB& decode_cb) {
+  ScheduleDecode(buffer, false, decode_cb);
+}
+
+void VpxVideoDecoder::DecodeDiscardingOutput(
+    const scoped_refptr<DecoderBuffer>& buffer,
+    const DecodeCB& decode_cb) {
+  DCHECK(!buffer->end_of_stream());
+  ScheduleDecode(buffer, true, decode_cb);
+}
+
+void VpxVideoDecoder::ScheduleDecode(const scoped_refptr<DecoderBuffer>& buffer,
+                                     bool discard_output,
+                                     const DecodeCB& decode_cb) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(buffer.get());
   DCHECK(!decode_cb.is_null());
@@ -426,17 +507,18 @@ void VpxVideoDecoder::Decode(const scoped_refptr<DecoderBuffer>& buffer,
 
   if (offload_task_runner_) {
     offload_task_runner_->PostTask(
-        FROM_HERE, base::Bind(&VpxVideoDecoder::DecodeBuffer,
-                              base::Unretained(this), buffer, bound_decode_cb));
+        FROM_HERE,
+        base::Bind(&VpxVideoDecoder::DecodeBuffer, base::Unretained(this),
+                   buffer, discard_output, bound_decode_cb));
   } else {
-    DecodeBuffer(buffer, bound_decode_cb);
+    DecodeBuffer(buffer, discard_output, bound_decode_cb);
   }
 }
 
 void VpxVideoDecoder::Reset(const base::Closure& closure) {
   DCHECK(thread_checker_.CalledOnValidThread());
   if (offload_task_runner_)
-    g_vpx_offload_thread.Pointer()->WaitForOutstandingTasks();
+    WaitForOutstandingTasks(offload_task_runner_.get());
 
   state_ = kNormal;
   // PostTask() to avoid calling |closure| inmediately.
@@ -464,25 +546,65 @@ bool VpxVideoDecoder::ConfigureDecoder(const VideoDecoderConfig& config) {
 
   CloseDecoder();
 
-  vpx_codec_ = InitializeVpxContext(vpx_codec_, config);
-  if (!vpx_codec_)
-    return false;
-
-  // Configure VP9 to decode on our buffers to skip a data copy on
-  // decoding. For YV12A-VP9, we use our buffers for the Y, U and V planes and
-  // copy the A plane.
-  if (config.codec() == kCodecVP9) {
-    DCHECK(vpx_codec_get_caps(vpx_codec_->iface) &
-           VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER);
+  RegisterWithThreadBudget(config);
 
+  if (use_decode_pool_) {
+    offload_task_runner_ = CreateDecodeSequence();
+  } else if (config.codec() == kCodecVP9) {
     // Move high resolution vp9 decodes off of the main media thread (otherwise
     // decode may block audio decoding, demuxing, and other control activities).
-    if (config.coded_size().width() >= 1024) {
+    if (config.coded_size().width() >= kMinWidthForPoolDecodeThreads) {
       offload_task_runner_ =
           g_vpx_offload_thread.Pointer()->RequestOffloadThread();
     }
+  }
 
+  if (config.codec() == kCodecVP9)
     memory_pool_ = new MemoryPool();
+
+  return CreateVpxContexts(config);
+}
+
+void VpxVideoDecoder::RegisterWithThreadBudget(
+    const VideoDecoderConfig& config) {
+  if (DecodeThreadBudget::HasThreadCountOverride())
+    return;
+
+  DecodeThreadBudget* budget = DecodeThreadBudget::GetInstance();
+  const int max_threads =
+      use_decode_pool_ &&
+              config.coded_size().width() < kMinWidthForPoolDecodeThreads
+          ? kMinBudgetedDecodeThreads
+          : std::max(GetThreadCount(config), kMinBudgetedDecodeThreads);
+  if (thread_budget_id_ == DecodeThreadBudget::kInvalidClientId) {
+    thread_budget_id_ = budget->RegisterDecoder(
+        config.coded_size(), kMinBudgetedDecodeThreads, max_threads);
+  } else {
+    budget->UpdateDecoder(thread_budget_id_, config.coded_size(), max_threads);
+  }
+}
+
+bool VpxVideoDecoder::CreateVpxContexts(const VideoDecoderConfig& config) {
+  DCHECK(!vpx_codec_);
+  DCHECK(!vpx_codec_alpha_);
+
+  thread_count_ =
+      thread_budget_id_ != DecodeThreadBudget::kInvalidClientId
+          ? DecodeThreadBudget::GetInstance()->GetThreadCount(thread_budget_id_)
+          : GetThreadCount(config);
+
+  vpx_codec_ = InitializeVpxContext(vpx_codec_, config, thread_count_);
+  if (!vpx_codec_)
+    return false;
+
+  // Configure VP9 to decode on our buffers to skip a data copy on
+  // decoding. For YV12A-VP9, the alpha context decodes on our buffers too, so
+  // the A plane is wrapped rather than copied.
+  if (config.codec() == kCodecVP9) {
+    DCHECK(vpx_codec_get_caps(vpx_codec_->iface) &
+           VPX_CODEC_CAP_EXTERNAL_FRAME_BUFFER);
+    DCHECK(memory_pool_);
+
     if (vpx_codec_set_frame_buffer_functions(vpx_codec_,
                                              &MemoryPool::GetVP9FrameBuffer,
                                              &MemoryPool::ReleaseVP9FrameBuffer,
@@ -496,22 +618,28 @@ bool VpxVideoDecoder::ConfigureDecoder(const VideoDecoderConfig& config) {
   if (config.format() != PIXEL_FORMAT_YV12A)
     return true;
 
-  vpx_codec_alpha_ = InitializeVpxContext(vpx_codec_alpha_, config);
-  return !!vpx_codec_alpha_;
-}
+  vpx_codec_alpha_ =
+      InitializeVpxContext(vpx_codec_alpha_, config, thread_count_);
+  if (!vpx_codec_alpha_)
+    return false;
 
-void VpxVideoDecoder::CloseDecoder() {
-  if (offload_task_runner_) {
-    g_vpx_offload_thread.Pointer()
-        ->WaitForOutstandingTasksAndReleaseOffloadThread();
-    offload_task_runner_ = nullptr;
+  if (config.codec() == kCodecVP9 &&
+      vpx_codec_set_frame_buffer_functions(vpx_codec_alpha_,
+                                           &MemoryPool::GetVP9FrameBuffer,
+                                           &MemoryPool::ReleaseVP9FrameBuffer,
+                                           memory_pool_.get())) {
+    DLOG(ERROR) << "Failed to configure external buffers for alpha. "
+                << vpx_codec_error(vpx_codec_alpha_);
+    return false;
   }
+  return true;
+}
 
+void VpxVideoDecoder::DestroyVpxContexts() {
   if (vpx_codec_) {
     vpx_codec_destroy(vpx_codec_);
     delete vpx_codec_;
     vpx_codec_ = nullptr;
-    memory_pool_ = nullptr;
   }
   if (vpx_codec_alpha_) {
     vpx_codec_destroy(vpx_codec_alpha_);
@@ -520,15 +648,56 @@ void VpxVideoDecoder::CloseDecoder() {
   }
 }
 
+bool VpxVideoDecoder::MaybeApplyThreadBudget() {
+  if (thread_budget_id_ == DecodeThreadBudget::kInvalidClientId)
+    return true;
+
+  const int thread_count =
+      DecodeThreadBudget::GetInstance()->GetThreadCount(thread_budget_id_);
+  if (thread_count == thread_count_)
+    return true;
+
+  // Drain the contexts before they are destroyed.  |memory_pool_| is kept;
+  // buffers referenced by outstanding VideoFrames stay valid.
+  if (!FlushVpxContext(vpx_codec_) ||
+      (vpx_codec_alpha_ && !FlushVpxContext(vpx_codec_alpha_))) {
+    return false;
+  }
+  DestroyVpxContexts();
+  return CreateVpxContexts(config_);
+}
+
+void VpxVideoDecoder::CloseDecoder() {
+  if (offload_task_runner_) {
+    if (use_decode_pool_) {
+      WaitForOutstandingTasks(offload_task_runner_.get());
+    } else {
+      g_vpx_offload_thread.Pointer()
+          ->WaitForOutstandingTasksAndReleaseOffloadThread();
+    }
+    offload_task_runner_ = nullptr;
+  }
+
+  DestroyVpxContexts();
+  memory_pool_ = nullptr;
+}
+
 bool VpxVideoDecoder::VpxDecode(const scoped_refptr<DecoderBuffer>& buffer,
+                                bool discard_output,
                                 scoped_refptr<VideoFrame>* video_frame) {
   DCHECK(video_frame);
   DCHECK(!buffer->end_of_stream());
 
+  // Keyframes are the only points where the contexts can be recreated without
+  // losing reference frames, so follow changes in the thread budget there.
+  if (buffer->is_key_frame() && !MaybeApplyThreadBudget())
+    return false;
+
   int64_t timestamp = buffer->timestamp().InMicroseconds();
   void* user_priv = reinterpret_cast<void*>(&timestamp);
   {
     TRACE_EVENT1("media", "vpx_codec_decode", "timestamp", timestamp);
+    const base::TimeTicks decode_start = base::TimeTicks::Now();
     vpx_codec_err_t status =
         vpx_codec_decode(vpx_codec_, buffer->data(), buffer->data_size(),
                          user_priv, 0 /* deadline */);
@@ -537,6 +706,10 @@ bool VpxVideoDecoder::VpxDecode(const scoped_refptr<DecoderBuffer>& buffer,
                   << vpx_codec_err_to_string(status);
       return false;
     }
+    if (thread_budget_id_ != DecodeThreadBudget::kInvalidClientId) {
+      DecodeThreadBudget::GetInstance()->AddDecodeTimeSample(
+          thread_budget_id_, base::TimeTicks::Now() - decode_start);
+    }
   }
 
   // Gets pointer to decoded data.
@@ -561,6 +734,14 @@ bool VpxVideoDecoder::VpxDecode(const scoped_refptr<DecoderBuffer>& buffer,
     *video_frame = nullptr;
     return true;
   }
+
+  // The frame was decoded, so later frames can reference it, but it will not be
+  // shown; skip copying or wrapping it.
+  if (discard_output) {
+    *video_frame = nullptr;
+    return true;
+  }
+
   if (!CopyVpxImageToVideoFrame(vpx_image, vpx_image_alpha, video_frame)) {
     return false;
   }
@@ -691,21 +872,6 @@ VpxVideoDecoder::AlphaDecodeStatus VpxVideoDecoder::DecodeAlphaPlane(
     return kAlphaPlaneError;
   }
 
-  if (config_.codec() == kCodecVP9) {
-    VpxVideoDecoder::MemoryPool::VP9FrameBuffer* frame_buffer =
-        static_cast<VpxVideoDecoder::MemoryPool::VP9FrameBuffer*>(
-            vpx_image->fb_priv);
-    uint64_t alpha_plane_size =
-        (*vpx_image_alpha)->stride[VPX_PLANE_Y] * (*vpx_image_alpha)->d_h;
-    if (frame_buffer->alpha_data.size() < alpha_plane_size) {
-      frame_buffer->alpha_data.resize(alpha_plane_size);
-    }
-    libyuv::CopyPlane((*vpx_image_alpha)->planes[VPX_PLANE_Y],
-                      (*vpx_image_alpha)->stride[VPX_PLANE_Y],
-                      &frame_buffer->alpha_data[0],
-                      (*vpx_image_alpha)->stride[VPX_PLANE_Y],
-                      (*vpx_image_alpha)->d_w, (*vpx_image_alpha)->d_h);
-  }
   return kAlphaPlaneProcessed;
 }
 
@@ -782,16 +948,13 @@ bool VpxVideoDecoder::CopyVpxImageToVideoFrame(
   if (memory_pool_.get()) {
     DCHECK_EQ(kCodecVP9, config_.codec());
     if (vpx_image_alpha) {
-      VpxVideoDecoder::MemoryPool::VP9FrameBuffer* frame_buffer =
-          static_cast<VpxVideoDecoder::MemoryPool::VP9FrameBuffer*>(
-              vpx_image->fb_priv);
       *video_frame = VideoFrame::WrapExternalYuvaData(
           codec_format, coded_size, gfx::Rect(visible_size),
           config_.natural_size(), vpx_image->stride[VPX_PLANE_Y],
           vpx_image->stride[VPX_PLANE_U], vpx_image->stride[VPX_PLANE_V],
           vpx_image_alpha->stride[VPX_PLANE_Y], vpx_image->planes[VPX_PLANE_Y],
           vpx_image->planes[VPX_PLANE_U], vpx_image->planes[VPX_PLANE_V],
-          &frame_buffer->alpha_data[0], kNoTimestamp);
+          vpx_image_alpha->planes[VPX_PLANE_Y], kNoTimestamp);
     } else {
       *video_frame = VideoFrame::WrapExternalYuvData(
           codec_format, coded_size, gfx::Rect(visible_size),
@@ -805,6 +968,12 @@ bool VpxVideoDecoder::CopyVpxImageToVideoFrame(
 
     video_frame->get()->AddDestructionObserver(
         memory_pool_->CreateFrameCallback(vpx_image->fb_priv));
+    // The alpha plane lives in a separate pool buffer owned by the alpha
+    // context; keep it alive for as long as the frame too.
+    if (vpx_image_alpha) {
+      video_frame->get()->AddDestructionObserver(
+          memory_pool_->CreateFrameCallback(vpx_image_alpha->fb_priv));
+    }
     return true;
   }
 
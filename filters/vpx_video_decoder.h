@@ -13,12 +13,13 @@
 #include "media/base/video_decoder_config.h"
 #include "media/base/video_frame.h"
 #include "media/base/video_frame_pool.h"
+#include "media/filters/decode_thread_budget.h"
 
 struct vpx_codec_ctx;
 struct vpx_image;
 
 namespace base {
-class SingleThreadTaskRunner;
+class SequencedTaskRunner;
 }
 
 namespace media {
@@ -35,6 +36,13 @@ class MEDIA_EXPORT VpxVideoDecoder : public VideoDecoder {
   VpxVideoDecoder();
   ~VpxVideoDecoder() override;
 
+  // Decode on a TaskScheduler sequence instead of the media thread or the high
+  // resolution offload thread; narrow streams then use a single libvpx thread.  Defaults to the kVpxSharedDecodePool feature.
+  // Must be called before Initialize().
+  void set_use_shared_decode_pool(bool use_decode_pool) {
+    use_decode_pool_ = use_decode_pool;
+  }
+
   // VideoDecoder implementation.
   std::string GetDisplayName() const override;
   void Initialize(const VideoDecoderConfig& config,
@@ -44,6 +52,8 @@ class MEDIA_EXPORT VpxVideoDecoder : public VideoDecoder {
                   const OutputCB& output_cb) override;
   void Decode(const scoped_refptr<DecoderBuffer>& buffer,
               const DecodeCB& decode_cb) override;
+  void DecodeDiscardingOutput(const scoped_refptr<DecoderBuffer>& buffer,
+                              const DecodeCB& decode_cb) override;
   void Reset(const base::Closure& closure) override;
 
  private:
@@ -69,16 +79,38 @@ class MEDIA_EXPORT VpxVideoDecoder : public VideoDecoder {
 
   void CloseDecoder();
 
+  // Registers |config| with the process-wide DecodeThreadBudget, unless the
+  // thread count was forced on the command line.
+  void RegisterWithThreadBudget(const VideoDecoderConfig& config);
+
+  // Creates |vpx_codec_| and, for alpha content, |vpx_codec_alpha_| with the
+  // number of threads currently allotted by the budget.
+  bool CreateVpxContexts(const VideoDecoderConfig& config);
+  void DestroyVpxContexts();
+
+  // Recreates the libvpx contexts if the thread budget now allots a different
+  // number of threads than |thread_count_|.  Must only be called before
+  // decoding a keyframe.  Returns false if the contexts could not be recreated.
+  bool MaybeApplyThreadBudget();
+
+  // Implements Decode() and DecodeDiscardingOutput() by running DecodeBuffer()
+  // on the offload thread, if any.
+  void ScheduleDecode(const scoped_refptr<DecoderBuffer>& buffer,
+                      bool discard_output,
+                      const DecodeCB& decode_cb);
+
   // Helper method for decoding buffers either on the offload thread or directly
   // on the media thread. |bound_decode_cb| must be bound to the thread that
   // called Decode().
   void DecodeBuffer(const scoped_refptr<DecoderBuffer>& buffer,
+                    bool discard_output,
                     const DecodeCB& bound_decode_cb);
 
   // Try to decode |buffer| into |video_frame|. Return true if all decoding
   // succeeded. Note that decoding can succeed and still |video_frame| be
-  // nullptr if there has been a partial decoding.
+  // nullptr if there has been a partial decoding, or if |discard_output|.
   bool VpxDecode(const scoped_refptr<DecoderBuffer>& buffer,
+                 bool discard_output,
                  scoped_refptr<VideoFrame>* video_frame);
 
   bool CopyVpxImageToVideoFrame(const struct vpx_image* vpx_image,
@@ -103,14 +135,23 @@ class MEDIA_EXPORT VpxVideoDecoder : public VideoDecoder {
   vpx_codec_ctx* vpx_codec_;
   vpx_codec_ctx* vpx_codec_alpha_;
 
-  // |memory_pool_| is a single-threaded memory pool used for VP9 decoding
-  // with no alpha. |frame_pool_| is used for all other cases.
+  // Number of threads the libvpx contexts were created with.
+  int thread_count_;
+
+  DecodeThreadBudget::ClientId thread_budget_id_;
+
+  // |memory_pool_| is a single-threaded memory pool used for VP9 decoding,
+  // including the alpha plane. |frame_pool_| is used for VP8 with alpha, where
+  // libvpx does not support decoding into external frame buffers.
   class MemoryPool;
   scoped_refptr<MemoryPool> memory_pool_;
 
   // High resolution vp9 may block the media thread for too long, in such cases
-  // we share a per-process thread to avoid overly long blocks.
-  scoped_refptr<base::SingleThreadTaskRunner> offload_task_runner_;
+  // we share a per-process thread to avoid overly long blocks.  When
+  // |use_decode_pool_| is set, this is instead a TaskScheduler sequence of
+  // this decoder's own and is used for all streams.
+  scoped_refptr<base::SequencedTaskRunner> offload_task_runner_;
+  bool use_decode_pool_;
 
   VideoFramePool frame_pool_;
 
@@ -0,0 +1,157 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task_scheduler/task_scheduler.h"
+#include "base/time/time.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/media_util.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/ivf_parser.h"
+#include "media/filters/vpx_video_decoder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const char kTestFile[] = "bear-vp9.ivf";
+static const int kBenchmarkRounds = 4;
+
+// Decodes the same stream on |num_decoders| VpxVideoDecoders concurrently,
+// one buffer per decoder at a time, and reports aggregate throughput along with
+// the median and 99th percentile latency of individual Decode() calls.
+class MultiDecoderBenchmark {
+ public:
+  MultiDecoderBenchmark() : outstanding_decodes_(0) {}
+
+  void Run(int num_decoders, bool use_shared_pool) {
+    ASSERT_TRUE(ReadBuffers());
+
+    std::vector<std::unique_ptr<VpxVideoDecoder>> decoders;
+    for (int i = 0; i < num_decoders; ++i) {
+      decoders.push_back(base::MakeUnique<VpxVideoDecoder>());
+      decoders.back()->set_use_shared_decode_pool(use_shared_pool);
+      bool success = false;
+      decoders.back()->Initialize(
+          config_, false, nullptr,
+          base::Bind(&MultiDecoderBenchmark::OnInitDone,
+                     base::Unretained(this), &success),
+          base::Bind(&MultiDecoderBenchmark::OnOutput, base::Unretained(this)));
+      base::RunLoop().RunUntilIdle();
+      ASSERT_TRUE(success);
+    }
+
+    latencies_.clear();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int round = 0; round < kBenchmarkRounds; ++round) {
+      for (const auto& buffer : buffers_) {
+        base::RunLoop run_loop;
+        quit_closure_ = run_loop.QuitClosure();
+        outstanding_decodes_ = num_decoders;
+        for (const auto& decoder : decoders) {
+          decoder->Decode(buffer,
+                          base::Bind(&MultiDecoderBenchmark::OnDecodeDone,
+                                     base::Unretained(this),
+                                     base::TimeTicks::Now()));
+        }
+        run_loop.Run();
+      }
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    decoders.clear();
+
+    const std::string trace = base::IntToString(num_decoders) +
+                              (use_shared_pool ? "_shared_pool" : "_default");
+    perf_test::PrintResult("vpx_multi_decoder", "_throughput", trace,
+                           latencies_.size() / elapsed.InSecondsF(),
+                           "frames/s", true);
+
+    std::sort(latencies_.begin(), latencies_.end());
+    perf_test::PrintResult("vpx_multi_decoder", "_latency_p50", trace,
+                           latencies_[latencies_.size() / 2].InMillisecondsF(),
+                           "ms", true);
+    perf_test::PrintResult(
+        "vpx_multi_decoder", "_latency_p99", trace,
+        latencies_[latencies_.size() * 99 / 100].InMillisecondsF(), "ms",
+        true);
+  }
+
+ private:
+  bool ReadBuffers() {
+    if (!buffers_.empty())
+      return true;
+
+    file_data_ = ReadTestDataFile(kTestFile);
+    IvfParser parser;
+    IvfFileHeader file_header;
+    if (!parser.Initialize(file_data_->data(), file_data_->data_size(),
+                           &file_header)) {
+      return false;
+    }
+
+    const gfx::Size size(file_header.width, file_header.height);
+    config_ = VideoDecoderConfig(kCodecVP9, VP9PROFILE_PROFILE0,
+                                 PIXEL_FORMAT_YV12, COLOR_SPACE_UNSPECIFIED,
+                                 size, gfx::Rect(size), size, EmptyExtraData(),
+                                 Unencrypted());
+
+    IvfFrameHeader frame_header;
+    const uint8_t* payload = nullptr;
+    while (parser.ParseNextFrame(&frame_header, &payload)) {
+      scoped_refptr<DecoderBuffer> buffer =
+          DecoderBuffer::CopyFrom(payload, frame_header.frame_size);
+      buffer->set_timestamp(
+          base::TimeDelta::FromMilliseconds(33 * buffers_.size()));
+      buffer->set_is_key_frame(buffers_.empty());
+      buffers_.push_back(buffer);
+    }
+    return !buffers_.empty();
+  }
+
+  void OnInitDone(bool* result, bool success) { *result = success; }
+
+  void OnOutput(const scoped_refptr<VideoFrame>& frame) {}
+
+  void OnDecodeDone(base::TimeTicks decode_start, DecodeStatus status) {
+    ASSERT_EQ(DecodeStatus::OK, status);
+    latencies_.push_back(base::TimeTicks::Now() - decode_start);
+    if (!--outstanding_decodes_)
+      quit_closure_.Run();
+  }
+
+  base::MessageLoop message_loop_;
+  scoped_refptr<DecoderBuffer> file_data_;
+  VideoDecoderConfig config_;
+  std::vector<scoped_refptr<DecoderBuffer>> buffers_;
+
+  int outstanding_decodes_;
+  base::Closure quit_closure_;
+  std::vector<base::TimeDelta> latencies_;
+};
+
+TEST(VpxVideoDecoderPerfTest, MultiDecoderBenchmark) {
+  // The shared pool decodes on TaskScheduler sequences.
+  if (!base::TaskScheduler::GetInstance())
+    base::TaskScheduler::CreateAndSetSimpleTaskScheduler("VpxDecoderPerfTest");
+
+  MultiDecoderBenchmark benchmark;
+  for (int num_decoders : {1, 4, 16, 36}) {
+    benchmark.Run(num_decoders, false);
+    benchmark.Run(num_decoders, true);
+  }
+}
+
+}  // namespace media
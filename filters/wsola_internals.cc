@@ -7,6 +7,9 @@
 
 #include "media/filters/wsola_internals.h"
 
+#include <stdint.h>
+#include <string.h>
+
 #include <algorithm>
 #include <cmath>
 #include <limits>
@@ -14,26 +17,48 @@
 
 #include "base/logging.h"
 #include "media/base/audio_bus.h"
+#include "media/base/vector_math.h"
 
 namespace media {
 
 namespace internal {
 
+FftCorrelationState::FftCorrelationState(int fft_size)
+    : fft_size(fft_size),
+      cos_table(new float[fft_size / 2]),
+      sin_table(new float[fft_size / 2]),
+      real(new float[fft_size]),
+      imag(new float[fft_size]),
+      sum_real(new float[fft_size]),
+      sum_imag(new float[fft_size]),
+      dot_product(new float[fft_size]) {
+  GetFftTwiddleFactors(fft_size, cos_table.get(), sin_table.get());
+}
+
+FftCorrelationState::~FftCorrelationState() {}
+
 bool InInterval(int n, Interval q) {
   return n >= q.first && n <= q.second;
 }
 
+// Normalized cross-correlation of two multi-channel blocks, treating all
+// channels as a single vector. Unlike normalizing each channel separately and
+// summing, this weights channels by their energy, so that a near silent
+// channel cannot dominate the match.
 float MultiChannelSimilarityMeasure(const float* dot_prod_a_b,
                                     const float* energy_a,
                                     const float* energy_b,
                                     int channels) {
   const float kEpsilon = 1e-12f;
-  float similarity_measure = 0.0f;
+  float dot_product = 0.0f;
+  float total_energy_a = 0.0f;
+  float total_energy_b = 0.0f;
   for (int n = 0; n < channels; ++n) {
-    similarity_measure += dot_prod_a_b[n] / sqrt(energy_a[n] * energy_b[n] +
-                                                 kEpsilon);
+    dot_product += dot_prod_a_b[n];
+    total_energy_a += energy_a[n];
+    total_energy_b += energy_b[n];
   }
-  return similarity_measure;
+  return dot_product / sqrt(total_energy_a * total_energy_b + kEpsilon);
 }
 
 void MultiChannelDotProduct(const AudioBus* a,
@@ -48,14 +73,187 @@ void MultiChannelDotProduct(const AudioBus* a,
   DCHECK_LE(frame_offset_a + num_frames, a->frames());
   DCHECK_LE(frame_offset_b + num_frames, b->frames());
 
-  memset(dot_product, 0, sizeof(*dot_product) * a->channels());
   for (int k = 0; k < a->channels(); ++k) {
-    const float* ch_a = a->channel(k) + frame_offset_a;
-    const float* ch_b = b->channel(k) + frame_offset_b;
-    for (int n = 0; n < num_frames; ++n) {
-      dot_product[k] += *ch_a++ * *ch_b++;
+    dot_product[k] = vector_math::DotProduct(a->channel(k) + frame_offset_a,
+                                             b->channel(k) + frame_offset_b,
+                                             num_frames);
+  }
+}
+
+void Fft(int fft_size,
+         bool inverse,
+         const float* cos_table,
+         const float* sin_table,
+         float* real,
+         float* imag) {
+  // Bit-reversal permutation.
+  for (int i = 1, j = 0; i < fft_size; ++i) {
+    int bit = fft_size >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      std::swap(real[i], real[j]);
+      std::swap(imag[i], imag[j]);
+    }
+  }
+
+  const float sign = inverse ? 1.0f : -1.0f;
+  for (int half_size = 1; half_size < fft_size; half_size *= 2) {
+    const int table_stride = fft_size / (2 * half_size);
+    for (int start = 0; start < fft_size; start += 2 * half_size) {
+      for (int k = 0; k < half_size; ++k) {
+        const float w_real = cos_table[k * table_stride];
+        const float w_imag = sign * sin_table[k * table_stride];
+        const int top = start + k;
+        const int bottom = top + half_size;
+        const float t_real = real[bottom] * w_real - imag[bottom] * w_imag;
+        const float t_imag = real[bottom] * w_imag + imag[bottom] * w_real;
+        real[bottom] = real[top] - t_real;
+        imag[bottom] = imag[top] - t_imag;
+        real[top] += t_real;
+        imag[top] += t_imag;
+      }
+    }
+  }
+}
+
+int GetFftSize(int frames) {
+  int fft_size = 2;
+  while (fft_size < frames)
+    fft_size *= 2;
+  return fft_size;
+}
+
+void GetFftTwiddleFactors(int fft_size, float* cos_table, float* sin_table) {
+  for (int k = 0; k < fft_size / 2; ++k) {
+    const double angle = 2.0 * M_PI * k / fft_size;
+    cos_table[k] = cos(angle);
+    sin_table[k] = sin(angle);
+  }
+}
+
+// Writes the spectrum of the cross-correlation of channel |ch| of
+// |target_block| and |search_block| to |real| and |imag|.
+static void CrossCorrelationSpectrum(const AudioBus* target_block,
+                                     const AudioBus* search_block,
+                                     int ch,
+                                     int fft_size,
+                                     const float* cos_table,
+                                     const float* sin_table,
+                                     float* real,
+                                     float* imag) {
+  // Transform the search and the target channel at once, as the real and
+  // imaginary parts of a single complex signal.
+  const int target_size = target_block->frames();
+  memcpy(real, search_block->channel(ch),
+         sizeof(float) * search_block->frames());
+  std::fill(real + search_block->frames(), real + fft_size, 0);
+  memcpy(imag, target_block->channel(ch), sizeof(float) * target_size);
+  std::fill(imag + target_size, imag + fft_size, 0);
+  Fft(fft_size, false, cos_table, sin_table, real, imag);
+
+  // With Z = FFT(s + i * t), the spectra of s and t are
+  //   S[k] = (Z[k] + conj(Z[-k])) / 2
+  //   T[k] = (Z[k] - conj(Z[-k])) / 2i
+  // and the cross-correlation spectrum S[k] * conj(T[k]) simplifies to
+  //   i / 4 * (Z[k] + conj(Z[-k])) * (conj(Z[k]) - Z[-k]).
+  for (int k = 0; k <= fft_size / 2; ++k) {
+    const int mirror = (fft_size - k) & (fft_size - 1);
+    const float a_real = real[k];
+    const float a_imag = imag[k];
+    const float b_real = real[mirror];
+    const float b_imag = imag[mirror];
+
+    // Bin |k|: P = Z[k] + conj(Z[-k]), Q = conj(Z[k]) - Z[-k].
+    float p_real = a_real + b_real;
+    float p_imag = a_imag - b_imag;
+    float q_real = a_real - b_real;
+    float q_imag = -a_imag - b_imag;
+    float pq_real = p_real * q_real - p_imag * q_imag;
+    float pq_imag = p_real * q_imag + p_imag * q_real;
+    real[k] = -0.25f * pq_imag;
+    imag[k] = 0.25f * pq_real;
+
+    if (mirror == k)
+      continue;
+
+    // Bin |mirror|, with the roles of Z[k] and Z[-k] swapped.
+    p_real = b_real + a_real;
+    p_imag = b_imag - a_imag;
+    q_real = b_real - a_real;
+    q_imag = -b_imag - a_imag;
+    pq_real = p_real * q_real - p_imag * q_imag;
+    pq_imag = p_real * q_imag + p_imag * q_real;
+    real[mirror] = -0.25f * pq_imag;
+    imag[mirror] = 0.25f * pq_real;
+  }
+}
+
+void MultiChannelCrossCorrelation(const AudioBus* target_block,
+                                  const AudioBus* search_block,
+                                  FftCorrelationState* fft_state,
+                                  float* dot_product) {
+  DCHECK_EQ(target_block->channels(), search_block->channels());
+  DCHECK_LE(target_block->frames(), search_block->frames());
+  const int channels = search_block->channels();
+  const int num_candidate_blocks =
+      search_block->frames() - (target_block->frames() - 1);
+
+  // Correlation lags never exceed the search block, so a transform covering it
+  // is free of circular wrap-around for all candidate blocks.
+  const int fft_size = fft_state->fft_size;
+  DCHECK_EQ(fft_size, GetFftSize(search_block->frames()));
+
+  float* real = fft_state->real.get();
+  float* imag = fft_state->imag.get();
+  const float scale = 1.0f / fft_size;
+  for (int ch = 0; ch < channels; ++ch) {
+    CrossCorrelationSpectrum(target_block, search_block, ch, fft_size,
+                             fft_state->cos_table.get(),
+                             fft_state->sin_table.get(), real, imag);
+    Fft(fft_size, true, fft_state->cos_table.get(), fft_state->sin_table.get(),
+        real, imag);
+    for (int n = 0; n < num_candidate_blocks; ++n)
+      dot_product[n * channels + ch] = real[n] * scale;
+  }
+}
+
+void SummedCrossCorrelation(const AudioBus* target_block,
+                            const AudioBus* search_block,
+                            FftCorrelationState* fft_state,
+                            float* dot_product) {
+  DCHECK_EQ(target_block->channels(), search_block->channels());
+  DCHECK_LE(target_block->frames(), search_block->frames());
+  const int num_candidate_blocks =
+      search_block->frames() - (target_block->frames() - 1);
+
+  const int fft_size = fft_state->fft_size;
+  DCHECK_EQ(fft_size, GetFftSize(search_block->frames()));
+
+  // The transform is linear, so the spectra of all channels are summed and
+  // only a single inverse transform is needed.
+  float* sum_real = fft_state->sum_real.get();
+  float* sum_imag = fft_state->sum_imag.get();
+  float* real = fft_state->real.get();
+  float* imag = fft_state->imag.get();
+  std::fill(sum_real, sum_real + fft_size, 0);
+  std::fill(sum_imag, sum_imag + fft_size, 0);
+  for (int ch = 0; ch < search_block->channels(); ++ch) {
+    CrossCorrelationSpectrum(target_block, search_block, ch, fft_size,
+                             fft_state->cos_table.get(),
+                             fft_state->sin_table.get(), real, imag);
+    for (int k = 0; k < fft_size; ++k) {
+      sum_real[k] += real[k];
+      sum_imag[k] += imag[k];
     }
   }
+
+  Fft(fft_size, true, fft_state->cos_table.get(), fft_state->sin_table.get(),
+      sum_real, sum_imag);
+  const float scale = 1.0f / fft_size;
+  for (int n = 0; n < num_candidate_blocks; ++n)
+    dot_product[n] = sum_real[n] * scale;
 }
 
 void MultiChannelMovingBlockEnergies(const AudioBus* input,
@@ -67,12 +265,9 @@ void MultiChannelMovingBlockEnergies(const AudioBus* input,
   for (int k = 0; k < input->channels(); ++k) {
     const float* input_channel = input->channel(k);
 
-    energy[k] = 0;
-
     // First block of channel |k|.
-    for (int m = 0; m < frames_per_block; ++m) {
-      energy[k] += input_channel[m] * input_channel[m];
-    }
+    energy[k] = vector_math::DotProduct(input_channel, input_channel,
+                                        frames_per_block);
 
     const float* slide_out = input_channel;
     const float* slide_in = input_channel + frames_per_block;
@@ -217,9 +412,53 @@ int FullSearch(int low_limit,
   return optimal_index;
 }
 
+int FftSearch(Interval exclude_interval,
+              const AudioBus* target_block,
+              const AudioBus* search_block,
+              const float* energy_target_block,
+              const float* energy_candidate_blocks,
+              FftCorrelationState* fft_state) {
+  int channels = search_block->channels();
+  int num_candidate_blocks =
+      search_block->frames() - (target_block->frames() - 1);
+
+  // The similarity measure only depends on sums over channels, so a single
+  // correlation of the summed spectra serves all of them.
+  DCHECK_LE(num_candidate_blocks, fft_state->fft_size);
+  float* dot_prod = fft_state->dot_product.get();
+  SummedCrossCorrelation(target_block, search_block, fft_state, dot_prod);
+
+  float energy_target = 0.0f;
+  for (int k = 0; k < channels; ++k)
+    energy_target += energy_target_block[k];
+
+  float best_similarity = std::numeric_limits<float>::min();
+  int optimal_index = 0;
+
+  for (int n = 0; n < num_candidate_blocks; ++n) {
+    if (InInterval(n, exclude_interval)) {
+      continue;
+    }
+    float energy_candidate = 0.0f;
+    for (int k = 0; k < channels; ++k)
+      energy_candidate += energy_candidate_blocks[n * channels + k];
+
+    float similarity = MultiChannelSimilarityMeasure(
+        &dot_prod[n], &energy_target, &energy_candidate, 1);
+
+    if (similarity > best_similarity) {
+      best_similarity = similarity;
+      optimal_index = n;
+    }
+  }
+
+  return optimal_index;
+}
+
 int OptimalIndex(const AudioBus* search_block,
                  const AudioBus* target_block,
-                 Interval exclude_interval) {
+                 Interval exclude_interval,
+                 FftCorrelationState* fft_state) {
   int channels = search_block->channels();
   DCHECK_EQ(channels, target_block->channels());
   int target_size = target_block->frames();
@@ -245,6 +484,25 @@ int OptimalIndex(const AudioBus* search_block,
   MultiChannelDotProduct(target_block, 0, target_block, 0,
                          target_size, energy_target_block.get());
 
+  // Rough floating point operation counts, per channel, of the decimated
+  // search (vectorized four wide) and of the forward and inverse transforms
+  // of the FFT search. The latter wins for large search windows, e.g. at high
+  // sample rates, and is exhaustive rather than decimated.
+  const int kSimdWidth = 4;
+  const int kFftFlopsPerPointAndStage = 10;
+  const int fft_size = fft_state->fft_size;
+  const int64_t decimated_search_cost =
+      2 * static_cast<int64_t>(num_candidate_blocks / kSearchDecimation +
+                               2 * kSearchDecimation + 1) *
+      target_size / kSimdWidth;
+  const int64_t fft_search_cost = static_cast<int64_t>(
+      kFftFlopsPerPointAndStage * fft_size * std::log2(fft_size));
+  if (fft_search_cost < decimated_search_cost) {
+    return FftSearch(exclude_interval, target_block, search_block,
+                     energy_target_block.get(), energy_candidate_blocks.get(),
+                     fft_state);
+  }
+
   int optimal_index = DecimatedSearch(kSearchDecimation,
                                       exclude_interval, target_block,
                                       search_block, energy_target_block.get(),
@@ -7,8 +7,10 @@
 #ifndef MEDIA_FILTERS_WSOLA_INTERNALS_H_
 #define MEDIA_FILTERS_WSOLA_INTERNALS_H_
 
+#include <memory>
 #include <utility>
 
+#include "base/macros.h"
 #include "media/base/media_export.h"
 
 namespace media {
@@ -19,6 +21,34 @@ namespace internal {
 
 typedef std::pair<int, int> Interval;
 
+// Twiddle factors and scratch buffers of the FFT based correlations below, for
+// a single FFT size. Computing the twiddle factors costs about as much as a
+// transform, so callers searching repeatedly should create one per search
+// block size, see GetFftSize(), and reuse it.
+struct MEDIA_EXPORT FftCorrelationState {
+  explicit FftCorrelationState(int fft_size);
+  ~FftCorrelationState();
+
+  const int fft_size;
+
+  // Twiddle factors from GetFftTwiddleFactors(), |fft_size| / 2 values each.
+  std::unique_ptr<float[]> cos_table;
+  std::unique_ptr<float[]> sin_table;
+
+  // Scratch buffers of |fft_size| values each.
+  std::unique_ptr<float[]> real;
+  std::unique_ptr<float[]> imag;
+  std::unique_ptr<float[]> sum_real;
+  std::unique_ptr<float[]> sum_imag;
+
+  // Output of FftSearch()'s correlation, |fft_size| values, which is at least
+  // the number of candidate blocks of a search block of that FFT size.
+  std::unique_ptr<float[]> dot_product;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(FftCorrelationState);
+};
+
 // Dot-product of channels of two AudioBus. For each AudioBus an offset is
 // given. |dot_product[k]| is the dot-product of channel |k|. The caller should
 // allocate sufficient space for |dot_product|.
@@ -29,6 +59,26 @@ MEDIA_EXPORT void MultiChannelDotProduct(const AudioBus* a,
                                          int num_frames,
                                          float* dot_product);
 
+// Dot-products of |target_block| with every candidate block of |search_block|,
+// computed at once by FFT based cross-correlation. The results are interleaved
+// like the energies of MultiChannelMovingBlockEnergies(), hence, |dot_product|
+// must be, at least, of size
+// (|search_block->frames()| - (|target_block->frames()| - 1)) *
+// |target_block->channels()|. |fft_state| must have been created for
+// GetFftSize(|search_block->frames()|).
+MEDIA_EXPORT void MultiChannelCrossCorrelation(const AudioBus* target_block,
+                                               const AudioBus* search_block,
+                                               FftCorrelationState* fft_state,
+                                               float* dot_product);
+
+// Like MultiChannelCrossCorrelation(), but writes the sum over channels of the
+// dot-products of each candidate block, hence, |dot_product| must be, at
+// least, of size |search_block->frames()| - (|target_block->frames()| - 1).
+MEDIA_EXPORT void SummedCrossCorrelation(const AudioBus* target_block,
+                                         const AudioBus* search_block,
+                                         FftCorrelationState* fft_state,
+                                         float* dot_product);
+
 // Energies of sliding windows of channels are interleaved.
 // The number windows is |input->frames()| - (|frames_per_window| - 1), hence,
 // the method assumes |energy| must be, at least, of size
@@ -69,12 +119,48 @@ MEDIA_EXPORT int FullSearch(int low_limit,
                             const float* energy_target_block,
                             const float* energy_candidate_blocks);
 
+// Search all candidate blocks of |search_block| to find the block that is most
+// similar to |target_block|, using dot-products from
+// MultiChannelCrossCorrelation(). The result matches a FullSearch() over all
+// candidates, but the cost grows as N * log(N) rather than as the number of
+// candidates times the block size. |fft_state| is as for
+// MultiChannelCrossCorrelation().
+MEDIA_EXPORT int FftSearch(Interval exclude_interval,
+                           const AudioBus* target_block,
+                           const AudioBus* search_block,
+                           const float* energy_target_block,
+                           const float* energy_candidate_blocks,
+                           FftCorrelationState* fft_state);
+
 // Find the index of the block, within |search_block|, that is most similar
 // to |target_block|. Obviously, the returned index is w.r.t. |search_block|.
-// |exclude_interval| is an interval that is excluded from the search.
+// |exclude_interval| is an interval that is excluded from the search. Large
+// search windows are searched with FftSearch(), using |fft_state|, others with
+// a DecimatedSearch() refined by a FullSearch().
 MEDIA_EXPORT int OptimalIndex(const AudioBus* search_block,
                               const AudioBus* target_block,
-                              Interval exclude_interval);
+                              Interval exclude_interval,
+                              FftCorrelationState* fft_state);
+
+// In-place radix-2 FFT of the |fft_size| complex values held in |real| and
+// |imag|. |fft_size| must be a power of two and |cos_table| and |sin_table|
+// must come from GetFftTwiddleFactors(). The inverse transform is not scaled
+// by 1 / |fft_size|.
+MEDIA_EXPORT void Fft(int fft_size,
+                      bool inverse,
+                      const float* cos_table,
+                      const float* sin_table,
+                      float* real,
+                      float* imag);
+
+// Returns the smallest power of two that is at least |frames|.
+MEDIA_EXPORT int GetFftSize(int frames);
+
+// Fills |cos_table| and |sin_table|, each of size |fft_size| / 2, with the
+// twiddle factors used by Fft().
+MEDIA_EXPORT void GetFftTwiddleFactors(int fft_size,
+                                       float* cos_table,
+                                       float* sin_table);
 
 // Return a "periodic" Hann window. This is the first L samples of an L+1
 // Hann window. It is perfect reconstruction for overlap-and-add.
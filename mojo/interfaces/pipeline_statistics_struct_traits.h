@@ -31,6 +31,30 @@ struct StructTraits<media::mojom::PipelineStatisticsDataView,
   static int64_t video_memory_usage(const media::PipelineStatistics& input) {
     return input.video_memory_usage;
   }
+  static int64_t audio_time_stretch_us(
+      const media::PipelineStatistics& input) {
+    return input.audio_time_stretch_us;
+  }
+  static int32_t video_decode_ahead_depth(
+      const media::PipelineStatistics& input) {
+    return input.video_decode_ahead_depth;
+  }
+  static int32_t video_ready_frames_target(
+      const media::PipelineStatistics& input) {
+    return input.video_ready_frames_target;
+  }
+  static int64_t audio_latency_p50_us(const media::PipelineStatistics& input) {
+    return input.audio_latency_p50_us;
+  }
+  static int64_t audio_latency_p99_us(const media::PipelineStatistics& input) {
+    return input.audio_latency_p99_us;
+  }
+  static int64_t video_latency_p50_us(const media::PipelineStatistics& input) {
+    return input.video_latency_p50_us;
+  }
+  static int64_t video_latency_p99_us(const media::PipelineStatistics& input) {
+    return input.video_latency_p99_us;
+  }
 
   static bool Read(media::mojom::PipelineStatisticsDataView data,
                    media::PipelineStatistics* output) {
@@ -40,6 +64,13 @@ struct StructTraits<media::mojom::PipelineStatisticsDataView,
     output->video_frames_dropped = data.video_frames_dropped();
     output->audio_memory_usage = data.audio_memory_usage();
     output->video_memory_usage = data.video_memory_usage();
+    output->audio_time_stretch_us = data.audio_time_stretch_us();
+    output->video_decode_ahead_depth = data.video_decode_ahead_depth();
+    output->video_ready_frames_target = data.video_ready_frames_target();
+    output->audio_latency_p50_us = data.audio_latency_p50_us();
+    output->audio_latency_p99_us = data.audio_latency_p99_us();
+    output->video_latency_p50_us = data.video_latency_p50_us();
+    output->video_latency_p99_us = data.video_latency_p99_us();
     return true;
   }
 };
@@ -40,7 +40,9 @@ AudioRendererImpl::AudioRendererImpl(
     const scoped_refptr<MediaLog>& media_log)
     : task_runner_(task_runner),
       expecting_config_changes_(false),
+      time_stretch_quality_(AudioRendererAlgorithm::Quality::kNormal),
       sink_(sink),
+      latency_histograms_(new PipelineLatencyHistograms()),
       audio_buffer_stream_(
           new AudioBufferStream(task_runner, std::move(decoders), media_log)),
       media_log_(media_log),
@@ -63,6 +65,7 @@ AudioRendererImpl::AudioRendererImpl(
       &AudioRendererImpl::OnNewSpliceBuffer, weak_factory_.GetWeakPtr()));
   audio_buffer_stream_->set_config_change_observer(base::Bind(
       &AudioRendererImpl::OnConfigChange, weak_factory_.GetWeakPtr()));
+  audio_buffer_stream_->set_latency_histograms(latency_histograms_.get());
 
   // Tests may not have a power monitor.
   base::PowerMonitor* monitor = base::PowerMonitor::Get();
@@ -490,7 +493,8 @@ void AudioRendererImpl::OnAudioBufferStreamInitialized(bool success) {
   // We're all good! Continue initializing the rest of the audio renderer
   // based on the decoder format.
   algorithm_.reset(new AudioRendererAlgorithm());
-  algorithm_->Initialize(audio_parameters_);
+  algorithm_->Initialize(audio_parameters_, time_stretch_quality_);
+  last_time_stretch_duration_ = base::TimeDelta();
 
   ChangeState_Locked(kFlushed);
 
@@ -677,6 +681,14 @@ bool AudioRendererImpl::HandleSplicerBuffer_Locked(
   PipelineStatistics stats;
   stats.audio_memory_usage = memory_usage - last_audio_memory_usage_;
   last_audio_memory_usage_ = memory_usage;
+  const base::TimeDelta time_stretch_duration =
+      algorithm_->time_stretch_duration();
+  stats.audio_time_stretch_us =
+      (time_stretch_duration - last_time_stretch_duration_).InMicroseconds();
+  last_time_stretch_duration_ = time_stretch_duration;
+  latency_histograms_->GetTotalPercentileChanges(
+      tick_clock_->NowTicks(), &stats.audio_latency_p50_us,
+      &stats.audio_latency_p99_us);
   task_runner_->PostTask(FROM_HERE,
                          base::Bind(&AudioRendererImpl::OnStatisticsUpdate,
                                     weak_factory_.GetWeakPtr(), stats));
@@ -843,6 +855,13 @@ int AudioRendererImpl::Render(AudioBus* audio_bus,
             audio_bus, frames_written, frames_requested - frames_written,
             playback_rate_);
       }
+
+      // Audio decoded now plays out after everything still queued.
+      latency_histograms_->AddSample(
+          PipelineLatencyHistograms::READY_QUEUE,
+          base::TimeDelta::FromSecondsD(
+              algorithm_->frames_buffered() /
+              (playback_rate_ * audio_parameters_.sample_rate())));
     }
 
     // We use the following conditions to determine end of playback:
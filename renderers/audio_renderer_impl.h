@@ -33,6 +33,7 @@
 #include "media/base/audio_renderer_sink.h"
 #include "media/base/decryptor.h"
 #include "media/base/media_log.h"
+#include "media/base/pipeline_latency_histograms.h"
 #include "media/base/time_source.h"
 #include "media/filters/audio_renderer_algorithm.h"
 #include "media/filters/decoder_stream.h"
@@ -88,6 +89,20 @@ class MEDIA_EXPORT AudioRendererImpl
   void StartPlaying() override;
   void SetVolume(float volume) override;
 
+  // Selects the time stretching algorithm used at playback rates other than
+  // 1.0. Must be called before Initialize(); defaults to
+  // AudioRendererAlgorithm::Quality::kNormal.
+  void set_time_stretch_quality(AudioRendererAlgorithm::Quality quality) {
+    time_stretch_quality_ = quality;
+  }
+
+  // Per-stage latencies of the audio passing through this renderer.  The
+  // READY_QUEUE latency is sampled on every render callback as the duration of
+  // audio queued ahead of newly decoded buffers.
+  const scoped_refptr<PipelineLatencyHistograms>& latency_histograms() const {
+    return latency_histograms_;
+  }
+
   // base::PowerObserver implementation.
   void OnSuspend() override;
   void OnResume() override;
@@ -207,11 +222,17 @@ class MEDIA_EXPORT AudioRendererImpl
   // Whether or not we expect to handle config changes.
   bool expecting_config_changes_;
 
+  // Time stretching algorithm used by |algorithm_|.
+  AudioRendererAlgorithm::Quality time_stretch_quality_;
+
   // The sink (destination) for rendered audio. |sink_| must only be accessed
   // on |task_runner_|. |sink_| must never be called under |lock_| or else we
   // may deadlock between |task_runner_| and the audio callback thread.
   scoped_refptr<media::AudioRendererSink> sink_;
 
+  // Declared before |audio_buffer_stream_|, which records into it.
+  const scoped_refptr<PipelineLatencyHistograms> latency_histograms_;
+
   std::unique_ptr<AudioBufferStream> audio_buffer_stream_;
 
   scoped_refptr<MediaLog> media_log_;
@@ -234,6 +255,10 @@ class MEDIA_EXPORT AudioRendererImpl
   // HandleSplicerBuffer_Locked() call.
   int64_t last_audio_memory_usage_;
 
+  // Time stretching duration of |algorithm_| recorded during the last
+  // HandleSplicerBuffer_Locked() call.
+  base::TimeDelta last_time_stretch_duration_;
+
   // Sample rate of the last decoded audio buffer. Allows for detection of
   // sample rate changes due to implicit AAC configuration change.
   int last_decoded_sample_rate_;
@@ -4,14 +4,17 @@
 
 #include "media/renderers/default_renderer_factory.h"
 
+#include <string>
 #include <utility>
 
 #include "base/bind.h"
+#include "base/command_line.h"
 #include "base/memory/ptr_util.h"
 #include "base/single_thread_task_runner.h"
 #include "build/build_config.h"
 #include "media/base/decoder_factory.h"
 #include "media/base/media_log.h"
+#include "media/base/media_switches.h"
 #include "media/filters/gpu_video_decoder.h"
 #include "media/filters/opus_audio_decoder.h"
 #include "media/renderers/audio_renderer_impl.h"
@@ -32,13 +35,27 @@
 
 namespace media {
 
+// Returns the time stretching algorithm selected on the command line, or the
+// default one if none or an unknown one is given.
+static AudioRendererAlgorithm::Quality GetDefaultTimeStretchQuality() {
+  const std::string quality =
+      base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+          switches::kAudioTimeStretchQuality);
+  if (quality == "low")
+    return AudioRendererAlgorithm::Quality::kLow;
+  if (quality == "high")
+    return AudioRendererAlgorithm::Quality::kHigh;
+  return AudioRendererAlgorithm::Quality::kNormal;
+}
+
 DefaultRendererFactory::DefaultRendererFactory(
     const scoped_refptr<MediaLog>& media_log,
     DecoderFactory* decoder_factory,
     const GetGpuFactoriesCB& get_gpu_factories_cb)
     : media_log_(media_log),
       decoder_factory_(decoder_factory),
-      get_gpu_factories_cb_(get_gpu_factories_cb) {}
+      get_gpu_factories_cb_(get_gpu_factories_cb),
+      time_stretch_quality_(GetDefaultTimeStretchQuality()) {}
 
 DefaultRendererFactory::~DefaultRendererFactory() {
 }
@@ -105,9 +122,10 @@ std::unique_ptr<Renderer> DefaultRendererFactory::CreateRenderer(
     const RequestSurfaceCB& request_surface_cb) {
   DCHECK(audio_renderer_sink);
 
-  std::unique_ptr<AudioRenderer> audio_renderer(new AudioRendererImpl(
+  std::unique_ptr<AudioRendererImpl> audio_renderer(new AudioRendererImpl(
       media_task_runner, audio_renderer_sink,
       CreateAudioDecoders(media_task_runner), media_log_));
+  audio_renderer->set_time_stretch_quality(time_stretch_quality_);
 
   GpuVideoAcceleratorFactories* gpu_factories = nullptr;
   if (!get_gpu_factories_cb_.is_null())
@@ -12,6 +12,7 @@
 #include "base/memory/scoped_vector.h"
 #include "media/base/media_export.h"
 #include "media/base/renderer_factory.h"
+#include "media/filters/audio_renderer_algorithm.h"
 
 namespace media {
 
@@ -33,6 +34,13 @@ class MEDIA_EXPORT DefaultRendererFactory : public RendererFactory {
                          const GetGpuFactoriesCB& get_gpu_factories_cb);
   ~DefaultRendererFactory() final;
 
+  // Selects the time stretching algorithm of the audio renderers created by
+  // CreateRenderer() from now on.  Defaults to the one given on the command
+  // line, if any, else AudioRendererAlgorithm::Quality::kNormal.
+  void set_time_stretch_quality(AudioRendererAlgorithm::Quality quality) {
+    time_stretch_quality_ = quality;
+  }
+
   std::unique_ptr<Renderer> CreateRenderer(
       const scoped_refptr<base::SingleThreadTaskRunner>& media_task_runner,
       const scoped_refptr<base::TaskRunner>& worker_task_runner,
@@ -57,6 +65,8 @@ class MEDIA_EXPORT DefaultRendererFactory : public RendererFactory {
   // Creates factories for supporting video accelerators. May be null.
   GetGpuFactoriesCB get_gpu_factories_cb_;
 
+  AudioRendererAlgorithm::Quality time_stretch_quality_;
+
   DISALLOW_COPY_AND_ASSIGN(DefaultRendererFactory);
 };
 
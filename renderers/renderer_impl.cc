@@ -11,6 +11,7 @@
 #include "base/callback_helpers.h"
 #include "base/command_line.h"
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/string_number_conversions.h"
@@ -89,6 +90,9 @@ RendererImpl::RendererImpl(
       cdm_context_(nullptr),
       underflow_disabled_for_testing_(false),
       clockless_video_playback_enabled_for_testing_(false),
+      concurrent_initialization_(
+          base::FeatureList::IsEnabled(kFastStartPipeline)),
+      pending_renderer_initializations_(0),
       video_underflow_threshold_(
           base::TimeDelta::FromMilliseconds(kDefaultVideoUnderflowThresholdMs)),
       weak_factory_(this) {
@@ -155,7 +159,7 @@ void RendererImpl::Initialize(DemuxerStreamProvider* demuxer_stream_provider,
   }
 
   state_ = STATE_INITIALIZING;
-  InitializeAudioRenderer();
+  InitializeRenderers();
 }
 
 void RendererImpl::SetCdm(CdmContext* cdm_context,
@@ -182,7 +186,7 @@ void RendererImpl::SetCdm(CdmContext* cdm_context,
   // |cdm_attached_cb| will be fired after initialization finishes.
   pending_cdm_attached_cb_ = cdm_attached_cb;
 
-  InitializeAudioRenderer();
+  InitializeRenderers();
 }
 
 void RendererImpl::Flush(const base::Closure& flush_cb) {
@@ -385,6 +389,28 @@ void RendererImpl::FinishInitialization(PipelineStatus status) {
   base::ResetAndReturn(&init_cb_).Run(status);
 }
 
+void RendererImpl::InitializeRenderers() {
+  DVLOG(1) << __func__;
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK_EQ(state_, STATE_INITIALIZING);
+
+  // The video renderer is initialized once the audio renderer is done; see
+  // OnAudioRendererInitializeDone().
+  if (!concurrent_initialization_) {
+    InitializeAudioRenderer();
+    return;
+  }
+
+  // Decoder selection and initialization of the two streams don't depend on
+  // each other, so overlap them and finish once both are done.
+  pending_renderer_initializations_ = 2;
+  InitializeAudioRenderer();
+
+  // Initializing audio may have failed synchronously.
+  if (state_ == STATE_INITIALIZING)
+    InitializeVideoRenderer();
+}
+
 void RendererImpl::InitializeAudioRenderer() {
   DVLOG(1) << __func__;
   DCHECK(task_runner_->BelongsToCurrentThread());
@@ -422,11 +448,17 @@ void RendererImpl::OnAudioRendererInitializeDone(PipelineStatus status) {
   }
 
   if (status != PIPELINE_OK) {
-    FinishInitialization(status);
+    OnRendererInitializeFailed(status);
     return;
   }
 
   DCHECK(!init_cb_.is_null());
+  if (concurrent_initialization_) {
+    if (--pending_renderer_initializations_ == 0)
+      CompleteInitialization();
+    return;
+  }
+
   InitializeVideoRenderer();
 }
 
@@ -470,10 +502,32 @@ void RendererImpl::OnVideoRendererInitializeDone(PipelineStatus status) {
   DCHECK(!init_cb_.is_null());
 
   if (status != PIPELINE_OK) {
-    FinishInitialization(status);
+    OnRendererInitializeFailed(status);
     return;
   }
 
+  if (concurrent_initialization_ && --pending_renderer_initializations_ > 0)
+    return;
+
+  CompleteInitialization();
+}
+
+void RendererImpl::OnRendererInitializeFailed(PipelineStatus status) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK_NE(status, PIPELINE_OK);
+
+  // When initializing concurrently the other renderer may still be busy;
+  // leaving STATE_INITIALIZING makes its completion a no-op.
+  if (concurrent_initialization_)
+    state_ = STATE_ERROR;
+
+  FinishInitialization(status);
+}
+
+void RendererImpl::CompleteInitialization() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK_EQ(state_, STATE_INITIALIZING);
+
   if (audio_renderer_) {
     time_source_ = audio_renderer_->GetTimeSource();
   } else if (!time_source_) {
@@ -66,6 +66,13 @@ class MEDIA_EXPORT RendererImpl : public Renderer {
                              bool enabled,
                              base::TimeDelta time);
 
+  // Initialize the audio and video renderers at the same time rather than one
+  // after the other.  Defaults to whether kFastStartPipeline is enabled.  Must
+  // be called before Initialize().
+  void set_concurrent_initialization(bool enabled) {
+    concurrent_initialization_ = enabled;
+  }
+
   // Helper functions for testing purposes. Must be called before Initialize().
   void DisableUnderflowForTesting();
   void EnableClocklessVideoPlaybackForTesting();
@@ -96,10 +103,13 @@ class MEDIA_EXPORT RendererImpl : public Renderer {
   void FinishInitialization(PipelineStatus status);
 
   // Helper functions and callbacks for Initialize().
+  void InitializeRenderers();
   void InitializeAudioRenderer();
   void OnAudioRendererInitializeDone(PipelineStatus status);
   void InitializeVideoRenderer();
   void OnVideoRendererInitializeDone(PipelineStatus status);
+  void OnRendererInitializeFailed(PipelineStatus status);
+  void CompleteInitialization();
 
   // Helper functions and callbacks for Flush().
   void FlushAudioRenderer();
@@ -187,6 +197,11 @@ class MEDIA_EXPORT RendererImpl : public Renderer {
   bool underflow_disabled_for_testing_;
   bool clockless_video_playback_enabled_for_testing_;
 
+  // See set_concurrent_initialization().  While initializing concurrently,
+  // the number of renderers which haven't finished initializing yet.
+  bool concurrent_initialization_;
+  int pending_renderer_initializations_;
+
   // Used to defer underflow for video when audio is present.
   base::CancelableClosure deferred_video_underflow_cb_;
 
@@ -366,6 +366,50 @@ TEST_F(RendererImplTest, InitializeWithAudioVideo_VideoRendererFailed) {
   InitializeAndExpect(PIPELINE_ERROR_INITIALIZATION_FAILED);
 }
 
+TEST_F(RendererImplTest, ConcurrentInitializeWithAudioVideo) {
+  CreateAudioAndVideoStream();
+  renderer_impl_->set_concurrent_initialization(true);
+
+  // The video renderer is initialized while audio initialization is pending.
+  PipelineStatusCB audio_init_cb;
+  EXPECT_CALL(*audio_renderer_, Initialize(audio_stream_.get(), _, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&audio_renderer_client_),
+                      SaveArg<3>(&audio_init_cb)));
+  SetVideoRendererInitializeExpectations(PIPELINE_OK);
+  EXPECT_CALL(*audio_renderer_, GetTimeSource())
+      .WillOnce(Return(&time_source_));
+  renderer_impl_->Initialize(demuxer_.get(), &callbacks_,
+                             base::Bind(&CallbackHelper::OnInitialize,
+                                        base::Unretained(&callbacks_)));
+  base::RunLoop().RunUntilIdle();
+
+  // Initialization completes once both are done.
+  EXPECT_CALL(callbacks_, OnInitialize(PIPELINE_OK));
+  audio_init_cb.Run(PIPELINE_OK);
+  base::RunLoop().RunUntilIdle();
+}
+
+TEST_F(RendererImplTest,
+       ConcurrentInitializeWithAudioVideo_VideoRendererFailed) {
+  CreateAudioAndVideoStream();
+  renderer_impl_->set_concurrent_initialization(true);
+
+  PipelineStatusCB audio_init_cb;
+  EXPECT_CALL(*audio_renderer_, Initialize(audio_stream_.get(), _, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&audio_renderer_client_),
+                      SaveArg<3>(&audio_init_cb)));
+  SetVideoRendererInitializeExpectations(PIPELINE_ERROR_INITIALIZATION_FAILED);
+  EXPECT_CALL(callbacks_, OnInitialize(PIPELINE_ERROR_INITIALIZATION_FAILED));
+  renderer_impl_->Initialize(demuxer_.get(), &callbacks_,
+                             base::Bind(&CallbackHelper::OnInitialize,
+                                        base::Unretained(&callbacks_)));
+  base::RunLoop().RunUntilIdle();
+
+  // The audio renderer finishing afterwards is ignored.
+  audio_init_cb.Run(PIPELINE_OK);
+  base::RunLoop().RunUntilIdle();
+}
+
 TEST_F(RendererImplTest, SetCdmBeforeInitialize) {
   // CDM will be successfully attached immediately if set before RendererImpl
   // initialization, regardless of the later initialization result.
@@ -39,6 +39,8 @@ VideoRendererImpl::VideoRendererImpl(
       sink_(sink),
       sink_started_(false),
       client_(nullptr),
+      latency_histograms_(new PipelineLatencyHistograms()),
+      decode_ahead_controller_(limits::kMaxVideoFrames),
       video_frame_stream_(new VideoFrameStream(media_task_runner,
                                                std::move(decoders),
                                                media_log)),
@@ -57,11 +59,16 @@ VideoRendererImpl::VideoRendererImpl(
       was_background_rendering_(false),
       time_progressing_(false),
       last_video_memory_usage_(0),
+      last_decode_ahead_depth_(0),
+      last_ready_frames_target_(0),
       have_renderered_frames_(false),
       last_frame_opaque_(false),
       painted_first_frame_(false),
       weak_factory_(this),
       frame_callback_weak_factory_(this) {
+  video_frame_stream_->set_decode_ahead_controller(&decode_ahead_controller_);
+  video_frame_stream_->set_latency_histograms(latency_histograms_.get());
+
   if (gpu_factories &&
       gpu_factories->ShouldUseGpuMemoryBuffersForVideoFrames()) {
     gpu_memory_buffer_pool_.reset(new GpuMemoryBufferVideoFramePool(
@@ -115,6 +122,7 @@ void VideoRendererImpl::Flush(const base::Closure& callback) {
   // will get a bunch of ReusePictureBuffer() calls before the Reset(), which
   // they may use to output more frames that won't be used.
   algorithm_->Reset();
+  ready_frame_times_.clear();
   painted_first_frame_ = false;
 }
 
@@ -129,6 +137,7 @@ void VideoRendererImpl::StartPlayingFrom(base::TimeDelta timestamp) {
   state_ = kPlaying;
   start_timestamp_ = timestamp;
   painted_first_frame_ = false;
+  video_frame_stream_->SetPrerollTarget(timestamp);
   AttemptRead_Locked();
 }
 
@@ -179,13 +188,33 @@ scoped_refptr<VideoFrame> VideoRendererImpl::Render(
   DCHECK_EQ(state_, kPlaying);
 
   size_t frames_dropped = 0;
+  const size_t frames_queued = algorithm_->frames_queued();
   scoped_refptr<VideoFrame> result =
       algorithm_->Render(deadline_min, deadline_max, &frames_dropped);
 
+  // Frames rendered or dropped leave the queue; measure how fast that happens
+  // while the output is visible.
+  if (!background_rendering) {
+    decode_ahead_controller_.AddConsumedFrames(
+        frames_queued - algorithm_->frames_queued(), deadline_min);
+  }
+
   // Due to how the |algorithm_| holds frames, this should never be null if
   // we've had a proper startup sequence.
   DCHECK(result);
 
+  // Measure how long the frame to be displayed was queued, unless it has been
+  // displayed before. Frames up to it were either rendered or dropped, in
+  // whatever order they were decoded, so forget about them.
+  const auto rendered_it = ready_frame_times_.find(result->timestamp());
+  if (rendered_it != ready_frame_times_.end() && !background_rendering) {
+    latency_histograms_->AddSample(
+        PipelineLatencyHistograms::READY_QUEUE,
+        tick_clock_->NowTicks() - rendered_it->second);
+  }
+  ready_frame_times_.erase(ready_frame_times_.begin(),
+                           ready_frame_times_.upper_bound(result->timestamp()));
+
   // Declare HAVE_NOTHING if we reach a state where we can't progress playback
   // any further.  We don't want to do this if we've already done so, reached
   // end of stream, or have frames available.  We also don't want to do this in
@@ -344,6 +373,19 @@ void VideoRendererImpl::FrameReadyForCopyingToGpuMemoryBuffers(
   }
 
   DCHECK(frame);
+
+  // Frames which the current cadence will never display aren't worth copying;
+  // the software frame is still enqueued so drop accounting stays correct.
+  bool planned_for_drop = false;
+  {
+    base::AutoLock auto_lock(lock_);
+    planned_for_drop = algorithm_->IsFramePlannedForDrop(frame->timestamp());
+  }
+  if (planned_for_drop) {
+    VideoRendererImpl::FrameReady(status, frame);
+    return;
+  }
+
   gpu_memory_buffer_pool_->MaybeCreateHardwareFrame(
       frame, base::Bind(&VideoRendererImpl::FrameReady,
                         frame_callback_weak_factory_.GetWeakPtr(), status));
@@ -387,8 +429,10 @@ void VideoRendererImpl::FrameReady(VideoFrameStream::Status status,
     // If the sink hasn't been started, we still have time to release less
     // than ideal frames prior to startup.  We don't use IsBeforeStartTime()
     // here since it's based on a duration estimate and we can be exact here.
-    if (!sink_started_ && frame->timestamp() <= start_timestamp_)
+    if (!sink_started_ && frame->timestamp() <= start_timestamp_) {
       algorithm_->Reset();
+      ready_frame_times_.clear();
+    }
 
     AddReadyFrame_Locked(frame);
   }
@@ -429,6 +473,8 @@ void VideoRendererImpl::FrameReady(VideoFrameStream::Status status,
   if (buffering_state_ == BUFFERING_HAVE_NOTHING && HaveEnoughData_Locked())
     TransitionToHaveEnough_Locked();
 
+  UpdateDecodeAheadStats_Locked();
+
   // Always request more decoded video if we have capacity.
   AttemptRead_Locked();
 }
@@ -494,6 +540,7 @@ void VideoRendererImpl::AddReadyFrame_Locked(
 
   frames_decoded_++;
 
+  ready_frame_times_[frame->timestamp()] = tick_clock_->NowTicks();
   algorithm_->EnqueueFrame(frame);
 }
 
@@ -555,6 +602,10 @@ void VideoRendererImpl::UpdateStats_Locked() {
     const size_t memory_usage = algorithm_->GetMemoryUsage();
     statistics.video_memory_usage = memory_usage - last_video_memory_usage_;
 
+    latency_histograms_->GetTotalPercentileChanges(
+        tick_clock_->NowTicks(), &statistics.video_latency_p50_us,
+        &statistics.video_latency_p99_us);
+
     task_runner_->PostTask(FROM_HERE,
                            base::Bind(&VideoRendererImpl::OnStatisticsUpdate,
                                       weak_factory_.GetWeakPtr(), statistics));
@@ -564,15 +615,46 @@ void VideoRendererImpl::UpdateStats_Locked() {
   }
 }
 
+void VideoRendererImpl::UpdateDecodeAheadStats_Locked() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  lock_.AssertAcquired();
+
+  const int decode_ahead_depth = video_frame_stream_->GetDecodeAheadDepth();
+  const size_t ready_frames_target =
+      decode_ahead_controller_.GetReadyFramesTarget();
+  if (decode_ahead_depth == last_decode_ahead_depth_ &&
+      ready_frames_target == last_ready_frames_target_) {
+    return;
+  }
+
+  media_log_->RecordDoubleProperty("video_decode_ahead_depth",
+                                   decode_ahead_depth);
+  media_log_->RecordDoubleProperty("video_ready_frames_target",
+                                   ready_frames_target);
+
+  PipelineStatistics statistics;
+  statistics.video_decode_ahead_depth =
+      decode_ahead_depth - last_decode_ahead_depth_;
+  statistics.video_ready_frames_target =
+      static_cast<int32_t>(ready_frames_target) -
+      static_cast<int32_t>(last_ready_frames_target_);
+  task_runner_->PostTask(FROM_HERE,
+                         base::Bind(&VideoRendererImpl::OnStatisticsUpdate,
+                                    weak_factory_.GetWeakPtr(), statistics));
+  last_decode_ahead_depth_ = decode_ahead_depth;
+  last_ready_frames_target_ = ready_frames_target;
+}
+
 bool VideoRendererImpl::HaveReachedBufferingCap() {
   DCHECK(task_runner_->BelongsToCurrentThread());
-  const size_t kMaxVideoFrames = limits::kMaxVideoFrames;
+  const size_t max_video_frames =
+      decode_ahead_controller_.GetReadyFramesTarget();
 
   // When the display rate is less than the frame rate, the effective frames
   // queued may be much smaller than the actual number of frames queued.  Here
   // we ensure that frames_queued() doesn't get excessive.
-  return algorithm_->effective_frames_queued() >= kMaxVideoFrames ||
-         algorithm_->frames_queued() >= 3 * kMaxVideoFrames;
+  return algorithm_->effective_frames_queued() >= max_video_frames ||
+         algorithm_->frames_queued() >= 3 * max_video_frames;
 }
 
 void VideoRendererImpl::StartSink() {
@@ -586,6 +668,7 @@ void VideoRendererImpl::StartSink() {
 void VideoRendererImpl::StopSink() {
   DCHECK(task_runner_->BelongsToCurrentThread());
   sink_->Stop();
+  decode_ahead_controller_.OnConsumptionStopped();
   algorithm_->set_time_stopped();
   sink_started_ = false;
   was_background_rendering_ = false;
@@ -678,6 +761,7 @@ void VideoRendererImpl::RemoveFramesForUnderflowOrBackgroundRendering() {
     frames_dropped_ += algorithm_->frames_queued();
     algorithm_->Reset(
         VideoRendererAlgorithm::ResetFlag::kPreserveNextFrameEstimates);
+    ready_frame_times_.clear();
     painted_first_frame_ = false;
 
     // It's possible in the background rendering case for us to expire enough
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <deque>
+#include <map>
 #include <memory>
 
 #include "base/macros.h"
@@ -21,11 +22,13 @@
 #include "media/base/decryptor.h"
 #include "media/base/demuxer_stream.h"
 #include "media/base/media_log.h"
+#include "media/base/pipeline_latency_histograms.h"
 #include "media/base/pipeline_status.h"
 #include "media/base/video_decoder.h"
 #include "media/base/video_frame.h"
 #include "media/base/video_renderer.h"
 #include "media/base/video_renderer_sink.h"
+#include "media/filters/decode_ahead_controller.h"
 #include "media/filters/decoder_stream.h"
 #include "media/filters/video_renderer_algorithm.h"
 #include "media/renderers/gpu_video_accelerator_factories.h"
@@ -80,6 +83,11 @@ class MEDIA_EXPORT VideoRendererImpl
     return algorithm_->frames_queued();
   }
 
+  // Per-stage latencies of the frames passing through this renderer.
+  const scoped_refptr<PipelineLatencyHistograms>& latency_histograms() const {
+    return latency_histograms_;
+  }
+
   // VideoRendererSink::RenderCallback implementation.
   scoped_refptr<VideoFrame> Render(base::TimeTicks deadline_min,
                                    base::TimeTicks deadline_max,
@@ -131,6 +139,10 @@ class MEDIA_EXPORT VideoRendererImpl
   // them to 0.
   void UpdateStats_Locked();
 
+  // Reports changes of the limits chosen by |decode_ahead_controller_| to
+  // |media_log_| and |statistics_cb_|.
+  void UpdateDecodeAheadStats_Locked();
+
   // Returns true if there is no more room for additional buffered frames.
   bool HaveReachedBufferingCap();
 
@@ -198,6 +210,14 @@ class MEDIA_EXPORT VideoRendererImpl
 
   RendererClient* client_;
 
+  // Declared before |video_frame_stream_|, which records into it.
+  const scoped_refptr<PipelineLatencyHistograms> latency_histograms_;
+
+  // Adapts how far ahead of rendering |video_frame_stream_| decodes and how
+  // many frames are kept queued.  Declared before |video_frame_stream_| since
+  // it must outlive it.
+  DecodeAheadController decode_ahead_controller_;
+
   // Provides video frames to VideoRendererImpl.
   std::unique_ptr<VideoFrameStream> video_frame_stream_;
 
@@ -279,6 +299,16 @@ class MEDIA_EXPORT VideoRendererImpl
   // call.
   int64_t last_video_memory_usage_;
 
+  // Limits of |decode_ahead_controller_| recorded during the last
+  // UpdateDecodeAheadStats_Locked() call.
+  int last_decode_ahead_depth_;
+  size_t last_ready_frames_target_;
+
+  // When each frame handed to |algorithm_| was, keyed by its timestamp, for
+  // measuring the READY_QUEUE latency of those which are rendered. Entries
+  // leave once a frame at or after their timestamp is rendered.
+  std::map<base::TimeDelta, base::TimeTicks> ready_frame_times_;
+
   // Indicates if a frame has been processed by CheckForMetadataChanges().
   bool have_renderered_frames_;
 
@@ -956,6 +956,64 @@ TEST_F(VideoRendererImplTest, UnderflowEvictionWhileHaveEnough) {
   Destroy();
 }
 
+// Tests that the ready queue latency is measured once for each frame which is
+// displayed, even if frames are decoded out of order or dropped.
+TEST_F(VideoRendererImplTest, ReadyQueueLatencyWithReorderedAndDroppedFrames) {
+  Initialize();
+  QueueFrames("0 60 30 90");
+
+  {
+    SCOPED_TRACE("Waiting for BUFFERING_HAVE_ENOUGH");
+    WaitableMessageLoopEvent event;
+    EXPECT_CALL(mock_cb_, FrameReceived(HasTimestampMatcher(0)));
+    EXPECT_CALL(mock_cb_, OnBufferingStateChange(BUFFERING_HAVE_ENOUGH))
+        .WillOnce(RunClosure(event.GetClosure()));
+    EXPECT_CALL(mock_cb_, OnStatisticsUpdate(_)).Times(AnyNumber());
+    EXPECT_CALL(mock_cb_, OnVideoNaturalSizeChange(_)).Times(1);
+    EXPECT_CALL(mock_cb_, OnVideoOpacityChange(_)).Times(1);
+    StartPlayingFrom(0);
+    event.RunAndWait();
+    Mock::VerifyAndClearExpectations(&mock_cb_);
+  }
+
+  const LatencyHistogram& ready_queue_latency =
+      renderer_->latency_histograms()->histogram(
+          PipelineLatencyHistograms::READY_QUEUE);
+  EXPECT_EQ(0, ready_queue_latency.GetCount());
+
+  renderer_->OnTimeProgressing();
+  time_source_.StartTicking();
+
+  // Frame 30 was decoded after frame 60, but is displayed first.
+  {
+    SCOPED_TRACE("Waiting for frame 30");
+    WaitableMessageLoopEvent event;
+    EXPECT_CALL(mock_cb_, FrameReceived(HasTimestampMatcher(30)))
+        .WillOnce(RunClosure(event.GetClosure()));
+    EXPECT_CALL(mock_cb_, OnStatisticsUpdate(_)).Times(AnyNumber());
+    AdvanceTimeInMs(31);
+    event.RunAndWait();
+    Mock::VerifyAndClearExpectations(&mock_cb_);
+  }
+  EXPECT_EQ(1, ready_queue_latency.GetCount());
+
+  // Frame 60 is dropped in favor of frame 90.
+  {
+    SCOPED_TRACE("Waiting for frame 90");
+    WaitableMessageLoopEvent event;
+    EXPECT_CALL(mock_cb_, FrameReceived(HasTimestampMatcher(60))).Times(0);
+    EXPECT_CALL(mock_cb_, FrameReceived(HasTimestampMatcher(90)))
+        .WillOnce(RunClosure(event.GetClosure()));
+    EXPECT_CALL(mock_cb_, OnStatisticsUpdate(_)).Times(AnyNumber());
+    AdvanceTimeInMs(60);
+    event.RunAndWait();
+    Mock::VerifyAndClearExpectations(&mock_cb_);
+  }
+  EXPECT_EQ(2, ready_queue_latency.GetCount());
+
+  Destroy();
+}
+
 TEST_F(VideoRendererImplTest, StartPlayingFromThenFlushThenEOS) {
   Initialize();
   QueueFrames("0 30 60 90");
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/macros.h"
+#include "media/base/pipeline_latency_histograms.h"
 #include "media/base/test_data_util.h"
 #include "media/test/pipeline_integration_test_base.h"
 #include "testing/perf/perf_test.h"
@@ -10,6 +12,29 @@ namespace media {
 
 static const int kBenchmarkIterationsAudio = 200;
 static const int kBenchmarkIterationsVideo = 20;
+static const int kBenchmarkIterationsStartup = 50;
+static const int kBenchmarkIterationsSeek = 20;
+
+// Reports the 50th and 99th percentile latency of each pipeline stage.
+static void PrintLatencyResults(const std::string& name,
+                                const std::string& filename,
+                                const PipelineLatencyHistograms& histograms) {
+  for (int i = 0; i <= PipelineLatencyHistograms::STAGE_MAX; ++i) {
+    const auto stage = static_cast<PipelineLatencyHistograms::Stage>(i);
+    const LatencyHistogram& histogram = histograms.histogram(stage);
+    if (!histogram.GetCount())
+      continue;
+
+    const std::string trace =
+        std::string(PipelineLatencyHistograms::GetStageName(stage)) + "_";
+    perf_test::PrintResult(name, filename, trace + "p50",
+                           histogram.GetPercentile(50).InMillisecondsF(), "ms",
+                           false);
+    perf_test::PrintResult(name, filename, trace + "p99",
+                           histogram.GetPercentile(99).InMillisecondsF(), "ms",
+                           false);
+  }
+}
 
 static void RunPlaybackBenchmark(const std::string& filename,
                                  const std::string& name,
@@ -32,6 +57,12 @@ static void RunPlaybackBenchmark(const std::string& filename,
     // Call Stop() to ensure that the rendering is complete.
     pipeline.Stop();
 
+    if (i == iterations - 1) {
+      PrintLatencyResults(name + "_latency", filename,
+                          audio_only ? *pipeline.GetAudioLatencyHistograms()
+                                     : *pipeline.GetVideoLatencyHistograms());
+    }
+
     if (audio_only) {
       time_seconds += pipeline.GetAudioTime().InSecondsF();
     } else {
@@ -57,6 +88,67 @@ static void RunAudioPlaybackBenchmark(const std::string& filename,
   RunPlaybackBenchmark(filename, name, kBenchmarkIterationsAudio, true);
 }
 
+// Reports the mean time from Start() until the first video frame is painted,
+// with and without fast start.
+static void RunStartupBenchmark(const std::string& filename,
+                                const std::string& name) {
+  for (bool fast_start : {false, true}) {
+    const uint8_t test_type =
+        PipelineIntegrationTestBase::kClockless |
+        (fast_start ? PipelineIntegrationTestBase::kFastStart : 0);
+    base::TimeDelta total;
+    for (int i = 0; i < kBenchmarkIterationsStartup; ++i) {
+      PipelineIntegrationTestBase pipeline;
+      ASSERT_EQ(PIPELINE_OK, pipeline.Start(filename, test_type));
+
+      // The first frame may still be decoding when Start() completes.
+      pipeline.Play();
+      ASSERT_TRUE(pipeline.WaitUntilCurrentTimeIsAfter(
+          base::TimeDelta::FromMilliseconds(100)));
+      ASSERT_NE(base::TimeDelta(), pipeline.GetTimeToFirstFrame());
+      total += pipeline.GetTimeToFirstFrame();
+      pipeline.Stop();
+    }
+
+    perf_test::PrintResult(
+        name, fast_start ? "_fast_start" : "", filename,
+        total.InMillisecondsF() / kBenchmarkIterationsStartup, "ms", true);
+  }
+}
+
+// Reports the mean time for a Seek() to preroll enough to display the frame at
+// the seek time.  The seek times are far from keyframes in |filename|, so most
+// of this is decoding frames which are never shown.
+static void RunSeekBenchmark(const std::string& filename,
+                             const std::string& name) {
+  const base::TimeDelta kSeekTimes[] = {
+      base::TimeDelta::FromMilliseconds(2500),
+      base::TimeDelta::FromMilliseconds(1500),
+      base::TimeDelta::FromMilliseconds(2000),
+      base::TimeDelta::FromMilliseconds(1000),
+  };
+
+  PipelineIntegrationTestBase pipeline;
+  ASSERT_EQ(PIPELINE_OK, pipeline.Start(filename,
+                                        PipelineIntegrationTestBase::kClockless));
+
+  base::TimeDelta total;
+  for (int i = 0; i < kBenchmarkIterationsSeek; ++i) {
+    for (const base::TimeDelta& seek_time : kSeekTimes) {
+      const base::TimeTicks start = base::TimeTicks::Now();
+      ASSERT_TRUE(pipeline.Seek(seek_time));
+      total += base::TimeTicks::Now() - start;
+    }
+  }
+  pipeline.Stop();
+
+  perf_test::PrintResult(
+      name, "", filename,
+      total.InMillisecondsF() /
+          (kBenchmarkIterationsSeek * arraysize(kSeekTimes)),
+      "ms", true);
+}
+
 TEST(PipelineIntegrationPerfTest, AudioPlaybackBenchmark) {
   RunAudioPlaybackBenchmark("sfx_f32le.wav", "clockless_playback");
   RunAudioPlaybackBenchmark("sfx_s24le.wav", "clockless_playback");
@@ -75,6 +167,16 @@ TEST(PipelineIntegrationPerfTest, VP9PlaybackBenchmark) {
   RunVideoPlaybackBenchmark("bear-vp9.webm", "clockless_video_playback_vp9");
 }
 
+TEST(PipelineIntegrationPerfTest, StartupBenchmark) {
+  RunStartupBenchmark("bear-320x240.webm", "time_to_first_frame");
+  RunStartupBenchmark("bear-vp9.webm", "time_to_first_frame");
+}
+
+TEST(PipelineIntegrationPerfTest, SeekBenchmark) {
+  RunSeekBenchmark("bear-320x240.webm", "seek_to_display");
+  RunSeekBenchmark("bear-vp9.webm", "seek_to_display");
+}
+
 // Android doesn't build Theora support.
 #if !defined(OS_ANDROID)
 TEST(PipelineIntegrationPerfTest, TheoraPlaybackBenchmark) {
@@ -46,6 +46,7 @@ const char kNullAudioHash[] = "0.00,0.00,0.00,0.00,0.00,0.00,";
 PipelineIntegrationTestBase::PipelineIntegrationTestBase()
     : hashing_enabled_(false),
       clockless_playback_(false),
+      fast_start_(false),
       pipeline_(new PipelineImpl(message_loop_.task_runner(), new MediaLog())),
       ended_(false),
       pipeline_status_(PIPELINE_OK),
@@ -135,6 +136,7 @@ PipelineStatus PipelineIntegrationTestBase::StartInternal(
     ScopedVector<AudioDecoder> prepend_audio_decoders) {
   hashing_enabled_ = test_type & kHashed;
   clockless_playback_ = test_type & kClockless;
+  fast_start_ = test_type & kFastStart;
 
   EXPECT_CALL(*this, OnMetadata(_))
       .Times(AtMost(1))
@@ -159,6 +161,8 @@ PipelineStatus PipelineIntegrationTestBase::StartInternal(
   // media files are provided in advance.
   EXPECT_CALL(*this, OnWaitingForDecryptionKey()).Times(0);
 
+  start_time_ = base::TimeTicks::Now();
+  first_frame_time_ = base::TimeTicks();
   pipeline_->Start(
       demuxer_.get(), CreateRenderer(std::move(prepend_video_decoders),
                                      std::move(prepend_audio_decoders)),
@@ -294,13 +298,16 @@ void PipelineIntegrationTestBase::CreateDemuxer(
   data_source_ = std::move(data_source);
 
 #if !defined(MEDIA_DISABLE_FFMPEG)
-  demuxer_ = std::unique_ptr<Demuxer>(new FFmpegDemuxer(
+  std::unique_ptr<FFmpegDemuxer> demuxer(new FFmpegDemuxer(
       message_loop_.task_runner(), data_source_.get(),
       base::Bind(&PipelineIntegrationTestBase::DemuxerEncryptedMediaInitDataCB,
                  base::Unretained(this)),
       base::Bind(&PipelineIntegrationTestBase::DemuxerMediaTracksUpdatedCB,
                  base::Unretained(this)),
       new MediaLog()));
+  if (fast_start_)
+    demuxer->set_prefetch_on_initialize(true);
+  demuxer_ = std::move(demuxer);
 #endif
 }
 
@@ -325,10 +332,11 @@ std::unique_ptr<Renderer> PipelineIntegrationTestBase::CreateRenderer(
       message_loop_.task_runner()));
 
   // Disable frame dropping if hashing is enabled.
-  std::unique_ptr<VideoRenderer> video_renderer(new VideoRendererImpl(
+  std::unique_ptr<VideoRendererImpl> video_renderer(new VideoRendererImpl(
       message_loop_.task_runner(), message_loop_.task_runner().get(),
       video_sink_.get(), std::move(video_decoders), false, nullptr,
       new MediaLog()));
+  video_latency_histograms_ = video_renderer->latency_histograms();
 
   ScopedVector<AudioDecoder> audio_decoders = std::move(prepend_audio_decoders);
 
@@ -352,12 +360,13 @@ std::unique_ptr<Renderer> PipelineIntegrationTestBase::CreateRenderer(
                               CHANNEL_LAYOUT_STEREO, 44100, 16, 512)));
   }
 
-  std::unique_ptr<AudioRenderer> audio_renderer(new AudioRendererImpl(
+  std::unique_ptr<AudioRendererImpl> audio_renderer(new AudioRendererImpl(
       message_loop_.task_runner(),
       (clockless_playback_)
           ? static_cast<AudioRendererSink*>(clockless_audio_sink_.get())
           : audio_sink_.get(),
       std::move(audio_decoders), new MediaLog()));
+  audio_latency_histograms_ = audio_renderer->latency_histograms();
   if (hashing_enabled_) {
     if (clockless_playback_)
       clockless_audio_sink_->StartAudioHashForTesting();
@@ -376,11 +385,16 @@ std::unique_ptr<Renderer> PipelineIntegrationTestBase::CreateRenderer(
   if (clockless_playback_)
     renderer_impl->EnableClocklessVideoPlaybackForTesting();
 
+  if (fast_start_)
+    renderer_impl->set_concurrent_initialization(true);
+
   return std::move(renderer_impl);
 }
 
 void PipelineIntegrationTestBase::OnVideoFramePaint(
     const scoped_refptr<VideoFrame>& frame) {
+  if (first_frame_time_.is_null())
+    first_frame_time_ = base::TimeTicks::Now();
   last_video_frame_format_ = frame->format();
   int result;
   if (frame->metadata()->GetInteger(VideoFrameMetadata::COLOR_SPACE, &result))
@@ -392,6 +406,12 @@ void PipelineIntegrationTestBase::OnVideoFramePaint(
   VideoFrame::HashFrameForTesting(&md5_context_, frame);
 }
 
+base::TimeDelta PipelineIntegrationTestBase::GetTimeToFirstFrame() const {
+  if (first_frame_time_.is_null())
+    return base::TimeDelta();
+  return first_frame_time_ - start_time_;
+}
+
 void PipelineIntegrationTestBase::ResetVideoHash() {
   DVLOG(1) << __FUNCTION__;
   base::MD5Init(&md5_context_);
@@ -16,6 +16,7 @@
 #include "media/base/demuxer.h"
 #include "media/base/media_keys.h"
 #include "media/base/null_video_sink.h"
+#include "media/base/pipeline_latency_histograms.h"
 #include "media/base/pipeline_impl.h"
 #include "media/base/pipeline_status.h"
 #include "media/base/text_track.h"
@@ -73,7 +74,8 @@ class PipelineIntegrationTestBase : public Pipeline::Client {
     kNormal = 0,
     kHashed = 1,
     kClockless = 2,
-    kExpectDemuxerFailure = 4
+    kExpectDemuxerFailure = 4,
+    kFastStart = 8
   };
 
   // Starts the pipeline with a file specified by |filename|, optionally with a
@@ -125,6 +127,19 @@ class PipelineIntegrationTestBase : public Pipeline::Client {
   // Pipeline must have been started with clockless playback enabled.
   base::TimeDelta GetAudioTime();
 
+  // Returns the time from Start() until the first video frame was painted, or
+  // zero if none has been painted yet.
+  base::TimeDelta GetTimeToFirstFrame() const;
+
+  // Returns the per-stage latency histograms of the most recently created audio
+  // and video renderers.
+  PipelineLatencyHistograms* GetAudioLatencyHistograms() {
+    return audio_latency_histograms_.get();
+  }
+  PipelineLatencyHistograms* GetVideoLatencyHistograms() {
+    return video_latency_histograms_.get();
+  }
+
   // Sets a callback to handle EME "encrypted" event. Must be called to test
   // potentially encrypted media.
   void set_encrypted_media_init_data_cb(
@@ -137,12 +152,15 @@ class PipelineIntegrationTestBase : public Pipeline::Client {
   base::MD5Context md5_context_;
   bool hashing_enabled_;
   bool clockless_playback_;
+  bool fast_start_;
   std::unique_ptr<Demuxer> demuxer_;
   std::unique_ptr<DataSource> data_source_;
   std::unique_ptr<PipelineImpl> pipeline_;
   scoped_refptr<NullAudioSink> audio_sink_;
   scoped_refptr<ClocklessAudioSink> clockless_audio_sink_;
   std::unique_ptr<NullVideoSink> video_sink_;
+  scoped_refptr<PipelineLatencyHistograms> audio_latency_histograms_;
+  scoped_refptr<PipelineLatencyHistograms> video_latency_histograms_;
   bool ended_;
   PipelineStatus pipeline_status_;
   Demuxer::EncryptedMediaInitDataCB encrypted_media_init_data_cb_;
@@ -151,6 +169,8 @@ class PipelineIntegrationTestBase : public Pipeline::Client {
   DummyTickClock dummy_clock_;
   PipelineMetadata metadata_;
   scoped_refptr<VideoFrame> last_frame_;
+  base::TimeTicks start_time_;
+  base::TimeTicks first_frame_time_;
 
   PipelineStatus StartInternal(
       std::unique_ptr<DataSource> data_source,